@@ -0,0 +1,518 @@
+// Rendimiento del núcleo sin interfaz sobre flotas sintéticas, con salida en JSON para
+// comparar versiones en el mismo equipo:
+//   - flotas deterministas (misma semilla, mismos datos) de 10k, 100k y 1M dispositivos,
+//     repartidos a razón de DevicesPerUser por usuario
+//   - DeviceManager: addDevice, updateDevice, getDevicesByUser y removeDevice (las bajas
+//     eliminan las altas, así que la flota vuelve a su tamaño)
+//   - User::login correcto e incorrecto
+//   - DatabaseManager::insertLog: latencia de encolado y ritmo de escritura en el almacén
+//   - filtro de búsqueda como en la barra de la ventana principal: texto libre por
+//     DeviceSearch + DeviceTableModel, y subred CIDR por DeviceManager::subnetFilter()
+//   - exportación a CSV completa con DeviceExporter
+//
+// Cada operación informa de operaciones/s y latencias (media, p50, p95, p99 y máximo) en
+// microsegundos. El JSON se escribe en la salida estándar (o en el archivo indicado) y el
+// progreso en la de errores.
+//
+// Uso: bench_backend [flotas] [operaciones] [salida.json]
+//      (por defecto "10000,100000,1000000", 2000 y la salida estándar)
+
+#include <QCoreApplication>
+#include <QTemporaryDir>
+#include <QElapsedTimer>
+#include <QEventLoop>
+#include <QTimer>
+#include <QThread>
+#include <QFile>
+#include <QFileInfo>
+#include <QDateTime>
+#include <QSysInfo>
+#include <QRandomGenerator>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QSqlQuery>
+#include <QSqlError>
+#include <QTextStream>
+#include <QDebug>
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <vector>
+#include "databasemanager.h"
+#include "devicemanager.h"
+#include "devicesearch.h"
+#include "deviceexporter.h"
+#include "devicetablemodel.h"
+#include "auditlogger.h"
+#include "user.h"
+
+namespace {
+
+const int DevicesPerUser = 100;
+const quint32 Seed = 20240611;
+
+const char *const Kinds[] = { "Sensor", "Medidor", "Válvula", "Bomba", "Cámara", "Termostato" };
+const char *const Areas[] = { "Norte", "Sur", "Planta", "Almacén", "Oficina", "Laboratorio" };
+const char *const Types[] = { "Sensor", "Actuador", "Controlador", "Gateway" };
+
+QTextStream &progress()
+{
+    static QTextStream stream(stderr);
+    return stream;
+}
+
+QString deviceName(QRandomGenerator &random, int index)
+{
+    return QString("%1 %2 %3").arg(QString::fromUtf8(Kinds[random.bounded(6)]),
+                                   QString::fromUtf8(Areas[random.bounded(6)]))
+        .arg(index);
+}
+
+QString deviceIp(int index)
+{
+    return QString("10.%1.%2.%3").arg((index >> 16) & 0xFF).arg((index >> 8) & 0xFF).arg(index & 0xFF);
+}
+
+// ---------------------------------------------------------
+// MEDICIÓN
+// ---------------------------------------------------------
+
+/**
+ * @brief Latencias de una operación repetida.
+ */
+class Samples
+{
+public:
+    void reserve(int count) { m_ns.reserve(count); }
+    void add(qint64 ns) { m_ns.push_back(ns); }
+
+    /**
+     * @brief Mide una llamada y guarda su duración.
+     * @return Lo que devuelva la llamada.
+     */
+    template <typename Fn>
+    auto time(Fn &&fn)
+    {
+        QElapsedTimer clock;
+        clock.start();
+        auto result = fn();
+        add(clock.nsecsElapsed());
+        return result;
+    }
+
+    /**
+     * @brief Resumen en JSON de las latencias.
+     * @param name Nombre de la operación.
+     * @param failures Operaciones que no se completaron.
+     */
+    QJsonObject toJson(const QString &name, qint64 failures = 0)
+    {
+        std::sort(m_ns.begin(), m_ns.end());
+        qint64 total = 0;
+        for (qint64 ns : m_ns) total += ns;
+
+        auto percentile = [this](double p) {
+            if (m_ns.empty()) return 0.0;
+            const size_t rank = size_t(std::ceil(p * m_ns.size()));
+            return m_ns[qBound<size_t>(1, rank, m_ns.size()) - 1] / 1e3;
+        };
+
+        QJsonObject json;
+        json["operation"] = name;
+        json["ops"] = qint64(m_ns.size());
+        json["failures"] = failures;
+        json["total_ms"] = total / 1e6;
+        json["ops_per_s"] = total > 0 ? m_ns.size() * 1e9 / total : 0.0;
+        json["mean_us"] = m_ns.empty() ? 0.0 : total / 1e3 / m_ns.size();
+        json["p50_us"] = percentile(0.50);
+        json["p95_us"] = percentile(0.95);
+        json["p99_us"] = percentile(0.99);
+        json["max_us"] = m_ns.empty() ? 0.0 : m_ns.back() / 1e3;
+        return json;
+    }
+
+private:
+    std::vector<qint64> m_ns;
+};
+
+// ---------------------------------------------------------
+// FLOTA SINTÉTICA
+// ---------------------------------------------------------
+
+/**
+ * @brief Inserta la flota en una sola transacción (no se mide como operación).
+ * Los usuarios 'usuarioN' (contraseña 'claveN') se crean después del administrador.
+ */
+bool populate(int devices, int users, QList<int> *userIds)
+{
+    ConnectionPool *pool = DatabaseManager::pool();
+    ConnectionPool::WriteLock lock(pool);
+    QSqlDatabase db = pool->writer();
+    QSqlQuery query(db);
+    QRandomGenerator random(Seed ^ quint32(devices));
+
+    db.transaction();
+    query.prepare("INSERT INTO users (username, password, role) VALUES (?, ?, 'Operator')");
+    for (int i = 0; i < users; ++i) {
+        query.addBindValue(QString("usuario%1").arg(i));
+        query.addBindValue(QString("clave%1").arg(i));
+        if (!query.exec()) {
+            qCritical() << "Error insertando usuarios:" << query.lastError().text();
+            db.rollback();
+            return false;
+        }
+        userIds->append(query.lastInsertId().toInt());
+    }
+
+    query.prepare("INSERT INTO devices (user_id, name, type, ip_address, ip_key, calibration) "
+                  "VALUES (?, ?, ?, ?, ?, ?)");
+    for (int i = 0; i < devices; ++i) {
+        const QString ip = deviceIp(i);
+        query.addBindValue(userIds->at(i % users));
+        query.addBindValue(deviceName(random, i));
+        query.addBindValue(QString(Types[random.bounded(4)]));
+        query.addBindValue(ip);
+        query.addBindValue(DeviceManager::ipSortKey(ip));
+        query.addBindValue(random.bounded(1000) / 100.0);
+        if (!query.exec()) {
+            qCritical() << "Error insertando dispositivos:" << query.lastError().text();
+            db.rollback();
+            return false;
+        }
+    }
+    return db.commit();
+}
+
+// ---------------------------------------------------------
+// OPERACIONES
+// ---------------------------------------------------------
+
+void benchDevices(const QList<int> &userIds, int operations, QRandomGenerator &random, QJsonArray *results)
+{
+    DeviceManager manager;
+    QList<int> ids;
+    ids.reserve(operations);
+
+    Samples add;
+    add.reserve(operations);
+    for (int i = 0; i < operations; ++i) {
+        Device device;
+        device.setUserId(userIds.at(random.bounded(userIds.size())));
+        device.setName(deviceName(random, i));
+        device.setType(Types[random.bounded(4)]);
+        device.setIp(QString("192.168.%1.%2").arg((i >> 8) & 0xFF).arg(i & 0xFF));
+        device.setCalibration(1.0);
+        if (add.time([&] { return manager.addDevice(&device); })) ids.append(device.getId());
+    }
+    results->append(add.toJson("device_add", operations - ids.size()));
+
+    Samples update;
+    update.reserve(ids.size());
+    qint64 failures = 0;
+    for (int id : std::as_const(ids)) {
+        Device device;
+        device.setId(id);
+        device.setUserId(userIds.at(random.bounded(userIds.size())));
+        device.setName(deviceName(random, id));
+        device.setType(Types[random.bounded(4)]);
+        device.setIp("172.16.0.1");
+        device.setCalibration(2.0);
+        if (!update.time([&] { return manager.updateDevice(&device); })) ++failures;
+    }
+    results->append(update.toJson("device_update", failures));
+
+    // Lista completa de un usuario (DevicesPerUser dispositivos de media)
+    Samples list;
+    const int lists = qMin(operations, 500);
+    list.reserve(lists);
+    qint64 rows = 0;
+    for (int i = 0; i < lists; ++i) {
+        const int userId = userIds.at(random.bounded(userIds.size()));
+        const QList<Device*> devices = list.time([&] { return manager.getDevicesByUser(userId); });
+        rows += devices.size();
+        qDeleteAll(devices);
+    }
+    QJsonObject listJson = list.toJson("device_list_by_user");
+    listJson["rows_per_op"] = lists > 0 ? double(rows) / lists : 0.0;
+    results->append(listJson);
+
+    Samples remove;
+    remove.reserve(ids.size());
+    failures = 0;
+    for (int id : std::as_const(ids)) {
+        if (!remove.time([&] { return manager.removeDevice(id); })) ++failures;
+    }
+    results->append(remove.toJson("device_remove", failures));
+}
+
+void benchLogin(int users, int operations, QRandomGenerator &random, QJsonArray *results)
+{
+    User user;
+
+    Samples ok;
+    ok.reserve(operations);
+    qint64 failures = 0;
+    for (int i = 0; i < operations; ++i) {
+        const int n = random.bounded(users);
+        const QString name = QString("usuario%1").arg(n);
+        const QString password = QString("clave%1").arg(n);
+        if (!ok.time([&] { return user.login(name, password); })) ++failures;
+    }
+    results->append(ok.toJson("user_login", failures));
+
+    Samples wrong;
+    wrong.reserve(operations);
+    failures = 0;
+    for (int i = 0; i < operations; ++i) {
+        const QString name = QString("usuario%1").arg(random.bounded(users));
+        if (wrong.time([&] { return user.login(name, "incorrecta"); })) ++failures;
+    }
+    results->append(wrong.toJson("user_login_rejected", failures));
+}
+
+void benchAuditLog(DatabaseManager &database, int operations, QJsonArray *results)
+{
+    AuditLogger *logger = database.auditLogger();
+    const AuditLoggerStats before = logger ? logger->stats() : AuditLoggerStats();
+
+    Samples enqueue;
+    enqueue.reserve(operations);
+    qint64 failures = 0;
+    QElapsedTimer clock;
+    clock.start();
+    for (int i = 0; i < operations; ++i) {
+        const QString message = QString("Dispositivo %1 modificado").arg(i);
+        if (!enqueue.time([&] { return database.insertLog("Benchmark", message); })) ++failures;
+    }
+
+    // Ritmo real de escritura: hasta que el hilo de auditoría confirma todo lo encolado
+    AuditLoggerStats after = before;
+    while (logger && clock.elapsed() < 60000) {
+        after = logger->stats();
+        if (after.written + after.dropped >= after.enqueued) break;
+        QThread::msleep(1);
+    }
+    const qint64 drainNs = clock.nsecsElapsed();
+
+    QJsonObject json = enqueue.toJson("audit_insert_log", failures);
+    json["written"] = after.written - before.written;
+    json["dropped"] = after.dropped - before.dropped;
+    json["commits"] = after.commits - before.commits;
+    json["written_per_s"] = drainNs > 0 ? (after.written - before.written) * 1e9 / drainNs : 0.0;
+    results->append(json);
+}
+
+void benchSearch(DatabaseManager &database, int devices, int operations, QRandomGenerator &random,
+                 QJsonArray *results)
+{
+    DeviceSearch search(DatabaseManager::pool());
+    search.setDebounceInterval(0);
+    DeviceTableModel model(database.getDatabase());
+
+    QList<int> found;
+    QEventLoop loop;
+    QTimer timeout;   // Por si una búsqueda no llega a emitir resultados
+    timeout.setSingleShot(true);
+    timeout.setInterval(30000);
+    QObject::connect(&timeout, &QTimer::timeout, &loop, &QEventLoop::quit);
+    QObject::connect(&search, &DeviceSearch::resultsReady, &loop,
+                     [&](const QString &, const QList<int> &ids, bool) {
+                         found = ids;
+                         loop.quit();
+                     });
+
+    // Texto libre: consulta en segundo plano y filtro del modelo, como la barra de búsqueda
+    const int searches = qMin(operations, 300);
+    Samples text;
+    text.reserve(searches);
+    qint64 rows = 0;
+    qint64 failures = 0;
+    for (int i = 0; i < searches; ++i) {
+        QString query;
+        switch (i % 3) {
+        case 0: query = QString::fromUtf8(Kinds[random.bounded(6)]) + ' ' + QString::fromUtf8(Areas[random.bounded(6)]); break;
+        case 1: query = QString::fromUtf8(Areas[random.bounded(6)]).left(4); break;
+        default: query = deviceIp(random.bounded(devices)).section('.', 0, 2) + '.'; break;
+        }
+
+        const bool ok = text.time([&] {
+            found.clear();
+            search.search(query);
+            timeout.start();
+            loop.exec();
+            timeout.stop();
+
+            QStringList idList;
+            idList.reserve(found.size());
+            for (int id : std::as_const(found)) idList << QString::number(id);
+            model.setFilter(found.isEmpty() ? QString("1=0") : "id IN (" + idList.join(',') + ")");
+            return model.select();
+        });
+        if (!ok) ++failures;
+        rows += model.rowCount();
+    }
+    QJsonObject textJson = text.toJson("search_text", failures);
+    textJson["rows_per_op"] = searches > 0 ? double(rows) / searches : 0.0;
+    results->append(textJson);
+
+    // Subred CIDR: rango sobre ip_key
+    Samples subnet;
+    subnet.reserve(searches);
+    rows = 0;
+    failures = 0;
+    for (int i = 0; i < searches; ++i) {
+        const QString cidr = deviceIp(random.bounded(devices)).section('.', 0, 2) + ".0/24";
+        const bool ok = subnet.time([&] {
+            model.setFilter(DeviceManager::subnetFilter(cidr));
+            return model.select();
+        });
+        if (!ok) ++failures;
+        rows += model.rowCount();
+    }
+    QJsonObject subnetJson = subnet.toJson("search_subnet", failures);
+    subnetJson["rows_per_op"] = searches > 0 ? double(rows) / searches : 0.0;
+    results->append(subnetJson);
+}
+
+void benchExport(const QString &fileName, QJsonArray *results)
+{
+    const int runs = 3;
+    Samples exports;
+    exports.reserve(runs);
+    ExportStats last;
+    qint64 failures = 0;
+
+    for (int i = 0; i < runs; ++i) {
+        DeviceExporter exporter(DatabaseManager::pool());
+        QEventLoop loop;
+        QObject::connect(&exporter, &DeviceExporter::finished, &loop, [&](const ExportStats &stats) {
+            last = stats;
+            loop.quit();
+        });
+
+        const bool ok = exports.time([&] {
+            if (!exporter.start(fileName)) return false;
+            loop.exec();
+            return last.error.isEmpty();
+        });
+        if (!ok) ++failures;
+    }
+
+    QJsonObject json = exports.toJson("csv_export", failures);
+    json["rows"] = last.rowsExported;
+    json["bytes"] = last.bytesWritten;
+    const double meanS = json["mean_us"].toDouble() / 1e6;
+    json["rows_per_s"] = meanS > 0 ? last.rowsExported / meanS : 0.0;
+    results->append(json);
+}
+
+QString sqliteVersion()
+{
+    QSqlQuery query(DatabaseManager::pool()->reader());
+    return query.exec("SELECT sqlite_version()") && query.next() ? query.value(0).toString() : QString();
+}
+
+/**
+ * @brief Crea, mide y descarta una flota.
+ * @param environment Recibe la versión de SQLite y el perfil de almacenamiento usados.
+ * @return Resultados de la flota, o un objeto vacío si no se pudo crear.
+ */
+QJsonObject runFleet(int devices, int operations, QJsonObject *environment)
+{
+    QTemporaryDir dir;
+    const QString dbPath = dir.filePath("bench.db");
+    auto database = std::make_unique<DatabaseManager>(dbPath);
+    if (!dir.isValid() || !database->openDatabase()) return QJsonObject();
+    (*environment)["sqlite"] = sqliteVersion();
+    (*environment)["storage_profile"] = database->storageProfile().name;
+
+    const int users = qMax(1, devices / DevicesPerUser);
+    QList<int> userIds;
+    QElapsedTimer clock;
+    clock.start();
+    if (!populate(devices, users, &userIds)) return QJsonObject();
+    const qint64 populateMs = clock.elapsed();
+
+    QRandomGenerator random(Seed + quint32(devices));
+    QJsonArray results;
+
+    progress() << "  CRUD de dispositivos..." << Qt::endl;
+    benchDevices(userIds, operations, random, &results);
+    progress() << "  Inicio de sesión..." << Qt::endl;
+    benchLogin(users, operations, random, &results);
+    progress() << "  Auditoría..." << Qt::endl;
+    benchAuditLog(*database, operations, &results);
+    progress() << "  Búsqueda..." << Qt::endl;
+    benchSearch(*database, devices, operations, random, &results);
+    progress() << "  Exportación a CSV..." << Qt::endl;
+    benchExport(dir.filePath("export.csv"), &results);
+
+    QJsonObject fleet;
+    fleet["devices"] = devices;
+    fleet["users"] = users;
+    fleet["populate_ms"] = populateMs;
+    fleet["database_bytes"] = QFileInfo(dbPath).size() + QFileInfo(dbPath + "-wal").size();
+    fleet["results"] = results;
+    return fleet;
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    const QStringList args = app.arguments();
+    const QStringList sizes = (args.size() > 1 ? args.at(1) : QString("10000,100000,1000000")).split(',', Qt::SkipEmptyParts);
+    const int operations = qMax(1, args.size() > 2 ? args.at(2).toInt() : 2000);
+    const QString output = args.size() > 3 ? args.at(3) : QString();
+
+    QJsonObject environment;
+    environment["qt"] = QString(qVersion());
+    environment["os"] = QSysInfo::prettyProductName();
+    environment["cpu_arch"] = QSysInfo::currentCpuArchitecture();
+    environment["cpu_threads"] = QThread::idealThreadCount();
+
+    QJsonArray fleets;
+    for (const QString &size : sizes) {
+        const int devices = size.toInt();
+        if (devices <= 0) {
+            qCritical() << "Tamaño de flota no válido:" << size;
+            return 1;
+        }
+        progress() << "Flota de " << devices << " dispositivos" << Qt::endl;
+
+        const QJsonObject fleet = runFleet(devices, operations, &environment);
+        if (fleet.isEmpty()) {
+            qCritical() << "No se pudo crear la flota de" << devices << "dispositivos";
+            return 1;
+        }
+        fleets.append(fleet);
+    }
+
+    QJsonObject root;
+    root["benchmark"] = "backend";
+    root["format"] = 1;
+    root["version"] = QString(PROYECTO_VERSION);
+    root["timestamp"] = QDateTime::currentDateTimeUtc().toString(Qt::ISODate);
+    root["seed"] = qint64(Seed);
+    root["operations"] = operations;
+    root["environment"] = environment;
+    root["fleets"] = fleets;
+
+    const QByteArray json = QJsonDocument(root).toJson(QJsonDocument::Indented);
+    if (output.isEmpty() || output == "-") {
+        QFile out;
+        if (!out.open(stdout, QIODevice::WriteOnly)) return 1;
+        out.write(json);
+    } else {
+        QFile out(output);
+        if (!out.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+            qCritical() << "No se pudo escribir" << output;
+            return 1;
+        }
+        out.write(json);
+        progress() << "Resultados en " << output << Qt::endl;
+    }
+    return 0;
+}
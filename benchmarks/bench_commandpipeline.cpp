@@ -0,0 +1,177 @@
+// Rendimiento y corrección de CommandPipeline contra dispositivos simulados (loopback):
+//   - cada "dispositivo" es una conexión a un QTcpServer local que responde "OK" a cada
+//     línea recibida, en orden
+//   - se envían comandos distintos con encadenado 1 (un comando por viaje de ida y vuelta)
+//     y con encadenado 8, respetando la contrapresión (se reanuda con writable())
+//   - después se envían ráfagas de escrituras de la misma clave, que deben fusionarse:
+//     el servidor tiene que recibir siempre el último valor
+//
+// Uso: bench_commandpipeline [dispositivos] [comandos por dispositivo]
+//      (por defecto 50 y 2000)
+
+#include <QCoreApplication>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QHostAddress>
+#include <QHash>
+#include <QElapsedTimer>
+#include <QTextStream>
+#include "commandpipeline.h"
+
+namespace {
+
+/**
+ * @brief Servidor que responde "OK" a cada línea y recuerda el último valor de cada clave.
+ */
+class FakeDevices : public QObject
+{
+public:
+    QTcpServer server;
+    QHash<QString, QString> lastValues;  // "clave" -> último valor recibido
+    qint64 lines = 0;
+
+    bool start()
+    {
+        if (!server.listen(QHostAddress::LocalHost, 0)) return false;
+        connect(&server, &QTcpServer::newConnection, this, [this]() {
+            while (QTcpSocket *client = server.nextPendingConnection()) {
+                client->setSocketOption(QAbstractSocket::LowDelayOption, 1);
+                connect(client, &QTcpSocket::readyRead, client, [this, client]() {
+                    QByteArray replies;
+                    while (client->canReadLine()) {
+                        const QString line = QString::fromUtf8(client->readLine()).trimmed();
+                        ++lines;
+                        const int eq = line.indexOf('=');
+                        if (eq > 0) lastValues.insert(line.left(eq), line.mid(eq + 1));
+                        replies += "OK\n";
+                    }
+                    client->write(replies);
+                });
+                connect(client, &QTcpSocket::disconnected, client, &QObject::deleteLater);
+            }
+        });
+        return true;
+    }
+};
+
+struct RunResult
+{
+    qint64 elapsedMs = 0;
+    qint64 acknowledged = 0;
+    qint64 other = 0;
+    PipelineStats stats;
+};
+
+/**
+ * @brief Envía 'perDevice' comandos distintos a cada dispositivo respetando la contrapresión.
+ */
+RunResult runThroughput(quint16 port, int devices, int perDevice, int depth)
+{
+    CommandPipeline pipeline;
+    pipeline.setPort(port);
+    pipeline.setMaxInFlight(depth);
+    pipeline.setQueueCapacity(64);
+
+    RunResult run;
+    QHash<int, int> nextCommand;
+    const qint64 total = qint64(devices) * perDevice;
+
+    auto feed = [&](int deviceId) {
+        int &next = nextCommand[deviceId];
+        while (next < perDevice) {
+            if (pipeline.submit(deviceId, "127.0.0.1", QString("get %1").arg(next)) == 0) return;
+            ++next;
+        }
+    };
+
+    QObject::connect(&pipeline, &CommandPipeline::writable, &pipeline, feed);
+    QObject::connect(&pipeline, &CommandPipeline::commandFinished, &pipeline, [&](const CommandResult &result) {
+        if (result.status == CommandResult::Acknowledged) {
+            ++run.acknowledged;
+        } else {
+            ++run.other;
+        }
+        if (run.acknowledged + run.other == total) QCoreApplication::quit();
+    });
+
+    QElapsedTimer clock;
+    clock.start();
+    for (int id = 1; id <= devices; ++id) feed(id);
+    QCoreApplication::exec();
+
+    run.elapsedMs = clock.elapsed();
+    run.stats = pipeline.stats();
+    return run;
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    const QStringList args = app.arguments();
+    const int devices = args.size() > 1 ? args.at(1).toInt() : 50;
+    const int perDevice = args.size() > 2 ? args.at(2).toInt() : 2000;
+
+    QTextStream out(stdout);
+
+    FakeDevices fake;
+    if (!fake.start()) {
+        out << "No se pudo abrir el servidor local: " << fake.server.errorString() << "\n";
+        return 1;
+    }
+    const quint16 port = fake.server.serverPort();
+    const qint64 total = qint64(devices) * perDevice;
+
+    bool ok = true;
+    for (int depth : { 1, 8 }) {
+        const RunResult run = runThroughput(port, devices, perDevice, depth);
+        const double perSecond = run.elapsedMs > 0 ? run.acknowledged * 1000.0 / run.elapsedMs : 0.0;
+
+        out << "Encadenado " << depth << ":\n";
+        out << "  Comandos:           " << run.acknowledged << " confirmados de " << total
+            << " en " << run.elapsedMs << " ms (" << QString::number(perSecond, 'f', 0) << " comandos/s)\n";
+        out << "  Comandos por envío: " << QString::number(run.stats.commandsPerBatch(), 'f', 2) << "\n";
+        out << "  Contrapresión:      " << run.stats.refused << " rechazos, cola máxima "
+            << run.stats.maxQueueDepth << "\n";
+        out << "  Latencia p50 / p99: " << run.stats.latencyP50Us << " / " << run.stats.latencyP99Us << " us\n";
+        out << "  Conexiones:         " << run.stats.connections << "\n";
+
+        if (run.acknowledged != total || run.other != 0 || run.stats.connections != devices) ok = false;
+    }
+
+    // Fusión: ráfagas de la misma clave mientras la conexión aún se está abriendo
+    {
+        CommandPipeline pipeline;
+        pipeline.setPort(port);
+
+        const int writes = 1000;
+        qint64 finished = 0;
+        qint64 coalesced = 0;
+        QObject::connect(&pipeline, &CommandPipeline::commandFinished, &pipeline, [&](const CommandResult &result) {
+            if (result.status == CommandResult::Coalesced) ++coalesced;
+            if (++finished == qint64(devices) * writes) QCoreApplication::quit();
+        });
+
+        for (int i = 0; i < writes; ++i) {
+            for (int id = 1; id <= devices; ++id) {
+                pipeline.submit(id, "127.0.0.1", QString("setpoint%1=%2").arg(id).arg(i));
+            }
+        }
+        app.exec();
+
+        int stale = 0;
+        for (int id = 1; id <= devices; ++id) {
+            if (fake.lastValues.value(QString("setpoint%1").arg(id)) != QString::number(writes - 1)) ++stale;
+        }
+
+        out << "Fusión de escrituras:\n";
+        out << "  " << qint64(devices) * writes << " escrituras, " << coalesced << " fusionadas, "
+            << pipeline.stats().sent << " enviadas\n";
+        if (stale > 0 || coalesced == 0) ok = false;
+        if (stale > 0) out << "  ERROR: " << stale << " dispositivos no recibieron el último valor\n";
+    }
+
+    out << (ok ? "Resultados correctos\n" : "ERROR: resultados incorrectos\n");
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,137 @@
+// Comparación de las lecturas de DeviceManager:
+//   - getDevicesByUser()       : un Device (QObject) en el heap por fila, columnas por nombre
+//   - getDeviceRecordsByUser() : registros por valor contiguos, 'type' internado
+//   - forEachDeviceOfUser()    : recorrido sin lista, registro reutilizado
+//
+// Uso: bench_devicerecords [filas]   (por defecto 100000)
+// Se reportan reservas de memoria (operator new) y tiempo por cada 100k filas.
+
+#include <QCoreApplication>
+#include <QSqlQuery>
+#include <QSqlError>
+#include <QTemporaryDir>
+#include <QElapsedTimer>
+#include <QStringList>
+#include <QTextStream>
+#include <QDebug>
+#include <atomic>
+#include <cstdlib>
+#include <new>
+#include "databasemanager.h"
+#include "devicemanager.h"
+
+// ---------------------------------------------------------
+// CONTEO DE RESERVAS
+// ---------------------------------------------------------
+
+static std::atomic<quint64> g_allocations{0};
+
+void *operator new(std::size_t size)
+{
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void *p = std::malloc(size ? size : 1)) return p;
+    throw std::bad_alloc();
+}
+
+void operator delete(void *p) noexcept { std::free(p); }
+void operator delete(void *p, std::size_t) noexcept { std::free(p); }
+
+namespace {
+
+struct Result
+{
+    quint64 allocations = 0;
+    qint64 elapsedNs = 0;
+    qint64 rows = 0;
+};
+
+template <typename Fn>
+Result measure(Fn &&fn)
+{
+    Result result;
+    const quint64 before = g_allocations.load();
+    QElapsedTimer timer;
+    timer.start();
+    result.rows = fn();
+    result.elapsedNs = timer.nsecsElapsed();
+    result.allocations = g_allocations.load() - before;
+    return result;
+}
+
+bool populate(int rows)
+{
+    ConnectionPool *pool = DatabaseManager::pool();
+    ConnectionPool::WriteLock lock(pool);
+    QSqlDatabase db = pool->writer();
+    QSqlQuery query(db);
+
+    const QStringList types = { "Sensor", "Actuador", "Controlador", "Gateway" };
+
+    db.transaction();
+    query.prepare("INSERT INTO devices (user_id, name, type, ip_address, ip_key, calibration) "
+                  "VALUES (1, ?, ?, ?, ?, ?)");
+    for (int i = 0; i < rows; ++i) {
+        const QString ip = QString("10.%1.%2.%3").arg((i >> 16) & 0xFF).arg((i >> 8) & 0xFF).arg(i & 0xFF);
+        query.addBindValue(QString("Dispositivo %1").arg(i));
+        query.addBindValue(types.at(i % types.size()));
+        query.addBindValue(ip);
+        query.addBindValue(DeviceManager::ipSortKey(ip));
+        query.addBindValue(i * 0.001);
+        if (!query.exec()) {
+            qCritical() << "Error insertando filas:" << query.lastError().text();
+            db.rollback();
+            return false;
+        }
+    }
+    return db.commit();
+}
+
+void report(QTextStream &out, const char *name, const Result &r)
+{
+    const double per100k = r.rows > 0 ? 100000.0 / r.rows : 0.0;
+    out << qSetFieldWidth(26) << Qt::left << name << qSetFieldWidth(0)
+        << " filas=" << r.rows
+        << "  reservas/100k=" << qRound64(r.allocations * per100k)
+        << "  ms/100k=" << QString::number(r.elapsedNs * per100k / 1e6, 'f', 2)
+        << Qt::endl;
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    const int rows = argc > 1 ? qMax(1, QString(argv[1]).toInt()) : 100000;
+
+    QTemporaryDir dir;
+    DatabaseManager database(dir.filePath("bench.db"));
+    if (!dir.isValid() || !database.openDatabase() || !populate(rows)) return 1;
+
+    DeviceManager manager;
+    QTextStream out(stdout);
+
+    // Calentamiento de la caché de páginas de SQLite
+    manager.forEachDeviceOfUser(1, [](const DeviceRecord &) { return true; });
+
+    report(out, "getDevicesByUser", measure([&] {
+        QList<Device*> devices = manager.getDevicesByUser(1);
+        const qint64 n = devices.size();
+        qDeleteAll(devices);
+        return n;
+    }));
+
+    report(out, "getDeviceRecordsByUser", measure([&] {
+        return qint64(manager.getDeviceRecordsByUser(1).size());
+    }));
+
+    report(out, "forEachDeviceOfUser", measure([&] {
+        double sum = 0.0;
+        const qint64 n = manager.forEachDeviceOfUser(1, [&sum](const DeviceRecord &r) {
+            sum += r.calibration;
+            return true;
+        });
+        return sum >= 0.0 ? n : 0;
+    }));
+
+    return 0;
+}
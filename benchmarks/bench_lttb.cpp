@@ -0,0 +1,111 @@
+// Coste por fotograma de la reducción LTTB que usa TrendWidget al desplazar la vista:
+//   - un año de lecturas por minuto de un sensor con ruido y un pico aislado
+//   - para vistas de un día, una semana, un mes y el año entero, se desplaza la vista por
+//     todo el año como haría un arrastre con el ratón: búsqueda binaria del tramo visible
+//     y reducción a un punto por píxel
+//   - se informa del tiempo medio y máximo por fotograma frente a los 16.7 ms de 60 fps
+//   - comprobación: cada reducción conserva el primer y último punto del tramo, no supera
+//     el ancho pedido y, si el pico está en la vista, lo conserva
+//
+// Uso: bench_lttb [ancho en píxeles] [fotogramas por vista]
+//      (por defecto 1920 y 600)
+
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QRandomGenerator>
+#include <QTextStream>
+#include <QtMath>
+#include <algorithm>
+#include "lttb.h"
+
+namespace {
+
+const qint64 StartMs = 1700000000000;
+const qint64 MinuteMs = 60 * 1000;
+const qint64 DayMs = 24 * 60 * MinuteMs;
+const qint64 Points = 365 * 24 * 60;
+const qint64 SpikeIndex = Points / 3 + 17;
+const double SpikeValue = 1000.0;
+
+QList<QPointF> makeYear()
+{
+    QRandomGenerator random(11);
+    QList<QPointF> points;
+    points.reserve(Points);
+    for (qint64 i = 0; i < Points; ++i) {
+        double value = 20.0 + 5.0 * qSin(i / 1440.0 * 2 * M_PI) + random.bounded(1.0);
+        if (i == SpikeIndex) value = SpikeValue;
+        points.append(QPointF(double(StartMs + i * MinuteMs), value));
+    }
+    return points;
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    const QStringList args = app.arguments();
+    const int width = qMax(3, args.size() > 1 ? args.at(1).toInt() : 1920);
+    const int frames = qMax(1, args.size() > 2 ? args.at(2).toInt() : 600);
+
+    QTextStream out(stdout);
+    const QList<QPointF> year = makeYear();
+    const qint64 endMs = StartMs + (Points - 1) * MinuteMs;
+
+    out << "Serie: " << Points << " lecturas (un año, una por minuto), " << width << " píxeles de ancho\n";
+
+    bool ok = true;
+    const struct { const char *name; qint64 spanMs; } views[] = {
+        { "1 día   ", DayMs }, { "1 semana", 7 * DayMs }, { "1 mes   ", 30 * DayMs }, { "1 año   ", 365 * DayMs }
+    };
+
+    QList<QPointF> visible;
+    for (const auto &view : views) {
+        const qint64 travel = qMax<qint64>(0, endMs - StartMs - view.spanMs);
+        qint64 totalNs = 0;
+        qint64 worstNs = 0;
+        qint64 input = 0;
+
+        for (int frame = 0; frame < frames; ++frame) {
+            const qint64 fromMs = StartMs + travel * frame / qMax(1, frames - 1);
+            const qint64 toMs = fromMs + view.spanMs;
+
+            QElapsedTimer clock;
+            clock.start();
+            const auto begin = year.cbegin();
+            auto first = std::lower_bound(begin, year.cend(), double(fromMs),
+                                          [](const QPointF &point, double ms) { return point.x() < ms; });
+            auto last = std::upper_bound(first, year.cend(), double(toMs),
+                                         [](double ms, const QPointF &point) { return ms < point.x(); });
+            Lttb::downsample(year.constData() + (first - begin), last - first, width, &visible);
+            const qint64 ns = clock.nsecsElapsed();
+
+            totalNs += ns;
+            worstNs = qMax(worstNs, ns);
+            input += last - first;
+
+            // Verificación
+            const qint64 firstIndex = first - begin;
+            const qint64 lastIndex = (last - begin) - 1;
+            if (visible.isEmpty() || visible.size() > width || visible.first() != *first
+                || visible.last() != year.at(lastIndex)) {
+                ok = false;
+            }
+            if (SpikeIndex >= firstIndex && SpikeIndex <= lastIndex
+                && std::none_of(visible.cbegin(), visible.cend(),
+                                [](const QPointF &point) { return point.y() == SpikeValue; })) {
+                ok = false;
+            }
+        }
+
+        const double meanMs = totalNs / 1e6 / frames;
+        out << "  Vista de " << view.name << ": " << input / frames << " lecturas -> " << visible.size()
+            << " puntos, " << QString::number(meanMs, 'f', 3) << " ms/fotograma de media, "
+            << QString::number(worstNs / 1e6, 'f', 3) << " ms como máximo ("
+            << (worstNs < 16666667 ? "cabe" : "NO cabe") << " en 60 fps)\n";
+    }
+
+    out << (ok ? "Resultados correctos\n" : "ERROR: resultados incorrectos\n");
+    return ok ? 0 : 1;
+}
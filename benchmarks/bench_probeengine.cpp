@@ -0,0 +1,128 @@
+// Rendimiento y corrección de ProbeEngine contra servidores locales (loopback):
+//   - la mitad de los objetivos apunta a puertos con un QTcpServer escuchando (En línea)
+//   - la otra mitad a puertos cerrados (Puerto cerrado: el núcleo responde con RST)
+// Comprueba que cada dispositivo recibe exactamente un resultado del estado esperado y
+// mide comprobaciones/s y latencias (p50/p99).
+//
+// Uso: bench_probeengine [objetivos] [servidores] [concurrencia]
+//      (por defecto 20000, 8 y 512)
+// Con muchas conexiones simultáneas puede ser necesario subir el límite de descriptores
+// (ulimit -n).
+
+#include <QCoreApplication>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QHostAddress>
+#include <QHash>
+#include <QTextStream>
+#include <algorithm>
+#include "probeengine.h"
+
+namespace {
+
+/**
+ * @brief Puerto local que no escucha nadie (se abre y se cierra un servidor).
+ */
+quint16 closedPort()
+{
+    QTcpServer server;
+    server.listen(QHostAddress::LocalHost, 0);
+    const quint16 port = server.serverPort();
+    server.close();
+    return port;
+}
+
+qint64 percentile(QList<qint64> values, double p)
+{
+    if (values.isEmpty()) return 0;
+    std::sort(values.begin(), values.end());
+    return values.at(qMin(values.size() - 1, int(values.size() * p)));
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    const QStringList args = app.arguments();
+    const int targetCount = args.size() > 1 ? args.at(1).toInt() : 20000;
+    const int serverCount = args.size() > 2 ? args.at(2).toInt() : 8;
+    const int concurrency = args.size() > 3 ? args.at(3).toInt() : 512;
+
+    QTextStream out(stdout);
+
+    // Servidores que aceptan y cierran de inmediato cada conexión
+    QList<QTcpServer *> servers;
+    for (int i = 0; i < serverCount; ++i) {
+        auto *server = new QTcpServer(&app);
+        server->setMaxPendingConnections(concurrency);
+        if (!server->listen(QHostAddress::LocalHost, 0)) {
+            out << "No se pudo abrir el servidor local: " << server->errorString() << "\n";
+            return 1;
+        }
+        QObject::connect(server, &QTcpServer::newConnection, server, [server]() {
+            while (QTcpSocket *client = server->nextPendingConnection()) {
+                client->abort();
+                client->deleteLater();
+            }
+        });
+        servers.append(server);
+    }
+    const quint16 closed = closedPort();
+
+    QList<ProbeTarget> targets;
+    QHash<int, ProbeResult::Status> expected;
+    targets.reserve(targetCount);
+    for (int i = 0; i < targetCount; ++i) {
+        ProbeTarget target;
+        target.deviceId = i + 1;
+        target.host = "127.0.0.1";
+        const bool open = (i % 2) == 0;
+        target.port = open ? servers.at(i % serverCount)->serverPort() : closed;
+        expected.insert(target.deviceId, open ? ProbeResult::Reachable : ProbeResult::Refused);
+        targets.append(target);
+    }
+
+    ProbeEngine engine;
+    engine.setMaxConcurrent(concurrency);
+    engine.setTimeout(3000);
+
+    QList<qint64> latencies;
+    latencies.reserve(targetCount);
+    int mismatches = 0;
+    int duplicates = 0;
+    QHash<int, bool> seen;
+
+    QObject::connect(&engine, &ProbeEngine::resultReady, &app, [&](const ProbeResult &result) {
+        if (seen.contains(result.deviceId)) ++duplicates;
+        seen.insert(result.deviceId, true);
+        if (expected.value(result.deviceId) != result.status) ++mismatches;
+        if (result.latencyUs >= 0) latencies.append(result.latencyUs);
+    });
+
+    ProbeStats stats;
+    QObject::connect(&engine, &ProbeEngine::finished, &app, [&](const ProbeStats &finished) {
+        stats = finished;
+        app.quit();
+    });
+
+    engine.probe(targets);
+    app.exec();
+
+    out << "Objetivos:          " << targetCount << " (" << serverCount << " servidores, concurrencia "
+        << concurrency << ")\n";
+    out << "En línea:           " << stats.reachable << "\n";
+    out << "Puerto cerrado:     " << stats.refused << "\n";
+    out << "Sin respuesta:      " << stats.timedOut << "\n";
+    out << "Inaccesibles:       " << stats.unreachable << "\n";
+    out << "Duración:           " << stats.elapsedMs << " ms ("
+        << QString::number(stats.probesPerSecond(), 'f', 0) << " comprobaciones/s)\n";
+    out << "Latencia p50 / p99: " << percentile(latencies, 0.50) << " / "
+        << percentile(latencies, 0.99) << " us\n";
+
+    const bool ok = seen.size() == targetCount && mismatches == 0 && duplicates == 0;
+    out << (ok ? "Resultados correctos\n"
+               : QString("ERROR: %1 sin resultado, %2 con estado inesperado, %3 duplicados\n")
+                     .arg(targetCount - seen.size()).arg(mismatches).arg(duplicates));
+    return ok ? 0 : 1;
+}
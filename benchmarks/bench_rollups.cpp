@@ -0,0 +1,135 @@
+// Rendimiento y corrección de RollupEngine sobre el TimeSeriesStore de DatabaseManager:
+//   - ingesta de N dispositivos con una lectura cada 10 s durante D días, con los
+//     agregados de minuto/hora/día mantenidos a la vez
+//   - gráfica de todo el periodo con un presupuesto de 500 puntos: resolución elegida,
+//     filas leídas y tiempo, frente a recorrer todas las lecturas
+//   - comprobación: en ventanas al azar, los agregados por hora coinciden con los
+//     calculados directamente sobre las lecturas
+//
+// Uso: bench_rollups [dispositivos] [días]
+//      (por defecto 20 y 30)
+
+#include <QCoreApplication>
+#include <QTemporaryDir>
+#include <QElapsedTimer>
+#include <QRandomGenerator>
+#include <QTextStream>
+#include <QtMath>
+#include "databasemanager.h"
+#include "rollupengine.h"
+#include "timeseriesstore.h"
+
+namespace {
+
+const qint64 StepMs = 10 * 1000;
+const qint64 HourMs = 3600LL * 1000;
+
+double valueAt(int deviceId, qint64 index)
+{
+    return qRound((20.0 + deviceId + 5.0 * qSin(index / 360.0)) * 100.0) / 100.0;
+}
+
+const char *resolutionName(RollupEngine::Resolution resolution)
+{
+    switch (resolution) {
+    case RollupEngine::Raw: return "lecturas";
+    case RollupEngine::Minute: return "minuto";
+    case RollupEngine::Hour: return "hora";
+    default: return "día";
+    }
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    const QStringList args = app.arguments();
+    const int devices = args.size() > 1 ? args.at(1).toInt() : 20;
+    const int days = args.size() > 2 ? args.at(2).toInt() : 30;
+
+    QTextStream out(stdout);
+
+    QTemporaryDir dir;
+    DatabaseManager database(dir.filePath("bench.db"));
+    if (!dir.isValid() || !database.openDatabase()) return 1;
+
+    TimeSeriesStore *store = database.timeSeries();
+    RollupEngine *rollups = database.rollups();
+
+    // Los datos terminan ahora, para que la retención por defecto los conserve
+    const qint64 perDevice = days * 24 * 3600 * 1000LL / StepMs;
+    const qint64 startMs = (QDateTime::currentMSecsSinceEpoch() / HourMs) * HourMs - perDevice * StepMs;
+    const qint64 endMs = startMs + (perDevice - 1) * StepMs;
+
+    // --- Ingesta: lotes de una hora de cada dispositivo ---
+    QElapsedTimer clock;
+    clock.start();
+    const int batch = int(HourMs / StepMs);
+    for (qint64 offset = 0; offset < perDevice; offset += batch) {
+        for (int id = 1; id <= devices; ++id) {
+            QList<SeriesPoint> points;
+            points.reserve(batch);
+            for (qint64 i = offset; i < qMin(perDevice, offset + batch); ++i) {
+                points.append({ startMs + i * StepMs, valueAt(id, i) });
+            }
+            store->append(id, points);
+        }
+    }
+    rollups->flush();
+    const qint64 ingestNs = clock.nsecsElapsed();
+    const qint64 total = perDevice * devices;
+
+    // --- Gráfica de todo el periodo: agregados frente a lecturas ---
+    RollupEngine::Resolution used = RollupEngine::Raw;
+    clock.restart();
+    qint64 chartPoints = 0;
+    for (int id = 1; id <= devices; ++id) {
+        chartPoints += rollups->query(id, startMs, endMs, 500, &used).size();
+    }
+    const qint64 rollupNs = clock.nsecsElapsed();
+
+    clock.restart();
+    qint64 rawPoints = 0;
+    for (int id = 1; id <= devices; ++id) {
+        rawPoints += rollups->query(id, RollupEngine::Raw, startMs, endMs).size();
+    }
+    const qint64 rawNs = clock.nsecsElapsed();
+
+    // --- Verificación por horas en ventanas al azar ---
+    bool ok = rawPoints == total;
+    int checked = 0;
+    int wrong = 0;
+    QRandomGenerator random(7);
+    for (int i = 0; i < 200; ++i) {
+        const int id = 1 + random.bounded(devices);
+        const qint64 hour = startMs + qint64(random.bounded(qMax(1, days * 24 - 1))) * HourMs;
+
+        const QList<RollupPoint> hourly = rollups->query(id, RollupEngine::Hour, hour, hour + HourMs - 1);
+        RollupPoint expected;
+        expected.bucketMs = hour;
+        for (const RollupPoint &reading : rollups->query(id, RollupEngine::Raw, hour, hour + HourMs - 1)) {
+            expected.add(reading.min);
+        }
+
+        ++checked;
+        if (hourly.size() != 1 || hourly.first().count != expected.count || hourly.first().min != expected.min
+            || hourly.first().max != expected.max || qAbs(hourly.first().sum - expected.sum) > 1e-6 * qAbs(expected.sum)) {
+            ++wrong;
+        }
+    }
+    if (wrong > 0) ok = false;
+
+    const RollupStats stats = rollups->stats();
+    out << "Lecturas: " << total << " (" << devices << " dispositivos x " << days << " días, una cada 10 s)\n";
+    out << "  Ingesta con agregados: " << QString::number(total * 1e9 / qMax<qint64>(1, ingestNs), 'f', 0)
+        << " lecturas/s, " << stats.written << " filas de agregados guardadas\n";
+    out << "Gráfica de todo el periodo (500 puntos como máximo):\n";
+    out << "  Agregados por " << resolutionName(used) << ": " << chartPoints << " puntos en "
+        << QString::number(rollupNs / 1e6, 'f', 2) << " ms\n";
+    out << "  Todas las lecturas:    " << rawPoints << " puntos en " << QString::number(rawNs / 1e6, 'f', 2) << " ms\n";
+    out << "Verificación: " << checked << " horas, " << wrong << " distintas\n";
+
+    out << (ok ? "Resultados correctos\n" : "ERROR: resultados incorrectos\n");
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,154 @@
+// Rendimiento de cada perfil de almacenamiento (StorageProfile):
+//   - CRUD: altas, modificaciones y bajas individuales con DeviceManager (un COMMIT por operación)
+//   - Importación: DeviceImporter sobre un CSV generado
+//
+// Uso: bench_storageprofiles [operaciones_crud] [filas_importacion] [directorio]
+//      (por defecto 2000 y 200000, en un directorio temporal)
+// El directorio debe estar en el disco real que se quiere medir: las cifras de
+// 'durable' dependen por completo del coste de fsync del dispositivo.
+
+#include <QCoreApplication>
+#include <QTemporaryDir>
+#include <QDir>
+#include <QFile>
+#include <QElapsedTimer>
+#include <QEventLoop>
+#include <QTextStream>
+#include <QDebug>
+#include "databasemanager.h"
+#include "devicemanager.h"
+#include "deviceimporter.h"
+#include "storageprofile.h"
+
+namespace {
+
+struct CrudResult
+{
+    double insertsPerSecond = 0.0;
+    double updatesPerSecond = 0.0;
+    double deletesPerSecond = 0.0;
+};
+
+double rate(qint64 count, qint64 elapsedNs)
+{
+    return elapsedNs > 0 ? count * 1e9 / elapsedNs : 0.0;
+}
+
+bool writeCsv(const QString &fileName, int rows)
+{
+    QFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly)) return false;
+
+    QTextStream out(&file);
+    out << "ID;Usuario_ID;Nombre;Tipo;IP;Calibracion\n";
+    for (int i = 0; i < rows; ++i) {
+        out << i + 1 << ";1;Dispositivo " << i << ";Sensor;10."
+            << ((i >> 16) & 0xFF) << '.' << ((i >> 8) & 0xFF) << '.' << (i & 0xFF)
+            << ';' << i * 0.001 << '\n';
+    }
+    return true;
+}
+
+CrudResult runCrud(int operations)
+{
+    CrudResult result;
+    DeviceManager manager;
+    QList<int> ids;
+    ids.reserve(operations);
+
+    QElapsedTimer timer;
+    timer.start();
+    for (int i = 0; i < operations; ++i) {
+        Device device;
+        device.setUserId(1);
+        device.setName(QString("Equipo %1").arg(i));
+        device.setType("Sensor");
+        device.setIp(QString("192.168.%1.%2").arg((i >> 8) & 0xFF).arg(i & 0xFF));
+        device.setCalibration(1.0);
+        if (manager.addDevice(&device)) ids.append(device.getId());
+    }
+    result.insertsPerSecond = rate(ids.size(), timer.nsecsElapsed());
+
+    timer.restart();
+    for (int id : std::as_const(ids)) {
+        Device device;
+        device.setId(id);
+        device.setUserId(1);
+        device.setName(QString("Equipo %1 (editado)").arg(id));
+        device.setType("Actuador");
+        device.setIp("10.0.0.1");
+        device.setCalibration(2.0);
+        manager.updateDevice(&device);
+    }
+    result.updatesPerSecond = rate(ids.size(), timer.nsecsElapsed());
+
+    timer.restart();
+    for (int id : std::as_const(ids)) {
+        manager.removeDevice(id);
+    }
+    result.deletesPerSecond = rate(ids.size(), timer.nsecsElapsed());
+
+    return result;
+}
+
+ImportStats runImport(const QString &csv)
+{
+    DeviceImporter importer(DatabaseManager::pool());
+    ImportStats stats;
+    QEventLoop loop;
+    QObject::connect(&importer, &DeviceImporter::finished, &loop, [&](const ImportStats &s) {
+        stats = s;
+        loop.quit();
+    });
+    importer.start(csv);
+    loop.exec();
+    return stats;
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    const int operations = argc > 1 ? qMax(1, QString(argv[1]).toInt()) : 2000;
+    const int importRows = argc > 2 ? qMax(1, QString(argv[2]).toInt()) : 200000;
+
+    QTemporaryDir tempDir(argc > 3 ? QString(argv[3]) + "/bench-XXXXXX" : QString());
+    if (!tempDir.isValid()) return 1;
+    QDir dir(tempDir.path());
+
+    const QString csv = dir.filePath("import.csv");
+    if (!writeCsv(csv, importRows)) return 1;
+
+    QTextStream out(stdout);
+    out << "perfil        altas/s   modif./s   bajas/s   import. filas/s" << Qt::endl;
+
+    for (const QString &name : StorageProfile::names()) {
+        StorageProfile profile;
+        StorageProfile::fromName(name, &profile);
+
+        CrudResult crud;
+        ImportStats import;
+        {
+            DatabaseManager database(dir.filePath(name + ".db"));
+            database.setStorageProfile(profile);
+            if (!database.openDatabase()) return 1;
+
+            crud = runCrud(operations);
+            import = runImport(csv);
+        }
+
+        out << qSetFieldWidth(12) << Qt::left << name << Qt::right
+            << qSetFieldWidth(10) << qRound(crud.insertsPerSecond)
+            << qSetFieldWidth(11) << qRound(crud.updatesPerSecond)
+            << qSetFieldWidth(10) << qRound(crud.deletesPerSecond)
+            << qSetFieldWidth(18) << qRound(import.rowsPerSecond())
+            << qSetFieldWidth(0) << Qt::endl;
+
+        if (!import.error.isEmpty()) {
+            qWarning() << name << ":" << import.error;
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,160 @@
+// Rendimiento y corrección de TelemetryReceiver con equipos simulados en loopback:
+//   - cada "dispositivo" es un QUdpSocket ligado a su propia dirección 127.0.1.N (Linux
+//     enruta todo 127.0.0.0/8 por la interfaz de loopback), con su calibración
+//   - los equipos envían tramas de 'lecturas por trama' lecturas a la mayor velocidad posible
+//   - se mide con lotes de 1 datagrama (una llamada al sistema por datagrama) y de 64
+//   - al final se comprueba en el TimeSeriesStore que cada lectura guardada es exactamente
+//     el valor enviado más la calibración de su dispositivo
+//
+// Uso: bench_telemetry [dispositivos] [tramas por dispositivo] [lecturas por trama]
+//      (por defecto 100, 2000 y 32)
+
+#include <QCoreApplication>
+#include <QUdpSocket>
+#include <QHostAddress>
+#include <QTemporaryDir>
+#include <QElapsedTimer>
+#include <QThread>
+#include <QTextStream>
+#include <QDebug>
+#include <climits>
+#include "telemetryreceiver.h"
+#include "telemetryframe.h"
+#include "timeseriesstore.h"
+
+namespace {
+
+const qint64 StartMs = 1700000000000;
+
+float rawValue(int deviceId, qint64 index)
+{
+    return float(deviceId % 50) + float(index % 1000) * 0.01f;
+}
+
+double calibrationOf(int deviceId)
+{
+    return (deviceId % 7) * 0.125 - 0.25;
+}
+
+struct RunResult
+{
+    qint64 sentDatagrams = 0;
+    qint64 sendMs = 0;
+    qint64 receiveMs = 0;
+    TelemetryStats stats;
+    qint64 mismatches = 0;
+    qint64 verified = 0;
+};
+
+RunResult run(int devices, int framesPerDevice, int samplesPerFrame, int batchSize)
+{
+    RunResult result;
+    QTemporaryDir dir;
+    TimeSeriesStore store(dir.path() + "/series");
+    store.open();
+
+    QList<DeviceRecord> fleet;
+    QList<QUdpSocket *> senders;
+    for (int id = 1; id <= devices; ++id) {
+        DeviceRecord record;
+        record.id = id;
+        record.ip = QString("127.0.1.%1").arg(id);
+        record.calibration = calibrationOf(id);
+        fleet.append(record);
+
+        auto *socket = new QUdpSocket();
+        if (!socket->bind(QHostAddress(record.ip), 0)) {
+            qWarning() << "No se pudo ligar" << record.ip << ":" << socket->errorString();
+        }
+        senders.append(socket);
+    }
+
+    TelemetryReceiver receiver(&store);
+    receiver.setBatchSize(batchSize);
+    receiver.setDevices(fleet);
+    if (!receiver.start(QHostAddress::LocalHost, 0)) {
+        qDeleteAll(senders);
+        return result;
+    }
+    const quint16 port = receiver.port();
+
+    QElapsedTimer clock;
+    clock.start();
+    for (int frame = 0; frame < framesPerDevice; ++frame) {
+        for (int id = 1; id <= devices; ++id) {
+            QList<TelemetryFrame::Sample> samples;
+            samples.reserve(samplesPerFrame);
+            for (int i = 0; i < samplesPerFrame; ++i) {
+                const qint64 index = qint64(frame) * samplesPerFrame + i;
+                samples.append({ StartMs + index * 100, rawValue(id, index) });
+            }
+            const QByteArray datagram = TelemetryFrame::encode(quint16(frame), samples);
+            if (senders.at(id - 1)->writeDatagram(datagram, QHostAddress::LocalHost, port) > 0) {
+                ++result.sentDatagrams;
+            }
+        }
+    }
+    result.sendMs = clock.elapsed();
+
+    // Esperar a que el receptor deje de avanzar (lo no recibido cuenta como descartado)
+    qint64 seen = -1;
+    while (receiver.stats().datagrams != seen) {
+        seen = receiver.stats().datagrams;
+        result.receiveMs = clock.elapsed();
+        QThread::msleep(50);
+    }
+    receiver.stop();
+    result.stats = receiver.stats();
+    store.flush();
+
+    // Cada lectura guardada debe ser exactamente el valor enviado más la calibración
+    for (int id = 1; id <= devices; ++id) {
+        store.scan(id, StartMs, LLONG_MAX, [&](const SeriesPoint &point) {
+            const qint64 index = (point.timestampMs - StartMs) / 100;
+            if (point.value != double(rawValue(id, index)) + calibrationOf(id)) ++result.mismatches;
+            ++result.verified;
+            return true;
+        });
+    }
+
+    qDeleteAll(senders);
+    return result;
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    const QStringList args = app.arguments();
+    const int devices = qBound(1, args.size() > 1 ? args.at(1).toInt() : 100, 250);
+    const int framesPerDevice = args.size() > 2 ? args.at(2).toInt() : 2000;
+    const int samplesPerFrame = qBound(1, args.size() > 3 ? args.at(3).toInt() : 32, TelemetryFrame::MaxSamples);
+
+    QTextStream out(stdout);
+    bool ok = true;
+
+    for (int batchSize : { 1, 64 }) {
+        const RunResult result = run(devices, framesPerDevice, samplesPerFrame, batchSize);
+        const TelemetryStats &stats = result.stats;
+        const double perSecond = result.receiveMs > 0 ? stats.datagrams * 1000.0 / result.receiveMs : 0.0;
+
+        out << "Lotes de " << batchSize << " datagramas:\n";
+        out << "  Enviados:           " << result.sentDatagrams << " datagramas en " << result.sendMs << " ms\n";
+        out << "  Recibidos:          " << stats.datagrams << " (" << QString::number(perSecond, 'f', 0)
+            << " datagramas/s, " << QString::number(stats.datagramsPerBatch(), 'f', 1) << " por llamada)\n";
+        out << "  Lecturas:           " << stats.samples << " decodificadas, " << stats.stored << " guardadas\n";
+        out << "  Descartes:          " << stats.kernelDrops << " en el núcleo, " << stats.lost
+            << " saltos de secuencia, " << stats.malformed << " inválidos, " << stats.unknownSource
+            << " de origen desconocido\n";
+        out << "  Verificadas:        " << result.verified << " lecturas, " << result.mismatches << " distintas\n";
+
+        if (stats.datagrams == 0 || stats.malformed != 0 || stats.unknownSource != 0 || stats.rejected != 0
+            || result.mismatches != 0 || result.verified != stats.stored) {
+            ok = false;
+        }
+    }
+
+    out << (ok ? "Resultados correctos\n" : "ERROR: resultados incorrectos\n");
+    return ok ? 0 : 1;
+}
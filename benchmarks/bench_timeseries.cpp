@@ -0,0 +1,212 @@
+// Rendimiento y tamaño de TimeSeriesStore frente a una tabla SQLite de una fila por lectura:
+//   - ingesta de lecturas de N dispositivos a intervalo regular (con algo de variación en
+//     el intervalo y valores de un sensor con ruido redondeado a dos decimales)
+//   - bytes por lectura en disco de cada alternativa
+//   - consultas de ventanas de tiempo al azar por dispositivo
+//   - reapertura del almacén (índice reconstruido desde las cabeceras) y comprobación de
+//     que todas las lecturas se decodifican exactamente
+//
+// Uso: bench_timeseries [dispositivos] [lecturas por dispositivo] [directorio]
+//      (por defecto 100 y 100000, en un directorio temporal)
+
+#include <QCoreApplication>
+#include <QTemporaryDir>
+#include <QDir>
+#include <QFileInfo>
+#include <QElapsedTimer>
+#include <QRandomGenerator>
+#include <QSqlDatabase>
+#include <QSqlQuery>
+#include <QSqlError>
+#include <QTextStream>
+#include <climits>
+#include "timeseriesstore.h"
+
+namespace {
+
+const qint64 StartMs = 1700000000000;   // Primera marca de tiempo
+const qint64 IntervalMs = 1000;         // Intervalo nominal entre lecturas
+
+/**
+ * @brief Lecturas simuladas de un dispositivo (deterministas para poder verificarlas).
+ */
+QList<SeriesPoint> makeSeries(int deviceId, int count)
+{
+    QRandomGenerator random(quint32(deviceId));
+    QList<SeriesPoint> points;
+    points.reserve(count);
+
+    qint64 ts = StartMs;
+    double base = 20.0 + deviceId % 10;
+    for (int i = 0; i < count; ++i) {
+        // Uno de cada diez intervalos se retrasa unos milisegundos
+        ts += IntervalMs + (random.bounded(10) == 0 ? random.bounded(20) : 0);
+        base += (random.bounded(200) - 100) / 1000.0;
+        points.append({ ts, qRound(base * 100.0) / 100.0 });
+    }
+    return points;
+}
+
+double rate(qint64 count, qint64 elapsedNs)
+{
+    return elapsedNs > 0 ? count * 1e9 / elapsedNs : 0.0;
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    const QStringList args = app.arguments();
+    const int devices = args.size() > 1 ? args.at(1).toInt() : 100;
+    const int perDevice = args.size() > 2 ? args.at(2).toInt() : 100000;
+
+    QTemporaryDir tempDir;
+    const QString baseDir = args.size() > 3 ? args.at(3) : tempDir.path();
+    QDir(baseDir).mkpath("series");
+
+    QTextStream out(stdout);
+    const qint64 total = qint64(devices) * perDevice;
+
+    QList<QList<SeriesPoint>> data;
+    data.reserve(devices);
+    for (int id = 1; id <= devices; ++id) data.append(makeSeries(id, perDevice));
+
+    // --- Ingesta en el almacén de series, por lotes de 1000 lecturas ---
+    qint64 storeNs = 0;
+    TimeSeriesStats stored;
+    {
+        TimeSeriesStore store(baseDir + "/series");
+        if (!store.open()) {
+            out << "No se pudo abrir el almacén en " << store.directory() << "\n";
+            return 1;
+        }
+
+        QElapsedTimer clock;
+        clock.start();
+        const int batch = 1000;
+        for (int offset = 0; offset < perDevice; offset += batch) {
+            for (int id = 1; id <= devices; ++id) {
+                store.append(id, data.at(id - 1).mid(offset, batch));
+            }
+        }
+        store.flush();
+        storeNs = clock.nsecsElapsed();
+        stored = store.stats();
+    }
+
+    // --- Ingesta en SQLite: una fila por lectura, una transacción por lote ---
+    qint64 sqliteNs = 0;
+    qint64 sqliteBytes = 0;
+    const qint64 sqliteRows = qMin<qint64>(total, 2000000);   // Basta una muestra para el tamaño por fila
+    {
+        const QString dbFile = baseDir + "/samples.sqlite";
+        QFile::remove(dbFile);
+        {
+            QSqlDatabase db = QSqlDatabase::addDatabase("QSQLITE", "bench_samples");
+            db.setDatabaseName(dbFile);
+            if (!db.open()) {
+                out << "No se pudo abrir " << dbFile << ": " << db.lastError().text() << "\n";
+                return 1;
+            }
+
+            QSqlQuery query(db);
+            query.exec("PRAGMA journal_mode=WAL");
+            query.exec("PRAGMA synchronous=NORMAL");
+            query.exec("CREATE TABLE samples (device_id INTEGER NOT NULL, ts INTEGER NOT NULL, "
+                       "value REAL NOT NULL, PRIMARY KEY(device_id, ts)) WITHOUT ROWID");
+
+            QSqlQuery insert(db);
+            insert.prepare("INSERT INTO samples(device_id, ts, value) VALUES (?, ?, ?)");
+
+            QElapsedTimer clock;
+            clock.start();
+            qint64 rows = 0;
+            db.transaction();
+            for (int i = 0; i < perDevice && rows < sqliteRows; ++i) {
+                for (int id = 1; id <= devices && rows < sqliteRows; ++id) {
+                    const SeriesPoint &point = data.at(id - 1).at(i);
+                    insert.addBindValue(id);
+                    insert.addBindValue(point.timestampMs);
+                    insert.addBindValue(point.value);
+                    insert.exec();
+                    if (++rows % 10000 == 0) {
+                        db.commit();
+                        db.transaction();
+                    }
+                }
+            }
+            db.commit();
+            sqliteNs = clock.nsecsElapsed();
+            query.exec("PRAGMA wal_checkpoint(TRUNCATE)");
+            db.close();
+        }
+        QSqlDatabase::removeDatabase("bench_samples");
+        sqliteBytes = QFileInfo(dbFile).size();
+    }
+
+    // --- Reapertura, consultas por ventana y verificación ---
+    bool ok = stored.storedPoints == total && stored.rejected == 0;
+    qint64 queryNs = 0;
+    qint64 queried = 0;
+    qint64 reopenNs = 0;
+    qint64 mismatches = 0;
+    const int windows = 2000;
+    {
+        TimeSeriesStore store(baseDir + "/series");
+        QElapsedTimer clock;
+        clock.start();
+        if (!store.open()) {
+            out << "No se pudo reabrir el almacén\n";
+            return 1;
+        }
+        reopenNs = clock.nsecsElapsed();
+
+        // Ventanas de una hora en posiciones al azar
+        QRandomGenerator random(42);
+        const qint64 span = qint64(perDevice) * IntervalMs;
+        clock.restart();
+        for (int i = 0; i < windows; ++i) {
+            const int id = 1 + random.bounded(devices);
+            const qint64 from = StartMs + qint64(random.bounded(double(span)));
+            queried += store.query(id, from, from + 3600 * 1000).size();
+        }
+        queryNs = clock.nsecsElapsed();
+
+        // Todas las lecturas deben volver exactamente (marca y bits del valor)
+        for (int id = 1; id <= devices; ++id) {
+            const QList<SeriesPoint> &expected = data.at(id - 1);
+            int index = 0;
+            const qint64 visited = store.scan(id, LLONG_MIN, LLONG_MAX, [&](const SeriesPoint &point) {
+                const SeriesPoint &want = expected.at(index++);
+                if (point.timestampMs != want.timestampMs || point.value != want.value) ++mismatches;
+                return true;
+            });
+            if (visited != perDevice) ok = false;
+        }
+    }
+    if (mismatches > 0) ok = false;
+
+    const double sqlitePerPoint = sqliteRows > 0 ? double(sqliteBytes) / sqliteRows : 0.0;
+
+    out << "Lecturas: " << total << " (" << devices << " dispositivos x " << perDevice << ")\n";
+    out << "Almacén de series:\n";
+    out << "  Ingesta:            " << QString::number(rate(total, storeNs), 'f', 0) << " lecturas/s\n";
+    out << "  Disco:              " << stored.diskBytes << " bytes, "
+        << QString::number(stored.bytesPerPoint(), 'f', 2) << " bytes/lectura ("
+        << stored.chunks << " bloques, " << stored.segments << " segmentos)\n";
+    out << "  Reapertura:         " << QString::number(reopenNs / 1e6, 'f', 1) << " ms\n";
+    out << "  Consultas (1 h):    " << QString::number(rate(windows, queryNs), 'f', 0) << " consultas/s, "
+        << QString::number(rate(queried, queryNs), 'f', 0) << " lecturas/s decodificadas\n";
+    out << "SQLite (una fila por lectura, " << sqliteRows << " filas):\n";
+    out << "  Ingesta:            " << QString::number(rate(sqliteRows, sqliteNs), 'f', 0) << " lecturas/s\n";
+    out << "  Disco:              " << QString::number(sqlitePerPoint, 'f', 2) << " bytes/lectura\n";
+    if (stored.bytesPerPoint() > 0) {
+        out << "Relación de tamaño:   " << QString::number(sqlitePerPoint / stored.bytesPerPoint(), 'f', 1)
+            << "x menos disco\n";
+    }
+
+    if (mismatches > 0) out << "  ERROR: " << mismatches << " lecturas no coinciden\n";
+    out << (ok ? "Resultados correctos\n" : "ERROR: resultados incorrectos\n");
+    return ok ? 0 : 1;
+}
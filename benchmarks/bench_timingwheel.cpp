@@ -0,0 +1,86 @@
+// Coste y exactitud de TimingWheel con una flota simulada:
+//   - cada dispositivo tiene un intervalo propio (entre 30 s y 10 min, ticks de 100 ms)
+//   - al vencer se reprograma con su intervalo más un desvío del ±10 %
+// Se simula una hora (o las indicadas) de ticks y se comprueba que cada clave vence
+// exactamente en el tick programado. Mide el coste por reprogramación y por tick.
+//
+// Uso: bench_timingwheel [dispositivos] [horas]
+//      (por defecto 100000 y 1)
+
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QRandomGenerator>
+#include <QTextStream>
+#include <QList>
+#include <algorithm>
+#include "timingwheel.h"
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    const QStringList args = app.arguments();
+    const int devices = args.size() > 1 ? args.at(1).toInt() : 100000;
+    const double hours = args.size() > 2 ? args.at(2).toDouble() : 1.0;
+
+    QTextStream out(stdout);
+    QRandomGenerator random(42);
+
+    const int tickMs = 100;
+    const quint64 totalTicks = quint64(hours * 3600 * 1000 / tickMs);
+
+    TimingWheel wheel;
+    QList<quint64> intervals(devices);
+    QList<quint64> expected(devices);
+
+    QElapsedTimer clock;
+    clock.start();
+    for (int id = 0; id < devices; ++id) {
+        intervals[id] = quint64(random.bounded(30, 601)) * 1000 / tickMs;
+        // Primer plazo repartido por todo el intervalo
+        const quint64 delay = 1 + quint64(random.bounded(int(intervals.at(id))));
+        wheel.schedule(id, delay);
+        expected[id] = wheel.now() + delay;
+    }
+    const qint64 scheduleNs = clock.nsecsElapsed();
+
+    qint64 fired = 0;
+    qint64 wrong = 0;
+    qint64 maxTickNs = 0;
+    clock.restart();
+
+    for (quint64 tick = 0; tick < totalTicks; ++tick) {
+        QElapsedTimer tickClock;
+        tickClock.start();
+
+        const QList<int> due = wheel.advance(1);
+        for (int id : due) {
+            ++fired;
+            if (expected.at(id) != wheel.now()) ++wrong;
+
+            const quint64 interval = intervals.at(id);
+            const quint64 jitter = interval / 10;
+            const quint64 delay = interval - jitter + quint64(random.bounded(int(2 * jitter + 1)));
+            wheel.schedule(id, delay);
+            expected[id] = wheel.now() + delay;
+        }
+
+        maxTickNs = std::max(maxTickNs, tickClock.nsecsElapsed());
+    }
+    const qint64 runNs = clock.nsecsElapsed();
+
+    out << "Dispositivos:          " << devices << " (" << hours << " h simuladas, "
+        << totalTicks << " ticks de " << tickMs << " ms)\n";
+    out << "Programación inicial:  " << scheduleNs / 1000000 << " ms ("
+        << (devices > 0 ? scheduleNs / devices : 0) << " ns por dispositivo)\n";
+    out << "Vencimientos:          " << fired << "\n";
+    out << "Simulación:            " << runNs / 1000000 << " ms ("
+        << (totalTicks > 0 ? runNs / qint64(totalTicks) : 0) << " ns por tick de media, "
+        << maxTickNs / 1000 << " us como máximo; "
+        << (fired > 0 ? runNs / fired : 0) << " ns por vencimiento)\n";
+
+    const bool ok = wrong == 0 && wheel.size() == devices;
+    out << (ok ? "Plazos exactos\n"
+               : QString("ERROR: %1 vencimientos fuera de plazo, %2 claves programadas de %3\n")
+                     .arg(wrong).arg(wheel.size()).arg(devices));
+    return ok ? 0 : 1;
+}
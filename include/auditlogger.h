@@ -0,0 +1,160 @@
+#ifndef AUDITLOGGER_H
+#define AUDITLOGGER_H
+
+#include <QObject>
+#include <QString>
+#include <QDateTime>
+#include <QThread>
+#include <QMutex>
+#include <QWaitCondition>
+#include <atomic>
+#include <memory>
+#include "logstore.h"
+#include "mpmcqueue.h"
+
+/**
+ * @brief Contadores del registrador de auditoría (instantánea).
+ */
+struct AuditLoggerStats
+{
+    qint64 enqueued = 0;       /**< Eventos aceptados en la cola. */
+    qint64 written = 0;        /**< Eventos confirmados (COMMIT) en el almacén. */
+    qint64 dropped = 0;        /**< Eventos descartados por cola llena o error de escritura. */
+    qint64 commits = 0;        /**< Transacciones de grupo confirmadas. */
+    qint64 queueDepth = 0;     /**< Eventos en cola en este momento (aproximado). */
+    qint64 lastCommitUs = 0;   /**< Duración de la última transacción (microsegundos). */
+    qint64 maxCommitUs = 0;    /**< Duración máxima de una transacción (microsegundos). */
+    qint64 totalCommitUs = 0;  /**< Suma de las duraciones (para calcular la media). */
+
+    /**
+     * @brief Latencia media de confirmación.
+     * @return Microsegundos por transacción (0 si aún no hubo ninguna).
+     */
+    double averageCommitUs() const { return commits > 0 ? double(totalCommitUs) / commits : 0.0; }
+};
+
+/**
+ * @brief Registrador asíncrono de auditoría con confirmación por grupos.
+ *
+ * log() solo encola el evento en una cola acotada sin bloqueos y vuelve de inmediato.
+ * Un hilo escritor vacía la cola y guarda los eventos en el LogStore (particiones
+ * mensuales) agrupados en una transacción por lote: el lote se confirma al alcanzar batchSize eventos o cuando
+ * el evento más antiguo lleva flushInterval ms esperando. stop() (y el destructor)
+ * escriben todo lo pendiente antes de terminar.
+ *
+ * Si la cola se llena, la política de desbordamiento decide entre descartar el evento
+ * (Drop, contabilizado en AuditLoggerStats::dropped) o esperar a que haya espacio (Block).
+ */
+class AuditLogger : public QObject
+{
+    Q_OBJECT
+
+public:
+    /**
+     * @brief Comportamiento de log() cuando la cola está llena.
+     */
+    enum OverflowPolicy {
+        Drop,   /**< Descartar el evento y contabilizarlo. */
+        Block   /**< Esperar a que el escritor libere espacio. */
+    };
+
+    /**
+     * @brief Constructor de la clase AuditLogger.
+     * @param store Almacén particionado de logs (solo el hilo escritor llama a append()).
+     * @param parent Objeto padre opcional.
+     */
+    explicit AuditLogger(LogStore *store, QObject *parent = nullptr);
+
+    /**
+     * @brief Destructor de la clase.
+     * Escribe los eventos pendientes y detiene el hilo escritor.
+     */
+    ~AuditLogger();
+
+    /**
+     * @brief Capacidad de la cola (se aplica en el próximo start()).
+     * @param entries Número máximo de eventos en espera (se redondea a potencia de dos).
+     */
+    void setCapacity(int entries);
+
+    /**
+     * @brief Eventos por transacción de grupo.
+     * @param entries Tamaño máximo del lote (mínimo 1).
+     */
+    void setBatchSize(int entries);
+
+    /**
+     * @brief Tiempo máximo que un evento espera antes de confirmar un lote incompleto.
+     * @param ms Milisegundos (mínimo 1).
+     */
+    void setFlushInterval(int ms);
+
+    /**
+     * @brief Política cuando la cola está llena.
+     * @param policy Drop o Block.
+     */
+    void setOverflowPolicy(OverflowPolicy policy);
+
+    /**
+     * @brief Inicia el hilo escritor.
+     * @return false si ya estaba en marcha.
+     */
+    bool start();
+
+    /**
+     * @brief Escribe todos los eventos pendientes y detiene el hilo escritor.
+     * Los eventos registrados después se descartan.
+     */
+    void stop();
+
+    /**
+     * @brief Encola un evento de auditoría (no bloquea salvo con la política Block).
+     * @param category Categoría del evento.
+     * @param message Descripción del evento.
+     * @return false si el evento se descartó (cola llena o registrador detenido).
+     */
+    bool log(const QString &category, const QString &message);
+
+    /**
+     * @brief Instantánea de los contadores.
+     * @return Contadores actuales.
+     */
+    AuditLoggerStats stats() const;
+
+private:
+    /**
+     * @brief Bucle del hilo escritor.
+     */
+    void run();
+
+    /**
+     * @brief Inserta un lote en una única transacción.
+     * @param batch Eventos a escribir.
+     * @return true si el lote se confirmó.
+     */
+    bool writeBatch(const QList<LogEntry> &batch);
+
+    LogStore *m_store;                            /**< Almacén particionado de logs. */
+    std::unique_ptr<MpmcQueue<LogEntry>> m_queue; /**< Cola sin bloqueos de eventos pendientes. */
+    int m_capacity;                               /**< Capacidad solicitada de la cola. */
+    std::atomic<int> m_batchSize;                 /**< Eventos por transacción. */
+    std::atomic<int> m_flushInterval;             /**< Espera máxima de un lote (ms). */
+    std::atomic<int> m_policy;                    /**< OverflowPolicy actual. */
+    std::atomic<bool> m_running;                  /**< Acepta eventos nuevos. */
+    std::atomic<bool> m_stopping;                 /**< Se solicitó detener el escritor. */
+    QThread *m_thread;                            /**< Hilo escritor. */
+    QMutex m_wakeMutex;                           /**< Solo para dormir/despertar al escritor. */
+    QWaitCondition m_wake;                        /**< Despierta al escritor (lote lleno o stop). */
+    std::atomic<bool> m_wakePending;              /**< Ya se pidió despertar al escritor. */
+    std::atomic<int> m_activeProducers;           /**< Llamadas a log() en curso (cierre ordenado). */
+
+    std::atomic<qint64> m_enqueued;               /**< Contador: eventos aceptados. */
+    std::atomic<qint64> m_written;                /**< Contador: eventos escritos. */
+    std::atomic<qint64> m_dropped;                /**< Contador: eventos descartados. */
+    std::atomic<qint64> m_commits;                /**< Contador: transacciones confirmadas. */
+    std::atomic<qint64> m_lastCommitUs;           /**< Contador: última latencia. */
+    std::atomic<qint64> m_maxCommitUs;            /**< Contador: latencia máxima. */
+    std::atomic<qint64> m_totalCommitUs;          /**< Contador: latencia acumulada. */
+};
+
+#endif // AUDITLOGGER_H
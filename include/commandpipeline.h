@@ -0,0 +1,306 @@
+#ifndef COMMANDPIPELINE_H
+#define COMMANDPIPELINE_H
+
+#include <QObject>
+#include <QString>
+#include <QByteArray>
+#include <QList>
+#include <QHash>
+#include <QTimer>
+#include <QElapsedTimer>
+#include <QMetaType>
+#include <deque>
+
+class QTcpSocket;
+
+/**
+ * @brief Resultado de un comando enviado a un dispositivo.
+ */
+struct CommandResult
+{
+    /**
+     * @brief Desenlace del comando.
+     */
+    enum Status {
+        Acknowledged,  /**< El dispositivo respondió "OK". */
+        Rejected,      /**< El dispositivo respondió "ERR" (no se reintenta). */
+        Coalesced,     /**< Sustituido en cola por una escritura posterior de la misma clave. */
+        Failed,        /**< Sin conexión o sin respuesta tras agotar los reintentos. */
+        Cancelled      /**< Descartado con close(). */
+    };
+
+    quint64 commandId = 0;       /**< Identificador devuelto por submit(). */
+    int deviceId = -1;           /**< Dispositivo destinatario. */
+    Status status = Failed;      /**< Desenlace. */
+    QString reply;               /**< Texto de la respuesta (o descripción del error). */
+    qint64 latencyUs = -1;       /**< Desde submit() hasta la respuesta (-1 si no hubo). */
+    int attempts = 0;            /**< Envíos realizados. */
+};
+
+/**
+ * @brief Métricas acumuladas de la cola de comandos.
+ */
+struct PipelineStats
+{
+    qint64 submitted = 0;        /**< Comandos aceptados por submit(). */
+    qint64 refused = 0;          /**< Comandos rechazados por cola llena (contrapresión). */
+    qint64 coalesced = 0;        /**< Escrituras sustituidas en cola. */
+    qint64 sent = 0;             /**< Envíos (incluidos reintentos). */
+    qint64 batches = 0;          /**< Escrituras al socket (cada una con uno o más comandos). */
+    qint64 acknowledged = 0;     /**< Respuestas "OK". */
+    qint64 rejected = 0;         /**< Respuestas "ERR". */
+    qint64 retried = 0;          /**< Comandos reenviados tras perder la conexión. */
+    qint64 failed = 0;           /**< Comandos fallidos. */
+    qint64 connections = 0;      /**< Conexiones establecidas. */
+    int openChannels = 0;        /**< Dispositivos con conexión o cola activa. */
+    int queueDepth = 0;          /**< Comandos en cola o en vuelo ahora mismo. */
+    int maxQueueDepth = 0;       /**< Máximo de queueDepth observado. */
+    qint64 latencyP50Us = 0;     /**< Mediana de latencia de los últimos comandos respondidos. */
+    qint64 latencyP99Us = 0;     /**< Percentil 99 de latencia de los últimos comandos respondidos. */
+
+    /**
+     * @brief Comandos por escritura al socket (efecto del encadenado).
+     * @return Media de comandos enviados en cada escritura.
+     */
+    double commandsPerBatch() const { return batches > 0 ? double(sent) / batches : 0.0; }
+};
+
+Q_DECLARE_METATYPE(CommandResult)
+
+/**
+ * @brief Cola de comandos salientes por dispositivo con conexión persistente.
+ *
+ * Protocolo de control: cada comando es una línea UTF-8 terminada en '\n' y el
+ * dispositivo responde a cada una, en el mismo orden, con otra línea "OK [texto]" o
+ * "ERR texto". Como las respuestas llegan en orden, se pueden enviar varios comandos
+ * sin esperar la respuesta del anterior (hasta maxInFlight por dispositivo); los que
+ * estén listos se escriben juntos en una sola escritura, de modo que varios comandos
+ * viajan en el mismo viaje de ida y vuelta.
+ *
+ * Las escrituras de configuración ("clave=valor") se fusionan: si en cola (aún sin
+ * enviar) hay otra escritura de la misma clave, se sustituye por la nueva, que ocupa
+ * su lugar, y la anterior termina como Coalesced.
+ *
+ * Cada dispositivo tiene una cola acotada (comandos en cola + en vuelo). Con la cola
+ * llena submit() rechaza el comando y, cuando vuelve a bajar a la mitad, se emite
+ * writable() para que el llamador reanude.
+ *
+ * La conexión de cada dispositivo se abre bajo demanda y se reutiliza; se cierra tras
+ * un periodo sin actividad. Si se cae, los comandos en vuelo se reenvían (como mucho
+ * maxRetries veces) tras reconectar con espera creciente. Funciona en el hilo que lo
+ * crea, como ProbeEngine.
+ */
+class CommandPipeline : public QObject
+{
+    Q_OBJECT
+
+public:
+    /**
+     * @brief Constructor de la clase CommandPipeline.
+     * @param parent Objeto padre opcional.
+     */
+    explicit CommandPipeline(QObject *parent = nullptr);
+
+    /**
+     * @brief Destructor de la clase.
+     * Cierra las conexiones sin emitir resultados de los comandos pendientes.
+     */
+    ~CommandPipeline();
+
+    /**
+     * @brief Puerto de control de los dispositivos.
+     * @param port Puerto TCP (por defecto 5000).
+     */
+    void setPort(quint16 port);
+
+    /**
+     * @brief Capacidad de la cola de cada dispositivo.
+     * @param commands Comandos en cola o en vuelo (mínimo 1; por defecto 256).
+     */
+    void setQueueCapacity(int commands);
+
+    /**
+     * @brief Comandos enviados sin respuesta por dispositivo.
+     * @param commands Profundidad del encadenado (mínimo 1; por defecto 8).
+     */
+    void setMaxInFlight(int commands);
+
+    /**
+     * @brief Reenvíos tras perder la conexión (y reconexiones fallidas seguidas).
+     * @param retries Reintentos (por defecto 3).
+     */
+    void setMaxRetries(int retries);
+
+    /**
+     * @brief Plazo de respuesta del comando más antiguo en vuelo.
+     * @param ms Milisegundos (mínimo 100; por defecto 5000). Al vencer se da la conexión por caída.
+     */
+    void setReplyTimeout(int ms);
+
+    /**
+     * @brief Tiempo sin actividad tras el que se cierra la conexión de un dispositivo.
+     * @param ms Milisegundos (por defecto 60000).
+     */
+    void setIdleTimeout(int ms);
+
+    /**
+     * @brief Encola un comando para un dispositivo.
+     * @param deviceId ID del dispositivo.
+     * @param host IP del dispositivo (si cambia, se reconecta a la nueva).
+     * @param command Comando sin salto de línea (ej. "calibration=1.25").
+     * @return Identificador del comando, o 0 si la cola del dispositivo está llena
+     *         o el comando está vacío.
+     */
+    quint64 submit(int deviceId, const QString &host, const QString &command);
+
+    /**
+     * @brief Indica si un dispositivo admite más comandos.
+     * @param deviceId ID del dispositivo.
+     * @return true si su cola no está llena.
+     */
+    bool canSubmit(int deviceId) const;
+
+    /**
+     * @brief Comandos en cola o en vuelo de un dispositivo.
+     * @param deviceId ID del dispositivo.
+     * @return Profundidad de su cola.
+     */
+    int queueDepth(int deviceId) const;
+
+    /**
+     * @brief Descarta los comandos de un dispositivo y cierra su conexión.
+     * Emite commandFinished() con Cancelled para cada comando pendiente.
+     * @param deviceId ID del dispositivo.
+     */
+    void close(int deviceId);
+
+    /**
+     * @brief Métricas acumuladas.
+     * @return Copia de los contadores y latencias recientes.
+     */
+    PipelineStats stats() const;
+
+signals:
+    /**
+     * @brief Desenlace de un comando.
+     * @param result Estado, respuesta y latencia.
+     */
+    void commandFinished(const CommandResult &result);
+
+    /**
+     * @brief La cola de un dispositivo que estaba llena ha bajado a la mitad.
+     * @param deviceId ID del dispositivo.
+     */
+    void writable(int deviceId);
+
+private slots:
+    /**
+     * @brief Revisa plazos de respuesta, reconexiones pendientes y conexiones inactivas.
+     */
+    void sweep();
+
+private:
+    /**
+     * @brief Comando en cola o en vuelo.
+     */
+    struct Command
+    {
+        quint64 id = 0;           /**< Identificador devuelto por submit(). */
+        QString key;              /**< Clave de configuración (vacía si no se fusiona). */
+        QByteArray line;          /**< Línea a enviar, con '\n'. */
+        qint64 submittedNs = 0;   /**< Momento de submit(). */
+        qint64 sentNs = 0;        /**< Último envío. */
+        int attempts = 0;         /**< Envíos realizados. */
+    };
+
+    /**
+     * @brief Conexión y colas de un dispositivo.
+     */
+    struct Channel
+    {
+        int deviceId = -1;                    /**< Dispositivo del canal. */
+        QString host;                         /**< IP a la que se conecta. */
+        QTcpSocket *socket = nullptr;         /**< Conexión (nullptr si no hay). */
+        bool connected = false;               /**< Conexión establecida. */
+        std::deque<Command> queue;            /**< Comandos sin enviar (en orden). */
+        std::deque<Command> inFlight;         /**< Enviados sin respuesta (en orden). */
+        QHash<QString, Command *> queuedKeys; /**< Escritura sin enviar de cada clave (para fusionar). */
+        int connectFailures = 0;              /**< Conexiones fallidas seguidas. */
+        qint64 retryAtNs = -1;                /**< Próxima reconexión (-1 si no hay ninguna pendiente). */
+        qint64 lastActivityNs = 0;            /**< Último envío o respuesta. */
+        bool blocked = false;                 /**< La cola se llenó y aún no se emitió writable(). */
+
+        int depth() const { return int(queue.size() + inFlight.size()); }
+    };
+
+    /**
+     * @brief Abre la conexión del canal.
+     * @param channel Canal a conectar.
+     */
+    void openConnection(Channel *channel);
+
+    /**
+     * @brief Escribe los comandos en cola que quepan en la ventana de encadenado.
+     * @param channel Canal conectado.
+     */
+    void pump(Channel *channel);
+
+    /**
+     * @brief Procesa las líneas de respuesta recibidas.
+     * @param channel Canal con datos pendientes de leer.
+     */
+    void readReplies(Channel *channel);
+
+    /**
+     * @brief Gestiona la pérdida (o el fallo) de la conexión: reintentos y reconexión.
+     * @param channel Canal afectado.
+     * @param error Descripción del error.
+     */
+    void handleDrop(Channel *channel, const QString &error);
+
+    /**
+     * @brief Cierra y libera el socket del canal.
+     * @param channel Canal afectado.
+     */
+    void dropSocket(Channel *channel);
+
+    /**
+     * @brief Emite el resultado de un comando y actualiza métricas y contrapresión.
+     * @param channel Canal del comando.
+     * @param command Comando terminado (ya retirado de sus colas).
+     * @param status Desenlace.
+     * @param reply Respuesta o descripción del error.
+     */
+    void finish(Channel *channel, const Command &command, CommandResult::Status status, const QString &reply);
+
+    /**
+     * @brief Termina todos los comandos del canal con el mismo desenlace.
+     * @param channel Canal afectado.
+     * @param status Desenlace.
+     * @param reply Descripción del motivo.
+     */
+    void finishAll(Channel *channel, CommandResult::Status status, const QString &reply);
+
+    /**
+     * @brief Clave de configuración de un comando "clave=valor".
+     * @param command Comando.
+     * @return Clave, o vacía si el comando no es una escritura de configuración.
+     */
+    static QString configKey(const QString &command);
+
+    quint16 m_port;                     /**< Puerto de control. */
+    int m_capacity;                     /**< Comandos por dispositivo. */
+    int m_maxInFlight;                  /**< Profundidad del encadenado. */
+    int m_maxRetries;                   /**< Reintentos. */
+    int m_replyTimeoutMs;               /**< Plazo de respuesta. */
+    int m_idleTimeoutMs;                /**< Cierre por inactividad. */
+    quint64 m_nextId;                   /**< Siguiente identificador de comando. */
+    QHash<int, Channel *> m_channels;   /**< Canal de cada dispositivo activo. */
+    QTimer m_sweep;                     /**< Revisión periódica de plazos. */
+    QElapsedTimer m_clock;              /**< Reloj de latencias y plazos. */
+    PipelineStats m_stats;              /**< Contadores acumulados. */
+    QList<qint64> m_latencies;          /**< Últimas latencias (anillo para los percentiles). */
+    int m_latencyPos;                   /**< Siguiente posición del anillo. */
+};
+
+#endif // COMMANDPIPELINE_H
@@ -0,0 +1,191 @@
+#ifndef CONNECTIONPOOL_H
+#define CONNECTIONPOOL_H
+
+#include <QSqlDatabase>
+#include <QString>
+#include <QAtomicInt>
+#include "storageprofile.h"
+#include "statementcache.h"
+#include <memory>
+#include <mutex>
+
+/**
+ * @brief Conjunto de conexiones SQLite con una conexión por hilo.
+ *
+ * QSqlDatabase solo puede usarse desde el hilo que la creó, por lo que una única
+ * conexión por defecto obliga a ejecutar todas las consultas en el hilo de la interfaz.
+ * El pool abre bajo demanda, en cada hilo que lo solicite:
+ *  - una conexión de solo lectura (reader()), que en modo WAL lee en paralelo con el
+ *    resto de hilos sin bloquearse;
+ *  - una conexión de escritura (writer()), cuyo uso se serializa con WriteLock para que
+ *    en cada momento haya un único escritor activo en todo el proceso.
+ *
+ * Cada conexión tiene además su StatementCache: readStatement() y writeStatement()
+ * devuelven sentencias ya preparadas para las consultas repetidas.
+ *
+ * Las conexiones de un hilo se cierran automáticamente cuando el hilo termina, o antes
+ * con releaseCurrentThread().
+ */
+class ConnectionPool
+{
+public:
+    /**
+     * @brief Bloqueo RAII del escritor del pool.
+     *
+     * Mientras exista, ningún otro hilo puede escribir a través del pool. Es recursivo:
+     * el mismo hilo puede anidar bloqueos (por ejemplo, registrar un log dentro de una
+     * operación que ya escribe).
+     */
+    class WriteLock
+    {
+    public:
+        /**
+         * @brief Adquiere el escritor (espera si otro hilo lo está usando).
+         * @param pool Pool cuyo escritor se bloquea.
+         */
+        explicit WriteLock(ConnectionPool *pool);
+
+        WriteLock(const WriteLock &) = delete;
+        WriteLock &operator=(const WriteLock &) = delete;
+
+    private:
+        std::unique_lock<std::recursive_mutex> m_lock;
+    };
+
+    /**
+     * @brief Constructor de la clase ConnectionPool.
+     * No abre ninguna conexión: cada hilo abre las suyas al solicitarlas.
+     * @param dbPath Ruta del archivo SQLite.
+     */
+    explicit ConnectionPool(const QString &dbPath);
+
+    /**
+     * @brief Destructor de la clase.
+     * Cierra las conexiones del hilo actual. Los hilos de trabajo deben haber terminado.
+     */
+    ~ConnectionPool();
+
+    ConnectionPool(const ConnectionPool &) = delete;
+    ConnectionPool &operator=(const ConnectionPool &) = delete;
+
+    /**
+     * @brief Obtiene la ruta del archivo de base de datos.
+     * @return Ruta del archivo SQLite.
+     */
+    QString databasePath() const;
+
+    /**
+     * @brief Tiempo de espera ante bloqueos para las conexiones que se abran a partir de ahora.
+     * @param ms Milisegundos que SQLite reintenta antes de devolver SQLITE_BUSY.
+     */
+    void setBusyTimeout(int ms);
+
+    /**
+     * @brief Perfil de almacenamiento aplicado a las conexiones que se abran a partir de ahora.
+     * Debe fijarse antes de que los hilos empiecen a pedir conexiones. Ajusta también
+     * la espera ante bloqueos (setBusyTimeout()).
+     * @param profile Parámetros PRAGMA de las conexiones.
+     */
+    void setStorageProfile(const StorageProfile &profile);
+
+    /**
+     * @brief Obtiene el perfil de almacenamiento del pool.
+     * @return Perfil actual.
+     */
+    StorageProfile storageProfile() const;
+
+    /**
+     * @brief Conexión de solo lectura del hilo actual (se abre la primera vez).
+     * @return Conexión abierta, o inválida/cerrada si no se pudo abrir.
+     */
+    QSqlDatabase reader();
+
+    /**
+     * @brief Conexión de escritura del hilo actual (se abre la primera vez).
+     *
+     * Cualquier escritura o transacción de escritura debe hacerse mientras se mantiene
+     * un WriteLock; preparar sentencias no lo requiere.
+     *
+     * @return Conexión abierta, o inválida/cerrada si no se pudo abrir.
+     */
+    QSqlDatabase writer();
+
+    /**
+     * @brief Sentencia preparada y reiniciada en la conexión de lectura del hilo actual.
+     * @param sql Texto de la consulta (clave de la caché).
+     * @return Sentencia de solo avance; válida hasta que la caché la desaloje.
+     */
+    QSqlQuery &readStatement(const QString &sql);
+
+    /**
+     * @brief Sentencia preparada y reiniciada en la conexión de escritura del hilo actual.
+     * Como con writer(), la ejecución debe hacerse con un WriteLock.
+     * @param sql Texto de la consulta (clave de la caché).
+     * @return Sentencia de solo avance; válida hasta que la caché la desaloje.
+     */
+    QSqlQuery &writeStatement(const QString &sql);
+
+    /**
+     * @brief Sentencias por conexión en las cachés que se creen a partir de ahora.
+     * @param statements Capacidad de cada caché (mínimo 4).
+     */
+    void setStatementCacheCapacity(int statements);
+
+    /**
+     * @brief Aciertos, fallos y desalojos de las cachés de sentencias de todos los hilos.
+     * @return Contadores acumulados.
+     */
+    StatementCacheStats statementCacheStats() const;
+
+    /**
+     * @brief Número de conexiones abiertas actualmente por este pool (todos los hilos).
+     * @return Conexiones abiertas.
+     */
+    int openConnections() const;
+
+    /**
+     * @brief Cierra todas las conexiones de pools abiertas por el hilo actual.
+     * Se llama automáticamente al terminar cada QThread.
+     */
+    static void releaseCurrentThread();
+
+private:
+    /**
+     * @brief Obtiene (o abre) la conexión del hilo actual.
+     * @param readOnly true para la conexión de lectura.
+     * @return Conexión del hilo actual.
+     */
+    QSqlDatabase connection(bool readOnly);
+
+    /**
+     * @brief Aplica los PRAGMA del perfil de almacenamiento a una conexión recién abierta.
+     * @param db Conexión abierta.
+     * @param readOnly true si es la conexión de lectura.
+     */
+    void applyProfile(QSqlDatabase &db, bool readOnly) const;
+
+    /**
+     * @brief Nombre de la conexión del hilo actual.
+     * @param readOnly true para la conexión de lectura.
+     * @return Nombre único (pool, modo e hilo).
+     */
+    QString connectionName(bool readOnly) const;
+
+    /**
+     * @brief Caché de sentencias de la conexión del hilo actual (la crea si no existe).
+     * @param readOnly true para la conexión de lectura.
+     * @return Caché del hilo.
+     */
+    StatementCache *statements(bool readOnly);
+
+    QString m_dbPath;                    /**< Ruta del archivo de base de datos. */
+    QString m_prefix;                    /**< Prefijo único de los nombres de conexión del pool. */
+    QAtomicInt m_busyTimeout;            /**< Espera ante bloqueos (ms). */
+    StorageProfile m_profile;            /**< PRAGMA aplicados a cada conexión nueva. */
+    std::shared_ptr<QAtomicInt> m_open;  /**< Conexiones abiertas (compartido con los hilos). */
+    std::recursive_mutex m_writeMutex;   /**< Serializa las escrituras de todos los hilos. */
+    QAtomicInt m_statementCapacity;      /**< Sentencias por caché. */
+    std::shared_ptr<StatementCache::Counters> m_statementCounters; /**< Contadores de las cachés. */
+};
+
+#endif // CONNECTIONPOOL_H
@@ -4,24 +4,53 @@
 #include <QObject>
 #include <QSqlDatabase>
 #include <QString>
+#include <QList>
+#include <QTimer>
+#include "connectionpool.h"
+#include "auditlogger.h"
+#include "logstore.h"
+#include "schemamigrator.h"
+#include "storageprofile.h"
+#include "timeseriesstore.h"
+#include "rollupengine.h"
 
 /**
  * @brief Clase responsable de gestionar la conexión y operaciones directas con la base de datos SQLite.
  *
  * Esta clase maneja la apertura del archivo de base de datos, la creación de tablas iniciales
  * y provee funciones utilitarias para el registro de logs y validación básica.
+ *
+ * Las conexiones se obtienen del ConnectionPool de la base de datos abierta (ver pool()):
+ * cada hilo usa sus propias conexiones de lectura y escritura, nunca la conexión por defecto.
  */
 class DatabaseManager : public QObject
 {
     Q_OBJECT
 
 public:
+    /**
+     * @brief Almacenes que openDatabase() abre junto a la base de datos principal.
+     */
+    enum Service {
+        AuditService = 0x1,    /**< LogStore y AuditLogger (migra la tabla logs antigua y aplica su retención). */
+        SeriesService = 0x2,   /**< TimeSeriesStore y RollupEngine. */
+        AllServices = AuditService | SeriesService
+    };
+    Q_DECLARE_FLAGS(Services, Service)
+
     /**
      * @brief Constructor de la clase DatabaseManager.
      * @param parent Puntero al objeto padre (opcional) para la gestión de memoria de Qt.
      */
     explicit DatabaseManager(QObject *parent = nullptr);
 
+    /**
+     * @brief Constructor con una ruta de base de datos explícita (herramientas y benchmarks).
+     * @param dbPath Ruta del archivo SQLite.
+     * @param parent Puntero al objeto padre (opcional).
+     */
+    explicit DatabaseManager(const QString &dbPath, QObject *parent = nullptr);
+
     /**
      * @brief Destructor de la clase.
      * Se encarga de cerrar la conexión si está abierta al destruir el objeto.
@@ -31,8 +60,8 @@ public:
     /**
      * @brief Abre la conexión con la base de datos SQLite.
      *
-     * Si el archivo de base de datos no existe, lo crea. También verifica e inicializa
-     * las tablas necesarias llamando a createTables().
+     * Si el archivo de base de datos no existe, lo crea. También lleva el esquema a la
+     * versión actual aplicando las migraciones pendientes (ver migrateSchema()).
      *
      * @return true si la conexión fue exitosa y las tablas están listas.
      * @return false si hubo un error al abrir la BD o crear tablas.
@@ -40,18 +69,127 @@ public:
     bool openDatabase();
 
     /**
-     * @brief Cierra la conexión actual con la base de datos.
+     * @brief Crea el archivo, aplica las migraciones pendientes y abre los almacenes de
+     * auditoría y de series sin abrir la base de datos.
+     *
+     * Es la parte lenta de openDatabase() en un arranque en frío (disco lento, esquema
+     * antiguo, tabla logs por migrar, particiones por archivar, segmentos por indexar).
+     * Puede llamarse desde un hilo de trabajo antes de openDatabase(), que ya no vuelve a
+     * migrar y adopta los almacenes abiertos: así la ventana se muestra sin esperar al disco.
+     *
+     * @return true si el esquema quedó en la última versión.
+     */
+    bool prepareDatabase();
+
+    /**
+     * @brief Pospone el mantenimiento de openDatabase() hasta runMaintenance().
+     * @param defer true para abrir sin completar ni caducar los agregados.
+     */
+    void setDeferMaintenance(bool defer);
+
+    /**
+     * @brief Elige los almacenes que abrirá openDatabase() (por defecto, todos).
+     *
+     * Las herramientas de línea de comandos abren solo lo que usa cada orden: sin
+     * AuditService no se migran ni se archivan los logs, y sin SeriesService no se
+     * indexan los segmentos de lecturas. insertLog() devuelve false sin AuditService.
+     *
+     * @param services Combinación de Service.
+     */
+    void setServices(Services services);
+
+    /**
+     * @brief Completa los agregados con las lecturas que les falten y aplica su retención.
+     *
+     * Es la parte lenta de runMaintenance(). Puede llamarse desde un hilo de trabajo
+     * después de openDatabase(); el hilo de la base de datos llama luego a runMaintenance().
+     */
+    void prepareMaintenance();
+
+    /**
+     * @brief Completa los agregados con las lecturas que les falten, aplica su retención
+     * y empieza a alimentarlos con las lecturas nuevas.
+     * openDatabase() lo ejecuta salvo que se haya pospuesto con setDeferMaintenance().
+     * Si ya se llamó a prepareMaintenance(), solo conecta y arranca los agregados.
+     */
+    void runMaintenance();
+
+    /**
+     * @brief Cierra la base de datos y destruye su pool de conexiones.
+     * Los hilos de trabajo que usen el pool deben haber terminado.
      */
     void closeDatabase();
 
     /**
-     * @brief Inserta un registro en la tabla de auditoría (logs).
+     * @brief Pool de conexiones de la base de datos abierta.
+     * Punto de acceso común para DeviceManager, User, RegisterDialog y los procesos en segundo plano.
+     * @return Pool activo, o nullptr si no hay ninguna base de datos abierta.
+     */
+    static ConnectionPool *pool();
+
+    /**
+     * @brief Perfil de almacenamiento (PRAGMA) con el que se abrirá la base de datos.
+     * Se aplica en la próxima llamada a openDatabase().
+     * @param profile Perfil a usar.
+     */
+    void setStorageProfile(const StorageProfile &profile);
+
+    /**
+     * @brief Obtiene el perfil de almacenamiento configurado.
+     * @return Perfil actual.
+     */
+    StorageProfile storageProfile() const;
+
+    /**
+     * @brief Perfil inicial de los DatabaseManager creados a partir de ahora.
+     * Lo fija main() según la línea de comandos o la configuración.
+     * @param profile Perfil por defecto.
+     */
+    static void setDefaultStorageProfile(const StorageProfile &profile);
+
+    /**
+     * @brief Registra un evento de auditoría.
+     *
+     * No escribe en el hilo que llama: el evento se encola en el AuditLogger, que lo
+     * guarda junto con otros en la partición mensual del LogStore. Los pendientes se
+     * escriben al cerrar la base de datos.
+     *
      * @param category Categoría del evento (ej. "Login", "Error", "Sistema").
      * @param message Descripción detallada del evento.
-     * @return true si la inserción fue correcta, false en caso contrario.
+     * @return true si el evento se encoló, false si se descartó o la BD no está abierta.
      */
     bool insertLog(const QString &category, const QString &message);
 
+    /**
+     * @brief Registrador de auditoría de la base de datos abierta (contadores, configuración).
+     * @return Registrador activo, o nullptr si la BD no está abierta.
+     */
+    AuditLogger *auditLogger() const;
+
+    /**
+     * @brief Almacén particionado de auditoría (consultas y retención).
+     * @return Almacén activo, o nullptr si la BD no está abierta.
+     */
+    LogStore *logStore() const;
+
+    /**
+     * @brief Almacén de series temporales de lecturas de los dispositivos.
+     * @return Almacén abierto, o nullptr si la BD no está abierta.
+     */
+    TimeSeriesStore *timeSeries() const;
+
+    /**
+     * @brief Agregados por minuto, hora y día de las lecturas.
+     * @return Motor de agregados, o nullptr si la BD no está abierta.
+     */
+    RollupEngine *rollups() const;
+
+    /**
+     * @brief Migraciones aplicadas al abrir la base de datos, con su duración.
+     * @return Pasos de la última llamada a openDatabase() (vacío si el esquema ya estaba al día).
+     */
+    QList<MigrationStep> migrationReport() const;
+
     /**
      * @brief Valida si un usuario y contraseña existen en la base de datos.
      * @param username Nombre de usuario a verificar.
@@ -61,34 +199,162 @@ public:
     bool validateUser(const QString &username, const QString &password);
 
     /**
-     * @brief Obtiene el objeto de conexión a la base de datos.
-     * Utilizado por los modelos (QSqlTableModel) para poblar las vistas.
-     * @return Objeto QSqlDatabase con la conexión configurada.
+     * @brief Obtiene la conexión de solo lectura del hilo actual.
+     * Utilizado por los modelos (DeviceTableModel) para poblar las vistas.
+     * @return Objeto QSqlDatabase con la conexión configurada (inválido si la BD está cerrada).
      */
     QSqlDatabase getDatabase() const;
 
+    /**
+     * @brief Obtiene la ruta del archivo físico de la base de datos.
+     * Utilizada por los procesos en segundo plano que abren su propia conexión.
+     * @return Ruta absoluta del archivo SQLite.
+     */
+    QString getDatabasePath() const;
+
 private:
     /**
-     * @brief Objeto interno de Qt que maneja la conexión SQL.
+     * @brief Conexión de escritura del hilo de la interfaz (creación del esquema).
      */
     QSqlDatabase m_database;
 
+    /**
+     * @brief Pool de conexiones por hilo de la base de datos abierta.
+     */
+    ConnectionPool *m_pool;
+
+    /**
+     * @brief Particiones mensuales de auditoría (carpeta 'logs' junto a la BD).
+     */
+    LogStore *m_logStore;
+
+    /**
+     * @brief Escritor asíncrono del almacén de auditoría.
+     */
+    AuditLogger *m_auditLogger;
+
+    /**
+     * @brief Lecturas de los dispositivos comprimidas por bloques (carpeta 'series' junto a la BD).
+     */
+    TimeSeriesStore *m_timeSeries;
+
+    /**
+     * @brief Agregados de las lecturas (tabla 'device_rollups').
+     */
+    RollupEngine *m_rollups;
+
+    /**
+     * @brief Volcado periódico de los bloques abiertos del almacén de series
+     * (TimeSeriesStore::flushExpired()).
+     */
+    QTimer m_seriesFlush;
+
+    /**
+     * @brief Perfil de almacenamiento aplicado al abrir la base de datos.
+     */
+    StorageProfile m_profile;
+
+    /**
+     * @brief El esquema ya está en la última versión (ver prepareDatabase()).
+     */
+    bool m_schemaReady;
+
+    /**
+     * @brief openDatabase() no ejecuta runMaintenance().
+     */
+    bool m_deferMaintenance;
+
+    /**
+     * @brief Falta el mantenimiento de la base de datos abierta.
+     */
+    bool m_maintenancePending;
+
+    /**
+     * @brief prepareMaintenance() ya completó los agregados y aplicó la retención.
+     */
+    bool m_maintenancePrepared;
+
+    /**
+     * @brief Almacenes que abre openDatabase().
+     */
+    Services m_services;
+
+    /**
+     * @brief Pool activo del proceso (devuelto por pool()).
+     */
+    static ConnectionPool *s_pool;
+
+    /**
+     * @brief Perfil inicial de las nuevas instancias (ver setDefaultStorageProfile()).
+     */
+    static StorageProfile s_defaultProfile;
+
     /**
      * @brief Ruta al archivo físico de la base de datos en el disco.
      */
     QString m_dbPath;
 
     /**
-     * @brief Crea las tablas necesarias (users, devices, logs) si no existen.
-     * @return true si todas las tablas se verificaron/crearon correctamente.
+     * @brief Informe de la última migración del esquema.
+     */
+    QList<MigrationStep> m_migrationReport;
+
+    /**
+     * @brief Aplica las migraciones pendientes del esquema (PRAGMA user_version).
+     * Registra todas las versiones (tablas, índices, columnas) y crea el usuario por defecto.
+     * @param db Conexión de escritura.
+     * @return true si el esquema quedó en la última versión.
+     */
+    bool migrateSchema(QSqlDatabase &db);
+
+    /**
+     * @brief Aplica el modo de diario del perfil de almacenamiento.
+     * @param db Conexión de escritura.
+     * @return true si SQLite lo aceptó.
+     */
+    bool setJournalMode(QSqlDatabase &db);
+
+    /**
+     * @brief Agrega la columna 'ip_key' (BLOB de 16 bytes ordenable) y su índice.
+     * Completa la clave de los dispositivos existentes que aún no la tengan.
+     * @param db Conexión de escritura con la transacción de la migración abierta.
+     * @return true si la columna y el índice están disponibles.
+     */
+    static bool createIpKeyColumn(QSqlDatabase &db);
+
+    /**
+     * @brief Crea la tabla virtual FTS5 'devices_fts' y los triggers que la sincronizan con 'devices'.
+     * Si la tabla es nueva, indexa los dispositivos existentes. Si SQLite no incluye el
+     * módulo FTS5 no hay índice que crear (DeviceSearch recurre a LIKE).
+     * @param db Conexión de escritura con la transacción de la migración abierta.
+     * @return true si el índice está disponible o SQLite no soporta FTS5, false si hubo error.
      */
-    bool createTables();
+    static bool createSearchIndex(QSqlDatabase &db);
 
     /**
      * @brief Inserta un usuario 'admin' por defecto.
      * Esta función se ejecuta solo si la tabla de usuarios está vacía para evitar bloqueos.
+     * @param db Conexión de escritura.
      */
-    void createDefaultUser();
+    void createDefaultUser(QSqlDatabase &db);
+
+    /**
+     * @brief Abre los almacenes de m_services que aún no estén abiertos.
+     * No crea QObject ni deja conexiones abiertas: puede ejecutarse en un hilo de trabajo.
+     * @param db Conexión de escritura (con el WriteLock de su pool adquirido).
+     */
+    void openStores(QSqlDatabase &db);
+
+    /**
+     * @brief Traslada la antigua tabla 'logs' de la BD principal al LogStore y la elimina.
+     * Se ejecuta antes de iniciar el AuditLogger. Es idempotente: si se interrumpe antes
+     * de eliminar la tabla, el siguiente arranque la vuelve a copiar sin duplicar filas.
+     * @param db Conexión de escritura.
+     * @return true si no había tabla o se migró completa.
+     */
+    bool migrateLegacyLogs(QSqlDatabase &db);
 };
 
+Q_DECLARE_OPERATORS_FOR_FLAGS(DatabaseManager::Services)
+
 #endif // DATABASEMANAGER_H
@@ -3,6 +3,10 @@
 
 #include <QObject>
 #include <QString>
+#include <functional>
+
+struct ProbeResult;
+struct CommandResult;
 
 /**
  * @brief Clase que modela un dispositivo físico o virtual dentro del sistema.
@@ -108,22 +112,78 @@ public:
     // ---------------------------------------------------------
 
     /**
-     * @brief Intenta establecer conexión con el dispositivo.
-     * Utiliza la dirección IP almacenada para realizar la conexión.
-     * @return true si la conexión fue exitosa, false en caso contrario.
+     * @brief Función que solicita la comprobación de alcance de un dispositivo: recibe el
+     * ID y la IP y devuelve false si no se pudo solicitar. Normalmente envuelve
+     * ProbeEngine::probe(); así Device no depende del módulo de red.
+     */
+    using ProbeRequester = std::function<bool(int deviceId, const QString &host)>;
+
+    /**
+     * @brief Asigna el motor de comprobación usado por connectToDevice().
+     * Los resultados se entregan con applyProbeResult() (por ejemplo, conectándolo a
+     * ProbeEngine::resultReady()).
+     * @param requester Función de comprobación (vacía para desactivarla).
+     */
+    void setProbeRequester(const ProbeRequester &requester);
+
+    /**
+     * @brief Comprueba si el dispositivo es alcanzable en su dirección IP.
+     * La comprobación es asíncrona: el resultado llega con applyProbeResult(), que emite
+     * deviceConnected() o errorOccurred().
+     * @return true si ya estaba conectado o la comprobación se solicitó; false si la IP
+     *         está vacía o no hay motor de comprobación asignado.
      */
     bool connectToDevice();
 
+    /**
+     * @brief Actualiza el estado de conexión con el resultado de una comprobación de ProbeEngine.
+     * Emite deviceConnected() si el dispositivo respondió y errorOccurred() si no,
+     * además de statusChanged() con el texto del estado. Se ignoran los resultados de
+     * otros dispositivos.
+     * @param result Resultado de la comprobación.
+     */
+    void applyProbeResult(const ProbeResult &result);
+
     /**
      * @brief Cierra la conexión activa con el dispositivo.
      */
     void disconnectDevice();
 
+    /**
+     * @brief Función que encola un comando: recibe el ID, la IP y el texto del comando y
+     * devuelve el identificador asignado (0 si se rechazó). Normalmente envuelve
+     * CommandPipeline::submit(); así Device no depende del módulo de red.
+     */
+    using CommandSender = std::function<quint64(int deviceId, const QString &host, const QString &command)>;
+
+    /**
+     * @brief Asigna la cola de comandos salientes usada por sendData().
+     * Los resultados se entregan con applyCommandResult() (por ejemplo, conectándolo a
+     * CommandPipeline::commandFinished()).
+     * @param sender Función de envío (vacía para desactivarla).
+     */
+    void setCommandSender(const CommandSender &sender);
+
+    /**
+     * @brief Traduce el resultado de un comando a las señales del dispositivo.
+     * Las respuestas llegan por dataReceived() y los fallos por errorOccurred(); se ignoran
+     * los resultados de otros dispositivos.
+     * @param result Resultado emitido por la cola de comandos.
+     */
+    void applyCommandResult(const CommandResult &result);
+
     /**
      * @brief Envía datos al dispositivo conectado.
+     *
+     * Con una cola asignada (setCommandSender()) el comando se encola para su conexión
+     * persistente: las escrituras "clave=valor" pendientes de la misma clave se fusionan y,
+     * si la cola del dispositivo está llena, el comando se rechaza (el llamador debe esperar
+     * a CommandPipeline::writable()). Sin cola, solo se registra en el log de depuración.
+     *
      * @param data Cadena de texto con los datos o comandos a enviar.
+     * @return true si el comando se aceptó, false si está desconectado o la cola está llena.
      */
-    void sendData(const QString &data);
+    bool sendData(const QString &data);
 
     /**
      * @brief Verifica el estado actual de la conexión.
@@ -171,6 +231,8 @@ private:
 
     // --- VARIABLES DE ESTADO ---
     bool m_isConnected;   /**< Bandera de estado de conexión. */
+    CommandSender m_sender; /**< Envío a la cola de comandos salientes (opcional). */
+    ProbeRequester m_prober; /**< Comprobación de alcance (opcional). */
 };
 
 #endif // DEVICE_H
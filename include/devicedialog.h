@@ -12,7 +12,7 @@ class DeviceDialog;
  * @brief Diálogo modal para la creación y edición de dispositivos.
  *
  * Esta clase gestiona la interfaz gráfica donde el usuario ingresa los datos
- * (Nombre, Tipo, IP, Calibración). Incluye validaciones de entrada (como Regex para IP)
+ * (Nombre, Tipo, IP, Calibración). Incluye validaciones de entrada (IPv4 o IPv6 mediante IpAddress)
  * y permite rellenar los campos automáticamente si se está en modo edición.
  */
 class DeviceDialog : public QDialog
@@ -22,7 +22,7 @@ class DeviceDialog : public QDialog
 public:
     /**
      * @brief Constructor de la clase DeviceDialog.
-     * Configura la interfaz y aplica validadores (ej. QRegularExpressionValidator para IP).
+     * Configura la interfaz y aplica validadores (ej. validador de IP basado en IpAddress).
      * @param parent Widget padre (opcional).
      */
     explicit DeviceDialog(QWidget *parent = nullptr);
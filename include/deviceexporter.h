@@ -0,0 +1,114 @@
+#ifndef DEVICEEXPORTER_H
+#define DEVICEEXPORTER_H
+
+#include <QObject>
+#include <QString>
+#include <QThread>
+#include <QMetaType>
+#include <atomic>
+#include "connectionpool.h"
+
+/**
+ * @brief Resultado y métricas de una exportación a CSV.
+ */
+struct ExportStats
+{
+    qint64 rowsExported = 0;  /**< Filas escritas en el archivo. */
+    qint64 bytesWritten = 0;  /**< Tamaño final del archivo en bytes. */
+    qint64 elapsedMs = 0;     /**< Duración total de la exportación en milisegundos. */
+    bool cancelled = false;   /**< true si el usuario canceló (el archivo no se crea). */
+    QString fileName;         /**< Ruta del archivo de destino. */
+    QString error;            /**< Descripción del error fatal (vacío si no hubo). */
+};
+
+Q_DECLARE_METATYPE(ExportStats)
+
+/**
+ * @brief Motor de exportación de dispositivos a CSV en segundo plano.
+ *
+ * Recorre la tabla 'devices' con un cursor de solo avance (QSqlQuery forward-only)
+ * sobre la conexión de solo lectura de su hilo, dentro de una transacción de lectura que
+ * garantiza una instantánea consistente aunque se sigan editando dispositivos.
+ * Las filas se formatean directamente a bytes en un búfer acotado que se vuelca
+ * al disco por bloques, por lo que la memoria usada no depende del tamaño de la tabla.
+ */
+class DeviceExporter : public QObject
+{
+    Q_OBJECT
+
+public:
+    /**
+     * @brief Constructor de la clase DeviceExporter.
+     * @param pool Pool de conexiones de la base de datos a exportar.
+     * @param parent Objeto padre opcional.
+     */
+    explicit DeviceExporter(ConnectionPool *pool, QObject *parent = nullptr);
+
+    /**
+     * @brief Destructor de la clase.
+     * Cancela la exportación en curso y espera a que el hilo de trabajo termine.
+     */
+    ~DeviceExporter();
+
+    /**
+     * @brief Condición WHERE aplicada a la consulta (la misma que el filtro de la tabla).
+     * @param where Expresión SQL sin la palabra WHERE; vacía para exportar todo.
+     */
+    void setFilter(const QString &where);
+
+    /**
+     * @brief Tamaño del búfer de escritura; se vuelca al disco al llenarse.
+     * @param bytes Capacidad en bytes (mínimo 4 KiB).
+     */
+    void setBufferSize(int bytes);
+
+    /**
+     * @brief Inicia la exportación en segundo plano.
+     * El resultado se notifica mediante la señal finished().
+     * @param fileName Ruta del archivo CSV a generar.
+     * @return false si ya hay una exportación en curso.
+     */
+    bool start(const QString &fileName);
+
+    /**
+     * @brief Solicita la cancelación; el archivo parcial se descarta.
+     */
+    void cancel();
+
+    /**
+     * @brief Indica si hay una exportación en curso.
+     * @return true mientras el hilo de trabajo siga activo.
+     */
+    bool isRunning() const;
+
+signals:
+    /**
+     * @brief Progreso de la exportación (emitida desde el hilo de trabajo).
+     * @param rowsExported Filas escritas hasta el momento.
+     * @param rowsTotal Total de filas de la instantánea.
+     */
+    void progress(qint64 rowsExported, qint64 rowsTotal);
+
+    /**
+     * @brief Señal emitida al terminar (con éxito, error o cancelación).
+     * @param stats Métricas finales de la exportación.
+     */
+    void finished(const ExportStats &stats);
+
+private:
+    /**
+     * @brief Cuerpo de la exportación, ejecutado en el hilo de trabajo.
+     * @param fileName Ruta del archivo de destino.
+     * @param where Filtro SQL capturado al iniciar.
+     * @return Métricas de la exportación.
+     */
+    ExportStats run(const QString &fileName, const QString &where);
+
+    ConnectionPool *m_pool;      /**< Pool de conexiones (una por hilo). */
+    QString m_filter;            /**< Filtro WHERE de la exportación. */
+    int m_bufferSize;            /**< Capacidad del búfer de escritura. */
+    QThread *m_thread;           /**< Hilo de trabajo de la exportación activa. */
+    std::atomic<bool> m_cancel;  /**< Bandera de cancelación solicitada. */
+};
+
+#endif // DEVICEEXPORTER_H
@@ -0,0 +1,135 @@
+#ifndef DEVICEIMPORTER_H
+#define DEVICEIMPORTER_H
+
+#include <QObject>
+#include <QString>
+#include <QThread>
+#include <QThreadPool>
+#include <QMetaType>
+#include <atomic>
+#include "connectionpool.h"
+
+/**
+ * @brief Resultado y métricas de una importación masiva de dispositivos.
+ */
+struct ImportStats
+{
+    qint64 rowsRead = 0;      /**< Filas de datos leídas del archivo (sin encabezado). */
+    qint64 rowsImported = 0;  /**< Filas confirmadas (COMMIT) en la base de datos. */
+    qint64 rowsRejected = 0;  /**< Filas descartadas por formato o IP inválida. */
+    qint64 elapsedMs = 0;     /**< Duración total de la importación en milisegundos. */
+    bool cancelled = false;   /**< true si el usuario canceló la operación. */
+    QString error;            /**< Descripción del error fatal (vacío si no hubo). */
+
+    /**
+     * @brief Rendimiento de la importación.
+     * @return Filas importadas por segundo (0 si no hubo tiempo medible).
+     */
+    double rowsPerSecond() const;
+};
+
+Q_DECLARE_METATYPE(ImportStats)
+
+/**
+ * @brief Importador masivo de dispositivos desde archivos CSV.
+ *
+ * Es la operación inversa de la exportación de MainWindow: lee el mismo formato
+ * separado por ';' (ID;Usuario_ID;Nombre;Tipo;IP;Calibracion). El archivo se procesa
+ * en bloques que se analizan en paralelo en un pool de hilos, mientras un hilo de
+ * trabajo inserta los resultados en orden usando una única sentencia preparada y
+ * transacciones grandes sobre la conexión de escritura de su hilo. El escritor del
+ * pool se retiene solo durante cada lote, por lo que la interfaz puede seguir
+ * guardando cambios entre lotes.
+ *
+ * Las IP (IPv4 o IPv6) se validan con el analizador de IpAddress, que recorre los
+ * bytes una sola vez sin asignar memoria, y se guardan junto a su clave 'ip_key'.
+ */
+class DeviceImporter : public QObject
+{
+    Q_OBJECT
+
+public:
+    /**
+     * @brief Constructor de la clase DeviceImporter.
+     * @param pool Pool de conexiones de la base de datos donde se insertarán los dispositivos.
+     * @param parent Objeto padre opcional.
+     */
+    explicit DeviceImporter(ConnectionPool *pool, QObject *parent = nullptr);
+
+    /**
+     * @brief Destructor de la clase.
+     * Cancela la importación en curso y espera a que el hilo de trabajo termine.
+     */
+    ~DeviceImporter();
+
+    /**
+     * @brief Usuario asignado a las filas cuya columna Usuario_ID esté vacía o sea inválida.
+     * @param userId ID del usuario propietario por defecto.
+     */
+    void setDefaultUserId(int userId);
+
+    /**
+     * @brief Número de filas por transacción (COMMIT).
+     * @param rows Tamaño del lote (mínimo 1).
+     */
+    void setBatchSize(int rows);
+
+    /**
+     * @brief Tamaño aproximado de cada bloque de lectura que se analiza en paralelo.
+     * @param bytes Tamaño del bloque en bytes (mínimo 4 KiB).
+     */
+    void setChunkSize(int bytes);
+
+    /**
+     * @brief Inicia la importación del archivo en segundo plano.
+     * El resultado se notifica mediante la señal finished().
+     * @param fileName Ruta del archivo CSV a importar.
+     * @return false si ya hay una importación en curso.
+     */
+    bool start(const QString &fileName);
+
+    /**
+     * @brief Solicita la cancelación de la importación en curso.
+     * El lote que no se haya confirmado se revierte (ROLLBACK).
+     */
+    void cancel();
+
+    /**
+     * @brief Indica si hay una importación en curso.
+     * @return true mientras el hilo de trabajo siga activo.
+     */
+    bool isRunning() const;
+
+signals:
+    /**
+     * @brief Progreso de la importación (emitida desde el hilo de trabajo).
+     * @param bytesProcessed Bytes del archivo ya insertados.
+     * @param bytesTotal Tamaño total del archivo.
+     * @param rowsImported Filas insertadas hasta el momento.
+     */
+    void progress(qint64 bytesProcessed, qint64 bytesTotal, qint64 rowsImported);
+
+    /**
+     * @brief Señal emitida al terminar (con éxito, error o cancelación).
+     * @param stats Métricas finales de la importación.
+     */
+    void finished(const ImportStats &stats);
+
+private:
+    /**
+     * @brief Cuerpo de la importación, ejecutado en el hilo de trabajo.
+     * @param fileName Ruta del archivo CSV.
+     * @return Métricas de la importación.
+     */
+    ImportStats run(const QString &fileName);
+
+    ConnectionPool *m_pool;           /**< Pool de conexiones (una por hilo). */
+    int m_defaultUserId;              /**< Propietario por defecto de las filas. */
+    int m_batchSize;                  /**< Filas por transacción. */
+    int m_chunkSize;                  /**< Bytes por bloque de análisis. */
+    QThread *m_thread;                /**< Hilo de trabajo de la importación activa. */
+    QThreadPool m_parsePool;          /**< Pool dedicado al análisis de bloques. */
+    std::atomic<bool> m_cancel;       /**< Bandera de cancelación solicitada. */
+};
+
+#endif // DEVICEIMPORTER_H
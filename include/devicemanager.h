@@ -3,13 +3,45 @@
 
 #include <QObject>
 #include <QList>
+#include <QByteArray>
+#include <QMetaType>
+#include <functional>
 #include "device.h"
+#include "devicerecord.h"
+#include "probeengine.h"
+
+/**
+ * @brief Cambio a nivel de fila producido por una operación CRUD.
+ *
+ * Permite a las vistas aplicar actualizaciones puntuales (insertar, modificar o
+ * eliminar una fila) sin volver a leer la tabla completa.
+ */
+struct DeviceChange
+{
+    /**
+     * @brief Tipo de operación.
+     */
+    enum Kind {
+        Inserted,  /**< Dispositivo nuevo (values contiene los datos guardados). */
+        Updated,   /**< Dispositivo modificado (previous contiene los datos anteriores). */
+        Removed    /**< Dispositivo eliminado (values contiene los datos que tenía). */
+    };
+
+    Kind kind = Inserted;   /**< Operación realizada. */
+    DeviceRecord values;    /**< Valores actuales (o eliminados), incluido el ID. */
+    DeviceRecord previous;  /**< Valores antes de la modificación (solo Updated). */
+};
+
+Q_DECLARE_METATYPE(DeviceChange)
 
 /**
  * @brief Clase controladora encargada de la lógica de negocio y gestión de datos de los dispositivos.
  *
  * Actúa como intermediaria entre la interfaz gráfica y la base de datos (Data Access Object).
  * Implementa las operaciones CRUD (Create, Read, Update, Delete) completas.
+ *
+ * Usa las conexiones del hilo que la llama (ver DatabaseManager::pool()): las lecturas
+ * van por la conexión de solo lectura y las escrituras se serializan con el escritor del pool.
  */
 class DeviceManager : public QObject
 {
@@ -25,7 +57,7 @@ public:
      * @brief Inserta un nuevo dispositivo en la base de datos.
      *
      * Toma los datos del objeto Device proporcionado (nombre, tipo, ip, calibración, userId)
-     * y ejecuta la sentencia SQL INSERT.
+     * y ejecuta la sentencia SQL INSERT. El ID generado se asigna al objeto.
      *
      * @param device Puntero al objeto Device con la información a guardar.
      * @return true si la inserción en la BD fue exitosa, false si hubo error SQL.
@@ -46,6 +78,67 @@ public:
      */
     QList<Device*> getDevicesByUser(int userId);
 
+    /**
+     * @brief Recupera los dispositivos de un usuario como registros por valor.
+     *
+     * Alternativa a getDevicesByUser() sin objetos en el heap ni liberación manual:
+     * los registros se guardan de forma contigua y los valores de 'type' se internan,
+     * por lo que todas las filas del mismo tipo comparten una única cadena.
+     *
+     * @param userId El ID del usuario del cual se quieren obtener los dispositivos.
+     * @return Lista de registros (vacía si hubo error).
+     */
+    QList<DeviceRecord> getDeviceRecordsByUser(int userId);
+
+    /**
+     * @brief Recorre los dispositivos de un usuario sin construir ninguna lista.
+     *
+     * Llama al visitante una vez por fila con un registro reutilizado; si necesita
+     * conservarlo debe copiarlo. El recorrido se detiene cuando el visitante devuelve false.
+     * La sentencia es propia del recorrido (no la cacheada del pool), así que el visitante
+     * puede volver a consultar la base de datos, incluso a este mismo método.
+     *
+     * @param userId El ID del usuario del cual se quieren recorrer los dispositivos.
+     * @param visitor Función llamada por cada fila; devuelve false para detenerse.
+     * @return Número de filas visitadas, o -1 si la consulta falló.
+     */
+    int forEachDeviceOfUser(int userId, const std::function<bool(const DeviceRecord &)> &visitor);
+
+    /**
+     * @brief Recupera los dispositivos cuya IP pertenece a una subred (IPv4 o IPv6).
+     *
+     * Convierte la subred en un rango sobre la columna indexada 'ip_key', por lo que
+     * la consulta no recorre la tabla completa. El resultado se ordena por IP.
+     *
+     * @warning Igual que getDevicesByUser(), el llamador debe eliminar (delete) los objetos.
+     *
+     * @param cidr Subred en notación CIDR (ej. "10.20.0.0/16", "2001:db8::/32").
+     * @return Lista de punteros a Device (vacía si la subred no es válida).
+     */
+    QList<Device*> getDevicesInSubnet(const QString &cidr);
+
+    /**
+     * @brief Objetivos de comprobación de alcance (ID e IP) de los dispositivos de un filtro.
+     * Solo lee dos columnas por fila, por lo que sirve para flotas completas.
+     * @param where Condición WHERE del modelo (sin la palabra WHERE; vacía para todos).
+     * @return Lista de objetivos con el puerto por defecto del motor.
+     */
+    QList<ProbeTarget> getProbeTargets(const QString &where);
+
+    /**
+     * @brief Construye la condición WHERE de una subred para filtrar modelos SQL.
+     * @param cidr Subred en notación CIDR o una IP individual.
+     * @return Condición sobre 'ip_key', o cadena vacía si el texto no es una subred.
+     */
+    static QString subnetFilter(const QString &cidr);
+
+    /**
+     * @brief Calcula el valor de la columna 'ip_key' para una IP en texto.
+     * @param ip Dirección IPv4 o IPv6.
+     * @return Clave binaria de 16 bytes, o vacía si la IP no es válida.
+     */
+    static QByteArray ipSortKey(const QString &ip);
+
     /**
      * @brief Actualiza la información de un dispositivo existente.
      *
@@ -67,9 +160,22 @@ public:
 signals:
     /**
      * @brief Señal emitida cuando ocurre cualquier cambio en la lista de dispositivos.
-     * Útil para notificar a la interfaz que debe refrescar la tabla.
+     * Transporta los cambios fila a fila para que la interfaz actualice solo las filas afectadas.
+     * @param changes Cambios aplicados, en el orden en que se realizaron.
      */
-    void deviceListChanged();
+    void deviceListChanged(const QList<DeviceChange> &changes);
+
+private:
+    /**
+     * @brief Lee los valores actuales de un dispositivo por su ID (clave primaria).
+     * Debe llamarse con el WriteLock del pool adquirido (se usa la conexión de escritura).
+     * @param deviceId ID del dispositivo.
+     * @param values Recibe los valores leídos.
+     * @return true si el dispositivo existe.
+     */
+    bool fetchValues(int deviceId, DeviceRecord *values);
+
+    StringInterner m_types;  /**< Valores de 'type' compartidos entre registros. */
 };
 
 #endif // DEVICEMANAGER_H
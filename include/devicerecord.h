@@ -0,0 +1,67 @@
+#ifndef DEVICERECORD_H
+#define DEVICERECORD_H
+
+#include <QString>
+#include <QSet>
+#include <QMetaType>
+
+/**
+ * @brief Registro de dispositivo como tipo valor (copiable y movible).
+ *
+ * Es la contraparte ligera de Device: no hereda de QObject, por lo que puede guardarse
+ * de forma contigua en un QList/QVector, copiarse y moverse sin reservar memoria por
+ * objeto. Se usa en las lecturas masivas de DeviceManager, en el modelo de la tabla y
+ * en los cambios emitidos por DeviceManager::deviceListChanged().
+ */
+struct DeviceRecord
+{
+    int id = -1;               /**< ID único en la base de datos. */
+    int userId = -1;           /**< ID del usuario dueño. */
+    QString name;              /**< Nombre descriptivo. */
+    QString type;              /**< Tipo de dispositivo (normalmente internado). */
+    QString ip;                /**< Dirección IP en texto. */
+    double calibration = 0.0;  /**< Valor de ajuste de calibración. */
+};
+
+Q_DECLARE_TYPEINFO(DeviceRecord, Q_RELOCATABLE_TYPE);
+Q_DECLARE_METATYPE(DeviceRecord)
+
+/**
+ * @brief Tabla de internado de cadenas.
+ *
+ * Devuelve siempre la misma instancia compartida (copy-on-write) para textos iguales.
+ * Las columnas con pocos valores distintos, como 'type' ("Sensor", "Actuador"...),
+ * pasan así de una reserva de memoria por fila a una por valor distinto.
+ */
+class StringInterner
+{
+public:
+    /**
+     * @brief Obtiene la instancia compartida de un texto.
+     * @param text Texto a internar.
+     * @return Copia que comparte datos con la instancia almacenada.
+     */
+    QString intern(const QString &text)
+    {
+        auto it = m_pool.constFind(text);
+        if (it != m_pool.constEnd()) return *it;
+        m_pool.insert(text);
+        return text;
+    }
+
+    /**
+     * @brief Número de textos distintos almacenados.
+     * @return Tamaño de la tabla.
+     */
+    qsizetype size() const { return m_pool.size(); }
+
+    /**
+     * @brief Vacía la tabla de internado.
+     */
+    void clear() { m_pool.clear(); }
+
+private:
+    QSet<QString> m_pool;  /**< Instancias compartidas de cada texto distinto. */
+};
+
+#endif // DEVICERECORD_H
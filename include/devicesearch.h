@@ -0,0 +1,140 @@
+#ifndef DEVICESEARCH_H
+#define DEVICESEARCH_H
+
+#include <QObject>
+#include <QString>
+#include <QList>
+#include <QTimer>
+#include <QThread>
+#include <atomic>
+#include <functional>
+#include "connectionpool.h"
+
+/**
+ * @brief Subsistema de búsqueda de dispositivos basado en el índice FTS5 'devices_fts'.
+ *
+ * La tabla virtual 'devices_fts' se mantiene sincronizada con 'devices' mediante
+ * triggers (ver DatabaseManager::migrateSchema). Cada texto introducido se convierte
+ * en una expresión MATCH por prefijos que se ejecuta como consulta parametrizada en
+ * un hilo propio con su conexión de solo lectura.
+ *
+ * Las pulsaciones se agrupan con un temporizador (debounce) y cada nueva búsqueda
+ * invalida las anteriores: las consultas obsoletas que aún estén en cola se descartan
+ * sin ejecutarse y sus resultados nunca se emiten.
+ */
+class DeviceSearch : public QObject
+{
+    Q_OBJECT
+
+public:
+    /**
+     * @brief Constructor de la clase DeviceSearch.
+     * @param pool Pool de conexiones de la base de datos a consultar.
+     * @param parent Objeto padre opcional.
+     */
+    explicit DeviceSearch(ConnectionPool *pool, QObject *parent = nullptr);
+
+    /**
+     * @brief Destructor de la clase.
+     * Cierra la conexión del hilo de búsqueda y espera a que termine.
+     */
+    ~DeviceSearch();
+
+    /**
+     * @brief Tiempo de espera tras la última pulsación antes de lanzar la consulta.
+     * @param ms Intervalo en milisegundos.
+     */
+    void setDebounceInterval(int ms);
+
+    /**
+     * @brief Número máximo de IDs devueltos por búsqueda.
+     * Acota el costo de cada consulta independientemente del tamaño de la tabla.
+     * @param limit Máximo de resultados (mínimo 1).
+     */
+    void setResultLimit(int limit);
+
+    /**
+     * @brief Programa una búsqueda (con debounce) que reemplaza a cualquier búsqueda previa.
+     * @param text Texto introducido por el usuario.
+     */
+    void search(const QString &text);
+
+    /**
+     * @brief Descarta la búsqueda pendiente y las que estén en curso.
+     */
+    void cancel();
+
+    /**
+     * @brief Convierte texto libre en una expresión MATCH de FTS5 por prefijos.
+     *
+     * Cada palabra se entrecomilla (escapando comillas dobles) y se marca como prefijo,
+     * por ejemplo "sensor 192.168" produce: "sensor"* "192.168"*
+     * El resultado se pasa siempre como parámetro enlazado, nunca concatenado al SQL.
+     *
+     * @param text Texto introducido por el usuario.
+     * @return Expresión MATCH, o cadena vacía si no hay términos.
+     */
+    static QString buildMatchExpression(const QString &text);
+
+    /**
+     * @brief Comprueba si la base de datos tiene el índice FTS5 'devices_fts'.
+     * @param db Conexión abierta.
+     * @return true si el índice existe.
+     */
+    static bool hasFtsIndex(QSqlDatabase db);
+
+    /**
+     * @brief IDs de los dispositivos que coinciden con un texto, en orden ascendente.
+     *
+     * Con FTS5 busca por prefijos (buildMatchExpression()); sin él, por subcadena en el
+     * nombre y la IP con LIKE parametrizado. Es síncrona: la usan el hilo de búsqueda y
+     * la línea de órdenes.
+     *
+     * @param db Conexión de lectura del hilo que llama.
+     * @param text Texto buscado.
+     * @param fts Usar el índice FTS5 (ver hasFtsIndex()).
+     * @param limit Máximo de resultados (0 = sin límite).
+     * @param ids Recibe los IDs.
+     * @param truncated Recibe true si había más de limit coincidencias (opcional).
+     * @param cancelled Se consulta cada 256 filas; si devuelve true se deja de leer (opcional).
+     * @return false si la consulta falló o se canceló.
+     */
+    static bool findIds(QSqlDatabase db, const QString &text, bool fts, int limit, QList<int> *ids,
+                        bool *truncated = nullptr, const std::function<bool()> &cancelled = {});
+
+signals:
+    /**
+     * @brief Resultados de la búsqueda más reciente.
+     * @param text Texto buscado.
+     * @param ids IDs de los dispositivos coincidentes en orden ascendente.
+     * @param truncated true si se alcanzó el límite de resultados.
+     */
+    void resultsReady(const QString &text, const QList<int> &ids, bool truncated);
+
+private slots:
+    /**
+     * @brief Envía al hilo de búsqueda el texto pendiente al vencer el debounce.
+     */
+    void dispatch();
+
+private:
+    /**
+     * @brief Ejecuta la consulta en el hilo de búsqueda.
+     * @param generation Generación de la búsqueda; se descarta si ya no es la vigente.
+     * @param text Texto buscado.
+     * @param limit Máximo de resultados.
+     */
+    void execute(quint64 generation, const QString &text, int limit);
+
+    ConnectionPool *m_pool;             /**< Pool de conexiones (una por hilo). */
+    QString m_pendingText;              /**< Texto que espera a que venza el debounce. */
+    int m_limit;                        /**< Máximo de resultados por búsqueda. */
+    bool m_connected;                   /**< FTS5 ya comprobado (solo se usa en el hilo). */
+    bool m_ftsAvailable;                /**< FTS5 disponible (solo se usa en el hilo). */
+    QTimer m_debounce;                  /**< Temporizador de agrupación de pulsaciones. */
+    QThread m_thread;                   /**< Hilo dedicado a las consultas. */
+    QObject *m_context;                 /**< Objeto de contexto que vive en m_thread. */
+    std::atomic<quint64> m_generation;  /**< Generación de la búsqueda vigente. */
+};
+
+#endif // DEVICESEARCH_H
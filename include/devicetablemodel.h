@@ -0,0 +1,281 @@
+#ifndef DEVICETABLEMODEL_H
+#define DEVICETABLEMODEL_H
+
+#include <QAbstractTableModel>
+#include <QSqlDatabase>
+#include <QSqlQuery>
+#include <QHash>
+#include <QMap>
+#include <QVector>
+#include <QVariant>
+#include "devicemanager.h"
+#include "devicerecord.h"
+#include "probeengine.h"
+
+/**
+ * @brief Modelo virtualizado de la tabla 'devices' para flotas de millones de filas.
+ *
+ * A diferencia de QSqlTableModel, que acumula en memoria todas las filas ya recorridas,
+ * mantiene solo una ventana deslizante de páginas. Cada página se obtiene por
+ * "keyset" (columna de orden indexada + id) en lugar de OFFSET, guardando la clave de la
+ * primera fila de cada página visitada como ancla. Los saltos a zonas no visitadas se
+ * resuelven con un único desplazamiento desde el ancla más cercana o desde el final.
+ *
+ * Al desplazarse se precarga la página siguiente en la dirección del movimiento y se
+ * descartan las páginas más alejadas, por lo que la memoria usada es aproximadamente
+ * constante sea cual sea el tamaño de la flota.
+ *
+ * @note Las columnas de orden no deben contener NULL (las inserciones siempre las rellenan).
+ */
+class DeviceTableModel : public QAbstractTableModel
+{
+    Q_OBJECT
+
+public:
+    /**
+     * @brief Columnas expuestas, en el mismo orden que la tabla y la exportación CSV.
+     * ColStatus no existe en la BD ni se exporta: la rellena setProbeResult().
+     */
+    enum Column {
+        ColId = 0,        /**< ID del dispositivo (oculta en la vista). */
+        ColUserId,        /**< ID del usuario propietario (oculta en la vista). */
+        ColName,          /**< Nombre. */
+        ColType,          /**< Tipo. */
+        ColIp,            /**< Dirección IP (se ordena por 'ip_key'). */
+        ColCalibration,   /**< Calibración. */
+        ColStatus,        /**< Estado de la última comprobación de alcance (no ordenable). */
+        ColumnCount
+    };
+
+    /**
+     * @brief Constructor de la clase DeviceTableModel.
+     * @param db Conexión a usar (debe pertenecer al hilo de la interfaz).
+     * @param parent Objeto padre opcional.
+     */
+    explicit DeviceTableModel(const QSqlDatabase &db, QObject *parent = nullptr);
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    int columnCount(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+    QVariant headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const override;
+
+    /**
+     * @brief Cambia el orden de la vista (sin releer filas: solo se invalida la caché).
+     * @param column Columna de orden (ver Column).
+     * @param order Orden ascendente o descendente.
+     */
+    void sort(int column, Qt::SortOrder order = Qt::AscendingOrder) override;
+
+    /**
+     * @brief Establece la condición WHERE aplicada a todas las consultas.
+     * No recarga el modelo: hay que llamar a select() después (igual que QSqlTableModel).
+     * @param where Expresión SQL sin la palabra WHERE; vacía para ver todos los dispositivos.
+     * @param params Valores para los marcadores '?' de la expresión, en orden.
+     */
+    void setFilter(const QString &where, const QVariantList &params = QVariantList());
+
+    /**
+     * @brief Obtiene la condición WHERE actual.
+     * @return Expresión SQL del filtro (vacía si no hay filtro).
+     */
+    QString filter() const;
+
+    /**
+     * @brief Recalcula el número de filas y descarta la caché de páginas y anclas.
+     * @return true si el conteo se realizó correctamente.
+     */
+    bool select();
+
+    /**
+     * @brief Obtiene el ID del dispositivo mostrado en una fila.
+     * @param row Fila de la vista.
+     * @return ID del dispositivo, o -1 si la fila no existe.
+     */
+    int deviceIdAt(int row) const;
+
+    /**
+     * @brief Número de filas por página (afecta a la próxima llamada a select()).
+     * @param rows Filas por página (mínimo 16).
+     */
+    void setPageSize(int rows);
+
+    /**
+     * @brief Número máximo de páginas que se mantienen en memoria.
+     * @param pages Páginas en caché (mínimo 2).
+     */
+    void setMaxCachedPages(int pages);
+
+public slots:
+    /**
+     * @brief Aplica cambios fila a fila emitidos por DeviceManager::deviceListChanged().
+     *
+     * Cada cambio se traduce en rowsInserted / dataChanged / rowsRemoved sobre la posición
+     * afectada, de modo que la vista conserva la selección y el desplazamiento. Solo se
+     * descartan de la caché las páginas posteriores a la fila modificada.
+     *
+     * @param changes Cambios realizados en la tabla 'devices'.
+     */
+    void applyChanges(const QList<DeviceChange> &changes);
+
+    /**
+     * @brief Guarda el resultado de una comprobación y repinta la celda de estado si está visible.
+     * @param result Resultado emitido por ProbeEngine::resultReady().
+     */
+    void setProbeResult(const ProbeResult &result);
+
+    /**
+     * @brief Olvida todos los estados de comprobación (la columna queda vacía).
+     */
+    void clearProbeResults();
+
+private:
+    /**
+     * @brief Página de filas consecutivas en caché.
+     */
+    struct Page
+    {
+        QVector<DeviceRecord> rows;
+        quint64 lastUse = 0;
+    };
+
+    /**
+     * @brief Clave (valor de orden + id) de la primera fila de una página.
+     */
+    struct Anchor
+    {
+        QVariant key;
+        int id;
+    };
+
+    /**
+     * @brief Devuelve la fila solicitada cargando su página si es necesario.
+     * @param row Fila de la vista.
+     * @return Puntero a la fila en caché, o nullptr si no se pudo cargar.
+     */
+    const DeviceRecord *rowAt(int row) const;
+
+    /**
+     * @brief Carga una página completa a partir de su ancla.
+     * @param page Índice de página.
+     * @return true si la página quedó en caché.
+     */
+    bool loadPage(int page) const;
+
+    /**
+     * @brief Obtiene (o calcula) el ancla de una página.
+     * @param page Índice de página (mayor que 0).
+     * @param anchor Recibe el ancla encontrada.
+     * @return true si se pudo determinar el ancla.
+     */
+    bool findAnchor(int page, Anchor *anchor) const;
+
+    /**
+     * @brief Programa la precarga de una página fuera de la ruta de pintado.
+     * @param page Índice de página a precargar.
+     */
+    void schedulePrefetch(int page) const;
+
+    /**
+     * @brief Descarta las páginas más alejadas de la página actual.
+     * @param current Página que se está mostrando.
+     */
+    void evictPages(int current) const;
+
+    /**
+     * @brief Refleja en la vista la inserción de un dispositivo ya guardado en la BD.
+     * @param id ID del dispositivo.
+     * @param values Valores del dispositivo.
+     */
+    void applyInsert(int id, const DeviceRecord &values);
+
+    /**
+     * @brief Refleja en la vista la eliminación de un dispositivo.
+     * @param id ID del dispositivo.
+     * @param values Valores que tenía el dispositivo (para ubicar su fila).
+     */
+    void applyRemove(int id, const DeviceRecord &values);
+
+    /**
+     * @brief Evalúa el filtro actual sobre unos valores sin leer la tabla.
+     * @param id ID del dispositivo.
+     * @param values Valores a evaluar.
+     * @return true si la fila sería visible con el filtro actual.
+     */
+    bool matchesFilter(int id, const DeviceRecord &values) const;
+
+    /**
+     * @brief Valor de la clave de orden actual para unos valores.
+     * @param id ID del dispositivo.
+     * @param values Valores del dispositivo.
+     * @return Valor comparable con la columna de orden.
+     */
+    QVariant sortKeyOf(int id, const DeviceRecord &values) const;
+
+    /**
+     * @brief Posición que ocupa (u ocuparía) una clave en el orden actual.
+     * Cuenta las filas visibles anteriores, excluyendo al propio dispositivo.
+     * @param id ID del dispositivo.
+     * @param key Clave de orden del dispositivo.
+     * @return Índice de fila, o -1 si hubo error.
+     */
+    int positionOf(int id, const QVariant &key) const;
+
+    /**
+     * @brief Busca un dispositivo entre las páginas en caché.
+     * @param id ID del dispositivo.
+     * @return Índice de fila, o -1 si no está en caché.
+     */
+    int cachedRowOf(int id) const;
+
+    /**
+     * @brief Descarta páginas y anclas a partir de una fila cuyo contenido se desplazó.
+     * @param row Primera fila afectada.
+     */
+    void invalidateFrom(int row);
+
+    /**
+     * @brief Expresión SQL de la columna de orden actual.
+     * @return Nombre de la columna de la tabla usada como clave de orden.
+     */
+    QString sortKeySql() const;
+
+    /**
+     * @brief Construye la cláusula WHERE con el filtro y, opcionalmente, la condición del ancla.
+     * @param withAnchor true para añadir la comparación por keyset.
+     * @return Cláusula WHERE (con la palabra clave) o cadena vacía.
+     */
+    QString whereSql(bool withAnchor) const;
+
+    /**
+     * @brief Construye la cláusula ORDER BY.
+     * @param reversed true para invertir el orden actual (recorrido desde el final).
+     * @return Cláusula ORDER BY.
+     */
+    QString orderSql(bool reversed) const;
+
+    /**
+     * @brief Enlaza los parámetros del filtro y, opcionalmente, del ancla.
+     * @param query Consulta preparada.
+     * @param anchor Ancla a enlazar, o nullptr.
+     */
+    void bindFilter(QSqlQuery &query, const Anchor *anchor) const;
+
+    QSqlDatabase m_db;             /**< Conexión de la interfaz. */
+    QString m_filter;              /**< Condición WHERE actual. */
+    QVariantList m_filterParams;   /**< Parámetros de la condición WHERE. */
+    int m_sortColumn;              /**< Columna de orden (ver Column). */
+    Qt::SortOrder m_sortOrder;     /**< Dirección del orden. */
+    int m_rowCount;                /**< Filas que cumplen el filtro. */
+    int m_pageSize;                /**< Filas por página. */
+    int m_maxPages;                /**< Máximo de páginas en caché. */
+
+    mutable QHash<int, Page> m_pages;     /**< Ventana deslizante de páginas cargadas. */
+    mutable QMap<int, Anchor> m_anchors;  /**< Anclas conocidas por índice de página. */
+    mutable quint64 m_useCounter;         /**< Reloj lógico para el LRU de páginas. */
+    mutable int m_lastPage;               /**< Última página accedida (dirección de scroll). */
+    mutable int m_prefetchPage;           /**< Página con precarga pendiente (-1 si ninguna). */
+    mutable StringInterner m_types;       /**< Valores de 'type' compartidos entre filas. */
+    QHash<int, ProbeResult> m_probes;     /**< Última comprobación por ID de dispositivo. */
+};
+
+#endif // DEVICETABLEMODEL_H
@@ -0,0 +1,321 @@
+#ifndef HEALTHSCHEDULER_H
+#define HEALTHSCHEDULER_H
+
+#include <QObject>
+#include <QString>
+#include <QList>
+#include <QHash>
+#include <QSet>
+#include <QByteArray>
+#include <QTimer>
+#include <QThread>
+#include <QElapsedTimer>
+#include <QDateTime>
+#include <QRandomGenerator>
+#include <atomic>
+#include "devicemanager.h"
+#include "probeengine.h"
+#include "timingwheel.h"
+
+class ConnectionPool;
+
+/**
+ * @brief Métricas acumuladas del planificador de comprobaciones.
+ */
+struct HealthStats
+{
+    int devices = 0;            /**< Dispositivos planificados. */
+    int failing = 0;            /**< Dispositivos con fallos consecutivos (en espera ampliada). */
+    qint64 probesStarted = 0;   /**< Comprobaciones lanzadas. */
+    qint64 deferred = 0;        /**< Comprobaciones retrasadas por el límite de su subred. */
+    qint64 persisted = 0;       /**< Estados guardados en 'device_health'. */
+    qint64 lastTickUs = 0;      /**< Coste del último avance de la rueda (microsegundos). */
+};
+
+/**
+ * @brief Planificador de comprobaciones periódicas de toda la flota.
+ *
+ * Cada dispositivo se comprueba con su propio intervalo ('device_health.poll_interval',
+ * o el intervalo por defecto). Los plazos viven en una TimingWheel que avanza con un
+ * único temporizador, de modo que el coste por tick no depende del tamaño de la flota.
+ *
+ * Para no saturar la red ni a los propios equipos:
+ *  - cada plazo lleva un desvío aleatorio (jitter) y el primer plazo se reparte por todo
+ *    el intervalo, así los dispositivos no se comprueban todos a la vez;
+ *  - cada subred (/24 en IPv4, /64 en IPv6) tiene un cubo de fichas: si se agota, las
+ *    comprobaciones siguientes reservan su ficha y se reprograman en orden;
+ *  - los dispositivos que no responden duplican su intervalo en cada fallo, hasta el
+ *    máximo configurado, y vuelven al intervalo normal en cuanto responden.
+ *
+ * Las comprobaciones las hace un ProbeEngine propio. El último estado conocido de cada
+ * dispositivo se guarda por lotes en 'device_health' y se recupera al arrancar.
+ * La planificación funciona en el hilo que lo crea (normalmente el de la interfaz); la
+ * lectura de la flota y el guardado de estados se hacen en un hilo propio, de modo que
+ * ni el recorrido de 'devices' ni el bloqueo de escritura frenan ese hilo.
+ */
+class HealthScheduler : public QObject
+{
+    Q_OBJECT
+
+public:
+    /**
+     * @brief Constructor de la clase HealthScheduler.
+     * @param pool Pool de conexiones para leer la flota y guardar los estados.
+     * @param parent Objeto padre opcional.
+     */
+    explicit HealthScheduler(ConnectionPool *pool, QObject *parent = nullptr);
+
+    /**
+     * @brief Destructor de la clase.
+     * Detiene el planificador, guarda los estados pendientes y espera a que se escriban.
+     */
+    ~HealthScheduler();
+
+    /**
+     * @brief Resolución de la rueda (antes de start()).
+     * @param ms Milisegundos por tick (mínimo 10; por defecto 100).
+     */
+    void setTickInterval(int ms);
+
+    /**
+     * @brief Intervalo de los dispositivos sin intervalo propio.
+     * @param seconds Segundos entre comprobaciones (mínimo 1; por defecto 300).
+     */
+    void setDefaultInterval(int seconds);
+
+    /**
+     * @brief Desvío aleatorio aplicado a cada plazo.
+     * @param fraction Fracción del intervalo, en ambos sentidos (0-0.5; por defecto 0.1).
+     */
+    void setJitter(double fraction);
+
+    /**
+     * @brief Límite de comprobaciones por subred.
+     * @param probesPerSecond Ritmo sostenido por subred (por defecto 10).
+     * @param burst Comprobaciones seguidas permitidas tras un periodo de calma (por defecto 20).
+     */
+    void setSubnetRateLimit(double probesPerSecond, int burst);
+
+    /**
+     * @brief Intervalo máximo de los dispositivos que fallan repetidamente.
+     * @param seconds Tope de la espera ampliada (por defecto 3600).
+     */
+    void setMaxBackoff(int seconds);
+
+    /**
+     * @brief Intervalo propio de un dispositivo (se guarda en la base de datos).
+     * @param deviceId ID del dispositivo.
+     * @param seconds Segundos entre comprobaciones (0 = intervalo por defecto).
+     * @return true si se guardó correctamente.
+     */
+    bool setPollInterval(int deviceId, int seconds);
+
+    /**
+     * @brief Motor de comprobación (para ajustar plazo, puerto o concurrencia).
+     * @return Motor propiedad del planificador.
+     */
+    ProbeEngine *engine();
+
+    /**
+     * @brief Empieza a planificar y pide la flota y su último estado.
+     * La flota se lee en segundo plano: al llegar, se programa y se emite resultReady()
+     * con cada estado guardado para que la interfaz lo muestre.
+     */
+    void start();
+
+    /**
+     * @brief Detiene la planificación, aborta las comprobaciones y encola el guardado de
+     * los estados.
+     */
+    void stop();
+
+    /**
+     * @brief Indica si el planificador está activo.
+     * @return true entre start() y stop().
+     */
+    bool isRunning() const;
+
+    /**
+     * @brief Vuelve a leer la flota en segundo plano (tras cambios masivos, como una importación).
+     * Conserva los plazos de los dispositivos que ya estaban planificados.
+     */
+    void reload();
+
+    /**
+     * @brief Último estado conocido de un dispositivo.
+     * @param deviceId ID del dispositivo.
+     * @return Resultado guardado (Unknown si nunca se comprobó).
+     */
+    ProbeResult lastResult(int deviceId) const;
+
+    /**
+     * @brief Métricas acumuladas.
+     * @return Copia de los contadores.
+     */
+    HealthStats stats() const;
+
+public slots:
+    /**
+     * @brief Aplica las altas, cambios de IP y bajas hechas desde la aplicación.
+     * @param changes Cambios emitidos por DeviceManager::deviceListChanged().
+     */
+    void applyChanges(const QList<DeviceChange> &changes);
+
+    /**
+     * @brief Encola el guardado en 'device_health' de los estados cambiados desde el último.
+     * Si la transacción falla, esos dispositivos se vuelven a guardar en el siguiente.
+     */
+    void flush();
+
+signals:
+    /**
+     * @brief Resultado de una comprobación (o estado recuperado al arrancar).
+     * @param result Estado y latencia del dispositivo.
+     */
+    void resultReady(const ProbeResult &result);
+
+private slots:
+    /**
+     * @brief Avanza la rueda según el tiempo transcurrido y lanza los vencidos.
+     */
+    void onTick();
+
+    /**
+     * @brief Registra el resultado, ajusta la espera y reprograma el dispositivo.
+     * @param result Resultado del motor.
+     */
+    void onProbeResult(const ProbeResult &result);
+
+private:
+    /**
+     * @brief Estado de planificación de un dispositivo.
+     */
+    struct Entry
+    {
+        QString host;              /**< IP del dispositivo. */
+        QByteArray subnet;         /**< Clave de su subred (límite de ritmo). */
+        int intervalSec = 0;       /**< Intervalo propio (0 = por defecto). */
+        int failures = 0;          /**< Fallos consecutivos. */
+        bool reserved = false;     /**< Ya tiene ficha de su subred para el próximo vencimiento. */
+        bool inFlight = false;     /**< Comprobación en curso. */
+        ProbeResult last;          /**< Último resultado. */
+        QDateTime checkedAt;       /**< Momento del último resultado. */
+    };
+
+    /**
+     * @brief Cubo de fichas de una subred.
+     */
+    struct Bucket
+    {
+        double tokens = 0.0;       /**< Fichas disponibles (negativo = reservadas a futuro). */
+        qint64 updatedMs = 0;      /**< Última recarga (reloj del planificador). */
+    };
+
+    /**
+     * @brief Fila de la flota leída o estado a guardar.
+     */
+    struct Stored
+    {
+        int deviceId = 0;          /**< ID del dispositivo. */
+        QString host;              /**< IP del dispositivo (solo al leer). */
+        int intervalSec = 0;       /**< Intervalo propio (solo al leer). */
+        bool hasState = false;     /**< Hay un estado guardado (solo al leer). */
+        ProbeResult last;          /**< Último resultado. */
+        int failures = 0;          /**< Fallos consecutivos. */
+        QDateTime checkedAt;       /**< Momento del último resultado. */
+    };
+
+    /**
+     * @brief Pide la flota al hilo de persistencia; applyFleet() la incorpora al llegar.
+     */
+    void loadFleet();
+
+    /**
+     * @brief Lee la flota y el estado guardado (hilo de persistencia).
+     * @param pool Pool de conexiones.
+     * @param rows Filas leídas.
+     * @return true si la consulta se completó.
+     */
+    static bool readFleet(ConnectionPool *pool, QList<Stored> &rows);
+
+    /**
+     * @brief Sincroniza las entradas con la flota leída y programa las nuevas.
+     * @param rows Filas de readFleet().
+     */
+    void applyFleet(const QList<Stored> &rows);
+
+    /**
+     * @brief Guarda estados en una única transacción (hilo de persistencia).
+     * @param pool Pool de conexiones.
+     * @param rows Estados a guardar.
+     * @return true si la transacción se completó.
+     */
+    static bool writeStates(ConnectionPool *pool, const QList<Stored> &rows);
+
+    /**
+     * @brief Alta o cambio de IP de un dispositivo; los nuevos se programan con desfase aleatorio.
+     * @param deviceId ID del dispositivo.
+     * @param host IP del dispositivo.
+     * @return Entrada del dispositivo.
+     */
+    Entry &track(int deviceId, const QString &host);
+
+    /**
+     * @brief Baja de un dispositivo.
+     * @param deviceId ID del dispositivo.
+     */
+    void untrack(int deviceId);
+
+    /**
+     * @brief Programa la próxima comprobación según intervalo, fallos y jitter.
+     * @param deviceId ID del dispositivo.
+     * @param entry Estado del dispositivo.
+     */
+    void scheduleNext(int deviceId, const Entry &entry);
+
+    /**
+     * @brief Toma una ficha de la subred del dispositivo.
+     * @param subnet Clave de la subred.
+     * @return 0 si se puede comprobar ya, o milisegundos hasta su ficha reservada.
+     */
+    qint64 takeToken(const QByteArray &subnet);
+
+    /**
+     * @brief Convierte milisegundos en ticks de la rueda (redondeo hacia arriba).
+     * @param ms Milisegundos.
+     * @return Ticks (mínimo 1).
+     */
+    quint64 ticksFor(qint64 ms) const;
+
+    /**
+     * @brief Clave de subred de una IP (/24 o /64).
+     * @param host IP en texto.
+     * @return Prefijo de la clave binaria (vacío si la IP no es válida).
+     */
+    static QByteArray subnetKey(const QString &host);
+
+    ConnectionPool *m_pool;              /**< Pool de conexiones (no es propietario). */
+    ProbeEngine m_engine;                /**< Comprobaciones TCP. */
+    TimingWheel m_wheel;                 /**< Plazos de todos los dispositivos. */
+    QHash<int, Entry> m_devices;         /**< Estado de cada dispositivo planificado. */
+    QHash<QByteArray, Bucket> m_buckets; /**< Límite de ritmo por subred. */
+    QSet<int> m_dirty;                   /**< Dispositivos con estado sin guardar. */
+    QTimer m_tick;                       /**< Avance de la rueda. */
+    QTimer m_flush;                      /**< Guardado periódico de estados. */
+    QElapsedTimer m_clock;               /**< Reloj del planificador. */
+    QRandomGenerator m_random;           /**< Jitter y desfase inicial. */
+    HealthStats m_stats;                 /**< Métricas acumuladas. */
+    QThread m_thread;                    /**< Hilo de lectura de la flota y guardado de estados. */
+    QObject *m_context;                  /**< Objeto de contexto que vive en m_thread. */
+    std::atomic<quint64> m_generation;   /**< Generación de las lecturas de la flota vigentes. */
+    quint64 m_tickOrigin;                /**< Tick de la rueda al iniciar el reloj. */
+    int m_tickMs;                        /**< Milisegundos por tick. */
+    int m_defaultIntervalSec;            /**< Intervalo por defecto. */
+    double m_jitter;                     /**< Desvío relativo de los plazos. */
+    double m_subnetRate;                 /**< Fichas por segundo y subred. */
+    int m_subnetBurst;                   /**< Capacidad del cubo. */
+    int m_maxBackoffSec;                 /**< Tope de la espera ampliada. */
+    bool m_running;                      /**< Planificación activa. */
+};
+
+#endif // HEALTHSCHEDULER_H
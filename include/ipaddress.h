@@ -0,0 +1,124 @@
+#ifndef IPADDRESS_H
+#define IPADDRESS_H
+
+#include <QByteArray>
+#include <QString>
+#include <QStringView>
+#include <QMetaType>
+#include <array>
+
+/**
+ * @brief Tipo valor compacto para direcciones IPv4 e IPv6.
+ *
+ * Internamente guarda siempre 16 bytes en orden de red; las IPv4 se representan
+ * como direcciones IPv6 mapeadas (::ffff:a.b.c.d). Gracias a ello, la clave binaria
+ * de 16 bytes (toSortKey) ordena correctamente por memcmp, que es como SQLite compara
+ * los BLOB: la columna 'devices.ip_key' se puede indexar y consultar por rangos.
+ *
+ * Los analizadores están escritos a mano (una sola pasada, sin memoria dinámica)
+ * porque se usan en la ruta de importación masiva.
+ */
+class IpAddress
+{
+public:
+    /**
+     * @brief Familia de la dirección.
+     */
+    enum Family : quint8 {
+        Invalid = 0,  /**< Dirección no inicializada o texto no válido. */
+        IPv4 = 4,     /**< Dirección IPv4. */
+        IPv6 = 6      /**< Dirección IPv6. */
+    };
+
+    /**
+     * @brief Construye una dirección inválida.
+     */
+    IpAddress();
+
+    /**
+     * @brief Construye una IPv4 a partir de su valor numérico.
+     * @param address Dirección en orden de host (ej. 0xC0A80001 para 192.168.0.1).
+     * @return Dirección IPv4.
+     */
+    static IpAddress fromIPv4(quint32 address);
+
+    /**
+     * @brief Analiza una dirección IPv4 o IPv6 en notación textual.
+     * @param text Texto a analizar (sin espacios).
+     * @return Dirección analizada, o inválida si el texto no es correcto.
+     */
+    static IpAddress parse(QStringView text);
+
+    /**
+     * @brief Variante de parse() sobre bytes Latin-1/UTF-8, sin conversión a QString.
+     * @param data Puntero al primer carácter.
+     * @param size Número de caracteres.
+     * @return Dirección analizada, o inválida si el texto no es correcto.
+     */
+    static IpAddress parse(const char *data, qsizetype size);
+
+    /**
+     * @brief Reconstruye una dirección a partir de su clave binaria de 16 bytes.
+     * @param key Valor leído de la columna 'ip_key'.
+     * @return Dirección, o inválida si la clave no tiene 16 bytes.
+     */
+    static IpAddress fromSortKey(const QByteArray &key);
+
+    /**
+     * @brief Analiza una subred en notación CIDR y calcula su rango.
+     *
+     * Acepta "10.20.0.0/16", "2001:db8::/32" o una dirección sin prefijo (rango de
+     * una sola dirección). Los bits de host de la dirección base se ignoran.
+     *
+     * @param text Texto a analizar.
+     * @param first Recibe la primera dirección del rango.
+     * @param last Recibe la última dirección del rango.
+     * @return true si el texto es una subred válida.
+     */
+    static bool parseCidr(QStringView text, IpAddress *first, IpAddress *last);
+
+    /**
+     * @brief Indica si la dirección es válida.
+     * @return true si es IPv4 o IPv6.
+     */
+    bool isValid() const { return m_family != Invalid; }
+
+    /**
+     * @brief Obtiene la familia de la dirección.
+     * @return IPv4, IPv6 o Invalid.
+     */
+    Family family() const { return m_family; }
+
+    /**
+     * @brief Valor numérico de una IPv4.
+     * @return Dirección en orden de host (0 si no es IPv4).
+     */
+    quint32 toIPv4() const;
+
+    /**
+     * @brief Clave binaria ordenable de 16 bytes para la columna 'ip_key'.
+     * @return 16 bytes en orden de red (vacía si la dirección es inválida).
+     */
+    QByteArray toSortKey() const;
+
+    /**
+     * @brief Representación textual canónica (RFC 5952 para IPv6).
+     * @return Texto de la dirección, o cadena vacía si es inválida.
+     */
+    QString toString() const;
+
+    bool operator==(const IpAddress &other) const
+    {
+        return m_family == other.m_family && m_bytes == other.m_bytes;
+    }
+    bool operator!=(const IpAddress &other) const { return !(*this == other); }
+    bool operator<(const IpAddress &other) const { return m_bytes < other.m_bytes; }
+
+private:
+    std::array<quint8, 16> m_bytes;  /**< Dirección en orden de red (IPv4 mapeada). */
+    Family m_family;                 /**< Familia de la dirección. */
+};
+
+Q_DECLARE_METATYPE(IpAddress)
+
+#endif // IPADDRESS_H
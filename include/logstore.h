@@ -0,0 +1,198 @@
+#ifndef LOGSTORE_H
+#define LOGSTORE_H
+
+#include <QString>
+#include <QStringList>
+#include <QDate>
+#include <QDateTime>
+#include <QList>
+#include <QHash>
+#include <QAtomicInt>
+#include <memory>
+#include "statementcache.h"
+
+/**
+ * @brief Evento de auditoría pendiente de escribir.
+ */
+struct LogEntry
+{
+    QDateTime timestamp;  /**< Momento en que se registró el evento. */
+    QString category;     /**< Categoría (ej. "Login", "Importación"). */
+    QString message;      /**< Descripción del evento. */
+    qint64 legacyId = 0;  /**< ID en la antigua tabla 'logs' (0 para los eventos nuevos). */
+};
+
+/**
+ * @brief Registro de auditoría leído del almacén.
+ */
+struct LogRecord
+{
+    qint64 id = 0;         /**< ID dentro de su partición (negativo si viene de la tabla antigua). */
+    QDateTime timestamp;   /**< Momento del evento. */
+    QString category;      /**< Categoría del evento. */
+    QString message;       /**< Descripción del evento. */
+};
+
+/**
+ * @brief Almacén de auditoría particionado por mes, fuera de la base de datos principal.
+ *
+ * Cada mes se guarda en su propio archivo SQLite (logs-AAAA-MM.sqlite) con índice por
+ * 'timestamp', de modo que los logs no comparten archivo ni bloqueo de escritura con
+ * 'devices'. La retención trabaja sobre particiones completas: las que superan
+ * retentionMonths se comprimen (qCompress) en logs-AAAA-MM.sqlite.qz y su archivo se
+ * elimina, sin ejecutar DELETE; los archivos comprimidos que superan
+ * archiveRetentionMonths se borran. Un archivo existente nunca se sobrescribe: si un
+ * mes se archiva otra vez, el nuevo se guarda como logs-AAAA-MM.N.sqlite.qz.
+ *
+ * Solo un hilo escribe (append(), normalmente el de AuditLogger); query() puede
+ * llamarse desde cualquier hilo y recorre las particiones vivas de la más reciente
+ * a la más antigua.
+ */
+class LogStore
+{
+public:
+    /**
+     * @brief Constructor de la clase LogStore.
+     * @param directory Carpeta de las particiones (se crea si no existe).
+     */
+    explicit LogStore(const QString &directory);
+
+    /**
+     * @brief Destructor de la clase.
+     * Cierra las conexiones de escritura del hilo actual.
+     */
+    ~LogStore();
+
+    LogStore(const LogStore &) = delete;
+    LogStore &operator=(const LogStore &) = delete;
+
+    /**
+     * @brief Carpeta de las particiones.
+     * @return Ruta absoluta.
+     */
+    QString directory() const;
+
+    /**
+     * @brief Meses que se mantienen consultables, incluido el actual (mínimo 1).
+     * @param months Número de particiones vivas.
+     */
+    void setRetentionMonths(int months);
+
+    /**
+     * @brief Meses que se conservan los archivos comprimidos (0 = indefinidamente).
+     * @param months Antigüedad máxima de los archivos, contada desde el mes actual.
+     */
+    void setArchiveRetentionMonths(int months);
+
+    /**
+     * @brief Aplica la retención al pasar append() a una partición nueva.
+     * La migración de la tabla antigua la desactiva: copia varios meses seguidos y no
+     * debe archivar nada hasta haber terminado.
+     * @param enabled true para aplicarla (por defecto).
+     */
+    void setRetentionOnRollover(bool enabled);
+
+    /**
+     * @brief Clave de la partición de una fecha.
+     * @param date Fecha del evento.
+     * @return Clave "AAAA-MM".
+     */
+    static QString partitionKey(const QDate &date);
+
+    /**
+     * @brief Claves de las particiones vivas, de la más antigua a la más reciente.
+     * @return Lista de claves "AAAA-MM".
+     */
+    QStringList partitions() const;
+
+    /**
+     * @brief Claves de las particiones archivadas (comprimidas).
+     * @return Lista de claves "AAAA-MM".
+     */
+    QStringList archives() const;
+
+    /**
+     * @brief Escribe eventos en sus particiones (una transacción por partición).
+     *
+     * Debe llamarse siempre desde el mismo hilo; al pasar a una partición nueva se
+     * aplica la retención (salvo con setRetentionOnRollover(false)). Los eventos con legacyId se guardan con id = -legacyId y se
+     * ignoran si ya existen: copiar dos veces la tabla antigua no duplica filas.
+     *
+     * @param entries Eventos a guardar.
+     * @return true si todos los eventos se confirmaron.
+     */
+    bool append(const QList<LogEntry> &entries);
+
+    /**
+     * @brief Cierra las conexiones de escritura abiertas por el hilo actual.
+     * El hilo escritor la llama antes de terminar.
+     */
+    void closeWriter();
+
+    /**
+     * @brief Consulta los eventos de un intervalo en las particiones vivas.
+     * @param from Inicio del intervalo (incluido).
+     * @param to Fin del intervalo (incluido).
+     * @param category Categoría exacta a filtrar (vacía para todas).
+     * @param limit Máximo de eventos a devolver.
+     * @return Eventos del más reciente al más antiguo.
+     */
+    QList<LogRecord> query(const QDateTime &from, const QDateTime &to,
+                           const QString &category = QString(), int limit = 1000) const;
+
+    /**
+     * @brief Archiva y elimina las particiones que superan la retención.
+     * @param today Fecha de referencia (mes actual).
+     * @return Número de particiones archivadas.
+     */
+    int applyRetention(const QDate &today = QDate::currentDate());
+
+private:
+    /**
+     * @brief Ruta del archivo SQLite de una partición.
+     * @param key Clave "AAAA-MM".
+     * @return Ruta absoluta.
+     */
+    QString partitionPath(const QString &key) const;
+
+    /**
+     * @brief Conexión de escritura de una partición (la crea con su esquema si no existe).
+     * @param key Clave "AAAA-MM".
+     * @return Nombre de la conexión, o vacío si no se pudo abrir.
+     */
+    QString writerConnection(const QString &key);
+
+    /**
+     * @brief Comprime una partición en un archivo .qz nuevo y elimina el original.
+     * @param key Clave "AAAA-MM".
+     * @return true si el archivo comprimido quedó escrito.
+     */
+    bool archivePartition(const QString &key);
+
+    /**
+     * @brief Archivos comprimidos de un mes (el original y sus copias numeradas).
+     * @param key Clave "AAAA-MM".
+     * @return Rutas absolutas.
+     */
+    QStringList archivePaths(const QString &key) const;
+
+    /**
+     * @brief Claves de los archivos de la carpeta con un sufijo dado.
+     * @param suffix Sufijo del nombre de archivo (".sqlite" o ".sqlite.qz").
+     * @return Claves ordenadas.
+     */
+    QStringList keysWithSuffix(const QString &suffix) const;
+
+    QString m_directory;                 /**< Carpeta de las particiones. */
+    QString m_prefix;                    /**< Prefijo único de los nombres de conexión. */
+    int m_retentionMonths;               /**< Particiones vivas. */
+    int m_archiveRetentionMonths;        /**< Antigüedad máxima de los archivos (0 = sin límite). */
+    QHash<QString, QString> m_writers;   /**< Conexiones de escritura por partición (hilo escritor). */
+    QString m_currentKey;                /**< Última partición escrita. */
+    bool m_retentionOnRollover;          /**< append() aplica la retención al cambiar de mes. */
+    mutable QAtomicInt m_querySerial;    /**< Numeración de conexiones de consulta. */
+    QHash<QString, std::shared_ptr<StatementCache>> m_statements;    /**< INSERT preparado por conexión de escritura. */
+    std::shared_ptr<StatementCache::Counters> m_statementCounters;   /**< Contadores de esas cachés. */
+};
+
+#endif // LOGSTORE_H
@@ -0,0 +1,30 @@
+#ifndef LTTB_H
+#define LTTB_H
+
+#include <QList>
+#include <QPointF>
+
+/**
+ * @brief Reducción de series para gráficas con Largest-Triangle-Three-Buckets
+ * (Steinarsson, 2013).
+ *
+ * Divide la serie en tantos cubos como puntos se quieren conservar y de cada cubo se
+ * queda con el punto que forma el triángulo de mayor área con el punto elegido en el
+ * cubo anterior y la media del cubo siguiente. A diferencia de tomar uno de cada N
+ * puntos, conserva los picos y la forma visual de la serie; el primero y el último se
+ * conservan siempre. Coste lineal en el número de puntos de entrada.
+ */
+class Lttb
+{
+public:
+    /**
+     * @brief Reduce una serie ordenada por x.
+     * @param points Puntos de entrada.
+     * @param count Número de puntos de entrada.
+     * @param threshold Puntos deseados (si es menor que 3 o no reduce nada, se copian todos).
+     * @param out Recibe los puntos elegidos (se vacía antes).
+     */
+    static void downsample(const QPointF *points, qsizetype count, int threshold, QList<QPointF> *out);
+};
+
+#endif // LTTB_H
@@ -2,14 +2,25 @@
 #define MAINWINDOW_H
 
 #include <QMainWindow>
-#include <QSqlTableModel>
 #include <QFile>
 #include <QTextStream>
 #include <QFileDialog>
 #include <QDir>
 #include "databasemanager.h"
 #include "user.h"
+#include "devicemanager.h"
 #include "registerdialog.h"
+#include "deviceimporter.h"
+#include "deviceexporter.h"
+#include "devicesearch.h"
+#include "devicetablemodel.h"
+#include "probeengine.h"
+#include "healthscheduler.h"
+#include "commandpipeline.h"
+#include "telemetryreceiver.h"
+
+class QProgressDialog;
+class QThread;
 
 QT_BEGIN_NAMESPACE
 namespace Ui { class MainWindow; }
@@ -31,7 +42,8 @@ class MainWindow : public QMainWindow
 public:
     /**
      * @brief Constructor de la ventana principal.
-     * Inicializa la interfaz (UI), aplica los estilos (Dark Mode) y abre la conexión a la BD.
+     * Aplica los estilos (Dark Mode), crea la interfaz y lanza en segundo plano la
+     * preparación de la BD; el resto del arranque sigue en onDatabasePrepared().
      * @param parent Widget padre (generalmente nullptr para la ventana raíz).
      */
     MainWindow(QWidget *parent = nullptr);
@@ -42,7 +54,26 @@ public:
      */
     ~MainWindow();
 
+protected:
+    /**
+     * @brief Registra en StartupTimeline el primer pintado de la ventana.
+     */
+    bool eventFilter(QObject *watched, QEvent *event) override;
+
 private slots:
+    /**
+     * @brief Continúa el arranque cuando el esquema está listo: abre la BD, crea los
+     * servicios de la sesión y habilita el inicio de sesión. Después lanza en segundo
+     * plano el mantenimiento de los agregados.
+     */
+    void onDatabasePrepared();
+
+    /**
+     * @brief Termina el arranque cuando el mantenimiento de los agregados está hecho:
+     * los conecta al almacén de series y registra la cronología del arranque.
+     */
+    void onMaintenancePrepared();
+
     /**
      * @brief Slot ejecutado al pulsar el botón "Iniciar Sesión".
      * Valida las credenciales ingresadas, registra el log y cambia a la vista principal.
@@ -74,23 +105,96 @@ private slots:
 
     /**
      * @brief Slot ejecutado cuando el texto de la barra de búsqueda cambia.
-     * Aplica un filtro SQL (WHERE) al modelo para buscar por nombre o IP en tiempo real.
+     * Programa una búsqueda en el índice FTS5 (con debounce) por nombre, IP o tipo.
      * @param arg1 El texto actual introducido por el usuario.
      */
     void on_txtSearch_textChanged(const QString &arg1);
 
+    /**
+     * @brief Aplica al modelo los resultados de la búsqueda más reciente.
+     * @param text Texto buscado.
+     * @param ids IDs de los dispositivos coincidentes.
+     * @param truncated true si se alcanzó el límite de resultados.
+     */
+    void onSearchResults(const QString &text, const QList<int> &ids, bool truncated);
+
     /**
      * @brief Slot para exportar los datos visibles de la tabla a un archivo CSV.
-     * Abre un cuadro de diálogo para seleccionar la ubicación de guardado.
+     * Abre un cuadro de diálogo para seleccionar la ubicación de guardado y
+     * ejecuta la exportación en segundo plano con opción de cancelar.
      */
     void on_btnExport_clicked();
 
+    /**
+     * @brief Actualiza el diálogo de progreso de la exportación en curso.
+     * @param rowsExported Filas escritas hasta el momento.
+     * @param rowsTotal Total de filas a exportar.
+     */
+    void onExportProgress(qint64 rowsExported, qint64 rowsTotal);
+
+    /**
+     * @brief Informa al usuario del resultado de la exportación.
+     * @param stats Métricas finales de la exportación.
+     */
+    void onExportFinished(const ExportStats &stats);
+
+    /**
+     * @brief Slot para importar dispositivos de forma masiva desde un archivo CSV.
+     * Acepta el mismo formato que genera la exportación y muestra el progreso con opción de cancelar.
+     */
+    void on_btnImport_clicked();
+
+    /**
+     * @brief Actualiza el diálogo de progreso de la importación en curso.
+     * @param bytesProcessed Bytes del archivo ya procesados.
+     * @param bytesTotal Tamaño total del archivo.
+     * @param rowsImported Filas insertadas hasta el momento.
+     */
+    void onImportProgress(qint64 bytesProcessed, qint64 bytesTotal, qint64 rowsImported);
+
+    /**
+     * @brief Finaliza la importación: registra el rendimiento en el log y refresca la tabla.
+     * @param stats Métricas finales de la importación.
+     */
+    void onImportFinished(const ImportStats &stats);
+
+    /**
+     * @brief Comprueba el alcance de los dispositivos visibles (o cancela la ronda en curso).
+     * Los resultados llenan la columna "Estado" a medida que llegan.
+     */
+    void on_btnProbe_clicked();
+
+    /**
+     * @brief Muestra el resumen de la ronda de comprobaciones y lo registra en el log.
+     * @param stats Métricas de la ronda.
+     */
+    void onProbeFinished(const ProbeStats &stats);
+
+    /**
+     * @brief Informa de los comandos no aplicados.
+     * Las respuestas no se guardan como lecturas: los comandos de la cola son escrituras de
+     * configuración, y las lecturas llegan por TelemetryReceiver.
+     * @param result Resultado de un comando de la cola.
+     */
+    void onCommandFinished(const CommandResult &result);
+
+    /**
+     * @brief Muestra en la gráfica de tendencia los dispositivos seleccionados en la tabla.
+     */
+    void onDeviceSelectionChanged();
+
     /**
      * @brief Slot para abrir el diálogo de registro de nuevos usuarios.
      * @note Este botón solo es visible si el usuario logueado tiene rol de Administrador.
      */
     void on_btnCreateUser_clicked();
 
+    /**
+     * @brief Activa la traza (Tracer) o, si ya está activa, la detiene y guarda el archivo
+     * junto a la base de datos. Asociado a Ctrl+Mayús+T.
+     */
+    void toggleTracing();
+
 private:
     /**
      * @brief Puntero a la interfaz gráfica generada por Qt Designer.
@@ -102,24 +206,99 @@ private:
      */
     DatabaseManager m_dbManager;
 
+    /**
+     * @brief Controlador de las operaciones CRUD de dispositivos.
+     * Sus señales de cambio alimentan las actualizaciones incrementales del modelo.
+     */
+    DeviceManager m_deviceManager;
+
     /**
      * @brief Objeto que mantiene el estado de la sesión del usuario actual (ID, Rol, Nombre).
      */
     User m_user;
 
     /**
-     * @brief Modelo de datos SQL que enlaza la tabla 'devices' de la BD con la vista visual (QTableView).
-     * Permite visualizar, ordenar y filtrar los datos sin escribir SQL manual en la vista.
+     * @brief Modelo virtualizado que enlaza la tabla 'devices' de la BD con la vista visual (QTableView).
+     * Solo mantiene en memoria las páginas cercanas a la zona visible; permite ordenar y filtrar.
+     */
+    DeviceTableModel *m_model;
+
+    /**
+     * @brief Importador masivo de CSV (se crea la primera vez que se usa).
+     */
+    DeviceImporter *m_importer;
+
+    /**
+     * @brief Diálogo de progreso de la importación activa (nullptr si no hay ninguna).
+     */
+    QProgressDialog *m_importProgress;
+
+    /**
+     * @brief Motor de exportación a CSV en segundo plano (se crea la primera vez que se usa).
+     */
+    DeviceExporter *m_exporter;
+
+    /**
+     * @brief Diálogo de progreso de la exportación activa (nullptr si no hay ninguna).
+     */
+    QProgressDialog *m_exportProgress;
+
+    /**
+     * @brief Subsistema de búsqueda FTS5 en segundo plano.
+     */
+    DeviceSearch *m_search;
+
+    /**
+     * @brief Motor de comprobación de alcance por TCP (asíncrono, en el hilo de la interfaz).
      */
-    QSqlTableModel *m_model;
+    ProbeEngine *m_probe;
+
+    /**
+     * @brief Motor propio de las comprobaciones de un solo dispositivo (alta o cambio de IP).
+     * Separado de m_probe para no mezclarse con el barrido manual ni con su resumen.
+     */
+    ProbeEngine *m_deviceCheck;
+
+    /**
+     * @brief Comprobaciones periódicas de toda la flota mientras hay una sesión abierta.
+     */
+    HealthScheduler *m_scheduler;
+
+    /**
+     * @brief Cola de comandos salientes (envía la nueva calibración al editar un dispositivo).
+     */
+    CommandPipeline *m_commands;
+
+    /**
+     * @brief Ingesta de telemetría UDP de los dispositivos mientras hay una sesión abierta.
+     */
+    TelemetryReceiver *m_telemetry;
+
+    /**
+     * @brief Hilo que prepara la BD o su mantenimiento durante el arranque (nullptr al terminar).
+     */
+    QThread *m_startup;
+
+    /**
+     * @brief Ya se registró el primer pintado de la ventana.
+     */
+    bool m_firstFrame;
 
     /**
      * @brief Configura las propiedades de la tabla de dispositivos.
-     * Establece el modelo, define los encabezados amigables, oculta columnas internas (ID)
+     * Establece el modelo, oculta columnas internas (ID), activa el orden por cabecera
      * y ajusta el modo de redimensionamiento de columnas.
      */
     void setupDevicesTable();
 
+    /**
+     * @brief Comprueba en segundo plano si un dispositivo recién guardado es alcanzable.
+     * Toma la propiedad del dispositivo: lo comprueba con m_deviceCheck, informa en la
+     * barra de estado y lo destruye al llegar su resultado (o si se cancela la comprobación).
+     * @param device Dispositivo con ID e IP asignados.
+     */
+    void checkDeviceConnection(Device *device);
+
     /**
      * @brief Aplica una hoja de estilos (QSS) global a la aplicación.
      * Define colores, bordes y fuentes para lograr el tema oscuro (Dark Mode).
@@ -0,0 +1,131 @@
+#ifndef MPMCQUEUE_H
+#define MPMCQUEUE_H
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <utility>
+
+/**
+ * @brief Cola acotada sin bloqueos para varios productores y varios consumidores.
+ *
+ * Anillo de capacidad fija (potencia de dos) en el que cada celda lleva un número de
+ * secuencia que indica si está libre u ocupada para la vuelta actual del anillo
+ * (algoritmo de D. Vyukov). Encolar y desencolar solo usan operaciones atómicas: ningún
+ * hilo queda esperando a otro, y si la cola está llena tryPush() falla de inmediato.
+ *
+ * @tparam T Tipo de los elementos (debe poder construirse por defecto y moverse).
+ */
+template <typename T>
+class MpmcQueue
+{
+public:
+    /**
+     * @brief Constructor de la clase MpmcQueue.
+     * @param capacity Capacidad mínima; se redondea a la siguiente potencia de dos (mínimo 2).
+     */
+    explicit MpmcQueue(std::size_t capacity)
+    {
+        std::size_t size = 2;
+        while (size < capacity) size <<= 1;
+
+        m_mask = size - 1;
+        m_cells.reset(new Cell[size]);
+        for (std::size_t i = 0; i < size; ++i) {
+            m_cells[i].sequence.store(i, std::memory_order_relaxed);
+        }
+        m_enqueuePos.store(0, std::memory_order_relaxed);
+        m_dequeuePos.store(0, std::memory_order_relaxed);
+    }
+
+    MpmcQueue(const MpmcQueue &) = delete;
+    MpmcQueue &operator=(const MpmcQueue &) = delete;
+
+    /**
+     * @brief Intenta encolar un elemento.
+     * @param value Elemento a encolar (se mueve solo si hay espacio).
+     * @return false si la cola está llena.
+     */
+    bool tryPush(T &&value)
+    {
+        std::size_t pos = m_enqueuePos.load(std::memory_order_relaxed);
+        for (;;) {
+            Cell &cell = m_cells[pos & m_mask];
+            const std::size_t seq = cell.sequence.load(std::memory_order_acquire);
+            const std::ptrdiff_t diff = static_cast<std::ptrdiff_t>(seq) - static_cast<std::ptrdiff_t>(pos);
+
+            if (diff == 0) {
+                // Celda libre en esta vuelta: reservarla
+                if (m_enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    cell.value = std::move(value);
+                    cell.sequence.store(pos + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (diff < 0) {
+                return false;   // El consumidor aún no liberó la celda: cola llena
+            } else {
+                pos = m_enqueuePos.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    /**
+     * @brief Intenta desencolar un elemento.
+     * @param value Recibe el elemento extraído.
+     * @return false si la cola está vacía.
+     */
+    bool tryPop(T &value)
+    {
+        std::size_t pos = m_dequeuePos.load(std::memory_order_relaxed);
+        for (;;) {
+            Cell &cell = m_cells[pos & m_mask];
+            const std::size_t seq = cell.sequence.load(std::memory_order_acquire);
+            const std::ptrdiff_t diff = static_cast<std::ptrdiff_t>(seq) - static_cast<std::ptrdiff_t>(pos + 1);
+
+            if (diff == 0) {
+                if (m_dequeuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    value = std::move(cell.value);
+                    // Liberar la celda para la siguiente vuelta del anillo
+                    cell.sequence.store(pos + m_mask + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (diff < 0) {
+                return false;   // Ningún productor completó esta celda: cola vacía
+            } else {
+                pos = m_dequeuePos.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    /**
+     * @brief Capacidad real del anillo.
+     * @return Número máximo de elementos.
+     */
+    std::size_t capacity() const { return m_mask + 1; }
+
+    /**
+     * @brief Número aproximado de elementos (exacto solo si no hay operaciones en curso).
+     * @return Elementos en la cola.
+     */
+    std::size_t sizeApprox() const
+    {
+        const std::size_t enqueued = m_enqueuePos.load(std::memory_order_relaxed);
+        const std::size_t dequeued = m_dequeuePos.load(std::memory_order_relaxed);
+        return enqueued > dequeued ? enqueued - dequeued : 0;
+    }
+
+private:
+    struct Cell
+    {
+        std::atomic<std::size_t> sequence;
+        T value;
+    };
+
+    std::unique_ptr<Cell[]> m_cells;
+    std::size_t m_mask = 0;
+    // Posiciones en líneas de caché distintas: productores y consumidores no se estorban
+    alignas(64) std::atomic<std::size_t> m_enqueuePos;
+    alignas(64) std::atomic<std::size_t> m_dequeuePos;
+};
+
+#endif // MPMCQUEUE_H
@@ -0,0 +1,230 @@
+#ifndef PROBEENGINE_H
+#define PROBEENGINE_H
+
+#include <QObject>
+#include <QString>
+#include <QList>
+#include <QHash>
+#include <QQueue>
+#include <QTimer>
+#include <QElapsedTimer>
+#include <QMetaType>
+
+class QTcpSocket;
+
+/**
+ * @brief Dispositivo a comprobar.
+ */
+struct ProbeTarget
+{
+    int deviceId = -1;   /**< ID del dispositivo (para asociar el resultado). */
+    QString host;        /**< IP (o nombre) del dispositivo. */
+    quint16 port = 0;    /**< Puerto TCP (0 = puerto por defecto del motor). */
+};
+
+/**
+ * @brief Resultado de la comprobación de un dispositivo.
+ */
+struct ProbeResult
+{
+    /**
+     * @brief Estado de alcance del dispositivo.
+     */
+    enum Status {
+        Unknown,       /**< Aún no comprobado. */
+        Reachable,     /**< La conexión TCP se completó. */
+        Refused,       /**< El equipo respondió pero el puerto está cerrado (RST). */
+        Timeout,       /**< Sin respuesta dentro del plazo. */
+        Unreachable    /**< Error de red o de dirección (sin ruta, IP no válida...). */
+    };
+
+    int deviceId = -1;        /**< ID del dispositivo. */
+    QString host;             /**< Dirección comprobada. */
+    quint16 port = 0;         /**< Puerto comprobado. */
+    Status status = Unknown;  /**< Estado obtenido. */
+    qint64 latencyUs = -1;    /**< Tiempo hasta la respuesta (microsegundos; -1 si no hubo). */
+    QString error;            /**< Descripción del error (vacía si Reachable). */
+
+    /**
+     * @brief Indica si el equipo respondió (conexión aceptada o rechazada).
+     * @return true para Reachable y Refused.
+     */
+    bool hostResponded() const { return status == Reachable || status == Refused; }
+
+    /**
+     * @brief Texto breve del estado para la interfaz.
+     * @return Descripción en español (ej. "En línea (3.2 ms)"), vacía si Unknown.
+     */
+    QString statusText() const
+    {
+        const QString latency = QString::number(latencyUs / 1000.0, 'f', 1);
+        switch (status) {
+        case Reachable:   return QString("En línea (%1 ms)").arg(latency);
+        case Refused:     return QString("Puerto %1 cerrado (%2 ms)").arg(port).arg(latency);
+        case Timeout:     return QStringLiteral("Sin respuesta");
+        case Unreachable: return "Inaccesible: " + error;
+        default:          return QString();
+        }
+    }
+};
+
+/**
+ * @brief Métricas de una ronda de comprobaciones.
+ */
+struct ProbeStats
+{
+    int total = 0;          /**< Dispositivos comprobados. */
+    int reachable = 0;      /**< Conexiones completadas. */
+    int refused = 0;        /**< Puertos cerrados. */
+    int timedOut = 0;       /**< Sin respuesta. */
+    int unreachable = 0;    /**< Errores de red. */
+    qint64 elapsedMs = 0;   /**< Duración de la ronda. */
+    bool cancelled = false; /**< La ronda se canceló. */
+
+    /**
+     * @brief Comprobaciones por segundo.
+     * @return Dispositivos comprobados por segundo de la ronda.
+     */
+    double probesPerSecond() const { return elapsedMs > 0 ? total * 1000.0 / elapsedMs : 0.0; }
+};
+
+Q_DECLARE_METATYPE(ProbeResult)
+Q_DECLARE_METATYPE(ProbeStats)
+
+/**
+ * @brief Motor de comprobación de alcance de dispositivos mediante conexiones TCP asíncronas.
+ *
+ * No usa hilos: cada comprobación es un QTcpSocket que inicia connectToHost() y queda a
+ * la espera de los eventos del bucle del hilo propietario (normalmente el de la
+ * interfaz), de modo que miles de conexiones avanzan a la vez sin bloquear nada. Como
+ * máximo hay maxConcurrent sockets abiertos; el resto espera en cola y entra a medida
+ * que los anteriores terminan. Un único temporizador revisa los plazos de los sockets
+ * en curso en lugar de un temporizador por dispositivo.
+ *
+ * La latencia es el tiempo hasta que el equipo responde: la conexión aceptada o el
+ * rechazo (RST) del puerto. Tras conectar, el socket se aborta sin enviar datos.
+ */
+class ProbeEngine : public QObject
+{
+    Q_OBJECT
+
+public:
+    /**
+     * @brief Constructor de la clase ProbeEngine.
+     * @param parent Objeto padre opcional.
+     */
+    explicit ProbeEngine(QObject *parent = nullptr);
+
+    /**
+     * @brief Destructor de la clase.
+     * Aborta las comprobaciones en curso.
+     */
+    ~ProbeEngine();
+
+    /**
+     * @brief Número máximo de conexiones simultáneas.
+     * @param sockets Sockets abiertos a la vez (mínimo 1; por defecto 256).
+     */
+    void setMaxConcurrent(int sockets);
+
+    /**
+     * @brief Plazo de cada comprobación.
+     * @param ms Milisegundos desde connectToHost() (mínimo 10; por defecto 1500).
+     */
+    void setTimeout(int ms);
+
+    /**
+     * @brief Puerto de los objetivos que no indican ninguno.
+     * @param port Puerto TCP (por defecto 80).
+     */
+    void setDefaultPort(quint16 port);
+
+    /**
+     * @brief Añade dispositivos a la ronda actual (o inicia una nueva).
+     * @param targets Dispositivos a comprobar.
+     */
+    void probe(const QList<ProbeTarget> &targets);
+
+    /**
+     * @brief Descarta los pendientes y aborta las comprobaciones en curso.
+     * Emite finished() con cancelled = true si había una ronda activa.
+     */
+    void cancel();
+
+    /**
+     * @brief Indica si hay una ronda en curso.
+     * @return true si quedan comprobaciones pendientes o en curso.
+     */
+    bool isRunning() const;
+
+    /**
+     * @brief Comprobaciones en cola o en curso.
+     * @return Número de dispositivos aún sin resultado.
+     */
+    int pending() const;
+
+signals:
+    /**
+     * @brief Resultado de un dispositivo (en el orden en que responden).
+     * @param result Estado y latencia del dispositivo.
+     */
+    void resultReady(const ProbeResult &result);
+
+    /**
+     * @brief Se emite cuando la ronda termina (o se cancela).
+     * @param stats Resumen de la ronda.
+     */
+    void finished(const ProbeStats &stats);
+
+private slots:
+    /**
+     * @brief Revisa los plazos de los sockets en curso.
+     */
+    void sweepTimeouts();
+
+private:
+    /**
+     * @brief Comprobación en curso.
+     */
+    struct InFlight
+    {
+        ProbeTarget target;
+        qint64 startedNs = 0;
+    };
+
+    /**
+     * @brief Abre sockets para los pendientes hasta llenar maxConcurrent.
+     */
+    void launchPending();
+
+    /**
+     * @brief Cierra un socket en curso, emite su resultado y lanza el siguiente.
+     * @param socket Socket que terminó.
+     * @param status Estado obtenido.
+     * @param error Descripción del error (vacía si Reachable).
+     */
+    void complete(QTcpSocket *socket, ProbeResult::Status status, const QString &error = QString());
+
+    /**
+     * @brief Encola launchPending() en el bucle de eventos (evita recursión con errores inmediatos).
+     */
+    void scheduleLaunch();
+
+    /**
+     * @brief Emite finished() si ya no queda nada pendiente.
+     */
+    void finishIfIdle();
+
+    int m_maxConcurrent;                      /**< Sockets simultáneos. */
+    int m_timeoutMs;                          /**< Plazo por comprobación. */
+    quint16 m_defaultPort;                    /**< Puerto por defecto. */
+    QQueue<ProbeTarget> m_queue;              /**< Objetivos aún sin socket. */
+    QHash<QTcpSocket *, InFlight> m_inFlight; /**< Sockets en curso. */
+    QTimer m_sweep;                           /**< Revisión periódica de plazos. */
+    QElapsedTimer m_clock;                    /**< Reloj de la ronda (latencias y duración). */
+    ProbeStats m_stats;                       /**< Métricas de la ronda actual. */
+    bool m_running;                           /**< Hay una ronda activa. */
+    bool m_launchScheduled;                   /**< Ya hay un launchPending() encolado. */
+};
+
+#endif // PROBEENGINE_H
@@ -0,0 +1,312 @@
+#ifndef ROLLUPENGINE_H
+#define ROLLUPENGINE_H
+
+#include <QObject>
+#include <QList>
+#include <QHash>
+#include <QTimer>
+#include <QDateTime>
+#include <mutex>
+#include "timeseriesstore.h"
+
+class ConnectionPool;
+
+/**
+ * @brief Agregado de las lecturas de un intervalo (o una lectura suelta en resolución Raw).
+ */
+struct RollupPoint
+{
+    qint64 bucketMs = 0;   /**< Inicio del intervalo (o marca de la lectura). */
+    double min = 0.0;      /**< Valor mínimo. */
+    double max = 0.0;      /**< Valor máximo. */
+    double sum = 0.0;      /**< Suma de los valores. */
+    qint64 count = 0;      /**< Número de lecturas. */
+
+    /**
+     * @brief Valor medio del intervalo.
+     * @return Media de las lecturas (0 si no hay ninguna).
+     */
+    double average() const { return count > 0 ? sum / count : 0.0; }
+
+    /**
+     * @brief Acumula una lectura.
+     * @param value Valor leído.
+     */
+    void add(double value)
+    {
+        min = count > 0 ? qMin(min, value) : value;
+        max = count > 0 ? qMax(max, value) : value;
+        sum += value;
+        ++count;
+    }
+
+    /**
+     * @brief Acumula otro agregado del mismo intervalo.
+     * @param other Agregado a sumar.
+     */
+    void merge(const RollupPoint &other)
+    {
+        if (other.count == 0) return;
+        min = count > 0 ? qMin(min, other.min) : other.min;
+        max = count > 0 ? qMax(max, other.max) : other.max;
+        sum += other.sum;
+        count += other.count;
+    }
+};
+
+/**
+ * @brief Métricas del motor de agregados.
+ */
+struct RollupStats
+{
+    int devices = 0;            /**< Dispositivos con agregados en curso. */
+    int pendingBuckets = 0;     /**< Intervalos cerrados pendientes de guardar. */
+    qint64 readings = 0;        /**< Lecturas agregadas. */
+    qint64 rejected = 0;        /**< Lecturas descartadas por llegar desordenadas. */
+    qint64 written = 0;         /**< Filas guardadas (o fusionadas) en 'device_rollups'. */
+    qint64 lastFlushUs = 0;     /**< Duración del último volcado (microsegundos). */
+};
+
+/**
+ * @brief Agregados por dispositivo (mínimo, máximo, media y número de lecturas) a
+ * resolución de minuto, hora y día.
+ *
+ * Se alimenta desde el TimeSeriesStore (ver TimeSeriesStore::setRollups()): cada lectura
+ * actualiza en memoria el intervalo abierto de las tres resoluciones, con coste constante.
+ * Al pasar a otro intervalo, el anterior queda pendiente y flush() (cada flushInterval ms)
+ * guarda los pendientes y el estado de los abiertos en 'device_rollups' con una sola
+ * transacción. Las filas se fusionan (mínimo de mínimos, suma de sumas...), así que
+ * volcar un intervalo a medias y completarlo después no cuenta nada dos veces.
+ *
+ * query() elige por sí mismo la resolución: la más fina cuyos datos siguen conservados
+ * en todo el rango pedido y que no supera el presupuesto de puntos. Así una gráfica de
+ * un año lee unos cientos de filas diarias en lugar de millones de lecturas.
+ *
+ * applyRetention() caduca cada nivel por separado y en cascada: las lecturas sin agregar
+ * duran poco (se borran segmentos enteros del almacén), los minutos algo más, y las
+ * horas y los días, que ya resumen todo lo anterior, mucho más.
+ *
+ * add() y query() son seguros entre hilos; query() no coincide con un volcado, así que
+ * cada intervalo lo ve una sola vez, en memoria o ya guardado. backfill() y applyRetention() pueden
+ * ejecutarse en un hilo de trabajo antes de start() (mantenimiento del arranque); el
+ * resto se usa desde el hilo que crea el objeto. Las lecturas que llegan entre el
+ * recorrido de backfill() y TimeSeriesStore::setRollups() las agrega esta última a
+ * partir de resumePoint().
+ */
+class RollupEngine : public QObject
+{
+    Q_OBJECT
+
+public:
+    /**
+     * @brief Resoluciones disponibles, de la más fina a la más gruesa.
+     */
+    enum Resolution {
+        Raw = 0,      /**< Lecturas tal como se guardaron (del TimeSeriesStore). */
+        Minute = 1,   /**< Agregados de 1 minuto. */
+        Hour = 2,     /**< Agregados de 1 hora. */
+        Day = 3       /**< Agregados de 1 día (UTC). */
+    };
+
+    /**
+     * @brief Duración de un intervalo.
+     * @param resolution Resolución.
+     * @return Milisegundos por intervalo (0 para Raw).
+     */
+    static qint64 stepMs(Resolution resolution);
+
+    /**
+     * @brief Constructor de la clase RollupEngine.
+     * @param pool Pool de conexiones para leer y guardar los agregados.
+     * @param store Almacén de lecturas (para la resolución Raw, el relleno y la retención).
+     * @param parent Objeto padre opcional.
+     */
+    RollupEngine(ConnectionPool *pool, TimeSeriesStore *store, QObject *parent = nullptr);
+
+    /**
+     * @brief Destructor de la clase.
+     * Guarda los agregados pendientes.
+     */
+    ~RollupEngine();
+
+    /**
+     * @brief Intervalo entre volcados a la base de datos.
+     * @param ms Milisegundos (por defecto 5000).
+     */
+    void setFlushInterval(int ms);
+
+    /**
+     * @brief Días que se conserva una resolución.
+     * @param resolution Resolución.
+     * @param days Días (0 = sin límite). Por defecto: Raw 30, Minute 90, Hour 730, Day sin límite.
+     */
+    void setRetentionDays(Resolution resolution, int days);
+
+    /**
+     * @brief Días que se conserva una resolución.
+     * @param resolution Resolución.
+     * @return Días (0 = sin límite).
+     */
+    int retentionDays(Resolution resolution) const;
+
+    /**
+     * @brief Arranca el volcado periódico y descarta los puntos de reanudación de backfill().
+     */
+    void start();
+
+    /**
+     * @brief Detiene el volcado periódico y guarda lo pendiente.
+     */
+    void stop();
+
+    /**
+     * @brief Agrega una lectura.
+     * @param deviceId ID del dispositivo.
+     * @param timestampMs Marca de tiempo (no anterior a la última del dispositivo).
+     * @param value Valor leído.
+     */
+    void add(int deviceId, qint64 timestampMs, double value);
+
+    /**
+     * @brief Agrega las lecturas de un dispositivo (un solo bloqueo).
+     * @param deviceId ID del dispositivo.
+     * @param points Lecturas en orden de tiempo.
+     */
+    void add(int deviceId, const QList<SeriesPoint> &points);
+
+    /**
+     * @brief Agrega un lote de varios dispositivos (un solo bloqueo).
+     * @param batch Lecturas; las de cada dispositivo, en orden de tiempo.
+     */
+    void add(const SeriesBatch &batch);
+
+    /**
+     * @brief Agrega las lecturas del almacén posteriores al último minuto guardado de
+     * cada dispositivo (datos anteriores al motor o perdidos en un cierre inesperado).
+     * @return Lecturas agregadas.
+     */
+    qint64 backfill();
+
+    /**
+     * @brief Primera lectura de un dispositivo que backfill() no llegó a agregar.
+     * @param deviceId ID del dispositivo.
+     * @param fromMs Recibe la marca de tiempo desde la que seguir.
+     * @param skip Recibe cuántas lecturas con esa misma marca ya se agregaron.
+     * @return false si no hay nada pendiente (no hubo backfill() o el dispositivo ya se
+     * agregaba en vivo).
+     */
+    bool resumePoint(int deviceId, qint64 *fromMs, qint64 *skip) const;
+
+    /**
+     * @brief Elige la resolución para un rango y un presupuesto de puntos.
+     * @param deviceId ID del dispositivo.
+     * @param fromMs Inicio del rango.
+     * @param toMs Fin del rango.
+     * @param maxPoints Puntos máximos deseados.
+     * @return La resolución más fina conservada en todo el rango que no supera el
+     *         presupuesto (Day si ninguna lo cumple).
+     */
+    Resolution chooseResolution(int deviceId, qint64 fromMs, qint64 toMs, int maxPoints) const;
+
+    /**
+     * @brief Serie de un dispositivo en un rango, a la resolución adecuada.
+     * @param deviceId ID del dispositivo.
+     * @param fromMs Inicio del rango.
+     * @param toMs Fin del rango.
+     * @param maxPoints Puntos máximos deseados.
+     * @param used Recibe la resolución elegida (opcional).
+     * @return Puntos en orden de tiempo.
+     */
+    QList<RollupPoint> query(int deviceId, qint64 fromMs, qint64 toMs, int maxPoints,
+                             Resolution *used = nullptr) const;
+
+    /**
+     * @brief Serie de un dispositivo en un rango, a una resolución concreta.
+     * @param deviceId ID del dispositivo.
+     * @param resolution Resolución.
+     * @param fromMs Inicio del rango.
+     * @param toMs Fin del rango.
+     * @return Puntos en orden de tiempo (incluye los intervalos aún no guardados).
+     */
+    QList<RollupPoint> query(int deviceId, Resolution resolution, qint64 fromMs, qint64 toMs) const;
+
+    /**
+     * @brief Borra lo que ha superado la retención de cada resolución.
+     * Antes guarda los agregados pendientes, para no perder el resumen de lo que se borra.
+     * @param now Momento de referencia.
+     * @return Filas de agregados borradas (los segmentos de lecturas se cuentan aparte en el log).
+     */
+    int applyRetention(const QDateTime &now = QDateTime::currentDateTimeUtc());
+
+    /**
+     * @brief Métricas del motor.
+     * @return Copia de los contadores.
+     */
+    RollupStats stats() const;
+
+public slots:
+    /**
+     * @brief Guarda en una transacción los intervalos cerrados y el estado de los abiertos.
+     * @return true si se guardó todo (si falla, se reintentará en el próximo volcado).
+     */
+    bool flush();
+
+private:
+    static constexpr int Levels = 3;   /**< Resoluciones agregadas (Minute, Hour, Day). */
+
+    /**
+     * @brief Intervalo de una resolución pendiente de guardar.
+     */
+    struct Row
+    {
+        int deviceId = 0;     /**< ID del dispositivo. */
+        int resolution = 0;   /**< Resolution del intervalo. */
+        RollupPoint point;    /**< Agregado. */
+    };
+
+    /**
+     * @brief Intervalos abiertos de un dispositivo.
+     */
+    struct Open
+    {
+        RollupPoint levels[Levels];   /**< Intervalo en curso de cada resolución. */
+        qint64 lastMs = 0;            /**< Última marca aceptada. */
+        bool hasData = false;         /**< Hay al menos una lectura. */
+    };
+
+    /**
+     * @brief Lectura de un dispositivo desde la que seguir tras backfill().
+     */
+    struct Resume
+    {
+        qint64 fromMs = 0;            /**< Marca de tiempo de la siguiente lectura. */
+        qint64 skip = 0;              /**< Lecturas con esa marca ya agregadas. */
+    };
+
+    /**
+     * @brief Agrega una lectura con el mutex adquirido.
+     * @param deviceId ID del dispositivo.
+     * @param open Intervalos abiertos del dispositivo.
+     * @param timestampMs Marca de tiempo.
+     * @param value Valor leído.
+     */
+    void addLocked(int deviceId, Open &open, qint64 timestampMs, double value);
+
+    ConnectionPool *m_pool;              /**< Pool de conexiones. */
+    TimeSeriesStore *m_store;            /**< Lecturas sin agregar. */
+    int m_retentionDays[4];              /**< Retención por resolución (0 = sin límite). */
+    QTimer m_flush;                      /**< Volcado periódico. */
+
+    mutable std::mutex m_flushMutex;     /**< Serializa flush() con la lectura y la suma de query(). */
+    mutable std::mutex m_mutex;          /**< Protege los intervalos abiertos, los pendientes y los contadores. */
+    QHash<int, Open> m_open;             /**< Intervalos abiertos por dispositivo. */
+    QList<Row> m_pending;                /**< Intervalos cerrados sin guardar. */
+    QHash<int, Resume> m_resume;         /**< Reanudación de cada dispositivo recorrido por backfill(). */
+    bool m_backfilled;                   /**< backfill() se ejecutó y start() aún no. */
+    qint64 m_readings;                   /**< Lecturas agregadas. */
+    qint64 m_rejected;                   /**< Lecturas desordenadas descartadas. */
+    qint64 m_written;                    /**< Filas guardadas. */
+    qint64 m_lastFlushUs;                /**< Duración del último volcado. */
+};
+
+#endif // ROLLUPENGINE_H
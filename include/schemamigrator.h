@@ -0,0 +1,91 @@
+#ifndef SCHEMAMIGRATOR_H
+#define SCHEMAMIGRATOR_H
+
+#include <QSqlDatabase>
+#include <QString>
+#include <QList>
+#include <functional>
+
+/**
+ * @brief Resultado de una migración aplicada (o fallida).
+ */
+struct MigrationStep
+{
+    int version = 0;        /**< Versión del esquema que deja la migración. */
+    QString description;    /**< Descripción de la migración. */
+    qint64 elapsedUs = 0;   /**< Duración, incluido el COMMIT (microsegundos). */
+    bool ok = false;        /**< La migración se confirmó. */
+};
+
+/**
+ * @brief Motor de migraciones del esquema basado en PRAGMA user_version.
+ *
+ * Cada migración tiene un número de versión y se aplica, en orden, solo si la versión
+ * guardada en el archivo es menor. Cada una corre en su propia transacción junto con
+ * la actualización de user_version: si falla se deshace por completo y las siguientes
+ * no se ejecutan, de modo que el archivo nunca queda con una versión a medias.
+ *
+ * Con WAL las transacciones cortas no bloquean a los lectores, así que las migraciones
+ * pueden aplicarse sobre una base de datos en uso (índices y columnas nuevas en
+ * instalaciones existentes sin reconstruir las tablas).
+ */
+class SchemaMigrator
+{
+public:
+    /**
+     * @brief Cuerpo de una migración: recibe la conexión con la transacción ya abierta.
+     * Debe devolver false ante cualquier error para que la migración se deshaga.
+     */
+    using Apply = std::function<bool(QSqlDatabase &)>;
+
+    /**
+     * @brief Registra una migración.
+     * @param version Versión que deja el esquema (estrictamente creciente, desde 1).
+     * @param description Descripción para el informe.
+     * @param apply Sentencias de la migración.
+     */
+    void addMigration(int version, const QString &description, const Apply &apply);
+
+    /**
+     * @brief Versión más alta registrada.
+     * @return Versión objetivo del esquema (0 si no hay migraciones).
+     */
+    int targetVersion() const;
+
+    /**
+     * @brief Lee la versión del esquema de un archivo.
+     * @param db Conexión abierta.
+     * @return Valor de PRAGMA user_version (-1 si no se pudo leer).
+     */
+    static int currentVersion(QSqlDatabase &db);
+
+    /**
+     * @brief Aplica las migraciones pendientes.
+     * La conexión debe ser la de escritura y el llamador debe tener el bloqueo de escritura.
+     * @param db Conexión de escritura.
+     * @return true si el esquema quedó en targetVersion().
+     */
+    bool migrate(QSqlDatabase &db);
+
+    /**
+     * @brief Migraciones ejecutadas en la última llamada a migrate().
+     * @return Pasos con su duración, en orden de aplicación.
+     */
+    QList<MigrationStep> report() const;
+
+private:
+    /**
+     * @brief Migración registrada.
+     */
+    struct Migration
+    {
+        int version;
+        QString description;
+        Apply apply;
+    };
+
+    QList<Migration> m_migrations;   /**< Migraciones ordenadas por versión. */
+    QList<MigrationStep> m_report;   /**< Informe de la última ejecución. */
+};
+
+#endif // SCHEMAMIGRATOR_H
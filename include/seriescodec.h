@@ -0,0 +1,149 @@
+#ifndef SERIESCODEC_H
+#define SERIESCODEC_H
+
+#include <QByteArray>
+#include <QtGlobal>
+
+/**
+ * @brief Codificador de una serie (marca de tiempo, valor) en un flujo de bits compacto.
+ *
+ * Usa el esquema de Gorilla (Facebook, VLDB 2015):
+ *  - marcas de tiempo por delta de delta: con lecturas a intervalo regular la diferencia
+ *    entre deltas consecutivos es 0 y ocupa un solo bit;
+ *  - valores por XOR con el anterior: si el valor no cambia ocupa un bit, y si cambia
+ *    solo se guardan los bits significativos del XOR (los ceros de los extremos se
+ *    omiten o se reutiliza la ventana del valor anterior).
+ *
+ * La primera muestra se guarda completa (64 + 64 bits), así cada bloque se decodifica
+ * de forma independiente con SeriesDecoder.
+ */
+class SeriesEncoder
+{
+public:
+    /**
+     * @brief Construye un codificador vacío.
+     */
+    SeriesEncoder();
+
+    /**
+     * @brief Añade una muestra al final de la serie.
+     * @param timestampMs Marca de tiempo (milisegundos; no menor que la anterior).
+     * @param value Valor de la lectura.
+     */
+    void append(qint64 timestampMs, double value);
+
+    /**
+     * @brief Número de muestras codificadas.
+     * @return Muestras añadidas desde la construcción o el último clear().
+     */
+    quint32 count() const { return m_count; }
+
+    /**
+     * @brief Primera marca de tiempo.
+     * @return Marca de la primera muestra (0 si está vacío).
+     */
+    qint64 firstTimestamp() const { return m_firstTimestamp; }
+
+    /**
+     * @brief Última marca de tiempo.
+     * @return Marca de la última muestra (0 si está vacío).
+     */
+    qint64 lastTimestamp() const { return m_prevTimestamp; }
+
+    /**
+     * @brief Tamaño aproximado del flujo codificado.
+     * @return Bytes ocupados (redondeando hacia arriba el último byte).
+     */
+    qint64 sizeBytes() const { return m_bytes.size() + (m_used + 7) / 8; }
+
+    /**
+     * @brief Copia del flujo codificado, con el último byte completado con ceros.
+     * @return Bytes listos para SeriesDecoder.
+     */
+    QByteArray bytes() const;
+
+    /**
+     * @brief Vacía el codificador para empezar un bloque nuevo.
+     */
+    void clear();
+
+private:
+    /**
+     * @brief Escribe los bits menos significativos de un valor (de mayor a menor peso).
+     * @param value Valor a escribir.
+     * @param bits Número de bits (1-64).
+     */
+    void writeBits(quint64 value, int bits);
+
+    QByteArray m_bytes;          /**< Bytes completos del flujo. */
+    quint64 m_acc;               /**< Bits pendientes de volcar (alineados a la derecha). */
+    int m_used;                  /**< Bits ocupados en m_acc. */
+    quint32 m_count;             /**< Muestras codificadas. */
+    qint64 m_firstTimestamp;     /**< Marca de la primera muestra. */
+    qint64 m_prevTimestamp;      /**< Marca de la muestra anterior. */
+    qint64 m_prevDelta;          /**< Delta anterior. */
+    quint64 m_prevValue;         /**< Bits del valor anterior. */
+    int m_prevLeading;           /**< Ceros a la izquierda de la ventana anterior (-1 si no hay). */
+    int m_prevTrailing;          /**< Ceros a la derecha de la ventana anterior. */
+};
+
+/**
+ * @brief Decodificador de los bloques generados por SeriesEncoder.
+ *
+ * Lee directamente de la memoria indicada (por ejemplo, un archivo mapeado), sin copiarla.
+ */
+class SeriesDecoder
+{
+public:
+    /**
+     * @brief Prepara la lectura de un bloque.
+     * @param data Inicio del flujo codificado.
+     * @param size Bytes disponibles.
+     * @param count Muestras del bloque.
+     */
+    SeriesDecoder(const uchar *data, qint64 size, quint32 count);
+
+    /**
+     * @brief Decodifica la siguiente muestra.
+     * @param timestampMs Recibe la marca de tiempo.
+     * @param value Recibe el valor.
+     * @return false al terminar el bloque o si el flujo está truncado.
+     */
+    bool next(qint64 *timestampMs, double *value);
+
+    /**
+     * @brief Indica si el flujo terminó antes de lo esperado.
+     * @return true si faltaban bits para alguna muestra.
+     */
+    bool truncated() const { return m_truncated; }
+
+private:
+    /**
+     * @brief Lee bits del flujo (de mayor a menor peso).
+     * @param bits Número de bits (1-64).
+     * @return Valor leído (0 y truncated() si no quedan bits).
+     */
+    quint64 readBits(int bits);
+
+    /**
+     * @brief Lee un único bit.
+     * @return Valor del bit.
+     */
+    bool readBit() { return readBits(1) != 0; }
+
+    const uchar *m_data;         /**< Flujo codificado. */
+    qint64 m_size;               /**< Bytes del flujo. */
+    qint64 m_pos;                /**< Siguiente byte a cargar. */
+    quint64 m_acc;               /**< Bits cargados (alineados a la izquierda). */
+    int m_avail;                 /**< Bits válidos en m_acc. */
+    quint32 m_remaining;         /**< Muestras por leer. */
+    quint32 m_read;              /**< Muestras leídas. */
+    bool m_truncated;            /**< Faltaron bits. */
+    qint64 m_prevTimestamp;      /**< Marca de la muestra anterior. */
+    qint64 m_prevDelta;          /**< Delta anterior. */
+    quint64 m_prevValue;         /**< Bits del valor anterior. */
+    int m_leading;               /**< Ceros a la izquierda de la ventana actual. */
+    int m_trailing;              /**< Ceros a la derecha de la ventana actual. */
+};
+
+#endif // SERIESCODEC_H
@@ -0,0 +1,161 @@
+#ifndef SLOWQUERYLOG_H
+#define SLOWQUERYLOG_H
+
+#include <QString>
+#include <QStringList>
+#include <QVariantList>
+#include <QDateTime>
+#include <QList>
+#include <QSqlDatabase>
+#include <QSqlQuery>
+
+class QSqlDriver;
+
+/**
+ * @brief Sentencias lentas agrupadas por su SQL normalizado.
+ */
+struct SlowQueryEntry
+{
+    QString sql;                   /**< SQL normalizado (literales y listas IN sustituidos por '?'). */
+    QString sampleSql;             /**< SQL de la última ejecución lenta, sin normalizar. */
+    QStringList parameterShapes;   /**< Formas distintas de los parámetros, p. ej. "(int, text(12))". */
+    QStringList plan;              /**< Salida de EXPLAIN QUERY PLAN (una línea por paso, sangrada). */
+    bool fullScan = false;         /**< El plan recorre una tabla o índice completo (SCAN). */
+    qint64 count = 0;              /**< Ejecuciones por encima del umbral. */
+    qint64 totalUs = 0;            /**< Suma de sus duraciones (microsegundos). */
+    qint64 maxUs = 0;              /**< Duración máxima (microsegundos). */
+    QDateTime lastSeen;            /**< Última ejecución lenta. */
+
+    double averageUs() const { return count > 0 ? double(totalUs) / count : 0.0; }
+};
+
+/**
+ * @brief Registro de consultas lentas con captura automática del plan de SQLite.
+ *
+ * exec() sustituye a QSqlQuery::exec() en la capa de datos (DeviceManager, User, el
+ * modelo de la tabla, la búsqueda y el almacén de logs): mide la ejecución y, si supera
+ * el umbral, la agrupa por su SQL normalizado junto con la forma de los parámetros
+ * enlazados (tipos y longitudes, nunca sus valores; los marcadores de credenciales como
+ * :pass o :password solo constan como "redacted"). La primera vez que una sentencia
+ * resulta lenta se obtiene su EXPLAIN QUERY PLAN en la misma conexión (la del driver de
+ * la consulta, sin buscarla por nombre) y se avisa con qWarning(), de modo que un
+ * recorrido completo (SCAN) se ve sin adjuntar un perfilador.
+ *
+ * Con el registro desactivado (umbral negativo), exec() solo añade una lectura atómica.
+ * Se mide la ejecución (el primer paso de SQLite): en las consultas con COUNT, ORDER BY
+ * sin índice o agregados es donde se hace casi todo el trabajo.
+ *
+ * DatabaseManager::closeDatabase() acumula los resultados de la sesión en
+ * consultas-lentas.json, junto a la base de datos.
+ */
+class SlowQueryLog
+{
+public:
+    static constexpr int MaxParameterShapes = 8;   /**< Formas de parámetros guardadas por sentencia. */
+
+    /**
+     * @brief Umbral a partir del cual una sentencia se registra.
+     * @param ms Milisegundos (negativo para desactivar el registro; por defecto 100).
+     */
+    static void setThresholdMs(int ms);
+
+    /**
+     * @brief Umbral actual en milisegundos (negativo si está desactivado).
+     */
+    static int thresholdMs();
+
+    /**
+     * @brief El registro está activo.
+     */
+    static bool isEnabled();
+
+    /**
+     * @brief Ejecuta una sentencia preparada y la registra si es lenta.
+     * @param query Sentencia con sus parámetros ya enlazados.
+     * @return Resultado de QSqlQuery::exec().
+     */
+    static bool exec(QSqlQuery &query);
+
+    /**
+     * @brief Ejecuta SQL directo y lo registra si es lento.
+     * @param query Consulta sobre la conexión en la que ejecutar.
+     * @param sql Sentencia a ejecutar.
+     * @return Resultado de QSqlQuery::exec(sql).
+     */
+    static bool exec(QSqlQuery &query, const QString &sql);
+
+    /**
+     * @brief Confirma la transacción de la conexión y registra el COMMIT si es lento.
+     * @param db Conexión con una transacción abierta.
+     * @return Resultado de QSqlDatabase::commit().
+     */
+    static bool commit(QSqlDatabase &db);
+
+    /**
+     * @brief Registra una ejecución ya medida (sin comprobar el umbral).
+     * @param sql SQL ejecutado.
+     * @param params Parámetros enlazados.
+     * @param elapsedUs Duración en microsegundos.
+     * @param driver Driver de la conexión para obtener el plan (nullptr para omitirlo).
+     */
+    static void record(const QString &sql, const QVariantList &params, qint64 elapsedUs, const QSqlDriver *driver);
+
+    /**
+     * @brief SQL con los literales, marcadores con nombre y listas IN sustituidos por '?'.
+     *
+     * "SELECT * FROM devices WHERE id IN (3,5,8) AND name = 'x'" se normaliza como
+     * "SELECT * FROM devices WHERE id IN (?...) AND name = ?".
+     *
+     * @param sql Sentencia original.
+     * @return Sentencia normalizada (espacios colapsados).
+     */
+    static QString normalize(const QString &sql);
+
+    /**
+     * @brief Forma de una lista de parámetros: tipo de cada uno y longitud de textos y blobs.
+     *
+     * Los parámetros cuyo marcador nombra una credencial (pass, pwd, secret, token...) se
+     * registran como "redacted", sin tipo ni longitud. Si los nombres no cuadran con los
+     * parámetros y alguno es una credencial, se ocultan todos los textos y blobs.
+     *
+     * @param params Parámetros enlazados.
+     * @param names Nombre del marcador de cada parámetro ("" para '?'), como placeholderNames().
+     * @return Texto como "(int, text(12), null, redacted)".
+     */
+    static QString parameterShape(const QVariantList &params, const QStringList &names = QStringList());
+
+    /**
+     * @brief Nombres de los marcadores de una sentencia, en orden, sin ':', '@' ni '$'.
+     * Los '?' aparecen como cadena vacía; se ignora lo que hay dentro de literales.
+     * @param sql Sentencia original.
+     * @return Un nombre por marcador.
+     */
+    static QStringList placeholderNames(const QString &sql);
+
+    /**
+     * @brief Sentencias registradas en esta sesión, de mayor a menor tiempo total.
+     */
+    static QList<SlowQueryEntry> entries();
+
+    /**
+     * @brief Descarta las sentencias registradas.
+     */
+    static void clear();
+
+    /**
+     * @brief Resumen de las sentencias con más tiempo total, con su plan.
+     * @param maxEntries Sentencias a incluir.
+     * @return Texto para el log.
+     */
+    static QString report(int maxEntries = 10);
+
+    /**
+     * @brief Acumula las sentencias de la sesión en un archivo JSON.
+     * Si el archivo existe, suma sus contadores a los de cada SQL normalizado.
+     * @param fileName Archivo de destino.
+     * @return true si se escribió.
+     */
+    static bool save(const QString &fileName);
+};
+
+#endif // SLOWQUERYLOG_H
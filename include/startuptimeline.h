@@ -0,0 +1,95 @@
+#ifndef STARTUPTIMELINE_H
+#define STARTUPTIMELINE_H
+
+#include <QString>
+#include <QList>
+
+/**
+ * @brief Fase del arranque medida por StartupTimeline.
+ */
+struct StartupPhase
+{
+    QString name;           /**< Nombre de la fase. */
+    qint64 startUs = 0;     /**< Inicio, desde el comienzo del proceso (microsegundos). */
+    qint64 durationUs = 0;  /**< Duración (0 para los hitos). */
+};
+
+/**
+ * @brief Cronología del arranque de la aplicación.
+ *
+ * Registra la duración de cada fase (crear la interfaz, aplicar estilos, migrar el
+ * esquema, abrir el almacén de series...) y los hitos (primer fotograma, sesión
+ * disponible), todos relativos a start(), que se llama al principio de main().
+ * report() produce la tabla que se escribe en el log al terminar el arranque, de modo
+ * que una regresión se ve comparando dos arranques.
+ *
+ * Todos los métodos son estáticos y seguros entre hilos: las fases que se ejecutan en
+ * segundo plano se registran igual que las del hilo de la interfaz.
+ */
+class StartupTimeline
+{
+public:
+    /**
+     * @brief Mide una fase desde su construcción hasta su destrucción.
+     */
+    class Scope
+    {
+    public:
+        /**
+         * @brief Empieza a medir la fase.
+         * @param name Nombre de la fase.
+         */
+        explicit Scope(const QString &name);
+
+        /**
+         * @brief Registra la fase con su duración.
+         */
+        ~Scope();
+
+        Scope(const Scope &) = delete;
+        Scope &operator=(const Scope &) = delete;
+
+    private:
+        QString m_name;    /**< Nombre de la fase. */
+        qint64 m_startUs;  /**< Inicio de la fase. */
+    };
+
+    /**
+     * @brief Fija el origen de tiempos (llamar al principio de main()).
+     * Si no se llama, el origen es el primer uso de la clase.
+     */
+    static void start();
+
+    /**
+     * @brief Registra un hito (fase de duración cero) en el momento actual.
+     * @param name Nombre del hito.
+     */
+    static void mark(const QString &name);
+
+    /**
+     * @brief Tiempo transcurrido desde el origen.
+     * @return Microsegundos.
+     */
+    static qint64 elapsedUs();
+
+    /**
+     * @brief Fases registradas, en orden de inicio.
+     * @return Copia de la cronología.
+     */
+    static QList<StartupPhase> phases();
+
+    /**
+     * @brief Tabla de la cronología, una fase por línea (inicio, duración y nombre en ms).
+     * @return Texto para el log.
+     */
+    static QString report();
+
+    /**
+     * @brief Resumen en una línea de las fases más largas y el tiempo total.
+     * @param maxPhases Fases a incluir (las de mayor duración).
+     * @return Texto para el registro de auditoría.
+     */
+    static QString summary(int maxPhases = 5);
+};
+
+#endif // STARTUPTIMELINE_H
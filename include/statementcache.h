@@ -0,0 +1,109 @@
+#ifndef STATEMENTCACHE_H
+#define STATEMENTCACHE_H
+
+#include <QSqlQuery>
+#include <QString>
+#include <atomic>
+#include <list>
+#include <memory>
+#include <unordered_map>
+
+/**
+ * @brief Contadores de las cachés de sentencias de un pool (instantánea).
+ */
+struct StatementCacheStats
+{
+    qint64 hits = 0;        /**< Sentencias entregadas ya preparadas. */
+    qint64 misses = 0;      /**< Sentencias que hubo que preparar (análisis y plan). */
+    qint64 evictions = 0;   /**< Sentencias descartadas por LRU. */
+
+    /**
+     * @brief Proporción de aciertos.
+     * @return Valor entre 0 y 1 (0 si aún no hubo peticiones).
+     */
+    double hitRate() const { return hits + misses > 0 ? double(hits) / double(hits + misses) : 0.0; }
+};
+
+/**
+ * @brief Caché LRU de sentencias preparadas de una conexión.
+ *
+ * Cada QSqlQuery guarda su sqlite3_stmt compilado; acquire() devuelve la misma sentencia
+ * para el mismo texto SQL, reiniciada (finish()) y lista para enlazar valores y
+ * ejecutar, sin volver a analizar ni planificar la consulta. Al superar la capacidad se
+ * finaliza la sentencia usada hace más tiempo.
+ *
+ * Como la conexión, la caché pertenece a un único hilo (ConnectionPool crea una por
+ * conexión); solo los contadores compartidos son atómicos.
+ */
+class StatementCache
+{
+public:
+    /**
+     * @brief Contadores compartidos por todas las cachés de un pool.
+     */
+    struct Counters
+    {
+        std::atomic<qint64> hits{ 0 };
+        std::atomic<qint64> misses{ 0 };
+        std::atomic<qint64> evictions{ 0 };
+    };
+
+    /**
+     * @brief Constructor de la clase StatementCache.
+     * @param connectionName Conexión en la que se preparan las sentencias.
+     * @param capacity Número máximo de sentencias (mínimo 4).
+     * @param counters Contadores donde acumular aciertos, fallos y desalojos.
+     */
+    StatementCache(const QString &connectionName, int capacity, std::shared_ptr<Counters> counters);
+
+    StatementCache(const StatementCache &) = delete;
+    StatementCache &operator=(const StatementCache &) = delete;
+
+    /**
+     * @brief Sentencia preparada para un texto SQL.
+     *
+     * La referencia sigue siendo válida hasta que la sentencia se desaloje (capacity()
+     * peticiones de otras sentencias). Si la preparación falla, se devuelve una sentencia
+     * no cacheada cuyo exec() falla con el error de preparación en lastError().
+     *
+     * @param sql Texto de la consulta (también es la clave de la caché).
+     * @return Sentencia de solo avance, reiniciada y sin resultados pendientes.
+     */
+    QSqlQuery &acquire(const QString &sql);
+
+    /**
+     * @brief Finaliza todas las sentencias (antes de cerrar la conexión).
+     */
+    void clear();
+
+    /**
+     * @brief Sentencias preparadas en la caché.
+     * @return Número de sentencias.
+     */
+    int size() const;
+
+    /**
+     * @brief Nombre de la conexión de la caché.
+     * @return Nombre de la conexión.
+     */
+    QString connectionName() const;
+
+private:
+    /**
+     * @brief Sentencia cacheada y su posición en la lista LRU.
+     */
+    struct Node
+    {
+        std::unique_ptr<QSqlQuery> query;
+        std::list<QString>::iterator position;
+    };
+
+    QString m_connectionName;                     /**< Conexión de las sentencias. */
+    int m_capacity;                               /**< Sentencias máximas. */
+    std::shared_ptr<Counters> m_counters;         /**< Contadores del pool. */
+    std::list<QString> m_lru;                     /**< Textos SQL, del más reciente al más antiguo. */
+    std::unordered_map<QString, Node> m_entries;  /**< Sentencias por texto SQL. */
+    std::unique_ptr<QSqlQuery> m_failed;          /**< Última sentencia que no se pudo preparar. */
+};
+
+#endif // STATEMENTCACHE_H
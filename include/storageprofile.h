@@ -0,0 +1,81 @@
+#ifndef STORAGEPROFILE_H
+#define STORAGEPROFILE_H
+
+#include <QString>
+#include <QStringList>
+
+/**
+ * @brief Perfil de almacenamiento: parámetros PRAGMA con los que se abre cada conexión SQLite.
+ *
+ * Perfiles predefinidos (seleccionables con --storage-profile o la clave
+ * "storage/profile" de la configuración):
+ *  - durable:   WAL + synchronous=FULL. Cada COMMIT llega al disco (fsync) antes de
+ *               devolver el control; no se pierde ninguna transacción confirmada.
+ *  - balanced:  WAL + synchronous=NORMAL (valor por defecto). Solo se sincroniza en los
+ *               checkpoints; la base de datos nunca se corrompe, pero un corte de energía
+ *               puede perder las últimas transacciones. Caché de 16 MiB por conexión y
+ *               mmap de 256 MiB.
+ *  - bulk-load: WAL + synchronous=OFF, caché y mmap grandes y checkpoints espaciados.
+ *               Pensado para importaciones masivas; un corte de energía puede perder
+ *               escrituras recientes.
+ *
+ * La caché de páginas (cacheSizeKiB) es de cada conexión: ConnectionPool abre hasta dos
+ * por hilo (lectura y escritura), así que la memoria total es cacheSizeKiB por el número
+ * de conexiones abiertas; con una decena de hilos de trabajo, unas 20. Las páginas
+ * mapeadas con mmap, en cambio, las comparte el sistema entre todas las conexiones.
+ *
+ * Las cifras de cada perfil se obtienen con el benchmark bench_storageprofiles.
+ */
+struct StorageProfile
+{
+    QString name;                   /**< Nombre del perfil ("durable", "balanced", "bulk-load"). */
+    QString journalMode = "WAL";    /**< PRAGMA journal_mode (persistente en el archivo). */
+    QString synchronous = "NORMAL"; /**< PRAGMA synchronous: OFF, NORMAL o FULL. */
+    qint64 mmapSize = 0;            /**< PRAGMA mmap_size en bytes (0 = sin mmap). */
+    int cacheSizeKiB = 2000;        /**< Caché de páginas de cada conexión en KiB (cache_size negativo). */
+    QString tempStore = "DEFAULT";  /**< PRAGMA temp_store: DEFAULT, FILE o MEMORY. */
+    int walAutoCheckpoint = 1000;   /**< Páginas del WAL antes de un checkpoint automático. */
+    int busyTimeoutMs = 5000;       /**< Espera ante bloqueos antes de devolver SQLITE_BUSY. */
+
+    /**
+     * @brief Perfil de máxima durabilidad.
+     * @return Perfil "durable".
+     */
+    static StorageProfile durable();
+
+    /**
+     * @brief Perfil por defecto: durabilidad ante caídas de la aplicación, pocas sincronizaciones.
+     * @return Perfil "balanced".
+     */
+    static StorageProfile balanced();
+
+    /**
+     * @brief Perfil para cargas masivas.
+     * @return Perfil "bulk-load".
+     */
+    static StorageProfile bulkLoad();
+
+    /**
+     * @brief Busca un perfil predefinido por nombre (sin distinguir mayúsculas).
+     * @param name Nombre del perfil.
+     * @param profile Recibe el perfil encontrado.
+     * @return true si el nombre corresponde a un perfil conocido.
+     */
+    static bool fromName(const QString &name, StorageProfile *profile);
+
+    /**
+     * @brief Nombres de los perfiles predefinidos.
+     * @return Lista de nombres válidos.
+     */
+    static QStringList names();
+
+    /**
+     * @brief Sentencias PRAGMA que se ejecutan al abrir cada conexión.
+     * No incluye journal_mode, que se fija una sola vez con la conexión de escritura.
+     * @param readOnly true si la conexión es de solo lectura.
+     * @return Sentencias a ejecutar, en orden.
+     */
+    QStringList connectionPragmas(bool readOnly) const;
+};
+
+#endif // STORAGEPROFILE_H
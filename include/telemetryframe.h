@@ -0,0 +1,90 @@
+#ifndef TELEMETRYFRAME_H
+#define TELEMETRYFRAME_H
+
+#include <QByteArray>
+#include <QList>
+#include <QtGlobal>
+
+/**
+ * @brief Formato binario de las tramas de telemetría UDP y kernel de calibración.
+ *
+ * Cada datagrama lleva una trama de un único dispositivo (identificado por la dirección
+ * de origen), en little-endian:
+ *
+ *     0   quint32  magic ('TLM1')
+ *     4   quint16  número de lecturas (1..MaxSamples)
+ *     6   quint16  secuencia (crece en 1 por trama; los saltos son tramas perdidas)
+ *     8   qint64   marca base (milisegundos desde el epoch, UTC)
+ *    16   N x { quint32 desplazamiento en ms desde la base, float valor sin calibrar }
+ *
+ * Con 8 bytes por lectura, una trama de MaxSamples lecturas cabe en un datagrama sin
+ * fragmentar en una red Ethernet (1472 bytes de carga útil).
+ */
+class TelemetryFrame
+{
+public:
+    static constexpr quint32 Magic = 0x314D4C54;   /**< 'TLM1' en little-endian. */
+    static constexpr int HeaderBytes = 16;          /**< Tamaño de la cabecera. */
+    static constexpr int SampleBytes = 8;           /**< Tamaño de cada lectura. */
+    static constexpr int MaxSamples = 182;          /**< Lecturas que caben en 1472 bytes. */
+
+    /**
+     * @brief Lectura sin calibrar tal como viaja en la trama.
+     */
+    struct Sample
+    {
+        qint64 timestampMs = 0;   /**< Marca de tiempo absoluta. */
+        float value = 0.0f;       /**< Valor medido por el equipo. */
+    };
+
+    /**
+     * @brief Cabecera decodificada.
+     */
+    struct Header
+    {
+        int count = 0;            /**< Lecturas de la trama. */
+        quint16 sequence = 0;     /**< Número de secuencia. */
+        qint64 baseMs = 0;        /**< Marca base. */
+    };
+
+    /**
+     * @brief Construye una trama (usado por los equipos simulados y las pruebas).
+     * @param sequence Número de secuencia.
+     * @param samples Lecturas (como máximo MaxSamples, sin marcas anteriores a la primera).
+     * @return Trama lista para enviar, o vacía si las lecturas no caben.
+     */
+    static QByteArray encode(quint16 sequence, const QList<Sample> &samples);
+
+    /**
+     * @brief Valida una trama y lee su cabecera.
+     * @param data Inicio del datagrama.
+     * @param size Bytes recibidos.
+     * @param header Recibe la cabecera.
+     * @return true si la trama es válida y su longitud coincide con el número de lecturas.
+     */
+    static bool parseHeader(const uchar *data, qsizetype size, Header *header);
+
+    /**
+     * @brief Extrae las lecturas de una trama ya validada con parseHeader().
+     * @param data Inicio del datagrama.
+     * @param header Cabecera de la trama.
+     * @param timestampsMs Recibe header.count marcas de tiempo absolutas.
+     * @param raw Recibe header.count valores sin calibrar.
+     */
+    static void unpack(const uchar *data, const Header &header, qint64 *timestampsMs, float *raw);
+
+    /**
+     * @brief Aplica la calibración a un lote: out[i] = raw[i] + offsets[i].
+     *
+     * Usa instrucciones vectoriales (SSE2 en x86-64, NEON en AArch64; dos lecturas por
+     * instrucción) y un bucle escalar para el resto o en otras arquitecturas.
+     *
+     * @param raw Valores medidos.
+     * @param offsets Calibración del dispositivo de cada lectura.
+     * @param out Recibe los valores calibrados (puede ser el mismo array que offsets).
+     * @param count Número de lecturas.
+     */
+    static void calibrate(const float *raw, const double *offsets, double *out, qsizetype count);
+};
+
+#endif // TELEMETRYFRAME_H
@@ -0,0 +1,243 @@
+#ifndef TELEMETRYRECEIVER_H
+#define TELEMETRYRECEIVER_H
+
+#include <QObject>
+#include <QString>
+#include <QList>
+#include <QHash>
+#include <QHostAddress>
+#include <QThread>
+#include <QMutex>
+#include <QElapsedTimer>
+#include <atomic>
+#include <memory>
+#include "devicemanager.h"
+#include "timeseriesstore.h"
+
+class ConnectionPool;
+class QUdpSocket;
+
+/**
+ * @brief Contadores de la ingesta de telemetría (instantánea).
+ */
+struct TelemetryStats
+{
+    qint64 datagrams = 0;       /**< Datagramas recibidos. */
+    qint64 batches = 0;         /**< Lotes leídos del socket (una llamada al sistema cada uno). */
+    qint64 samples = 0;         /**< Lecturas decodificadas de tramas válidas. */
+    qint64 stored = 0;          /**< Lecturas aceptadas por el almacén. */
+    qint64 malformed = 0;       /**< Datagramas descartados por trama inválida. */
+    qint64 unknownSource = 0;   /**< Datagramas de direcciones sin dispositivo. */
+    qint64 lost = 0;            /**< Tramas perdidas en la red (saltos de secuencia). */
+    qint64 kernelDrops = 0;     /**< Datagramas descartados por el núcleo con el búfer lleno (solo Linux). */
+    qint64 rejected = 0;        /**< Lecturas rechazadas por el almacén (desordenadas). */
+    qint64 elapsedMs = 0;       /**< Tiempo desde start(). */
+
+    /**
+     * @brief Ritmo medio de recepción.
+     * @return Datagramas por segundo desde start().
+     */
+    double datagramsPerSecond() const { return elapsedMs > 0 ? datagrams * 1000.0 / elapsedMs : 0.0; }
+
+    /**
+     * @brief Aprovechamiento de cada llamada al sistema.
+     * @return Datagramas medios por lote.
+     */
+    double datagramsPerBatch() const { return batches > 0 ? double(datagrams) / batches : 0.0; }
+};
+
+/**
+ * @brief Servicio de ingesta de telemetría UDP por lotes.
+ *
+ * Un hilo propio lee los datagramas del socket por lotes (en Linux, hasta batchSize
+ * datagramas por llamada a recvmmsg(); en otras plataformas, con QUdpSocket). Cada
+ * datagrama lleva una TelemetryFrame de un dispositivo, que se identifica por la
+ * dirección IPv4 de origen en un índice hash (dirección -> ID y calibración).
+ *
+ * Las lecturas de todo el lote se acumulan en columnas, la calibración de cada
+ * dispositivo se aplica de una vez con TelemetryFrame::calibrate() y el lote completo
+ * se guarda con una sola llamada a TimeSeriesStore::append(). No se crea ningún Device
+ * ni se emite ninguna señal por lectura.
+ *
+ * El índice se reemplaza entero (copia y cambio de puntero) en loadDevices() y
+ * applyChanges(); el hilo receptor toma la versión vigente al principio de cada lote.
+ * La tabla 'devices' se lee en un hilo de carga aparte, nunca en el hilo del objeto.
+ */
+class TelemetryReceiver : public QObject
+{
+    Q_OBJECT
+
+public:
+    static constexpr quint16 DefaultPort = 5001;   /**< Puerto UDP por defecto. */
+
+    /**
+     * @brief Constructor de la clase TelemetryReceiver.
+     * @param store Almacén donde se guardan las lecturas (no es propietario).
+     * @param parent Objeto padre opcional.
+     */
+    explicit TelemetryReceiver(TimeSeriesStore *store, QObject *parent = nullptr);
+
+    /**
+     * @brief Destructor de la clase.
+     * Detiene el hilo receptor y el de carga.
+     */
+    ~TelemetryReceiver();
+
+    /**
+     * @brief Datagramas leídos por llamada al sistema (se aplica en el próximo start()).
+     * @param datagrams Tamaño del lote (1-1024; por defecto 64).
+     */
+    void setBatchSize(int datagrams);
+
+    /**
+     * @brief Tamaño pedido para el búfer de recepción del socket (próximo start()).
+     * @param bytes Bytes (por defecto 4 MB; el sistema puede limitarlo).
+     */
+    void setReceiveBufferSize(int bytes);
+
+    /**
+     * @brief Reconstruye el índice de direcciones a partir de la tabla 'devices'.
+     *
+     * La consulta se hace en el hilo de carga y el índice se publica al llegar; hasta
+     * entonces sigue vigente el anterior. Los cambios recibidos por applyChanges()
+     * mientras tanto se vuelven a aplicar sobre el índice leído.
+     * @param pool Pool de conexiones del que se toma el lector del hilo de carga.
+     */
+    void loadDevices(ConnectionPool *pool);
+
+    /**
+     * @brief Reemplaza el índice de direcciones.
+     * @param devices Dispositivos (se usan id, ip y calibration).
+     */
+    void setDevices(const QList<DeviceRecord> &devices);
+
+    /**
+     * @brief Abre el socket y arranca el hilo receptor.
+     * @param address Dirección local (por defecto todas las interfaces IPv4).
+     * @param port Puerto UDP (0 para que el sistema elija uno; ver port()).
+     * @return false si ya estaba en marcha o no se pudo abrir el puerto.
+     */
+    bool start(const QHostAddress &address = QHostAddress::AnyIPv4, quint16 port = DefaultPort);
+
+    /**
+     * @brief Detiene el hilo receptor y cierra el socket.
+     * Cada lote se guarda en cuanto se recibe, así que no queda nada pendiente.
+     */
+    void stop();
+
+    /**
+     * @brief Indica si el hilo receptor está en marcha.
+     * @return true entre start() y stop().
+     */
+    bool isRunning() const;
+
+    /**
+     * @brief Puerto local en el que se escucha.
+     * @return Puerto, o 0 si está detenido.
+     */
+    quint16 port() const;
+
+    /**
+     * @brief Instantánea de los contadores.
+     * @return Contadores acumulados desde el último start().
+     */
+    TelemetryStats stats() const;
+
+public slots:
+    /**
+     * @brief Actualiza el índice con los cambios de la flota.
+     * @param changes Altas, modificaciones (IP o calibración) y bajas.
+     */
+    void applyChanges(const QList<DeviceChange> &changes);
+
+private:
+    /**
+     * @brief Dispositivo asociado a una dirección de origen.
+     */
+    struct Source
+    {
+        int deviceId = -1;          /**< ID del dispositivo. */
+        double calibration = 0.0;   /**< Desplazamiento que se suma a cada lectura. */
+    };
+
+    using SourceIndex = QHash<quint32, Source>;
+
+    /**
+     * @brief Bucle del hilo receptor.
+     */
+    void run();
+
+    /**
+     * @brief Decodifica y guarda un lote de datagramas.
+     * @param datagrams Cargas útiles recibidas.
+     * @param sizes Bytes de cada una.
+     * @param sources Dirección IPv4 de origen de cada una (orden de host).
+     * @param count Datagramas del lote.
+     */
+    void processBatch(const uchar *const *datagrams, const qsizetype *sizes, const quint32 *sources, int count);
+
+    /**
+     * @brief Índice vigente.
+     * @return Copia del puntero compartido (válida aunque se reemplace después).
+     */
+    std::shared_ptr<const SourceIndex> currentIndex() const;
+
+    /**
+     * @brief Publica un índice nuevo.
+     * @param index Índice completo.
+     */
+    void publishIndex(SourceIndex index);
+
+    /**
+     * @brief Publica el índice leído por loadDevices() (hilo del objeto).
+     * @param generation Generación de la carga que lo produjo.
+     * @param index Índice leído de la tabla 'devices'.
+     */
+    void applyLoadedIndex(quint64 generation, SourceIndex index);
+
+    /**
+     * @brief Convierte una dirección en texto a la clave del índice.
+     * @param ip Dirección IPv4 en texto.
+     * @param key Recibe la dirección en orden de host.
+     * @return false si no es una dirección IPv4 válida.
+     */
+    static bool addressKey(const QString &ip, quint32 *key);
+
+    TimeSeriesStore *m_store;                       /**< Almacén de lecturas. */
+    int m_batchSize;                                /**< Datagramas por lote. */
+    int m_receiveBufferSize;                        /**< Búfer del socket solicitado. */
+
+    mutable QMutex m_indexMutex;                    /**< Protege el puntero del índice. */
+    std::shared_ptr<const SourceIndex> m_index;     /**< Dirección -> dispositivo. */
+
+    QThread m_loader;                               /**< Hilo de lectura de la tabla 'devices'. */
+    QObject *m_loaderContext;                       /**< Objeto de contexto que vive en m_loader. */
+    std::atomic<quint64> m_generation;              /**< Generación de la carga vigente. */
+    bool m_loading;                                 /**< Hay una carga en curso. */
+    QList<DeviceChange> m_changesWhileLoading;      /**< Cambios recibidos durante la carga. */
+
+    QThread *m_thread;                              /**< Hilo receptor. */
+    std::atomic<bool> m_stopping;                   /**< Se solicitó detener el receptor. */
+    int m_socket;                                   /**< Descriptor del socket (Linux; -1 si cerrado). */
+    QUdpSocket *m_udp;                              /**< Socket en otras plataformas. */
+    quint16 m_port;                                 /**< Puerto local abierto. */
+    QElapsedTimer m_clock;                          /**< Tiempo desde start(). */
+    qint64 m_elapsedMs;                             /**< Duración de la última sesión (tras stop()). */
+
+    // Estado del hilo receptor (no se comparte)
+    QHash<int, quint16> m_lastSequence;             /**< Última secuencia vista por dispositivo. */
+    SeriesBatch m_batch;                            /**< Columnas del lote en curso. */
+    QList<float> m_raw;                             /**< Valores sin calibrar del lote. */
+
+    std::atomic<qint64> m_datagrams;                /**< Contador: datagramas. */
+    std::atomic<qint64> m_batches;                  /**< Contador: lotes. */
+    std::atomic<qint64> m_samples;                  /**< Contador: lecturas decodificadas. */
+    std::atomic<qint64> m_stored;                   /**< Contador: lecturas guardadas. */
+    std::atomic<qint64> m_malformed;                /**< Contador: tramas inválidas. */
+    std::atomic<qint64> m_unknownSource;            /**< Contador: orígenes desconocidos. */
+    std::atomic<qint64> m_lost;                     /**< Contador: tramas perdidas. */
+    std::atomic<qint64> m_kernelDrops;              /**< Contador: descartes del núcleo. */
+    std::atomic<qint64> m_rejected;                 /**< Contador: lecturas rechazadas. */
+};
+
+#endif // TELEMETRYRECEIVER_H
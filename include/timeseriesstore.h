@@ -0,0 +1,391 @@
+#ifndef TIMESERIESSTORE_H
+#define TIMESERIESSTORE_H
+
+#include <QString>
+#include <QList>
+#include <QHash>
+#include <QFile>
+#include <QElapsedTimer>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include "seriescodec.h"
+
+class RollupEngine;
+
+/**
+ * @brief Lectura de un dispositivo en un instante.
+ */
+struct SeriesPoint
+{
+    qint64 timestampMs = 0;   /**< Milisegundos desde el epoch (UTC). */
+    double value = 0.0;       /**< Valor leído. */
+};
+
+/**
+ * @brief Lote de lecturas de varios dispositivos en columnas paralelas.
+ *
+ * Es la forma en que llegan de la ingesta de telemetría: las tres listas tienen la misma
+ * longitud y cada posición es una lectura.
+ */
+struct SeriesBatch
+{
+    QList<int> deviceIds;       /**< Dispositivo de cada lectura. */
+    QList<qint64> timestampsMs; /**< Marca de tiempo de cada lectura. */
+    QList<double> values;       /**< Valor de cada lectura. */
+
+    /**
+     * @brief Número de lecturas del lote.
+     * @return Longitud de las columnas.
+     */
+    qsizetype size() const { return deviceIds.size(); }
+
+    /**
+     * @brief Vacía el lote conservando la memoria reservada.
+     */
+    void clear()
+    {
+        deviceIds.resize(0);
+        timestampsMs.resize(0);
+        values.resize(0);
+    }
+};
+
+/**
+ * @brief Métricas del almacén de series.
+ */
+struct TimeSeriesStats
+{
+    int devices = 0;            /**< Dispositivos con lecturas. */
+    int segments = 0;           /**< Archivos de segmento. */
+    qint64 chunks = 0;          /**< Bloques sellados en disco. */
+    qint64 storedPoints = 0;    /**< Lecturas en bloques sellados. */
+    qint64 openPoints = 0;      /**< Lecturas en bloques abiertos (solo en memoria). */
+    qint64 diskBytes = 0;       /**< Tamaño de los segmentos. */
+    qint64 rejected = 0;        /**< Lecturas descartadas por llegar desordenadas. */
+
+    /**
+     * @brief Bytes de disco por lectura sellada (cabeceras incluidas).
+     * @return Media de bytes por lectura.
+     */
+    double bytesPerPoint() const { return storedPoints > 0 ? double(diskBytes) / storedPoints : 0.0; }
+};
+
+/**
+ * @brief Almacén de series temporales de lecturas por dispositivo.
+ *
+ * Cada dispositivo acumula sus lecturas en un bloque abierto en memoria, comprimido con
+ * SeriesEncoder (delta de delta para las marcas de tiempo y XOR para los valores).
+ * Cuando el bloque llega a chunkPoints lecturas, o con flush(), se sella y se añade al
+ * final del segmento activo (series-NNNNNN.tsd); los segmentos nunca se reescriben y se
+ * cambia de archivo al superar segmentBytes.
+ *
+ * Cada bloque lleva una cabecera con dispositivo, número de lecturas y rango de
+ * tiempo. Al abrir se recorren solo las cabeceras para reconstruir el índice en memoria
+ * (bloques de cada dispositivo ordenados por tiempo); una cola truncada por un cierre
+ * inesperado se recorta. Las consultas localizan los bloques del rango por búsqueda
+ * binaria y los decodifican directamente del archivo mapeado en memoria (QFile::map),
+ * sin copias ni lecturas intermedias.
+ *
+ * Durabilidad: los bloques abiertos solo están en memoria. flushExpired(), llamado
+ * periódicamente (DatabaseManager lo hace cada segundo), sella los que llevan abiertos
+ * más de maxOpenAge ms y pasa el segmento al sistema operativo; así un cierre inesperado
+ * del proceso pierde como mucho las lecturas de los últimos maxOpenAge ms más un periodo
+ * de ese volcado (por defecto, unos 11 s). No se llama a fsync: ante un corte de corriente
+ * se pierde además lo que el sistema no haya escrito todavía en el disco.
+ *
+ * Las lecturas de cada dispositivo deben llegar en orden de tiempo; las anteriores a la
+ * última se descartan. Es seguro entre hilos: append() y query() se serializan con un
+ * mutex, pero la decodificación de query() se hace fuera de él. Para ingerir a gran
+ * ritmo conviene usar append() por lotes.
+ */
+class TimeSeriesStore
+{
+public:
+    /**
+     * @brief Constructor de la clase TimeSeriesStore.
+     * @param directory Carpeta de los segmentos (se crea si no existe).
+     */
+    explicit TimeSeriesStore(const QString &directory);
+
+    /**
+     * @brief Destructor de la clase.
+     * Sella los bloques abiertos y cierra los segmentos.
+     */
+    ~TimeSeriesStore();
+
+    TimeSeriesStore(const TimeSeriesStore &) = delete;
+    TimeSeriesStore &operator=(const TimeSeriesStore &) = delete;
+
+    /**
+     * @brief Carpeta de los segmentos.
+     * @return Ruta absoluta.
+     */
+    QString directory() const;
+
+    /**
+     * @brief Lecturas por bloque antes de sellarlo (antes de open()).
+     * @param points Lecturas por bloque (mínimo 16; por defecto 1024).
+     */
+    void setChunkPoints(int points);
+
+    /**
+     * @brief Tamaño a partir del cual se empieza un segmento nuevo.
+     * @param bytes Bytes por segmento (mínimo 1 MB; por defecto 64 MB).
+     */
+    void setSegmentBytes(qint64 bytes);
+
+    /**
+     * @brief Tiempo máximo que un bloque puede seguir abierto (solo en memoria).
+     * Valores bajos acotan más la pérdida en un cierre inesperado a cambio de bloques
+     * más pequeños (peor compresión en dispositivos con pocas lecturas).
+     * @param ms Milisegundos (mínimo 100; por defecto 10000).
+     */
+    void setMaxOpenAge(int ms);
+
+    /**
+     * @brief Reconstruye el índice a partir de los segmentos y prepara el segmento activo.
+     * @return true si la carpeta y el segmento activo se pudieron abrir.
+     */
+    bool open();
+
+    /**
+     * @brief Sella los bloques abiertos y cierra los archivos.
+     */
+    void close();
+
+    /**
+     * @brief Añade una lectura.
+     * @param deviceId ID del dispositivo.
+     * @param timestampMs Marca de tiempo (no anterior a la última del dispositivo).
+     * @param value Valor leído.
+     * @return true si se guardó; false si llegó desordenada o el almacén no está abierto.
+     */
+    bool append(int deviceId, qint64 timestampMs, double value);
+
+    /**
+     * @brief Añade un lote de lecturas de un dispositivo (un solo bloqueo).
+     * @param deviceId ID del dispositivo.
+     * @param points Lecturas en orden de tiempo.
+     * @return Número de lecturas guardadas.
+     */
+    int append(int deviceId, const QList<SeriesPoint> &points);
+
+    /**
+     * @brief Añade un lote de lecturas de varios dispositivos (un solo bloqueo).
+     * @param batch Lecturas; las de cada dispositivo, en orden de tiempo.
+     * @return Número de lecturas guardadas.
+     */
+    int append(const SeriesBatch &batch);
+
+    /**
+     * @brief Asigna el motor de agregados que recibe cada lectura guardada.
+     * Antes de conectarlo le entrega, bajo el mismo bloqueo que append(), las lecturas
+     * guardadas después de su RollupEngine::backfill() (ver RollupEngine::resumePoint()).
+     * @param rollups Motor de agregados (no es propietario; nullptr para desconectarlo).
+     */
+    void setRollups(RollupEngine *rollups);
+
+    /**
+     * @brief Borra los segmentos cuyas lecturas son todas anteriores a una marca de tiempo.
+     *
+     * Se borran segmentos completos (nunca el activo), así que pueden quedar lecturas
+     * algo más antiguas que la marca hasta que su segmento entero caduque.
+     *
+     * @param cutoffMs Marca de tiempo límite.
+     * @return Número de segmentos borrados.
+     */
+    int removeBefore(qint64 cutoffMs);
+
+    /**
+     * @brief Sella todos los bloques abiertos y vuelca el segmento activo al disco.
+     * @return true si todo se escribió correctamente.
+     */
+    bool flush();
+
+    /**
+     * @brief Sella los bloques abiertos hace más de maxOpenAge ms y vuelca el segmento
+     * activo al disco. Es el volcado periódico que acota la pérdida de lecturas.
+     * @return true si todo se escribió correctamente.
+     */
+    bool flushExpired();
+
+    /**
+     * @brief Recorre las lecturas de un dispositivo en un intervalo, en orden de tiempo.
+     * @param deviceId ID del dispositivo.
+     * @param fromMs Inicio del intervalo (incluido).
+     * @param toMs Fin del intervalo (incluido).
+     * @param visitor Función llamada por cada lectura; devuelve false para detenerse.
+     * @return Lecturas visitadas, o -1 si algún bloque estaba dañado.
+     */
+    qint64 scan(int deviceId, qint64 fromMs, qint64 toMs,
+                const std::function<bool(const SeriesPoint &)> &visitor) const;
+
+    /**
+     * @brief Lecturas de un dispositivo en un intervalo.
+     * @param deviceId ID del dispositivo.
+     * @param fromMs Inicio del intervalo (incluido).
+     * @param toMs Fin del intervalo (incluido).
+     * @param limit Máximo de lecturas (-1 sin límite).
+     * @return Lecturas en orden de tiempo.
+     */
+    QList<SeriesPoint> query(int deviceId, qint64 fromMs, qint64 toMs, int limit = -1) const;
+
+    /**
+     * @brief Dispositivos con lecturas.
+     * @return IDs de los dispositivos.
+     */
+    QList<int> devices() const;
+
+    /**
+     * @brief Métricas del almacén.
+     * @return Copia de los contadores.
+     */
+    TimeSeriesStats stats() const;
+
+private:
+    /**
+     * @brief Archivo de segmento mapeado en memoria (se libera al soltar la última referencia).
+     */
+    struct Mapping
+    {
+        QFile file;              /**< Archivo abierto en solo lectura. */
+        uchar *data = nullptr;   /**< Inicio del mapeo. */
+        qint64 size = 0;         /**< Bytes mapeados. */
+
+        ~Mapping();
+    };
+
+    /**
+     * @brief Segmento en disco.
+     */
+    struct Segment
+    {
+        QString path;                            /**< Ruta del archivo. */
+        qint64 size = 0;                         /**< Bytes escritos. */
+        mutable std::shared_ptr<Mapping> map;    /**< Mapeo actual (puede cubrir menos que size). */
+    };
+
+    /**
+     * @brief Bloque sellado dentro de un segmento.
+     */
+    struct ChunkRef
+    {
+        int segment = 0;         /**< Número de segmento. */
+        qint64 offset = 0;       /**< Inicio de los datos comprimidos. */
+        quint32 bytes = 0;       /**< Bytes comprimidos. */
+        quint32 count = 0;       /**< Lecturas. */
+        qint64 firstMs = 0;      /**< Primera marca de tiempo. */
+        qint64 lastMs = 0;       /**< Última marca de tiempo. */
+    };
+
+    /**
+     * @brief Lecturas de un dispositivo: bloques sellados y bloque abierto.
+     */
+    struct Series
+    {
+        QList<ChunkRef> chunks;  /**< Bloques sellados, en orden de tiempo. */
+        SeriesEncoder open;      /**< Bloque en curso. */
+        qint64 openedMs = 0;     /**< Momento en que se abrió el bloque en curso (m_clock). */
+        qint64 lastMs = 0;       /**< Última marca aceptada. */
+        bool hasData = false;    /**< Hay al menos una lectura. */
+    };
+
+    /**
+     * @brief Bloques de una serie elegidos bajo el mutex para decodificarlos después.
+     */
+    struct Selection
+    {
+        QList<std::shared_ptr<Mapping>> maps;   /**< Mapeo de cada bloque sellado. */
+        QList<ChunkRef> chunks;                 /**< Bloques sellados que cortan el intervalo. */
+        QByteArray openBytes;                   /**< Copia del bloque abierto. */
+        quint32 openCount = 0;                  /**< Lecturas del bloque abierto. */
+    };
+
+    /**
+     * @brief Elige los bloques de una serie que cortan un intervalo (con el mutex adquirido).
+     * @param series Serie del dispositivo.
+     * @param fromMs Inicio del intervalo (incluido).
+     * @param toMs Fin del intervalo (incluido).
+     * @param selection Recibe los bloques.
+     * @return false si algún segmento no se pudo mapear.
+     */
+    bool selectLocked(const Series &series, qint64 fromMs, qint64 toMs, Selection *selection) const;
+
+    /**
+     * @brief Decodifica los bloques elegidos en orden de tiempo.
+     * @param deviceId ID del dispositivo (para los avisos).
+     * @param selection Bloques de selectLocked().
+     * @param fromMs Inicio del intervalo (incluido).
+     * @param toMs Fin del intervalo (incluido).
+     * @param visitor Función llamada por cada lectura; devuelve false para detenerse.
+     * @return Lecturas visitadas, o -1 si algún bloque estaba dañado.
+     */
+    static qint64 visit(int deviceId, const Selection &selection, qint64 fromMs, qint64 toMs,
+                        const std::function<bool(const SeriesPoint &)> &visitor);
+
+    /**
+     * @brief Añade una lectura con el mutex adquirido.
+     * @param deviceId ID del dispositivo.
+     * @param series Serie del dispositivo.
+     * @param timestampMs Marca de tiempo.
+     * @param value Valor leído.
+     * @return true si se aceptó.
+     */
+    bool appendLocked(int deviceId, Series &series, qint64 timestampMs, double value);
+
+    /**
+     * @brief Escribe el bloque abierto de una serie al final del segmento activo.
+     * @param deviceId ID del dispositivo.
+     * @param series Serie del dispositivo.
+     * @return true si se escribió (el bloque abierto queda vacío).
+     */
+    bool seal(int deviceId, Series &series);
+
+    /**
+     * @brief Crea y abre para escritura el segmento siguiente.
+     * @return true si se pudo crear.
+     */
+    bool startSegment();
+
+    /**
+     * @brief Recorre las cabeceras de un segmento y añade sus bloques al índice.
+     * @param number Número de segmento.
+     * @param path Ruta del archivo.
+     * @param last true si es el último (se recorta una cola incompleta).
+     * @return Bytes válidos del segmento.
+     */
+    qint64 indexSegment(int number, const QString &path, bool last);
+
+    /**
+     * @brief Mapeo de un segmento que cubra al menos hasta un desplazamiento.
+     * @param number Número de segmento.
+     * @param end Desplazamiento que debe quedar dentro del mapeo.
+     * @return Mapeo compartido, o nullptr si no se pudo mapear.
+     */
+    std::shared_ptr<Mapping> mapping(int number, qint64 end) const;
+
+    /**
+     * @brief Ruta de un segmento.
+     * @param number Número de segmento.
+     * @return Ruta absoluta.
+     */
+    QString segmentPath(int number) const;
+
+    QString m_directory;                 /**< Carpeta de los segmentos. */
+    int m_chunkPoints;                   /**< Lecturas por bloque. */
+    qint64 m_segmentBytes;               /**< Tamaño máximo de segmento. */
+    int m_maxOpenAgeMs;                  /**< Antigüedad máxima de un bloque abierto. */
+    QElapsedTimer m_clock;               /**< Reloj de la antigüedad de los bloques abiertos. */
+    mutable std::mutex m_mutex;          /**< Protege índice, bloques abiertos y escritor. */
+    mutable QFile m_writer;              /**< Segmento activo (modo añadir). */
+    int m_active;                        /**< Número del segmento activo (0 si cerrado). */
+    QHash<int, Segment> m_segments;      /**< Segmentos por número. */
+    QHash<int, Series> m_series;         /**< Series por dispositivo. */
+    qint64 m_chunkCount;                 /**< Bloques sellados. */
+    qint64 m_storedPoints;               /**< Lecturas selladas. */
+    qint64 m_rejected;                   /**< Lecturas desordenadas descartadas. */
+    RollupEngine *m_rollups;             /**< Agregados alimentados con cada lectura (opcional). */
+};
+
+#endif // TIMESERIESSTORE_H
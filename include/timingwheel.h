@@ -0,0 +1,121 @@
+#ifndef TIMINGWHEEL_H
+#define TIMINGWHEEL_H
+
+#include <QtGlobal>
+#include <QList>
+#include <list>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * @brief Rueda de temporización jerárquica para miles de plazos con coste O(1).
+ *
+ * El tiempo avanza en ticks enteros. Hay Levels niveles de 256 casillas: el nivel 0
+ * cubre los próximos 256 ticks con una casilla por tick, el nivel 1 los siguientes
+ * 256² en casillas de 256 ticks, y así sucesivamente. Programar o cancelar una clave es
+ * insertar o quitar un nodo de una lista; al avanzar solo se mira la casilla del tick
+ * actual y, cada 256 ticks, se reparte ("cascada") una casilla del nivel superior en
+ * el inferior. No hay montículo ni temporizador por clave.
+ *
+ * Con 4 niveles el horizonte es de 256⁴ ticks (más de 13 años con ticks de 100 ms);
+ * los plazos mayores se recortan al horizonte.
+ *
+ * Las claves son enteros (ej. ID de dispositivo) y cada una tiene como mucho un plazo.
+ * No es segura entre hilos.
+ */
+class TimingWheel
+{
+public:
+    static constexpr int SlotBits = 8;                  /**< Bits por nivel. */
+    static constexpr int Slots = 1 << SlotBits;         /**< Casillas por nivel. */
+    static constexpr int Levels = 4;                    /**< Niveles de la rueda. */
+
+    /**
+     * @brief Construye una rueda vacía en el tick 0.
+     */
+    TimingWheel();
+
+    /**
+     * @brief Programa (o reprograma) una clave.
+     * @param key Clave a programar; si ya tenía plazo, se sustituye.
+     * @param delayTicks Ticks desde el actual (0 se trata como 1: vence en el próximo avance).
+     */
+    void schedule(int key, quint64 delayTicks);
+
+    /**
+     * @brief Cancela el plazo de una clave.
+     * @param key Clave a cancelar.
+     * @return true si la clave estaba programada.
+     */
+    bool cancel(int key);
+
+    /**
+     * @brief Indica si una clave tiene un plazo pendiente.
+     * @param key Clave a consultar.
+     * @return true si está programada.
+     */
+    bool contains(int key) const;
+
+    /**
+     * @brief Tick en el que vence una clave.
+     * @param key Clave a consultar.
+     * @return Tick absoluto, o 0 si no está programada.
+     */
+    quint64 expiry(int key) const;
+
+    /**
+     * @brief Avanza el tiempo y recoge las claves vencidas.
+     * Las claves vencidas dejan de estar programadas.
+     * @param ticks Ticks a avanzar.
+     * @return Claves vencidas, en orden de vencimiento.
+     */
+    QList<int> advance(quint64 ticks);
+
+    /**
+     * @brief Elimina todas las claves (el tick actual se conserva).
+     */
+    void clear();
+
+    /**
+     * @brief Tick actual.
+     * @return Ticks avanzados desde la construcción.
+     */
+    quint64 now() const { return m_now; }
+
+    /**
+     * @brief Número de claves programadas.
+     * @return Claves con plazo pendiente.
+     */
+    int size() const { return int(m_nodes.size()); }
+
+private:
+    /**
+     * @brief Plazo de una clave y su posición en la rueda.
+     */
+    struct Node
+    {
+        quint64 expires = 0;             /**< Tick absoluto de vencimiento. */
+        int slot = 0;                    /**< Casilla (nivel * Slots + índice). */
+        std::list<int>::iterator pos;    /**< Posición dentro de la casilla. */
+    };
+
+    /**
+     * @brief Casilla que corresponde a un vencimiento según la distancia al tick actual.
+     * @param expires Tick absoluto de vencimiento.
+     * @return Índice de casilla (nivel * Slots + índice).
+     */
+    int slotFor(quint64 expires) const;
+
+    /**
+     * @brief Reparte una casilla de un nivel superior en los niveles inferiores.
+     * @param level Nivel de la casilla.
+     * @param index Índice de la casilla en su nivel.
+     */
+    void cascade(int level, int index);
+
+    quint64 m_now;                                /**< Tick actual. */
+    std::vector<std::list<int>> m_slots;          /**< Levels * Slots listas de claves. */
+    std::unordered_map<int, Node> m_nodes;        /**< Plazo de cada clave programada. */
+};
+
+#endif // TIMINGWHEEL_H
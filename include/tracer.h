@@ -0,0 +1,123 @@
+#ifndef TRACER_H
+#define TRACER_H
+
+#include <QString>
+#include <atomic>
+
+/**
+ * @brief Trazas de ejecución en formato Chrome trace-event (visibles en Perfetto o chrome://tracing).
+ *
+ * Cada Span mide un tramo (una consulta SQL, un manejador de la interfaz...) y guarda su
+ * duración, el hilo que lo ejecutó y, opcionalmente, las filas afectadas o leídas y un
+ * detalle (el texto SQL). stop() escribe todos los tramos en un archivo JSON.
+ *
+ * Se activa en tiempo de ejecución con start() (opción --trace, variable de entorno
+ * PROYECTO_TRACE o Ctrl+Mayús+T en la ventana principal). Mientras está desactivado,
+ * un Span cuesta una lectura atómica y un salto: no toma el reloj, no reserva memoria
+ * ni copia el detalle.
+ *
+ * Con la traza activa, cada hilo escribe en su propio búfer (su mutex solo compite con
+ * stop()), acotado a MaxEventsPerThread tramos; los que no caben se cuentan como
+ * descartados.
+ */
+class Tracer
+{
+public:
+    static constexpr int MaxEventsPerThread = 500000;   /**< Tramos guardados por hilo y sesión. */
+
+    /**
+     * @brief Tramo medido desde su construcción hasta su destrucción.
+     */
+    class Span
+    {
+    public:
+        /**
+         * @brief Empieza a medir el tramo si la traza está activa.
+         * @param name Nombre del tramo (literal: no se copia).
+         * @param category Categoría ("sql", "ui"...; literal).
+         */
+        explicit Span(const char *name, const char *category = "sql")
+            : m_name(name)
+            , m_category(category)
+            , m_startNs(Tracer::isEnabled() ? Tracer::nowNs() : -1)
+            , m_rows(-1)
+        {
+        }
+
+        /**
+         * @brief Registra el tramo con su duración.
+         */
+        ~Span()
+        {
+            if (m_startNs >= 0) finish();
+        }
+
+        Span(const Span &) = delete;
+        Span &operator=(const Span &) = delete;
+
+        /**
+         * @brief El tramo se está midiendo (la traza estaba activa al crearlo).
+         */
+        bool isActive() const { return m_startNs >= 0; }
+
+        /**
+         * @brief Filas leídas o modificadas por el tramo.
+         * @param rows Número de filas.
+         */
+        void setRows(qint64 rows) { m_rows = rows; }
+
+        /**
+         * @brief Detalle del tramo (texto SQL, archivo...). Solo se guarda si está activo.
+         * @param detail Texto libre.
+         */
+        void setDetail(const QString &detail)
+        {
+            if (m_startNs >= 0) m_detail = detail;
+        }
+
+    private:
+        /**
+         * @brief Guarda el tramo en el búfer del hilo.
+         */
+        void finish();
+
+        const char *m_name;       /**< Nombre del tramo. */
+        const char *m_category;   /**< Categoría. */
+        qint64 m_startNs;         /**< Inicio (-1 si la traza estaba desactivada). */
+        qint64 m_rows;            /**< Filas (-1 si no se indicaron). */
+        QString m_detail;         /**< Detalle opcional. */
+    };
+
+    /**
+     * @brief Activa la traza (descarta los tramos de una sesión anterior).
+     * @param fileName Archivo JSON que escribirá stop().
+     * @return false si ya estaba activa.
+     */
+    static bool start(const QString &fileName);
+
+    /**
+     * @brief Desactiva la traza y escribe los tramos registrados.
+     * @return true si se escribió el archivo (false si no estaba activa o hubo error).
+     */
+    static bool stop();
+
+    /**
+     * @brief La traza está activa.
+     */
+    static bool isEnabled() { return s_enabled.load(std::memory_order_relaxed); }
+
+    /**
+     * @brief Archivo de la sesión activa (o de la última).
+     */
+    static QString fileName();
+
+    /**
+     * @brief Tiempo desde el origen del proceso, en nanosegundos.
+     */
+    static qint64 nowNs();
+
+private:
+    static std::atomic<bool> s_enabled;   /**< Traza activa. */
+};
+
+#endif // TRACER_H
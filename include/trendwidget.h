@@ -0,0 +1,212 @@
+#ifndef TRENDWIDGET_H
+#define TRENDWIDGET_H
+
+#include <QWidget>
+#include <QList>
+#include <QPointF>
+#include <QColor>
+#include <QTimer>
+#include <QThread>
+#include <atomic>
+#include "rollupengine.h"
+
+/**
+ * @brief Gráfica de tendencia de las lecturas de varios dispositivos.
+ *
+ * Pinta directamente con QPainter la media de cada intervalo (o cada lectura, si el
+ * rango es corto) de hasta MaxSeries dispositivos, con el tiempo en el eje X.
+ *
+ * Para que desplazar un año de datos vaya a 60 fps, pintar nunca toca la base de datos
+ * ni recorre la serie entera:
+ * - Cada serie guarda una caché de tres anchos de vista (la vista y uno a cada lado),
+ *   pedida a RollupEngine::query() con un presupuesto de unos pocos puntos por píxel, de
+ *   modo que el motor elige la resolución (lecturas, minutos, horas o días). Solo se
+ *   vuelve a pedir al salir de la caché o al cambiar mucho el zoom.
+ * - Las consultas se hacen en un hilo propio, una por serie a la vez: mientras llegan
+ *   se pinta la caché anterior y, al recibirlas, se vuelve a pintar.
+ * - Al pintar se localiza por búsqueda binaria el tramo visible de la caché y se reduce
+ *   con LTTB (ver Lttb) a un punto por píxel, conservando picos y forma. La reducción se
+ *   repite solo si la vista o los datos han cambiado.
+ *
+ * Las lecturas nuevas se incorporan de forma incremental: cada refreshInterval ms se
+ * pide solo la cola de cada serie (desde su último intervalo, que puede seguir abierto)
+ * y, en modo "en vivo", la vista avanza hasta el momento actual.
+ *
+ * Arrastrar con el ratón desplaza la vista, la rueda acerca o aleja en torno al cursor y
+ * un doble clic vuelve al modo en vivo.
+ */
+class TrendWidget : public QWidget
+{
+    Q_OBJECT
+
+public:
+    static constexpr int MaxSeries = 8;   /**< Dispositivos que se pueden mostrar a la vez. */
+
+    /**
+     * @brief Constructor de la clase TrendWidget.
+     * @param parent Widget padre opcional.
+     */
+    explicit TrendWidget(QWidget *parent = nullptr);
+
+    /**
+     * @brief Destructor de la clase.
+     * Espera a la consulta en curso y detiene el hilo de consultas.
+     */
+    ~TrendWidget();
+
+    /**
+     * @brief Origen de los datos.
+     * Espera a la consulta en curso con el motor anterior: al volver, ese motor ya puede
+     * destruirse.
+     * @param rollups Motor de agregados (nullptr para desconectar la gráfica).
+     */
+    void setRollups(RollupEngine *rollups);
+
+    /**
+     * @brief Dispositivos a mostrar.
+     * Conserva la caché de los que ya se mostraban.
+     * @param deviceIds IDs de los dispositivos (se usan los MaxSeries primeros).
+     * @param names Nombres para la leyenda, en el mismo orden.
+     */
+    void setDevices(const QList<int> &deviceIds, const QStringList &names);
+
+    /**
+     * @brief Muestra un rango fijo (sale del modo en vivo).
+     * @param fromMs Inicio del rango.
+     * @param toMs Fin del rango.
+     */
+    void setRange(qint64 fromMs, qint64 toMs);
+
+    /**
+     * @brief Activa o desactiva el modo en vivo (la vista termina en el momento actual).
+     * @param follow true para seguir las lecturas nuevas.
+     */
+    void setFollowLive(bool follow);
+
+    /**
+     * @brief Intervalo de incorporación de lecturas nuevas.
+     * @param ms Milisegundos (por defecto 1000).
+     */
+    void setRefreshInterval(int ms);
+
+    /**
+     * @brief Quita todas las series y detiene la actualización.
+     */
+    void clear();
+
+    QSize sizeHint() const override;
+
+public slots:
+    /**
+     * @brief Incorpora las lecturas llegadas desde la última actualización.
+     */
+    void refresh();
+
+protected:
+    void paintEvent(QPaintEvent *event) override;
+    void resizeEvent(QResizeEvent *event) override;
+    void mousePressEvent(QMouseEvent *event) override;
+    void mouseMoveEvent(QMouseEvent *event) override;
+    void mouseReleaseEvent(QMouseEvent *event) override;
+    void mouseDoubleClickEvent(QMouseEvent *event) override;
+    void wheelEvent(QWheelEvent *event) override;
+
+private:
+    /**
+     * @brief Serie de un dispositivo con su caché.
+     */
+    struct Series
+    {
+        int deviceId = 0;                                  /**< ID del dispositivo. */
+        QString name;                                      /**< Nombre para la leyenda. */
+        QColor color;                                      /**< Color de la línea. */
+        RollupEngine::Resolution resolution = RollupEngine::Raw;   /**< Resolución de la caché. */
+        qint64 cacheFrom = 0;                              /**< Inicio del rango en caché. */
+        qint64 cacheTo = -1;                               /**< Fin del rango en caché (< cacheFrom si vacía). */
+        qint64 cacheSpan = 0;                              /**< Ancho de la vista al llenar la caché. */
+        QList<QPointF> points;                             /**< Caché (x = ms, y = media), en orden de tiempo. */
+        QList<QPointF> visible;                            /**< Tramo visible reducido con LTTB. */
+        bool dirty = true;                                 /**< 'visible' debe recalcularse. */
+        quint64 version = 0;                               /**< Cambia cada vez que se sustituye la caché. */
+        bool fetching = false;                             /**< Hay una consulta de la caché en curso. */
+        bool refreshing = false;                           /**< Hay una consulta de lecturas nuevas en curso. */
+    };
+
+    /**
+     * @brief Consulta de una serie: se rellena en el hilo de la interfaz, se ejecuta en el
+     * de consultas y vuelve con los puntos.
+     */
+    struct Fetch
+    {
+        int deviceId = 0;                                  /**< ID del dispositivo. */
+        bool tail = false;                                 /**< Solo lecturas nuevas (refresh()). */
+        qint64 fromMs = 0;                                 /**< Inicio del rango pedido. */
+        qint64 toMs = 0;                                   /**< Fin del rango pedido. */
+        qint64 span = 0;                                   /**< Ancho de la vista al pedirla. */
+        int budget = 0;                                    /**< Puntos máximos (consulta de caché). */
+        RollupEngine::Resolution resolution = RollupEngine::Raw;   /**< Resolución (pedida o elegida). */
+        quint64 version = 0;                               /**< Versión de la caché al pedirla. */
+        QList<QPointF> points;                             /**< Resultado (x = ms, y = media). */
+    };
+
+    /**
+     * @brief Pide la caché de una serie si la vista actual no está cubierta.
+     * @param series Serie a comprobar.
+     */
+    void ensureCache(Series &series);
+
+    /**
+     * @brief Ejecuta una consulta en el hilo de consultas y entrega el resultado a receive().
+     * @param fetch Consulta a ejecutar.
+     */
+    void submit(const Fetch &fetch);
+
+    /**
+     * @brief Incorpora el resultado de una consulta a su serie y vuelve a pintar.
+     * @param generation Generación en la que se pidió (se descarta si ha cambiado).
+     * @param fetch Consulta con sus puntos.
+     */
+    void receive(quint64 generation, const Fetch &fetch);
+
+    /**
+     * @brief Descarta las consultas en cola, espera a la que esté en curso y cierra la
+     * conexión del hilo de consultas.
+     */
+    void dropQueries();
+
+    /**
+     * @brief Recalcula el tramo visible reducido de una serie.
+     * @param series Serie a reducir.
+     */
+    void decimate(Series &series);
+
+    /**
+     * @brief Cambia la vista y marca las series para reducir de nuevo.
+     * @param fromMs Inicio de la vista.
+     * @param toMs Fin de la vista.
+     */
+    void moveView(qint64 fromMs, qint64 toMs);
+
+    /**
+     * @brief Área de trazado (sin márgenes de ejes).
+     * @return Rectángulo en coordenadas del widget.
+     */
+    QRect plotRect() const;
+
+    RollupEngine *m_rollups;          /**< Origen de los datos. */
+    QList<Series> m_series;           /**< Series mostradas. */
+    qint64 m_from;                    /**< Inicio de la vista. */
+    qint64 m_to;                      /**< Fin de la vista. */
+    bool m_followLive;                /**< La vista termina en el momento actual. */
+    QTimer m_refresh;                 /**< Incorporación periódica de lecturas nuevas. */
+    QThread m_thread;                 /**< Hilo de las consultas a RollupEngine. */
+    QObject *m_context;               /**< Objeto de contexto que vive en m_thread. */
+    std::atomic<quint64> m_generation;   /**< Generación de las consultas vigentes. */
+
+    bool m_dragging;                  /**< Arrastre en curso. */
+    int m_dragX;                      /**< Posición X al empezar el arrastre. */
+    qint64 m_dragFrom;                /**< Inicio de la vista al empezar el arrastre. */
+    qint64 m_dragTo;                  /**< Fin de la vista al empezar el arrastre. */
+};
+
+#endif // TRENDWIDGET_H
@@ -0,0 +1,209 @@
+#include "auditlogger.h"
+#include "tracer.h"
+#include <QElapsedTimer>
+#include <QMutexLocker>
+#include <QDebug>
+
+// ---------------------------------------------------------
+// CONSTRUCTOR Y DESTRUCTOR
+// ---------------------------------------------------------
+
+AuditLogger::AuditLogger(LogStore *store, QObject *parent)
+    : QObject(parent)
+    , m_store(store)
+    , m_capacity(8192)
+    , m_batchSize(512)
+    , m_flushInterval(50)
+    , m_policy(Drop)
+    , m_running(false)
+    , m_stopping(false)
+    , m_thread(nullptr)
+    , m_wakePending(false)
+    , m_activeProducers(0)
+    , m_enqueued(0)
+    , m_written(0)
+    , m_dropped(0)
+    , m_commits(0)
+    , m_lastCommitUs(0)
+    , m_maxCommitUs(0)
+    , m_totalCommitUs(0)
+{
+}
+
+AuditLogger::~AuditLogger()
+{
+    stop();
+}
+
+// ---------------------------------------------------------
+// CONFIGURACIÓN
+// ---------------------------------------------------------
+
+void AuditLogger::setCapacity(int entries) { m_capacity = qMax(2, entries); }
+
+void AuditLogger::setBatchSize(int entries) { m_batchSize = qMax(1, entries); }
+
+void AuditLogger::setFlushInterval(int ms) { m_flushInterval = qMax(1, ms); }
+
+void AuditLogger::setOverflowPolicy(OverflowPolicy policy) { m_policy = policy; }
+
+// ---------------------------------------------------------
+// CONTROL DEL HILO ESCRITOR
+// ---------------------------------------------------------
+
+bool AuditLogger::start()
+{
+    if (m_thread) return false;
+
+    m_queue.reset(new MpmcQueue<LogEntry>(static_cast<std::size_t>(m_capacity)));
+    m_stopping = false;
+    m_running = true;
+
+    m_thread = QThread::create([this]() { run(); });
+    m_thread->setObjectName("Auditoría");
+    m_thread->start();
+    return true;
+}
+
+void AuditLogger::stop()
+{
+    if (!m_thread) return;
+
+    // Rechazar eventos nuevos; el escritor vacía la cola antes de salir
+    m_running = false;
+    {
+        QMutexLocker locker(&m_wakeMutex);
+        m_stopping = true;
+        m_wake.wakeAll();
+    }
+
+    m_thread->wait();
+    delete m_thread;
+    m_thread = nullptr;
+}
+
+// ---------------------------------------------------------
+// PRODUCTORES
+// ---------------------------------------------------------
+
+bool AuditLogger::log(const QString &category, const QString &message)
+{
+    // Contabilizar la llamada antes de comprobar m_running: stop() espera a que terminen
+    m_activeProducers.fetch_add(1, std::memory_order_acq_rel);
+
+    bool pushed = false;
+    if (m_running) {
+        LogEntry entry{ QDateTime::currentDateTime(), category, message };
+        pushed = m_queue->tryPush(std::move(entry));
+
+        // Política Block: ceder el procesador hasta que el escritor libere espacio
+        while (!pushed && m_policy == Block && !m_stopping) {
+            m_wake.wakeOne();
+            QThread::usleep(50);
+            pushed = m_queue->tryPush(std::move(entry));
+        }
+
+        // Lote completo: despertar al escritor una sola vez
+        if (pushed && m_queue->sizeApprox() >= static_cast<std::size_t>(m_batchSize.load())
+            && !m_wakePending.exchange(true)) {
+            m_wake.wakeOne();
+        }
+    }
+
+    if (pushed) {
+        m_enqueued.fetch_add(1, std::memory_order_relaxed);
+    } else {
+        m_dropped.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    m_activeProducers.fetch_sub(1, std::memory_order_acq_rel);
+    return pushed;
+}
+
+AuditLoggerStats AuditLogger::stats() const
+{
+    AuditLoggerStats stats;
+    stats.enqueued = m_enqueued.load();
+    stats.written = m_written.load();
+    stats.dropped = m_dropped.load();
+    stats.commits = m_commits.load();
+    stats.queueDepth = m_queue ? static_cast<qint64>(m_queue->sizeApprox()) : 0;
+    stats.lastCommitUs = m_lastCommitUs.load();
+    stats.maxCommitUs = m_maxCommitUs.load();
+    stats.totalCommitUs = m_totalCommitUs.load();
+    return stats;
+}
+
+// ---------------------------------------------------------
+// HILO ESCRITOR
+// ---------------------------------------------------------
+
+void AuditLogger::run()
+{
+    QList<LogEntry> batch;
+    QElapsedTimer oldest;   // Tiempo desde que el primer evento del lote salió de la cola
+
+    for (;;) {
+        const bool stopping = m_stopping;
+        const int batchSize = m_batchSize;
+        const int interval = m_flushInterval;
+
+        m_wakePending = false;
+        LogEntry entry;
+        while (batch.size() < batchSize && m_queue->tryPop(entry)) {
+            if (batch.isEmpty()) oldest.start();
+            batch.append(std::move(entry));
+        }
+
+        // Confirmar por tamaño, por tiempo o por cierre
+        if (!batch.isEmpty()
+            && (batch.size() >= batchSize || oldest.elapsed() >= interval || stopping)) {
+            writeBatch(batch);
+            batch.clear();
+            continue;
+        }
+
+        if (stopping) {
+            // Salir solo cuando ninguna llamada a log() pueda encolar ya nada
+            if (m_activeProducers.load(std::memory_order_acquire) == 0 && m_queue->sizeApprox() == 0) {
+                break;
+            }
+            QThread::yieldCurrentThread();
+            continue;
+        }
+
+        const int wait = batch.isEmpty() ? interval : qMax(1, interval - static_cast<int>(oldest.elapsed()));
+        QMutexLocker locker(&m_wakeMutex);
+        if (!m_stopping) {
+            m_wake.wait(&m_wakeMutex, static_cast<unsigned long>(wait));
+        }
+    }
+
+    m_store->closeWriter();
+}
+
+bool AuditLogger::writeBatch(const QList<LogEntry> &batch)
+{
+    Tracer::Span span("AuditLogger::writeBatch");
+    span.setRows(batch.size());
+    QElapsedTimer timer;
+    timer.start();
+
+    // Una única transacción por partición: un solo COMMIT (y fsync) para todo el lote
+    if (!m_store->append(batch)) {
+        m_dropped.fetch_add(batch.size(), std::memory_order_relaxed);
+        return false;
+    }
+
+    const qint64 elapsedUs = timer.nsecsElapsed() / 1000;
+    m_written.fetch_add(batch.size(), std::memory_order_relaxed);
+    m_commits.fetch_add(1, std::memory_order_relaxed);
+    m_lastCommitUs.store(elapsedUs, std::memory_order_relaxed);
+    m_totalCommitUs.fetch_add(elapsedUs, std::memory_order_relaxed);
+
+    qint64 max = m_maxCommitUs.load(std::memory_order_relaxed);
+    while (elapsedUs > max && !m_maxCommitUs.compare_exchange_weak(max, elapsedUs)) {
+    }
+
+    return true;
+}
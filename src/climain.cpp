@@ -0,0 +1,292 @@
+// Modo de línea de comandos, sin interfaz gráfica.
+//
+// Solo enlaza la biblioteca núcleo (QtCore y QtSql): no crea QApplication ni carga
+// plugins de plataforma, así que arranca en milisegundos y funciona en servidores sin
+// pantalla. Usa la misma base de datos y el mismo perfil de almacenamiento que la
+// aplicación gráfica.
+//
+// Uso: proyecto_cli [opciones] <orden> [argumentos]
+//   query [texto | subred CIDR]   Lista los dispositivos (separados por tabuladores)
+//   import <archivo.csv>          Importa dispositivos (formato de la exportación)
+//   export <archivo.csv>          Exporta dispositivos (--filter para filtrarlos)
+//   stats                         Resumen de la base de datos y del almacén de lecturas
+
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QSettings>
+#include <QSqlDatabase>
+#include <QSqlQuery>
+#include <QSqlError>
+#include <QEventLoop>
+#include <QFileInfo>
+#include <QTextStream>
+#include <QDebug>
+#include <memory>
+#include "databasemanager.h"
+#include "devicemanager.h"
+#include "devicesearch.h"
+#include "deviceimporter.h"
+#include "deviceexporter.h"
+#include "connectionpool.h"
+#include "storageprofile.h"
+#include "timeseriesstore.h"
+#include "rollupengine.h"
+#include "tracer.h"
+#include "slowquerylog.h"
+
+namespace {
+
+QTextStream &out()
+{
+    static QTextStream stream(stdout);
+    return stream;
+}
+
+QTextStream &err()
+{
+    static QTextStream stream(stderr);
+    return stream;
+}
+
+/**
+ * @brief Condición WHERE equivalente a la barra de búsqueda de la aplicación.
+ * @param text Texto libre o subred CIDR (vacío: sin filtro).
+ * @param where Recibe la condición (sin la palabra WHERE).
+ * @param userId Si es >= 0, limita además a los dispositivos de ese usuario.
+ */
+bool buildFilter(const QString &text, int userId, QString *where)
+{
+    QStringList conditions;
+
+    if (text.contains('/')) {
+        const QString subnet = DeviceManager::subnetFilter(text);
+        if (subnet.isEmpty()) {
+            err() << "Subred no válida: " << text << "\n";
+            return false;
+        }
+        conditions << subnet;
+    } else if (!text.trimmed().isEmpty()) {
+        // Misma búsqueda que la barra de la aplicación (índice FTS5 o LIKE), sin límite
+        QSqlDatabase db = DatabaseManager::pool()->reader();
+        QList<int> ids;
+        if (!DeviceSearch::findIds(db, text, DeviceSearch::hasFtsIndex(db), 0, &ids)) {
+            err() << "Error en la búsqueda\n";
+            return false;
+        }
+
+        // Solo enteros devueltos por la consulta parametrizada: no hay texto del usuario en el SQL
+        QStringList idList;
+        idList.reserve(ids.size());
+        for (int id : std::as_const(ids)) idList << QString::number(id);
+        conditions << (ids.isEmpty() ? QString("1=0") : "id IN (" + idList.join(',') + ")");
+    }
+
+    if (userId >= 0) conditions << QString("user_id = %1").arg(userId);
+
+    *where = conditions.join(" AND ");
+    return true;
+}
+
+// ---------------------------------------------------------
+// ÓRDENES
+// ---------------------------------------------------------
+
+int runQuery(const QString &text, int userId, int limit)
+{
+    QString where;
+    if (!buildFilter(text, userId, &where)) return 1;
+
+    QSqlQuery query(DatabaseManager::pool()->reader());
+    query.setForwardOnly(true);
+    QString sql = "SELECT id, user_id, name, type, ip_address, calibration FROM devices";
+    if (!where.isEmpty()) sql += " WHERE " + where;
+    sql += " ORDER BY id";
+    if (limit > 0) sql += QString(" LIMIT %1").arg(limit);
+
+    if (!query.exec(sql)) {
+        err() << "Error consultando dispositivos: " << query.lastError().text() << "\n";
+        return 1;
+    }
+
+    out() << "ID\tUsuario_ID\tNombre\tTipo\tIP\tCalibracion\n";
+    while (query.next()) {
+        out() << query.value(0).toInt() << '\t' << query.value(1).toInt() << '\t'
+              << query.value(2).toString() << '\t' << query.value(3).toString() << '\t'
+              << query.value(4).toString() << '\t' << query.value(5).toDouble() << '\n';
+    }
+    return 0;
+}
+
+int runImport(const QString &fileName, int userId)
+{
+    DeviceImporter importer(DatabaseManager::pool());
+    importer.setDefaultUserId(userId);
+
+    ImportStats result;
+    QEventLoop loop;
+    QObject::connect(&importer, &DeviceImporter::finished, &loop, [&](const ImportStats &stats) {
+        result = stats;
+        loop.quit();
+    });
+    if (!importer.start(fileName)) {
+        err() << "No se pudo iniciar la importación de " << fileName << "\n";
+        return 1;
+    }
+    loop.exec();
+
+    if (!result.error.isEmpty()) {
+        err() << "Error en la importación: " << result.error << "\n";
+        return 1;
+    }
+    out() << "Importados " << result.rowsImported << " de " << result.rowsRead << " dispositivos ("
+          << result.rowsRejected << " rechazados) en " << result.elapsedMs << " ms, "
+          << QString::number(result.rowsPerSecond(), 'f', 0) << " filas/s\n";
+    return 0;
+}
+
+int runExport(const QString &fileName, const QString &filter, int userId)
+{
+    QString where;
+    if (!buildFilter(filter, userId, &where)) return 1;
+
+    DeviceExporter exporter(DatabaseManager::pool());
+    exporter.setFilter(where);
+
+    ExportStats result;
+    QEventLoop loop;
+    QObject::connect(&exporter, &DeviceExporter::finished, &loop, [&](const ExportStats &stats) {
+        result = stats;
+        loop.quit();
+    });
+    if (!exporter.start(fileName)) {
+        err() << "No se pudo iniciar la exportación a " << fileName << "\n";
+        return 1;
+    }
+    loop.exec();
+
+    if (!result.error.isEmpty()) {
+        err() << "Error en la exportación: " << result.error << "\n";
+        return 1;
+    }
+    out() << "Exportados " << result.rowsExported << " dispositivos (" << result.bytesWritten
+          << " bytes) a " << result.fileName << " en " << result.elapsedMs << " ms\n";
+    return 0;
+}
+
+int runStats(const DatabaseManager &database)
+{
+    QSqlQuery query(DatabaseManager::pool()->reader());
+    auto scalar = [&query](const QString &sql) {
+        return query.exec(sql) && query.next() ? query.value(0).toLongLong() : -1;
+    };
+
+    out() << "Base de datos:    " << database.getDatabasePath() << " ("
+          << QFileInfo(database.getDatabasePath()).size() << " bytes, perfil "
+          << database.storageProfile().name << ", esquema v" << scalar("PRAGMA user_version") << ")\n";
+    out() << "Usuarios:         " << scalar("SELECT COUNT(*) FROM users") << "\n";
+    out() << "Dispositivos:     " << scalar("SELECT COUNT(*) FROM devices") << "\n";
+
+    if (TimeSeriesStore *store = database.timeSeries()) {
+        const TimeSeriesStats stats = store->stats();
+        out() << "Lecturas:         " << stats.storedPoints + stats.openPoints << " de " << stats.devices
+              << " dispositivos en " << stats.segments << " segmentos (" << stats.diskBytes << " bytes, "
+              << QString::number(stats.bytesPerPoint(), 'f', 2) << " bytes/lectura)\n";
+    }
+
+    if (query.exec("SELECT resolution, COUNT(*) FROM device_rollups GROUP BY resolution ORDER BY resolution")) {
+        QStringList levels;
+        while (query.next()) {
+            const int resolution = query.value(0).toInt();
+            const QString name = resolution == RollupEngine::Minute ? "minuto"
+                               : resolution == RollupEngine::Hour ? "hora" : "día";
+            levels << QString("%1 por %2").arg(query.value(1).toLongLong()).arg(name);
+        }
+        out() << "Agregados:        " << (levels.isEmpty() ? QString("ninguno") : levels.join(", ")) << "\n";
+    }
+    return 0;
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    // Mismo nombre que la aplicación gráfica: comparte su directorio de datos
+    QCoreApplication::setApplicationName("AppProyectoFinal");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Gestión de dispositivos sin interfaz gráfica.");
+    parser.addHelpOption();
+    parser.addPositionalArgument("orden", "query, import, export o stats.");
+    parser.addPositionalArgument("argumento", "Texto o subred (query) o archivo CSV (import, export).", "[argumento]");
+
+    QCommandLineOption databaseOption("database", "Ruta de la base de datos (por defecto, la de la aplicación).", "ruta");
+    QCommandLineOption profileOption("storage-profile",
+                                     "Perfil de almacenamiento SQLite: " + StorageProfile::names().join(", ") + ".",
+                                     "perfil");
+    QCommandLineOption userOption("user", "ID del usuario: filtro en query/export, propietario por defecto en import (1 si no se indica).", "id");
+    QCommandLineOption limitOption("limit", "Máximo de filas de query.", "n");
+    QCommandLineOption filterOption("filter", "Texto o subred CIDR de los dispositivos a exportar.", "texto");
+    QCommandLineOption traceOption("trace", "Guarda una traza de las consultas (formato Chrome trace-event).", "archivo");
+    QCommandLineOption slowQueryOption("slow-query-ms", "Umbral del registro de consultas lentas en ms (negativo para desactivarlo).", "ms");
+    parser.addOptions({ databaseOption, profileOption, userOption, limitOption, filterOption, traceOption, slowQueryOption });
+    parser.process(app);
+
+    // Opción --trace o variable de entorno PROYECTO_TRACE; se escribe al salir de main()
+    const QString traceFile = parser.isSet(traceOption) ? parser.value(traceOption)
+                                                        : qEnvironmentVariable("PROYECTO_TRACE");
+    if (!traceFile.isEmpty()) {
+        Tracer::start(traceFile);
+    }
+    struct TraceWriter { ~TraceWriter() { Tracer::stop(); } } traceWriter;
+
+    const QStringList args = parser.positionalArguments();
+    const QString command = args.value(0);
+    if (command.isEmpty()) parser.showHelp(1);
+
+    // Perfil de almacenamiento (línea de comandos > configuración), como en la aplicación gráfica
+    QSettings settings(QSettings::IniFormat, QSettings::UserScope, "ProyectoFinal", "AppProyectoFinal");
+    const QString profileName = parser.isSet(profileOption)
+                                    ? parser.value(profileOption)
+                                    : settings.value("storage/profile", "balanced").toString();
+    StorageProfile profile;
+    if (StorageProfile::fromName(profileName, &profile)) {
+        DatabaseManager::setDefaultStorageProfile(profile);
+    } else {
+        qWarning() << "Perfil de almacenamiento desconocido:" << profileName << "- se usa 'balanced'.";
+    }
+    SlowQueryLog::setThresholdMs(parser.isSet(slowQueryOption)
+                                     ? parser.value(slowQueryOption).toInt()
+                                     : settings.value("diagnostics/slow_query_ms", 100).toInt());
+
+    std::unique_ptr<DatabaseManager> database(parser.isSet(databaseOption)
+                                                  ? new DatabaseManager(parser.value(databaseOption))
+                                                  : new DatabaseManager());
+    // Ni auditoría ni mantenimiento de agregados: de eso se ocupa la aplicación gráfica.
+    // Solo 'stats' lee el almacén de lecturas
+    database->setDeferMaintenance(true);
+    database->setServices(command == "stats" ? DatabaseManager::Services(DatabaseManager::SeriesService)
+                                             : DatabaseManager::Services());
+    if (!database->openDatabase()) {
+        err() << "No se pudo abrir la base de datos\n";
+        return 1;
+    }
+
+    const int userId = parser.isSet(userOption) ? parser.value(userOption).toInt() : -1;
+
+    if (command == "query") {
+        return runQuery(args.value(1), userId, parser.value(limitOption).toInt());
+    }
+    if (command == "import" && args.size() > 1) {
+        return runImport(args.at(1), userId >= 0 ? userId : 1);
+    }
+    if (command == "export" && args.size() > 1) {
+        return runExport(args.at(1), parser.value(filterOption), userId);
+    }
+    if (command == "stats") {
+        return runStats(*database);
+    }
+
+    err() << "Orden no válida: " << args.join(' ') << "\n\n";
+    parser.showHelp(1);
+}
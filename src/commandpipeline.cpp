@@ -0,0 +1,422 @@
+#include "commandpipeline.h"
+#include <QTcpSocket>
+#include <QHostAddress>
+#include <QDebug>
+#include <algorithm>
+
+namespace {
+
+constexpr int LatencySamples = 1024;               // Respuestas recientes para los percentiles
+constexpr qint64 ReconnectBaseNs = 250000000;      // Primera espera tras una conexión fallida
+constexpr qint64 ReconnectMaxNs = 10000000000LL;   // Espera máxima entre reconexiones
+
+} // namespace
+
+// ---------------------------------------------------------
+// CONSTRUCTOR Y DESTRUCTOR
+// ---------------------------------------------------------
+
+CommandPipeline::CommandPipeline(QObject *parent)
+    : QObject(parent)
+    , m_port(5000)
+    , m_capacity(256)
+    , m_maxInFlight(8)
+    , m_maxRetries(3)
+    , m_replyTimeoutMs(5000)
+    , m_idleTimeoutMs(60000)
+    , m_nextId(1)
+    , m_latencyPos(0)
+{
+    qRegisterMetaType<CommandResult>();
+
+    m_clock.start();
+    m_latencies.reserve(LatencySamples);
+
+    m_sweep.setInterval(100);
+    connect(&m_sweep, &QTimer::timeout, this, &CommandPipeline::sweep);
+}
+
+CommandPipeline::~CommandPipeline()
+{
+    for (Channel *channel : std::as_const(m_channels)) {
+        if (channel->socket) {
+            channel->socket->disconnect(this);
+            channel->socket->abort();
+        }
+        delete channel;
+    }
+    m_channels.clear();
+}
+
+// ---------------------------------------------------------
+// CONFIGURACIÓN
+// ---------------------------------------------------------
+
+void CommandPipeline::setPort(quint16 port) { m_port = port; }
+
+void CommandPipeline::setQueueCapacity(int commands) { m_capacity = qMax(1, commands); }
+
+void CommandPipeline::setMaxInFlight(int commands) { m_maxInFlight = qMax(1, commands); }
+
+void CommandPipeline::setMaxRetries(int retries) { m_maxRetries = qMax(0, retries); }
+
+void CommandPipeline::setReplyTimeout(int ms) { m_replyTimeoutMs = qMax(100, ms); }
+
+void CommandPipeline::setIdleTimeout(int ms) { m_idleTimeoutMs = qMax(0, ms); }
+
+// ---------------------------------------------------------
+// ENCOLADO
+// ---------------------------------------------------------
+
+quint64 CommandPipeline::submit(int deviceId, const QString &host, const QString &command)
+{
+    const QString text = command.trimmed();
+    if (text.isEmpty() || text.contains('\n') || text.contains('\r')) {
+        qWarning() << "Comando no válido para el dispositivo" << deviceId << ":" << command;
+        return 0;
+    }
+
+    Channel *channel = m_channels.value(deviceId);
+    if (!channel) {
+        channel = new Channel;
+        channel->deviceId = deviceId;
+        channel->host = host;
+        m_channels.insert(deviceId, channel);
+        if (!m_sweep.isActive()) m_sweep.start();
+    } else if (channel->host != host) {
+        // Nueva IP: lo enviado a la anterior se repite en la nueva conexión
+        while (!channel->inFlight.empty()) {
+            channel->queue.push_front(std::move(channel->inFlight.back()));
+            channel->inFlight.pop_back();
+        }
+        dropSocket(channel);
+        channel->host = host;
+        channel->connectFailures = 0;
+        channel->retryAtNs = -1;
+    }
+
+    const qint64 now = m_clock.nsecsElapsed();
+    const quint64 id = m_nextId++;
+    const QString key = configKey(text);
+
+    // Escritura de una clave que ya espera en cola: se sustituye en su sitio.
+    // No cambia la profundidad, así que se acepta incluso con la cola llena
+    if (!key.isEmpty()) {
+        if (Command *queued = channel->queuedKeys.value(key)) {
+            const Command replaced = *queued;
+            queued->id = id;
+            queued->line = text.toUtf8() + '\n';
+            queued->submittedNs = now;
+            queued->attempts = 0;
+            ++m_stats.submitted;
+            ++m_stats.coalesced;
+            finish(channel, replaced, CommandResult::Coalesced, "Sustituido por el comando " + QString::number(id));
+            return id;
+        }
+    }
+
+    // Contrapresión: el llamador debe esperar a writable()
+    if (channel->depth() >= m_capacity) {
+        channel->blocked = true;
+        ++m_stats.refused;
+        return 0;
+    }
+
+    Command entry;
+    entry.id = id;
+    entry.key = key;
+    entry.line = text.toUtf8() + '\n';
+    entry.submittedNs = now;
+    channel->queue.push_back(std::move(entry));
+    // deque no reubica sus elementos al insertar o quitar por los extremos: el puntero sigue siendo válido
+    if (!key.isEmpty()) channel->queuedKeys.insert(key, &channel->queue.back());
+
+    ++m_stats.submitted;
+    m_stats.maxQueueDepth = qMax(m_stats.maxQueueDepth, ++m_stats.queueDepth);
+
+    pump(channel);
+    return id;
+}
+
+bool CommandPipeline::canSubmit(int deviceId) const
+{
+    const Channel *channel = m_channels.value(deviceId);
+    return !channel || channel->depth() < m_capacity;
+}
+
+int CommandPipeline::queueDepth(int deviceId) const
+{
+    const Channel *channel = m_channels.value(deviceId);
+    return channel ? channel->depth() : 0;
+}
+
+void CommandPipeline::close(int deviceId)
+{
+    Channel *channel = m_channels.value(deviceId);
+    if (!channel) return;
+
+    dropSocket(channel);
+    channel->retryAtNs = -1;
+    channel->connectFailures = 0;
+    finishAll(channel, CommandResult::Cancelled, "Cancelado");
+}
+
+PipelineStats CommandPipeline::stats() const
+{
+    PipelineStats stats = m_stats;
+    stats.openChannels = m_channels.size();
+
+    QList<qint64> latencies = m_latencies;
+    if (!latencies.isEmpty()) {
+        std::sort(latencies.begin(), latencies.end());
+        stats.latencyP50Us = latencies.at(qMin(latencies.size() - 1, int(latencies.size() * 0.50)));
+        stats.latencyP99Us = latencies.at(qMin(latencies.size() - 1, int(latencies.size() * 0.99)));
+    }
+    return stats;
+}
+
+// ---------------------------------------------------------
+// CONEXIÓN Y ENVÍO
+// ---------------------------------------------------------
+
+void CommandPipeline::openConnection(Channel *channel)
+{
+    QTcpSocket *socket = new QTcpSocket(this);
+    channel->socket = socket;
+    channel->connected = false;
+    channel->retryAtNs = -1;
+    channel->lastActivityNs = m_clock.nsecsElapsed();
+
+    connect(socket, &QTcpSocket::connected, this, [this, channel, socket]() {
+        if (channel->socket != socket) return;
+        // Sin Nagle: cada lote sale en cuanto se escribe
+        socket->setSocketOption(QAbstractSocket::LowDelayOption, 1);
+        channel->connected = true;
+        channel->connectFailures = 0;
+        channel->lastActivityNs = m_clock.nsecsElapsed();
+        ++m_stats.connections;
+        pump(channel);
+    });
+    connect(socket, &QTcpSocket::readyRead, this, [this, channel, socket]() {
+        if (channel->socket == socket) readReplies(channel);
+    });
+    connect(socket, &QTcpSocket::errorOccurred, this, [this, channel, socket](QAbstractSocket::SocketError) {
+        if (channel->socket == socket) handleDrop(channel, socket->errorString());
+    });
+    connect(socket, &QTcpSocket::disconnected, this, [this, channel, socket]() {
+        if (channel->socket == socket) handleDrop(channel, "Conexión cerrada por el dispositivo");
+    });
+
+    // Las IP literales evitan la resolución de nombres
+    const QHostAddress address(channel->host.trimmed());
+    if (address.isNull()) {
+        socket->connectToHost(channel->host.trimmed(), m_port);
+    } else {
+        socket->connectToHost(address, m_port);
+    }
+}
+
+void CommandPipeline::pump(Channel *channel)
+{
+    if (!channel->connected) {
+        // La reconexión tras un fallo la lanza sweep() cuando vence su espera
+        if (!channel->socket && channel->retryAtNs < 0 && !channel->queue.empty()) openConnection(channel);
+        return;
+    }
+
+    const qint64 now = m_clock.nsecsElapsed();
+    QByteArray batch;
+
+    while (int(channel->inFlight.size()) < m_maxInFlight && !channel->queue.empty()) {
+        Command &front = channel->queue.front();
+        if (!front.key.isEmpty() && channel->queuedKeys.value(front.key) == &front) {
+            channel->queuedKeys.remove(front.key);
+        }
+
+        Command command = std::move(front);
+        channel->queue.pop_front();
+
+        if (command.attempts > 0) ++m_stats.retried;
+        ++command.attempts;
+        command.sentNs = now;
+        batch += command.line;
+        channel->inFlight.push_back(std::move(command));
+        ++m_stats.sent;
+    }
+
+    if (batch.isEmpty()) return;
+
+    // Todos los comandos listos en una sola escritura: comparten viaje de ida y vuelta
+    channel->socket->write(batch);
+    channel->lastActivityNs = now;
+    ++m_stats.batches;
+}
+
+void CommandPipeline::readReplies(Channel *channel)
+{
+    while (channel->socket && channel->socket->canReadLine()) {
+        const QString line = QString::fromUtf8(channel->socket->readLine()).trimmed();
+        channel->lastActivityNs = m_clock.nsecsElapsed();
+
+        if (channel->inFlight.empty()) {
+            qWarning() << "Respuesta inesperada del dispositivo" << channel->deviceId << ":" << line;
+            continue;
+        }
+
+        const Command command = std::move(channel->inFlight.front());
+        channel->inFlight.pop_front();
+
+        if (line.startsWith("OK")) {
+            finish(channel, command, CommandResult::Acknowledged, line.mid(2).trimmed());
+        } else if (line.startsWith("ERR")) {
+            finish(channel, command, CommandResult::Rejected, line.mid(3).trimmed());
+        } else {
+            finish(channel, command, CommandResult::Rejected, "Respuesta no válida: " + line);
+        }
+    }
+
+    // Las respuestas liberan hueco en la ventana de encadenado
+    pump(channel);
+}
+
+void CommandPipeline::handleDrop(Channel *channel, const QString &error)
+{
+    const bool wasConnected = channel->connected;
+    dropSocket(channel);
+
+    // Lo enviado sin respuesta vuelve al principio de la cola, en el mismo orden
+    while (!channel->inFlight.empty()) {
+        Command command = std::move(channel->inFlight.back());
+        channel->inFlight.pop_back();
+
+        if (command.attempts > m_maxRetries) {
+            finish(channel, command, CommandResult::Failed, error);
+        } else {
+            channel->queue.push_front(std::move(command));
+        }
+    }
+
+    if (!wasConnected) ++channel->connectFailures;
+    if (channel->connectFailures > m_maxRetries) {
+        qWarning() << "Dispositivo" << channel->deviceId << "sin conexión de control:" << error;
+        channel->connectFailures = 0;
+        channel->retryAtNs = -1;
+        finishAll(channel, CommandResult::Failed, "Sin conexión: " + error);
+        return;
+    }
+
+    if (channel->queue.empty()) return;
+
+    // Conexión caída: se reconecta enseguida. Conexión fallida: espera creciente
+    qint64 waitNs = 0;
+    if (!wasConnected) {
+        waitNs = qMin(ReconnectMaxNs, ReconnectBaseNs << qMin(channel->connectFailures - 1, 16));
+    }
+    channel->retryAtNs = m_clock.nsecsElapsed() + waitNs;
+}
+
+void CommandPipeline::dropSocket(Channel *channel)
+{
+    if (!channel->socket) return;
+
+    QTcpSocket *socket = channel->socket;
+    channel->socket = nullptr;
+    channel->connected = false;
+
+    socket->disconnect(this);
+    socket->abort();
+    socket->deleteLater();
+}
+
+void CommandPipeline::finish(Channel *channel, const Command &command, CommandResult::Status status,
+                             const QString &reply)
+{
+    CommandResult result;
+    result.commandId = command.id;
+    result.deviceId = channel->deviceId;
+    result.status = status;
+    result.reply = reply;
+    result.attempts = command.attempts;
+
+    switch (status) {
+    case CommandResult::Acknowledged: ++m_stats.acknowledged; break;
+    case CommandResult::Rejected:     ++m_stats.rejected; break;
+    case CommandResult::Failed:       ++m_stats.failed; break;
+    default: break;
+    }
+
+    if (status == CommandResult::Acknowledged || status == CommandResult::Rejected) {
+        result.latencyUs = (m_clock.nsecsElapsed() - command.submittedNs) / 1000;
+        if (m_latencies.size() < LatencySamples) {
+            m_latencies.append(result.latencyUs);
+        } else {
+            m_latencies[m_latencyPos] = result.latencyUs;
+        }
+        m_latencyPos = (m_latencyPos + 1) % LatencySamples;
+    }
+
+    // El comando sustituido deja su sitio al nuevo: la profundidad no cambia
+    if (status != CommandResult::Coalesced) --m_stats.queueDepth;
+
+    emit commandFinished(result);
+
+    if (channel->blocked && channel->depth() <= m_capacity / 2) {
+        channel->blocked = false;
+        emit writable(channel->deviceId);
+    }
+}
+
+void CommandPipeline::finishAll(Channel *channel, CommandResult::Status status, const QString &reply)
+{
+    // Se vacían antes de emitir: lo que se encole desde los slots no se descarta
+    std::deque<Command> inFlight;
+    std::deque<Command> queue;
+    inFlight.swap(channel->inFlight);
+    queue.swap(channel->queue);
+    channel->queuedKeys.clear();
+
+    for (const Command &command : inFlight) finish(channel, command, status, reply);
+    for (const Command &command : queue) finish(channel, command, status, reply);
+}
+
+// ---------------------------------------------------------
+// PLAZOS
+// ---------------------------------------------------------
+
+void CommandPipeline::sweep()
+{
+    const qint64 now = m_clock.nsecsElapsed();
+    const qint64 replyLimit = qint64(m_replyTimeoutMs) * 1000000;
+    const qint64 idleLimit = qint64(m_idleTimeoutMs) * 1000000;
+
+    // Copia de la lista: los slots de commandFinished pueden crear canales nuevos.
+    // Los canales solo se liberan al final de esta función
+    const QList<Channel *> channels = m_channels.values();
+
+    for (Channel *channel : channels) {
+        if (channel->connected && !channel->inFlight.empty()
+            && now - channel->inFlight.front().sentNs >= replyLimit) {
+            handleDrop(channel, "Sin respuesta del dispositivo");
+        } else if (channel->socket && !channel->connected && now - channel->lastActivityNs >= replyLimit) {
+            handleDrop(channel, "Tiempo de conexión agotado");
+        } else if (!channel->socket && channel->retryAtNs >= 0 && now >= channel->retryAtNs) {
+            channel->retryAtNs = -1;
+            if (!channel->queue.empty()) openConnection(channel);
+        } else if (channel->connected && channel->depth() == 0 && now - channel->lastActivityNs >= idleLimit) {
+            dropSocket(channel);
+        }
+    }
+
+    // Canales sin conexión ni comandos: se liberan (se recrean con el próximo submit())
+    for (auto it = m_channels.begin(); it != m_channels.end();) {
+        Channel *channel = it.value();
+        if (!channel->socket && channel->depth() == 0 && channel->retryAtNs < 0) {
+            delete channel;
+            it = m_channels.erase(it);
+        } else {
+            ++it;
+        }
+    }
+
+    if (m_channels.isEmpty()) m_sweep.stop();
+}
@@ -0,0 +1,213 @@
+#include "connectionpool.h"
+#include <QSqlError>
+#include <QSqlQuery>
+#include <QThread>
+#include <QThreadStorage>
+#include <QList>
+#include <QHash>
+#include <QDebug>
+
+namespace {
+
+/**
+ * @brief Conexiones abiertas por un hilo; se cierran al destruirse (fin del hilo).
+ */
+struct ThreadConnections
+{
+    struct Entry
+    {
+        QString name;
+        std::shared_ptr<QAtomicInt> counter;
+    };
+
+    QList<Entry> entries;
+    QHash<QString, std::shared_ptr<StatementCache>> statements;   // Por nombre de conexión
+
+    ~ThreadConnections() { closeAll(); }
+
+    void closeAll()
+    {
+        // Finalizar las sentencias antes de cerrar sus conexiones
+        statements.clear();
+
+        for (const Entry &entry : std::as_const(entries)) {
+            {
+                QSqlDatabase db = QSqlDatabase::database(entry.name, false);
+                if (db.isOpen()) db.close();
+            }
+            QSqlDatabase::removeDatabase(entry.name);
+            entry.counter->deref();
+        }
+        entries.clear();
+    }
+};
+
+// Estático: debe sobrevivir a los pools para cerrar las conexiones de hilos que terminan tarde
+QThreadStorage<ThreadConnections *> &threadConnections()
+{
+    static QThreadStorage<ThreadConnections *> storage;
+    return storage;
+}
+
+QAtomicInt nextPoolId;
+
+} // namespace
+
+// ---------------------------------------------------------
+// BLOQUEO DEL ESCRITOR
+// ---------------------------------------------------------
+
+ConnectionPool::WriteLock::WriteLock(ConnectionPool *pool)
+    : m_lock(pool->m_writeMutex)
+{
+}
+
+// ---------------------------------------------------------
+// CONSTRUCTOR Y DESTRUCTOR
+// ---------------------------------------------------------
+
+ConnectionPool::ConnectionPool(const QString &dbPath)
+    : m_dbPath(dbPath)
+    , m_prefix(QString("pool%1").arg(nextPoolId.fetchAndAddRelaxed(1)))
+    , m_busyTimeout(5000)
+    , m_profile(StorageProfile::balanced())
+    , m_open(std::make_shared<QAtomicInt>(0))
+    , m_statementCapacity(64)
+    , m_statementCounters(std::make_shared<StatementCache::Counters>())
+{
+}
+
+ConnectionPool::~ConnectionPool()
+{
+    releaseCurrentThread();
+
+    if (m_open->loadRelaxed() > 0) {
+        qWarning() << "Pool de conexiones destruido con" << m_open->loadRelaxed()
+                   << "conexiones abiertas en otros hilos.";
+    }
+}
+
+// ---------------------------------------------------------
+// CONFIGURACIÓN
+// ---------------------------------------------------------
+
+QString ConnectionPool::databasePath() const { return m_dbPath; }
+
+void ConnectionPool::setBusyTimeout(int ms) { m_busyTimeout.storeRelaxed(qMax(0, ms)); }
+
+void ConnectionPool::setStorageProfile(const StorageProfile &profile)
+{
+    m_profile = profile;
+    setBusyTimeout(profile.busyTimeoutMs);
+}
+
+StorageProfile ConnectionPool::storageProfile() const { return m_profile; }
+
+int ConnectionPool::openConnections() const { return m_open->loadRelaxed(); }
+
+void ConnectionPool::setStatementCacheCapacity(int statements) { m_statementCapacity.storeRelaxed(qMax(4, statements)); }
+
+StatementCacheStats ConnectionPool::statementCacheStats() const
+{
+    StatementCacheStats stats;
+    stats.hits = m_statementCounters->hits.load(std::memory_order_relaxed);
+    stats.misses = m_statementCounters->misses.load(std::memory_order_relaxed);
+    stats.evictions = m_statementCounters->evictions.load(std::memory_order_relaxed);
+    return stats;
+}
+
+// ---------------------------------------------------------
+// CONEXIONES POR HILO
+// ---------------------------------------------------------
+
+QSqlDatabase ConnectionPool::reader() { return connection(true); }
+
+QSqlDatabase ConnectionPool::writer() { return connection(false); }
+
+QString ConnectionPool::connectionName(bool readOnly) const
+{
+    return QString("%1_%2_%3")
+        .arg(m_prefix, readOnly ? QStringLiteral("ro") : QStringLiteral("rw"))
+        .arg(reinterpret_cast<quintptr>(QThread::currentThread()));
+}
+
+QSqlDatabase ConnectionPool::connection(bool readOnly)
+{
+    const QString name = connectionName(readOnly);
+
+    if (QSqlDatabase::contains(name)) {
+        QSqlDatabase db = QSqlDatabase::database(name, false);
+        // Reintentar si la apertura anterior falló (ej. el archivo aún no existía)
+        if (!db.isOpen()) {
+            if (db.open()) {
+                applyProfile(db, readOnly);
+            } else {
+                qCritical() << "Error abriendo conexión" << name << ":" << db.lastError().text();
+            }
+        }
+        return db;
+    }
+
+    QSqlDatabase db = QSqlDatabase::addDatabase("QSQLITE", name);
+    db.setDatabaseName(m_dbPath);
+
+    QString options = QString("QSQLITE_BUSY_TIMEOUT=%1").arg(m_busyTimeout.loadRelaxed());
+    if (readOnly) options.prepend("QSQLITE_OPEN_READONLY;");
+    db.setConnectOptions(options);
+
+    if (!db.open()) {
+        qCritical() << "Error abriendo conexión" << name << ":" << db.lastError().text();
+    } else {
+        applyProfile(db, readOnly);
+    }
+
+    // Registrar aunque haya fallado: el nombre se libera igualmente al terminar el hilo
+    QThreadStorage<ThreadConnections *> &storage = threadConnections();
+    if (!storage.hasLocalData()) {
+        storage.setLocalData(new ThreadConnections);
+    }
+    storage.localData()->entries.append({ name, m_open });
+    m_open->ref();
+
+    return db;
+}
+
+void ConnectionPool::applyProfile(QSqlDatabase &db, bool readOnly) const
+{
+    // Parámetros por conexión del perfil de almacenamiento (caché, mmap, synchronous...)
+    QSqlQuery pragma(db);
+    for (const QString &statement : m_profile.connectionPragmas(readOnly)) {
+        if (!pragma.exec(statement)) {
+            qWarning() << "No se pudo aplicar" << statement << ":" << pragma.lastError().text();
+        }
+    }
+}
+
+// ---------------------------------------------------------
+// SENTENCIAS PREPARADAS
+// ---------------------------------------------------------
+
+QSqlQuery &ConnectionPool::readStatement(const QString &sql) { return statements(true)->acquire(sql); }
+
+QSqlQuery &ConnectionPool::writeStatement(const QString &sql) { return statements(false)->acquire(sql); }
+
+StatementCache *ConnectionPool::statements(bool readOnly)
+{
+    // Abre (o registra) la conexión del hilo si aún no existe
+    connection(readOnly);
+
+    const QString name = connectionName(readOnly);
+    std::shared_ptr<StatementCache> &cache = threadConnections().localData()->statements[name];
+    if (!cache) {
+        cache = std::make_shared<StatementCache>(name, m_statementCapacity.loadRelaxed(), m_statementCounters);
+    }
+    return cache.get();
+}
+
+void ConnectionPool::releaseCurrentThread()
+{
+    QThreadStorage<ThreadConnections *> &storage = threadConnections();
+    if (storage.hasLocalData()) {
+        storage.localData()->closeAll();
+    }
+}
@@ -1,18 +1,41 @@
 #include "databasemanager.h"
+#include "ipaddress.h"
+#include "schemamigrator.h"
+#include "startuptimeline.h"
+#include "tracer.h"
+#include "slowquerylog.h"
 #include <QSqlDatabase>
 #include <QSqlQuery>
 #include <QSqlError>
 #include <QStandardPaths>
 #include <QDir>
+#include <QFileInfo>
 #include <QDebug>
 #include <QDateTime>
+#include <QStringList>
+#include <QList>
+#include <QPair>
 
 // ---------------------------------------------------------
 // CONSTRUCTOR Y DESTRUCTOR
 // ---------------------------------------------------------
 
+ConnectionPool *DatabaseManager::s_pool = nullptr;
+StorageProfile DatabaseManager::s_defaultProfile = StorageProfile::balanced();
+
 DatabaseManager::DatabaseManager(QObject *parent)
     : QObject(parent)
+    , m_pool(nullptr)
+    , m_logStore(nullptr)
+    , m_auditLogger(nullptr)
+    , m_timeSeries(nullptr)
+    , m_rollups(nullptr)
+    , m_profile(s_defaultProfile)
+    , m_schemaReady(false)
+    , m_deferMaintenance(false)
+    , m_maintenancePending(false)
+    , m_maintenancePrepared(false)
+    , m_services(AllServices)
 {
     // Establecer la ruta de la base de datos en un directorio con permisos de escritura (AppData)
     QString path = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation);
@@ -23,6 +46,32 @@ DatabaseManager::DatabaseManager(QObject *parent)
     }
 
     m_dbPath = path + "/app_database.sqlite";
+
+    m_seriesFlush.setInterval(1000);
+    connect(&m_seriesFlush, &QTimer::timeout, this, [this] {
+        if (m_timeSeries) m_timeSeries->flushExpired();
+    });
+}
+
+DatabaseManager::DatabaseManager(const QString &dbPath, QObject *parent)
+    : QObject(parent)
+    , m_pool(nullptr)
+    , m_logStore(nullptr)
+    , m_auditLogger(nullptr)
+    , m_timeSeries(nullptr)
+    , m_rollups(nullptr)
+    , m_profile(s_defaultProfile)
+    , m_schemaReady(false)
+    , m_deferMaintenance(false)
+    , m_maintenancePending(false)
+    , m_maintenancePrepared(false)
+    , m_services(AllServices)
+    , m_dbPath(dbPath)
+{
+    m_seriesFlush.setInterval(1000);
+    connect(&m_seriesFlush, &QTimer::timeout, this, [this] {
+        if (m_timeSeries) m_timeSeries->flushExpired();
+    });
 }
 
 DatabaseManager::~DatabaseManager()
@@ -36,96 +85,481 @@ DatabaseManager::~DatabaseManager()
 
 bool DatabaseManager::openDatabase()
 {
-    // Verificar si ya existe una conexión activa para reutilizarla
-    if (QSqlDatabase::contains("qt_sql_default_connection")) {
-        QSqlDatabase db = QSqlDatabase::database("qt_sql_default_connection");
-        if (db.isOpen()) {
-            m_database = db;
-            return true;
+    // Reutilizar el pool si la base de datos ya está abierta
+    if (m_pool && m_database.isOpen()) {
+        return true;
+    }
+
+    // Los almacenes abiertos por prepareDatabase() se conservan (aún no hay pool)
+    if (m_pool) closeDatabase();
+    m_pool = new ConnectionPool(m_dbPath);
+    m_pool->setStorageProfile(m_profile);
+    s_pool = m_pool;
+
+    {
+        StartupTimeline::Scope phase("Apertura de la base de datos");
+
+        // La conexión de escritura del hilo de la interfaz crea el archivo y el esquema
+        ConnectionPool::WriteLock lock(m_pool);
+        m_database = m_pool->writer();
+
+        if (!m_database.isOpen()) {
+            qCritical() << "Error al abrir la base de datos:" << m_database.lastError().text();
+            return false;
+        }
+
+        setJournalMode(m_database);
+        qInfo() << "Perfil de almacenamiento:" << m_profile.name;
+
+        // Sin prepareDatabase() previo, las migraciones se aplican aquí
+        if (!m_schemaReady && !migrateSchema(m_database)) {
+            return false;
         }
     }
 
-    m_database = QSqlDatabase::addDatabase("QSQLITE");
-    m_database.setDatabaseName(m_dbPath);
+    {
+        // Sin prepareDatabase() previo, los almacenes se abren aquí
+        ConnectionPool::WriteLock lock(m_pool);
+        openStores(m_database);
+    }
 
-    if (!m_database.open()) {
-        qCritical() << "Error al abrir la base de datos:" << m_database.lastError().text();
-        return false;
+    if (m_logStore) {
+        // Escritor de auditoría en segundo plano (insertLog solo encola)
+        m_auditLogger = new AuditLogger(m_logStore);
+        m_auditLogger->start();
     }
 
-    return createTables();
+    if (m_timeSeries) {
+        // Acota las lecturas que se perderían en un cierre inesperado (bloques abiertos)
+        m_seriesFlush.start();
+
+        // Los agregados reciben lecturas a partir de runMaintenance()
+        m_rollups = new RollupEngine(m_pool, m_timeSeries, this);
+        m_maintenancePending = true;
+        m_maintenancePrepared = false;
+        if (!m_deferMaintenance) {
+            runMaintenance();
+        }
+    }
+    return true;
 }
 
-void DatabaseManager::closeDatabase()
+bool DatabaseManager::prepareDatabase()
 {
-    QString connectionName;
+    StartupTimeline::Scope phase("Migración del esquema");
+
+    // Pool propio: sus conexiones pertenecen a este hilo y se cierran al destruirlo
+    ConnectionPool pool(m_dbPath);
+    pool.setStorageProfile(m_profile);
+
     {
-        QSqlDatabase db = QSqlDatabase::database();
-        connectionName = db.connectionName();
-        if (db.isOpen()) {
-            db.close();
+        ConnectionPool::WriteLock lock(&pool);
+        QSqlDatabase db = pool.writer();
+        if (!db.isOpen()) {
+            qCritical() << "Error al abrir la base de datos:" << db.lastError().text();
+            return false;
         }
+
+        setJournalMode(db);
+        m_schemaReady = migrateSchema(db);
+
+        // Migración de la tabla logs antigua, archivo de particiones e índice de los
+        // segmentos: openDatabase() recibe los almacenes ya abiertos
+        if (m_schemaReady) openStores(db);
     }
-    QSqlDatabase::removeDatabase(connectionName);
+    return m_schemaReady;
+}
+
+void DatabaseManager::openStores(QSqlDatabase &db)
+{
+    if ((m_services & AuditService) && !m_logStore) {
+        StartupTimeline::Scope phase("Almacén de auditoría");
+
+        // Auditoría fuera de la BD principal: una partición SQLite por mes
+        m_logStore = new LogStore(QFileInfo(m_dbPath).absolutePath() + "/logs");
+        if (!migrateLegacyLogs(db)) {
+            // Sin archivar: el reintento encuentra las filas ya copiadas en sus particiones
+            qWarning() << "La tabla logs antigua se conserva; se reintentará en el próximo arranque";
+        } else {
+            m_logStore->applyRetention();
+        }
+    }
+
+    if ((m_services & SeriesService) && !m_timeSeries) {
+        StartupTimeline::Scope phase("Almacén de series");
+
+        // Lecturas de los dispositivos: segmentos comprimidos junto a la BD
+        m_timeSeries = new TimeSeriesStore(QFileInfo(m_dbPath).absolutePath() + "/series");
+        if (!m_timeSeries->open()) {
+            qWarning() << "No se pudo abrir el almacén de series en" << m_timeSeries->directory();
+        }
+    }
+}
+
+void DatabaseManager::setDeferMaintenance(bool defer)
+{
+    m_deferMaintenance = defer;
+}
+
+void DatabaseManager::setServices(Services services)
+{
+    m_services = services;
+}
+
+void DatabaseManager::prepareMaintenance()
+{
+    if (!m_rollups || !m_maintenancePending || m_maintenancePrepared) return;
+
+    StartupTimeline::Scope phase("Mantenimiento de agregados");
+    Tracer::Span span("DatabaseManager::prepareMaintenance");
+
+    // Agregados por minuto/hora/día: se completan con lo que falte y se aplica la retención
+    m_rollups->backfill();
+    m_rollups->applyRetention();
+    m_maintenancePrepared = true;
+}
+
+void DatabaseManager::runMaintenance()
+{
+    if (!m_rollups || !m_maintenancePending) return;
+    prepareMaintenance();
+    m_maintenancePending = false;
+
+    // Solo queda conectar el motor al almacén y arrancar su volcado periódico
+    Tracer::Span span("DatabaseManager::runMaintenance");
+    m_timeSeries->setRollups(m_rollups);
+    m_rollups->start();
+}
+
+void DatabaseManager::closeDatabase()
+{
+    // Escribir los logs pendientes antes de cerrar las conexiones
+    delete m_auditLogger;
+    m_auditLogger = nullptr;
+    delete m_logStore;
+    m_logStore = nullptr;
+    m_seriesFlush.stop();
+    if (m_timeSeries) m_timeSeries->setRollups(nullptr);
+    delete m_rollups;      // Guarda los agregados pendientes
+    m_rollups = nullptr;
+    delete m_timeSeries;   // Sella los bloques abiertos
+    m_timeSeries = nullptr;
+    if (!m_pool) return;   // Solo estaban abiertos los almacenes de prepareDatabase()
+
+    // Consultas lentas de la sesión (incluidas las del vaciado de la auditoría): se
+    // acumulan en un archivo junto a la base de datos
+    if (!SlowQueryLog::entries().isEmpty()) {
+        qInfo().noquote() << SlowQueryLog::report();
+        SlowQueryLog::save(QFileInfo(m_dbPath).absolutePath() + "/consultas-lentas.json");
+        SlowQueryLog::clear();
+    }
+
+    m_database = QSqlDatabase();
+    if (s_pool == m_pool) {
+        s_pool = nullptr;
+    }
+    delete m_pool;
+    m_pool = nullptr;
+}
+
+ConnectionPool *DatabaseManager::pool()
+{
+    return s_pool;
+}
+
+void DatabaseManager::setStorageProfile(const StorageProfile &profile)
+{
+    m_profile = profile;
+}
+
+StorageProfile DatabaseManager::storageProfile() const
+{
+    return m_profile;
+}
+
+void DatabaseManager::setDefaultStorageProfile(const StorageProfile &profile)
+{
+    s_defaultProfile = profile;
 }
 
 // ---------------------------------------------------------
 // INICIALIZACIÓN DE TABLAS
 // ---------------------------------------------------------
 
-bool DatabaseManager::createTables()
+bool DatabaseManager::setJournalMode(QSqlDatabase &db)
+{
+    // Modo de diario del perfil (WAL en todos los predefinidos): los lectores en segundo
+    // plano mantienen una instantánea consistente sin bloquear las escrituras de la interfaz
+    Tracer::Span span("DatabaseManager::setJournalMode");
+    QSqlQuery pragma(db);
+    if (!pragma.exec("PRAGMA journal_mode=" + m_profile.journalMode)) {
+        qWarning() << "No se pudo activar el modo" << m_profile.journalMode << ":"
+                   << pragma.lastError().text();
+        return false;
+    }
+    return true;
+}
+
+bool DatabaseManager::migrateSchema(QSqlDatabase &db)
 {
-    QSqlQuery query;
+    Tracer::Span span("DatabaseManager::migrateSchema");
+    SchemaMigrator migrator;
+
+    // Las migraciones 1-4 reproducen el esquema anterior a user_version: son idempotentes
+    // para que las instalaciones existentes (versión 0) las recorran sin errores
+    migrator.addMigration(1, "tablas users y devices", [](QSqlDatabase &db) {
+        QSqlQuery query(db);
+
+        QString usersTable = "CREATE TABLE IF NOT EXISTS users ("
+                             "id INTEGER PRIMARY KEY AUTOINCREMENT, "
+                             "username TEXT UNIQUE, "
+                             "password TEXT, "
+                             "role TEXT)";
+
+        if (!query.exec(usersTable)) {
+            qCritical() << "Error creando tabla users:" << query.lastError().text();
+            return false;
+        }
+
+        QString devicesTable = "CREATE TABLE IF NOT EXISTS devices ("
+                               "id INTEGER PRIMARY KEY AUTOINCREMENT, "
+                               "user_id INTEGER, "
+                               "name TEXT, "
+                               "type TEXT, "
+                               "ip_address TEXT, "
+                               "calibration REAL, "
+                               "FOREIGN KEY(user_id) REFERENCES users(id))";
 
-    // 1. Tabla de Logs (Auditoría)
-    QString logsTable = "CREATE TABLE IF NOT EXISTS logs ("
-                        "id INTEGER PRIMARY KEY AUTOINCREMENT, "
-                        "timestamp DATETIME, "
-                        "category TEXT, "
-                        "message TEXT)";
+        if (!query.exec(devicesTable)) {
+            qCritical() << "Error creando tabla devices:" << query.lastError().text();
+            return false;
+        }
+        return true;
+    });
+
+    // Índices de las columnas de orden de la tabla (paginación por keyset: columna + id)
+    migrator.addMigration(2, "índices de orden de devices", [](QSqlDatabase &db) {
+        QSqlQuery query(db);
+        const QStringList sortIndexes = {
+            "CREATE INDEX IF NOT EXISTS idx_devices_name ON devices(name)",
+            "CREATE INDEX IF NOT EXISTS idx_devices_type ON devices(type)",
+            "CREATE INDEX IF NOT EXISTS idx_devices_calibration ON devices(calibration)"
+        };
+        for (const QString &index : sortIndexes) {
+            if (!query.exec(index)) {
+                qCritical() << "Error creando índice de orden:" << query.lastError().text();
+                return false;
+            }
+        }
+        return true;
+    });
+
+    // Clave binaria de IP ordenable e indexada (consultas por subred)
+    migrator.addMigration(3, "columna ip_key", &DatabaseManager::createIpKeyColumn);
+
+    // Índice de búsqueda de texto completo (FTS5) sincronizado con 'devices'.
+    // Sin FTS5 la migración se da por aplicada: DeviceSearch recurre a LIKE
+    migrator.addMigration(4, "índice de búsqueda FTS5", &DatabaseManager::createSearchIndex);
+
+    // Filtro por propietario (getDevicesByUser, forEachDeviceOfUser, vista por usuario).
+    // El rowid va implícito en el índice: las filas de un usuario salen ordenadas por id
+    migrator.addMigration(5, "índice devices(user_id)", [](QSqlDatabase &db) {
+        QSqlQuery query(db);
+        if (!query.exec("CREATE INDEX IF NOT EXISTS idx_devices_user_id ON devices(user_id)")) {
+            qCritical() << "Error creando índice user_id:" << query.lastError().text();
+            return false;
+        }
+        return true;
+    });
+
+    // Último estado conocido de cada dispositivo (HealthScheduler). Se guarda aparte para
+    // que las comprobaciones periódicas no reescriban las filas de 'devices'
+    migrator.addMigration(6, "tabla device_health", [](QSqlDatabase &db) {
+        QSqlQuery query(db);
+        const QStringList statements = {
+            "CREATE TABLE IF NOT EXISTS device_health ("
+            "device_id INTEGER PRIMARY KEY, "
+            "status INTEGER NOT NULL DEFAULT 0, "
+            "port INTEGER, "
+            "latency_us INTEGER, "
+            "error TEXT, "
+            "failures INTEGER NOT NULL DEFAULT 0, "
+            "checked_at DATETIME, "
+            "poll_interval INTEGER)",
+            "CREATE TRIGGER IF NOT EXISTS devices_health_ad AFTER DELETE ON devices BEGIN "
+            "DELETE FROM device_health WHERE device_id = old.id; END"
+        };
+        for (const QString &sql : statements) {
+            if (!query.exec(sql)) {
+                qCritical() << "Error creando device_health:" << query.lastError().text();
+                return false;
+            }
+        }
+        return true;
+    });
+
+    // Agregados por minuto, hora y día de las lecturas (RollupEngine)
+    migrator.addMigration(7, "tabla device_rollups", [](QSqlDatabase &db) {
+        QSqlQuery query(db);
+        const QStringList statements = {
+            "CREATE TABLE IF NOT EXISTS device_rollups ("
+            "device_id INTEGER NOT NULL, "
+            "resolution INTEGER NOT NULL, "
+            "bucket_ms INTEGER NOT NULL, "
+            "min_value REAL NOT NULL, "
+            "max_value REAL NOT NULL, "
+            "sum_value REAL NOT NULL, "
+            "samples INTEGER NOT NULL, "
+            "PRIMARY KEY (device_id, resolution, bucket_ms)) WITHOUT ROWID",
+            "CREATE INDEX IF NOT EXISTS idx_device_rollups_retention ON device_rollups(resolution, bucket_ms)",
+            "CREATE TRIGGER IF NOT EXISTS devices_rollups_ad AFTER DELETE ON devices BEGIN "
+            "DELETE FROM device_rollups WHERE device_id = old.id; END"
+        };
+        for (const QString &sql : statements) {
+            if (!query.exec(sql)) {
+                qCritical() << "Error creando device_rollups:" << query.lastError().text();
+                return false;
+            }
+        }
+        return true;
+    });
 
-    if (!query.exec(logsTable)) {
-        qCritical() << "Error creando tabla logs:" << query.lastError().text();
+    const bool ok = migrator.migrate(db);
+    m_migrationReport = migrator.report();
+    if (!ok) {
         return false;
     }
 
-    // 2. Tabla de Usuarios (Autenticación)
-    QString usersTable = "CREATE TABLE IF NOT EXISTS users ("
-                         "id INTEGER PRIMARY KEY AUTOINCREMENT, "
-                         "username TEXT UNIQUE, "
-                         "password TEXT, "
-                         "role TEXT)";
+    createDefaultUser(db);
 
-    if (!query.exec(usersTable)) {
-        qCritical() << "Error creando tabla users:" << query.lastError().text();
+    return true;
+}
+
+bool DatabaseManager::createIpKeyColumn(QSqlDatabase &db)
+{
+    QSqlQuery query(db);
+
+    bool hasColumn = false;
+    if (query.exec("PRAGMA table_info(devices)")) {
+        while (query.next()) {
+            if (query.value(1).toString() == "ip_key") {
+                hasColumn = true;
+            }
+        }
+    }
+    query.finish();
+
+    if (!hasColumn && !query.exec("ALTER TABLE devices ADD COLUMN ip_key BLOB")) {
+        qCritical() << "Error agregando columna ip_key:" << query.lastError().text();
         return false;
     }
 
-    // 3. Tabla de Dispositivos (Inventario)
-    QString devicesTable = "CREATE TABLE IF NOT EXISTS devices ("
-                           "id INTEGER PRIMARY KEY AUTOINCREMENT, "
-                           "user_id INTEGER, "
-                           "name TEXT, "
-                           "type TEXT, "
-                           "ip_address TEXT, "
-                           "calibration REAL, "
-                           "FOREIGN KEY(user_id) REFERENCES users(id))";
+    if (!query.exec("CREATE INDEX IF NOT EXISTS idx_devices_ip_key ON devices(ip_key)")) {
+        qCritical() << "Error creando índice ip_key:" << query.lastError().text();
+        return false;
+    }
 
-    if (!query.exec(devicesTable)) {
-        qCritical() << "Error creando tabla devices:" << query.lastError().text();
+    // Completar la clave de los dispositivos guardados antes de existir la columna
+    QSqlQuery pending(db);
+    pending.setForwardOnly(true);
+    if (!pending.exec("SELECT id, ip_address FROM devices WHERE ip_key IS NULL")) {
+        qCritical() << "Error leyendo los dispositivos sin ip_key:" << pending.lastError().text();
         return false;
     }
 
-    createDefaultUser();
+    QList<QPair<int, QByteArray>> keys;
+    while (pending.next()) {
+        const IpAddress ip = IpAddress::parse(pending.value(1).toString().trimmed());
+        // Las IP no válidas quedan con clave vacía para no volver a procesarlas
+        keys.append({ pending.value(0).toInt(), ip.isValid() ? ip.toSortKey() : QByteArray("") });
+    }
+    pending.finish();
+
+    if (keys.isEmpty()) return true;
+
+    // La migración ya abrió la transacción: un único COMMIT para todo el relleno
+    QSqlQuery update(db);
+    update.prepare("UPDATE devices SET ip_key = :key WHERE id = :id");
+    for (const auto &entry : std::as_const(keys)) {
+        update.bindValue(":key", entry.second);
+        update.bindValue(":id", entry.first);
+        if (!update.exec()) {
+            qCritical() << "Error rellenando ip_key:" << update.lastError().text();
+            return false;
+        }
+    }
 
     return true;
 }
 
-void DatabaseManager::createDefaultUser()
+bool DatabaseManager::createSearchIndex(QSqlDatabase &db)
 {
-    QSqlQuery query("SELECT COUNT(*) FROM users");
-    if (query.next() && query.value(0).toInt() == 0) {
-        QSqlQuery insertQuery;
+    QSqlQuery query(db);
+
+    bool exists = query.exec("SELECT 1 FROM sqlite_master WHERE type = 'table' AND name = 'devices_fts'")
+                  && query.next();
+    query.finish();
+
+    if (!exists) {
+        // Tabla de contenido externo: solo guarda el índice, los datos siguen en 'devices'.
+        // Los índices de prefijo aceleran las búsquedas mientras se escribe.
+        QString ftsTable = "CREATE VIRTUAL TABLE devices_fts USING fts5("
+                           "name, ip_address, type, "
+                           "content='devices', content_rowid='id', prefix='1 2 3')";
+
+        if (!query.exec(ftsTable)) {
+            // SQLite compilado sin FTS5: DeviceSearch recurre a LIKE parametrizado
+            if (query.lastError().databaseText().contains("no such module: fts5", Qt::CaseInsensitive)) {
+                qWarning() << "FTS5 no disponible, búsqueda sin índice:" << query.lastError().text();
+                return true;
+            }
+            qCritical() << "Error creando índice de búsqueda:" << query.lastError().text();
+            return false;
+        }
+    }
+
+    const QStringList triggers = {
+        "CREATE TRIGGER IF NOT EXISTS devices_fts_ai AFTER INSERT ON devices BEGIN "
+        "INSERT INTO devices_fts(rowid, name, ip_address, type) "
+        "VALUES (new.id, new.name, new.ip_address, new.type); "
+        "END",
+
+        "CREATE TRIGGER IF NOT EXISTS devices_fts_ad AFTER DELETE ON devices BEGIN "
+        "INSERT INTO devices_fts(devices_fts, rowid, name, ip_address, type) "
+        "VALUES ('delete', old.id, old.name, old.ip_address, old.type); "
+        "END",
+
+        "CREATE TRIGGER IF NOT EXISTS devices_fts_au AFTER UPDATE ON devices BEGIN "
+        "INSERT INTO devices_fts(devices_fts, rowid, name, ip_address, type) "
+        "VALUES ('delete', old.id, old.name, old.ip_address, old.type); "
+        "INSERT INTO devices_fts(rowid, name, ip_address, type) "
+        "VALUES (new.id, new.name, new.ip_address, new.type); "
+        "END"
+    };
+
+    for (const QString &trigger : triggers) {
+        if (!query.exec(trigger)) {
+            qCritical() << "Error creando trigger de búsqueda:" << query.lastError().text();
+            return false;
+        }
+    }
+
+    // Indexar los dispositivos que ya existían antes de crear la tabla virtual
+    if (!exists && !query.exec("INSERT INTO devices_fts(devices_fts) VALUES ('rebuild')")) {
+        qCritical() << "Error construyendo índice de búsqueda:" << query.lastError().text();
+        return false;
+    }
+
+    return true;
+}
+
+void DatabaseManager::createDefaultUser(QSqlDatabase &db)
+{
+    // Basta con saber si hay alguna fila: no se cuenta la tabla entera
+    Tracer::Span span("DatabaseManager::createDefaultUser");
+    QSqlQuery query(db);
+    if (query.exec("SELECT 1 FROM users LIMIT 1") && !query.next()) {
+        QSqlQuery insertQuery(db);
         insertQuery.prepare("INSERT INTO users (username, password, role) VALUES (:user, :pass, :role)");
         insertQuery.bindValue(":user", "admin");
         insertQuery.bindValue(":pass", "1234");
@@ -134,41 +568,131 @@ void DatabaseManager::createDefaultUser()
     }
 }
 
+bool DatabaseManager::migrateLegacyLogs(QSqlDatabase &db)
+{
+    Tracer::Span span("DatabaseManager::migrateLegacyLogs");
+    QSqlQuery query(db);
+    const bool exists = query.exec("SELECT 1 FROM sqlite_master WHERE type = 'table' AND name = 'logs'")
+                        && query.next();
+    query.finish();
+    if (!exists) return true;
+
+    // Copiar en orden cronológico y por bloques: cada partición se escribe una sola vez.
+    // Cada fila lleva su id: si un arranque anterior se interrumpió antes del DROP, las
+    // ya copiadas se ignoran en lugar de duplicarse (ver LogStore::append())
+    QSqlQuery rows(db);
+    rows.setForwardOnly(true);
+    if (!rows.exec("SELECT timestamp, category, message, id FROM logs ORDER BY timestamp, id")) {
+        qCritical() << "Error leyendo la tabla logs antigua:" << rows.lastError().text();
+        return false;
+    }
+
+    // Nada se archiva hasta el DROP: un reintento volvería a crear las particiones ya
+    // archivadas y el archivo del mes quedaría duplicado. openStores() aplica la retención
+    m_logStore->setRetentionOnRollover(false);
+
+    const int chunkSize = 10000;
+    QList<LogEntry> chunk;
+    chunk.reserve(chunkSize);
+    int migrated = 0;
+    bool ok = true;
+
+    while (ok && rows.next()) {
+        chunk.append({ rows.value(0).toDateTime(), rows.value(1).toString(), rows.value(2).toString(),
+                       rows.value(3).toLongLong() });
+        if (chunk.size() == chunkSize) {
+            ok = m_logStore->append(chunk);
+            migrated += chunk.size();
+            chunk.clear();
+        }
+    }
+    rows.finish();
+
+    if (ok && !chunk.isEmpty()) {
+        ok = m_logStore->append(chunk);
+        migrated += chunk.size();
+    }
+
+    // Este hilo no vuelve a escribir: el AuditLogger abre sus propias conexiones. Si algo
+    // falla, la retención sigue desactivada en esta sesión: el AuditLogger también cambia
+    // de mes al escribir y archivaría las particiones que el reintento vuelve a rellenar
+    m_logStore->closeWriter();
+    if (!ok) return false;
+
+    if (!query.exec("DROP TABLE logs")) {
+        qCritical() << "Error eliminando la tabla logs antigua:" << query.lastError().text();
+        return false;
+    }
+    m_logStore->setRetentionOnRollover(true);
+    span.setRows(migrated);
+    qInfo() << "Logs migrados al almacén particionado:" << migrated;
+    return true;
+}
+
 // ---------------------------------------------------------
 // OPERACIONES CRUD Y UTILIDADES
 // ---------------------------------------------------------
 
 bool DatabaseManager::insertLog(const QString &category, const QString &message)
 {
-    QSqlQuery query;
-    query.prepare("INSERT INTO logs (timestamp, category, message) VALUES (:time, :cat, :msg)");
+    if (!m_auditLogger) return false;
 
-    query.bindValue(":time", QDateTime::currentDateTime());
-    query.bindValue(":cat", category);
-    query.bindValue(":msg", message);
-
-    if (!query.exec()) {
-        qWarning() << "Error insertando log:" << query.lastError().text();
+    if (!m_auditLogger->log(category, message)) {
+        qWarning() << "Log descartado (cola de auditoría llena):" << category;
         return false;
     }
     return true;
 }
 
+AuditLogger *DatabaseManager::auditLogger() const
+{
+    return m_auditLogger;
+}
+
+LogStore *DatabaseManager::logStore() const
+{
+    return m_logStore;
+}
+
+TimeSeriesStore *DatabaseManager::timeSeries() const
+{
+    return m_timeSeries;
+}
+
+RollupEngine *DatabaseManager::rollups() const
+{
+    return m_rollups;
+}
+
+QList<MigrationStep> DatabaseManager::migrationReport() const
+{
+    return m_migrationReport;
+}
+
 bool DatabaseManager::validateUser(const QString &username, const QString &password)
 {
-    QSqlQuery query;
-    query.prepare("SELECT password FROM users WHERE username = :user");
+    if (!m_pool) return false;
+
+    Tracer::Span span("DatabaseManager::validateUser");
+    QSqlQuery &query = m_pool->readStatement("SELECT password FROM users WHERE username = :user");
     query.bindValue(":user", username);
 
-    if (query.exec() && query.next()) {
+    bool valid = false;
+    if (SlowQueryLog::exec(query) && query.next()) {
         QString storedPass = query.value(0).toString();
-        return (storedPass == password);
+        valid = (storedPass == password);
     }
+    query.finish();
 
-    return false;
+    return valid;
 }
 
 QSqlDatabase DatabaseManager::getDatabase() const
 {
-    return m_database;
+    return m_pool ? m_pool->reader() : QSqlDatabase();
+}
+
+QString DatabaseManager::getDatabasePath() const
+{
+    return m_dbPath;
 }
@@ -1,4 +1,6 @@
 #include "device.h"
+#include "probeengine.h"
+#include "commandpipeline.h"
 #include <QDebug>
 
 // ---------------------------------------------------------
@@ -48,21 +50,53 @@ double Device::getCalibration() const { return m_calibration; }
 // LÓGICA DE CONEXIÓN
 // ---------------------------------------------------------
 
+void Device::setProbeRequester(const ProbeRequester &requester)
+{
+    m_prober = requester;
+}
+
 bool Device::connectToDevice()
 {
     if (m_isConnected) return true;
 
-    qDebug() << "Haciendo Ping a" << m_ip << "...";
+    if (m_ip.isEmpty()) {
+        emit errorOccurred("IP inválida");
+        return false;
+    }
 
-    if (!m_ip.isEmpty()) {
+    if (!m_prober) {
+        emit errorOccurred("Sin motor de comprobación");
+        return false;
+    }
+
+    // El estado se actualiza cuando llegue el resultado (applyProbeResult)
+    if (!m_prober(m_id, m_ip)) {
+        emit errorOccurred("No se pudo comprobar " + m_ip);
+        return false;
+    }
+    emit statusChanged("Comprobando " + m_ip + "...");
+    return true;
+}
+
+void Device::applyProbeResult(const ProbeResult &result)
+{
+    if (result.deviceId != m_id) return;
+
+    if (result.status == ProbeResult::Reachable) {
+        const bool wasConnected = m_isConnected;
         m_isConnected = true;
-        emit deviceConnected();
-        emit statusChanged("Conectado a " + m_ip);
-        return true;
+        if (!wasConnected) emit deviceConnected();
+        emit statusChanged(result.statusText());
+        return;
     }
 
-    emit errorOccurred("IP inválida");
-    return false;
+    // Puerto cerrado, sin respuesta o error de red: el dispositivo no está disponible
+    if (m_isConnected) {
+        m_isConnected = false;
+        emit deviceDisconnected();
+    }
+    emit errorOccurred(result.statusText());
+    emit statusChanged(result.statusText());
 }
 
 void Device::disconnectDevice()
@@ -74,12 +108,47 @@ void Device::disconnectDevice()
     emit statusChanged("Desconectado de " + m_ip);
 }
 
-void Device::sendData(const QString &data)
+void Device::setCommandSender(const CommandSender &sender)
+{
+    m_sender = sender;
+}
+
+bool Device::sendData(const QString &data)
 {
+    if (m_sender) {
+        // La cola abre (y reutiliza) su propia conexión con el dispositivo
+        if (m_sender(m_id, m_ip, data) == 0) {
+            emit errorOccurred("Cola de envío llena");
+            return false;
+        }
+        emit statusChanged("Comando en cola para " + m_ip);
+        return true;
+    }
+
     if (!m_isConnected) {
         emit errorOccurred("Dispositivo desconectado");
-        return;
+        return false;
     }
 
     qDebug() << "Enviando configuración a" << m_ip << ":" << data;
+    return true;
+}
+
+void Device::applyCommandResult(const CommandResult &result)
+{
+    if (result.deviceId != m_id) return;
+
+    switch (result.status) {
+    case CommandResult::Acknowledged:
+        emit dataReceived(result.reply);
+        break;
+    case CommandResult::Rejected:
+        emit errorOccurred("Comando rechazado: " + result.reply);
+        break;
+    case CommandResult::Failed:
+        emit errorOccurred(result.reply);
+        break;
+    default:
+        break;   // Sustituido o cancelado: no hay nada que notificar
+    }
 }
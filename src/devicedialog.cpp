@@ -1,8 +1,38 @@
 #include "devicedialog.h"
 #include "ui_devicedialog.h"
+#include "ipaddress.h"
 #include <QMessageBox>
-#include <QRegularExpression>
-#include <QRegularExpressionValidator>
+#include <QValidator>
+#include <utility>
+
+namespace {
+
+/**
+ * @brief Validador de IP (IPv4 o IPv6) basado en el analizador de IpAddress.
+ * Mientras se escribe acepta como intermedio cualquier texto con caracteres válidos.
+ */
+class IpAddressValidator : public QValidator
+{
+public:
+    explicit IpAddressValidator(QObject *parent) : QValidator(parent) {}
+
+    State validate(QString &input, int &) const override
+    {
+        if (input.isEmpty()) return Intermediate;
+        if (IpAddress::parse(input).isValid()) return Acceptable;
+        if (input.size() > 45) return Invalid;
+
+        for (const QChar c : std::as_const(input)) {
+            if (!(c.isDigit() || c == u'.' || c == u':'
+                  || (c.toLower() >= u'a' && c.toLower() <= u'f'))) {
+                return Invalid;
+            }
+        }
+        return Intermediate;
+    }
+};
+
+} // namespace
 
 // ---------------------------------------------------------
 // CONSTRUCTOR Y DESTRUCTOR
@@ -15,13 +45,9 @@ DeviceDialog::DeviceDialog(QWidget *parent) :
 {
     ui->setupUi(this);
 
-    // Configuración de validación para dirección IP (IPv4)
-    QString ipRange = "(?:[0-1]?[0-9]?[0-9]|2[0-4][0-9]|25[0-5])";
-    QRegularExpression ipRegex("^" + ipRange + "\\." + ipRange + "\\." + ipRange + "\\." + ipRange + "$");
-
-    QRegularExpressionValidator *ipValidator = new QRegularExpressionValidator(ipRegex, this);
-    ui->txtIp->setValidator(ipValidator);
-    ui->txtIp->setPlaceholderText("Ej: 192.168.0.1");
+    // Configuración de validación para dirección IP (IPv4 o IPv6)
+    ui->txtIp->setValidator(new IpAddressValidator(this));
+    ui->txtIp->setPlaceholderText("Ej: 192.168.0.1 o fe80::1");
 
     // Configuración del campo de calibración
     ui->spinCalibration->setRange(-100.0, 100.0);
@@ -47,6 +73,12 @@ void DeviceDialog::on_btnSave_clicked()
         return;
     }
 
+    const IpAddress ip = IpAddress::parse(ui->txtIp->text());
+    if (!ip.isValid()) {
+        QMessageBox::warning(this, "Aviso", "La dirección IP no es válida.");
+        return;
+    }
+
     // Limpiar objeto previo si existe para evitar fugas en reintentos
     if (m_device) {
         delete m_device;
@@ -56,7 +88,7 @@ void DeviceDialog::on_btnSave_clicked()
     m_device = new Device();
     m_device->setName(ui->txtName->text());
     m_device->setType(ui->comboType->currentText());
-    m_device->setIp(ui->txtIp->text());
+    m_device->setIp(ip.toString());
     m_device->setCalibration(ui->spinCalibration->value());
 
     accept();
@@ -0,0 +1,230 @@
+#include "deviceexporter.h"
+#include "tracer.h"
+#include <QSaveFile>
+#include <QSqlDatabase>
+#include <QSqlQuery>
+#include <QSqlError>
+#include <QElapsedTimer>
+#include <QLocale>
+#include <QDebug>
+
+namespace {
+
+/**
+ * @brief Destino de escritura con búfer de capacidad fija.
+ * Acumula las filas ya formateadas y solo toca el disco cuando el búfer se llena.
+ */
+class BufferedSink
+{
+public:
+    BufferedSink(QIODevice *device, int capacity)
+        : m_device(device), m_capacity(capacity), m_ok(true)
+    {
+        m_buffer.reserve(capacity);
+    }
+
+    void append(const QByteArray &data)
+    {
+        m_buffer.append(data);
+        if (m_buffer.size() >= m_capacity) flush();
+    }
+
+    void append(char c)
+    {
+        m_buffer.append(c);
+    }
+
+    bool flush()
+    {
+        if (!m_buffer.isEmpty() && m_ok) {
+            m_ok = m_device->write(m_buffer) == m_buffer.size();
+        }
+        m_buffer.clear();   // Conserva la capacidad reservada
+        return m_ok;
+    }
+
+    bool ok() const { return m_ok; }
+
+private:
+    QIODevice *m_device;
+    QByteArray m_buffer;
+    int m_capacity;
+    bool m_ok;
+};
+
+// Sanitización básica para formato CSV (igual que la exportación original)
+inline QByteArray csvField(const QString &text)
+{
+    QByteArray data = text.toUtf8();
+    data.replace(';', ',');
+    return data;
+}
+
+} // namespace
+
+// ---------------------------------------------------------
+// CONSTRUCTOR Y DESTRUCTOR
+// ---------------------------------------------------------
+
+DeviceExporter::DeviceExporter(ConnectionPool *pool, QObject *parent)
+    : QObject(parent)
+    , m_pool(pool)
+    , m_bufferSize(256 * 1024)
+    , m_thread(nullptr)
+    , m_cancel(false)
+{
+    qRegisterMetaType<ExportStats>();
+}
+
+DeviceExporter::~DeviceExporter()
+{
+    cancel();
+    if (m_thread) {
+        m_thread->wait();
+        delete m_thread;
+    }
+}
+
+// ---------------------------------------------------------
+// CONFIGURACIÓN
+// ---------------------------------------------------------
+
+void DeviceExporter::setFilter(const QString &where) { m_filter = where; }
+
+void DeviceExporter::setBufferSize(int bytes) { m_bufferSize = qMax(4096, bytes); }
+
+// ---------------------------------------------------------
+// CONTROL DE LA EXPORTACIÓN
+// ---------------------------------------------------------
+
+bool DeviceExporter::start(const QString &fileName)
+{
+    if (isRunning()) return false;
+
+    if (m_thread) {
+        delete m_thread;
+        m_thread = nullptr;
+    }
+
+    m_cancel = false;
+    const QString where = m_filter;
+    m_thread = QThread::create([this, fileName, where]() {
+        ExportStats stats = run(fileName, where);
+        emit finished(stats);
+    });
+    m_thread->setObjectName("Exportación");
+    m_thread->start();
+    return true;
+}
+
+void DeviceExporter::cancel()
+{
+    m_cancel = true;
+}
+
+bool DeviceExporter::isRunning() const
+{
+    return m_thread && m_thread->isRunning();
+}
+
+// ---------------------------------------------------------
+// HILO DE TRABAJO
+// ---------------------------------------------------------
+
+ExportStats DeviceExporter::run(const QString &fileName, const QString &where)
+{
+    ExportStats stats;
+    stats.fileName = fileName;
+    QElapsedTimer timer;
+    timer.start();
+
+    Tracer::Span span("DeviceExporter::run");
+    span.setDetail(fileName);
+
+    // QSaveFile escribe en un temporal y solo reemplaza el destino al confirmar
+    QSaveFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly)) {
+        stats.error = "No se pudo crear el archivo: " + file.errorString();
+        return stats;
+    }
+
+    {
+        QSqlDatabase db = m_pool->reader();
+
+        if (!db.isOpen()) {
+            stats.error = "Error al abrir la base de datos: " + db.lastError().text();
+        } else {
+            const QString whereClause = where.isEmpty() ? QString() : " WHERE " + where;
+
+            // Transacción de lectura: COUNT y SELECT ven la misma instantánea (WAL)
+            db.transaction();
+
+            qint64 total = 0;
+            {
+                QSqlQuery count(db);
+                if (count.exec("SELECT COUNT(*) FROM devices" + whereClause) && count.next()) {
+                    total = count.value(0).toLongLong();
+                }
+            }
+
+            QSqlQuery query(db);
+            query.setForwardOnly(true);
+
+            if (!query.exec("SELECT id, user_id, name, type, ip_address, calibration FROM devices"
+                            + whereClause + " ORDER BY id")) {
+                stats.error = "Error consultando dispositivos: " + query.lastError().text();
+            } else {
+                BufferedSink sink(&file, m_bufferSize);
+                sink.append(QByteArray("ID;Usuario_ID;Nombre;Tipo;IP;Calibracion\n"));
+
+                while (!m_cancel && query.next()) {
+                    sink.append(QByteArray::number(query.value(0).toLongLong()));
+                    sink.append(';');
+                    sink.append(QByteArray::number(query.value(1).toLongLong()));
+                    sink.append(';');
+                    sink.append(csvField(query.value(2).toString()));
+                    sink.append(';');
+                    sink.append(csvField(query.value(3).toString()));
+                    sink.append(';');
+                    sink.append(csvField(query.value(4).toString()));
+                    sink.append(';');
+                    sink.append(QByteArray::number(query.value(5).toDouble(), 'g',
+                                                   QLocale::FloatingPointShortest));
+                    sink.append(QByteArray("\n"));
+
+                    if (!sink.ok()) {
+                        stats.error = "Error escribiendo el archivo: " + file.errorString();
+                        break;
+                    }
+
+                    if (++stats.rowsExported % 10000 == 0) {
+                        emit progress(stats.rowsExported, total);
+                    }
+                }
+
+                if (stats.error.isEmpty() && !sink.flush()) {
+                    stats.error = "Error escribiendo el archivo: " + file.errorString();
+                }
+                emit progress(stats.rowsExported, total);
+            }
+
+            query.finish();
+            db.rollback();   // Solo lectura: cerrar la instantánea
+        }
+    }
+    ConnectionPool::releaseCurrentThread();
+
+    stats.cancelled = m_cancel;
+    if (stats.cancelled || !stats.error.isEmpty()) {
+        file.cancelWriting();
+    } else {
+        stats.bytesWritten = file.pos();
+        if (!file.commit()) {
+            stats.error = "No se pudo guardar el archivo: " + file.errorString();
+        }
+    }
+
+    stats.elapsedMs = timer.elapsed();
+    span.setRows(stats.rowsExported);
+    return stats;
+}
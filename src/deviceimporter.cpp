@@ -0,0 +1,334 @@
+#include "deviceimporter.h"
+#include "ipaddress.h"
+#include <QFile>
+#include <QSqlDatabase>
+#include <QSqlQuery>
+#include <QSqlError>
+#include <QElapsedTimer>
+#include <QVector>
+#include <QDebug>
+#include <cstring>
+#include <deque>
+#include <future>
+#include <memory>
+#include <utility>
+
+namespace {
+
+/**
+ * @brief Fila ya analizada y validada, lista para el INSERT.
+ */
+struct ParsedDevice
+{
+    int userId;
+    QString name;
+    QString type;
+    QString ip;
+    QByteArray ipKey;
+    double calibration;
+};
+
+/**
+ * @brief Resultado del análisis de un bloque del archivo.
+ */
+struct ParsedChunk
+{
+    QVector<ParsedDevice> rows;
+    qint64 rowsRead = 0;
+    qint64 rowsRejected = 0;
+    qint64 endOffset = 0;   // Posición del archivo al final del bloque (para el progreso)
+};
+
+// Columnas del formato exportado: ID;Usuario_ID;Nombre;Tipo;IP;Calibracion
+constexpr int kColumnCount = 6;
+
+ParsedChunk parseChunk(const QByteArray &block, qint64 endOffset, int defaultUserId)
+{
+    ParsedChunk chunk;
+    chunk.endOffset = endOffset;
+    chunk.rows.reserve(block.count('\n') + 1);
+
+    const char *p = block.constData();
+    const char *end = p + block.size();
+
+    while (p < end) {
+        const char *lineEnd = static_cast<const char *>(memchr(p, '\n', end - p));
+        if (!lineEnd) lineEnd = end;
+
+        const char *lineLast = lineEnd;
+        if (lineLast > p && lineLast[-1] == '\r') --lineLast;
+
+        if (lineLast > p) {
+            ++chunk.rowsRead;
+
+            // Separar campos sin copiar
+            const char *fieldStart[kColumnCount];
+            qsizetype fieldSize[kColumnCount];
+            int fields = 0;
+            const char *f = p;
+            for (const char *c = p; c <= lineLast && fields < kColumnCount; ++c) {
+                if (c == lineLast || *c == ';') {
+                    fieldStart[fields] = f;
+                    fieldSize[fields] = c - f;
+                    ++fields;
+                    f = c + 1;
+                }
+            }
+
+            const IpAddress ip = fields == kColumnCount
+                                     ? IpAddress::parse(fieldStart[4], fieldSize[4])
+                                     : IpAddress();
+
+            if (ip.isValid() && fieldSize[2] > 0) {
+                ParsedDevice dev;
+
+                bool ok = false;
+                dev.userId = QByteArray::fromRawData(fieldStart[1], fieldSize[1]).toInt(&ok);
+                if (!ok || dev.userId <= 0) dev.userId = defaultUserId;
+
+                dev.name = QString::fromUtf8(fieldStart[2], fieldSize[2]);
+                dev.type = QString::fromUtf8(fieldStart[3], fieldSize[3]);
+                dev.ip = ip.toString();
+                dev.ipKey = ip.toSortKey();
+
+                dev.calibration = QByteArray::fromRawData(fieldStart[5], fieldSize[5]).toDouble(&ok);
+                if (!ok) dev.calibration = 0.0;
+
+                chunk.rows.append(std::move(dev));
+            } else {
+                ++chunk.rowsRejected;
+            }
+        }
+
+        p = lineEnd + 1;
+    }
+
+    return chunk;
+}
+
+} // namespace
+
+// ---------------------------------------------------------
+// MÉTRICAS
+// ---------------------------------------------------------
+
+double ImportStats::rowsPerSecond() const
+{
+    if (elapsedMs <= 0) return 0.0;
+    return rowsImported * 1000.0 / elapsedMs;
+}
+
+// ---------------------------------------------------------
+// CONSTRUCTOR Y DESTRUCTOR
+// ---------------------------------------------------------
+
+DeviceImporter::DeviceImporter(ConnectionPool *pool, QObject *parent)
+    : QObject(parent)
+    , m_pool(pool)
+    , m_defaultUserId(1)
+    , m_batchSize(50000)
+    , m_chunkSize(1 << 20)
+    , m_thread(nullptr)
+    , m_cancel(false)
+{
+    qRegisterMetaType<ImportStats>();
+    m_parsePool.setMaxThreadCount(qMax(1, QThread::idealThreadCount() - 1));
+}
+
+DeviceImporter::~DeviceImporter()
+{
+    cancel();
+    if (m_thread) {
+        m_thread->wait();
+        delete m_thread;
+    }
+    m_parsePool.waitForDone();
+}
+
+// ---------------------------------------------------------
+// CONFIGURACIÓN
+// ---------------------------------------------------------
+
+void DeviceImporter::setDefaultUserId(int userId) { m_defaultUserId = userId; }
+
+void DeviceImporter::setBatchSize(int rows) { m_batchSize = qMax(1, rows); }
+
+void DeviceImporter::setChunkSize(int bytes) { m_chunkSize = qMax(4096, bytes); }
+
+// ---------------------------------------------------------
+// CONTROL DE LA IMPORTACIÓN
+// ---------------------------------------------------------
+
+bool DeviceImporter::start(const QString &fileName)
+{
+    if (isRunning()) return false;
+
+    if (m_thread) {
+        delete m_thread;
+        m_thread = nullptr;
+    }
+
+    m_cancel = false;
+    m_thread = QThread::create([this, fileName]() {
+        ImportStats stats = run(fileName);
+        emit finished(stats);
+    });
+    m_thread->setObjectName("Importación");
+    m_thread->start();
+    return true;
+}
+
+void DeviceImporter::cancel()
+{
+    m_cancel = true;
+}
+
+bool DeviceImporter::isRunning() const
+{
+    return m_thread && m_thread->isRunning();
+}
+
+// ---------------------------------------------------------
+// HILO DE TRABAJO
+// ---------------------------------------------------------
+
+ImportStats DeviceImporter::run(const QString &fileName)
+{
+    ImportStats stats;
+    QElapsedTimer timer;
+    timer.start();
+
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly)) {
+        stats.error = "No se pudo abrir el archivo: " + file.errorString();
+        return stats;
+    }
+    const qint64 totalBytes = file.size();
+
+    // Conexión de escritura propia del hilo: QSqlDatabase no puede compartirse entre hilos
+    {
+        QSqlDatabase db = m_pool->writer();
+
+        if (!db.isOpen()) {
+            stats.error = "Error al abrir la base de datos: " + db.lastError().text();
+        } else {
+            QSqlQuery insert(db);
+            // Una única sentencia preparada reutilizada para todas las filas
+            if (!insert.prepare("INSERT INTO devices (user_id, name, type, ip_address, ip_key, calibration) "
+                                "VALUES (?, ?, ?, ?, ?, ?)")) {
+                stats.error = "Error preparando INSERT: " + insert.lastError().text();
+            }
+
+            const int maxInFlight = qMax(2, m_parsePool.maxThreadCount() * 2);
+            std::deque<std::future<ParsedChunk>> pending;
+            QByteArray carry;
+            bool firstBlock = true;
+            bool inTransaction = false;
+            qint64 rowsInBatch = 0;
+            // Escritor del pool: se retiene solo mientras dura cada lote
+            std::unique_ptr<ConnectionPool::WriteLock> writeLock;
+
+            while (stats.error.isEmpty() && !m_cancel) {
+                // 1. Mantener el pool ocupado con bloques terminados en salto de línea
+                while (pending.size() < static_cast<size_t>(maxInFlight) && !file.atEnd()) {
+                    QByteArray block = carry + file.read(m_chunkSize);
+                    carry.clear();
+
+                    if (!file.atEnd()) {
+                        const qsizetype cut = block.lastIndexOf('\n');
+                        if (cut < 0) {
+                            carry = block;   // Línea más larga que el bloque: seguir leyendo
+                            continue;
+                        }
+                        carry = block.mid(cut + 1);
+                        block.truncate(cut + 1);
+                    }
+
+                    // Omitir el encabezado generado por la exportación
+                    if (firstBlock) {
+                        firstBlock = false;
+                        if (block.startsWith("ID;")) {
+                            const qsizetype nl = block.indexOf('\n');
+                            block = (nl < 0) ? QByteArray() : block.mid(nl + 1);
+                        }
+                    }
+
+                    const qint64 endOffset = file.pos() - carry.size();
+                    const int defaultUser = m_defaultUserId;
+                    auto promise = std::make_shared<std::promise<ParsedChunk>>();
+                    pending.push_back(promise->get_future());
+                    m_parsePool.start([promise, block, endOffset, defaultUser]() {
+                        promise->set_value(parseChunk(block, endOffset, defaultUser));
+                    });
+                }
+
+                if (pending.empty()) break;
+
+                // 2. Insertar los bloques en el orden del archivo
+                ParsedChunk chunk = pending.front().get();
+                pending.pop_front();
+
+                stats.rowsRead += chunk.rowsRead;
+                stats.rowsRejected += chunk.rowsRejected;
+
+                for (const ParsedDevice &dev : std::as_const(chunk.rows)) {
+                    if (m_cancel) break;
+
+                    if (!inTransaction) {
+                        writeLock = std::make_unique<ConnectionPool::WriteLock>(m_pool);
+                        if (!db.transaction()) {
+                            stats.error = "Error iniciando transacción: " + db.lastError().text();
+                            break;
+                        }
+                        inTransaction = true;
+                    }
+
+                    insert.bindValue(0, dev.userId);
+                    insert.bindValue(1, dev.name);
+                    insert.bindValue(2, dev.type);
+                    insert.bindValue(3, dev.ip);
+                    insert.bindValue(4, dev.ipKey);
+                    insert.bindValue(5, dev.calibration);
+
+                    if (!insert.exec()) {
+                        stats.error = "Error insertando dispositivo: " + insert.lastError().text();
+                        break;
+                    }
+
+                    if (++rowsInBatch >= m_batchSize) {
+                        if (!db.commit()) {
+                            stats.error = "Error confirmando lote: " + db.lastError().text();
+                            break;
+                        }
+                        inTransaction = false;
+                        writeLock.reset();
+                        stats.rowsImported += rowsInBatch;
+                        rowsInBatch = 0;
+                    }
+                }
+
+                emit progress(chunk.endOffset, totalBytes, stats.rowsImported + rowsInBatch);
+            }
+
+            // 3. Confirmar el último lote o revertirlo si hubo error/cancelación
+            if (inTransaction) {
+                if (stats.error.isEmpty() && !m_cancel && db.commit()) {
+                    stats.rowsImported += rowsInBatch;
+                } else {
+                    db.rollback();
+                }
+            }
+            writeLock.reset();
+
+            // Esperar a los bloques que sigan en análisis antes de liberar recursos
+            for (auto &future : pending) future.wait();
+
+            insert.finish();
+        }
+    }
+    ConnectionPool::releaseCurrentThread();
+
+    stats.cancelled = m_cancel;
+    stats.elapsedMs = timer.elapsed();
+    return stats;
+}
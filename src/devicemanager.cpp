@@ -1,11 +1,41 @@
 #include "devicemanager.h"
+#include "ipaddress.h"
+#include "databasemanager.h"
+#include "tracer.h"
+#include "slowquerylog.h"
 #include <QSqlQuery>
 #include <QSqlError>
 #include <QDebug>
 
+namespace {
+
+DeviceRecord valuesOf(const Device *device)
+{
+    DeviceRecord values;
+    values.id = device->getId();
+    values.userId = device->getUserId();
+    values.name = device->getName();
+    values.type = device->getType();
+    values.ip = device->getIp();
+    values.calibration = device->getCalibration();
+    return values;
+}
+
+ConnectionPool *openPool()
+{
+    ConnectionPool *pool = DatabaseManager::pool();
+    if (!pool) {
+        qCritical() << "No hay una base de datos abierta.";
+    }
+    return pool;
+}
+
+} // namespace
+
 DeviceManager::DeviceManager(QObject *parent)
     : QObject(parent)
 {
+    qRegisterMetaType<DeviceChange>();
 }
 
 // ---------------------------------------------------------
@@ -14,24 +44,34 @@ DeviceManager::DeviceManager(QObject *parent)
 
 bool DeviceManager::addDevice(Device *device)
 {
-    if (!device) return false;
+    ConnectionPool *pool = openPool();
+    if (!device || !pool) return false;
 
-    QSqlQuery query;
-    query.prepare("INSERT INTO devices (user_id, name, type, ip_address, calibration) "
-                  "VALUES (:user, :name, :type, :ip, :cal)");
+    Tracer::Span span("DeviceManager::addDevice");
+    ConnectionPool::WriteLock lock(pool);
+    QSqlQuery &query = pool->writeStatement("INSERT INTO devices (user_id, name, type, ip_address, ip_key, calibration) "
+                                            "VALUES (:user, :name, :type, :ip, :key, :cal)");
 
     query.bindValue(":user", device->getUserId());
     query.bindValue(":name", device->getName());
     query.bindValue(":type", device->getType());
     query.bindValue(":ip", device->getIp());
+    query.bindValue(":key", ipSortKey(device->getIp()));
     query.bindValue(":cal", device->getCalibration());
 
-    if (!query.exec()) {
+    if (!SlowQueryLog::exec(query)) {
         qCritical() << "Error al agregar dispositivo:" << query.lastError().text();
         return false;
     }
 
-    emit deviceListChanged();
+    device->setId(query.lastInsertId().toInt());
+    span.setRows(1);
+
+    DeviceChange change;
+    change.kind = DeviceChange::Inserted;
+    change.values = valuesOf(device);
+
+    emit deviceListChanged({ change });
     return true;
 }
 
@@ -42,12 +82,14 @@ bool DeviceManager::addDevice(Device *device)
 QList<Device*> DeviceManager::getDevicesByUser(int userId)
 {
     QList<Device*> list;
-    QSqlQuery query;
+    ConnectionPool *pool = openPool();
+    if (!pool) return list;
 
-    query.prepare("SELECT id, name, type, ip_address, calibration FROM devices WHERE user_id = :uid");
+    Tracer::Span span("DeviceManager::getDevicesByUser");
+    QSqlQuery &query = pool->readStatement("SELECT id, name, type, ip_address, calibration FROM devices WHERE user_id = :uid");
     query.bindValue(":uid", userId);
 
-    if (query.exec()) {
+    if (SlowQueryLog::exec(query)) {
         while (query.next()) {
             Device *dev = new Device();
 
@@ -63,34 +105,194 @@ QList<Device*> DeviceManager::getDevicesByUser(int userId)
     } else {
         qCritical() << "Error recuperando dispositivos:" << query.lastError().text();
     }
+    // Sentencia cacheada: liberar la lectura sin finalizarla
+    query.finish();
+    span.setRows(list.size());
 
     return list;
 }
 
+QList<DeviceRecord> DeviceManager::getDeviceRecordsByUser(int userId)
+{
+    QList<DeviceRecord> list;
+
+    forEachDeviceOfUser(userId, [&list](const DeviceRecord &record) {
+        list.append(record);
+        return true;
+    });
+
+    return list;
+}
+
+int DeviceManager::forEachDeviceOfUser(int userId,
+                                       const std::function<bool(const DeviceRecord &)> &visitor)
+{
+    ConnectionPool *pool = openPool();
+    if (!pool) return -1;
+
+    Tracer::Span span("DeviceManager::forEachDeviceOfUser");
+    // Sentencia propia y de solo avance: el visitante puede usar las cacheadas del pool
+    // (que se reinician al reutilizarlas) sin mover este cursor
+    QSqlQuery query(pool->reader());
+    query.setForwardOnly(true);
+    query.prepare("SELECT id, name, type, ip_address, calibration FROM devices WHERE user_id = :uid");
+    query.bindValue(":uid", userId);
+
+    if (!SlowQueryLog::exec(query)) {
+        qCritical() << "Error recorriendo dispositivos:" << query.lastError().text();
+        return -1;
+    }
+
+    // Un único registro reutilizado; columnas leídas por posición
+    DeviceRecord record;
+    record.userId = userId;
+    int visited = 0;
+
+    while (query.next()) {
+        record.id = query.value(0).toInt();
+        record.name = query.value(1).toString();
+        record.type = m_types.intern(query.value(2).toString());
+        record.ip = query.value(3).toString();
+        record.calibration = query.value(4).toDouble();
+
+        ++visited;
+        if (!visitor(record)) break;
+    }
+    span.setRows(visited);
+
+    return visited;
+}
+
+QList<Device*> DeviceManager::getDevicesInSubnet(const QString &cidr)
+{
+    QList<Device*> list;
+
+    ConnectionPool *pool = openPool();
+    if (!pool) return list;
+
+    IpAddress first, last;
+    if (!IpAddress::parseCidr(cidr, &first, &last)) {
+        qWarning() << "Subred no válida:" << cidr;
+        return list;
+    }
+
+    Tracer::Span span("DeviceManager::getDevicesInSubnet");
+    span.setDetail(cidr);
+    QSqlQuery &query = pool->readStatement("SELECT id, user_id, name, type, ip_address, calibration FROM devices "
+                                           "WHERE ip_key BETWEEN :first AND :last ORDER BY ip_key");
+    query.bindValue(":first", first.toSortKey());
+    query.bindValue(":last", last.toSortKey());
+
+    if (SlowQueryLog::exec(query)) {
+        while (query.next()) {
+            Device *dev = new Device();
+
+            dev->setId(query.value(0).toInt());
+            dev->setUserId(query.value(1).toInt());
+            dev->setName(query.value(2).toString());
+            dev->setType(query.value(3).toString());
+            dev->setIp(query.value(4).toString());
+            dev->setCalibration(query.value(5).toDouble());
+
+            list.append(dev);
+        }
+    } else {
+        qCritical() << "Error recuperando dispositivos por subred:" << query.lastError().text();
+    }
+    query.finish();
+    span.setRows(list.size());
+
+    return list;
+}
+
+QList<ProbeTarget> DeviceManager::getProbeTargets(const QString &where)
+{
+    QList<ProbeTarget> targets;
+    ConnectionPool *pool = openPool();
+    if (!pool) return targets;
+
+    Tracer::Span span("DeviceManager::getProbeTargets");
+    span.setDetail(where);
+
+    // El filtro es el del modelo (subred o IDs de búsqueda), nunca texto del usuario
+    QSqlQuery query(pool->reader());
+    query.setForwardOnly(true);
+    if (!SlowQueryLog::exec(query, "SELECT id, ip_address FROM devices" + (where.isEmpty() ? QString() : " WHERE " + where))) {
+        qCritical() << "Error recuperando direcciones:" << query.lastError().text();
+        return targets;
+    }
+
+    while (query.next()) {
+        ProbeTarget target;
+        target.deviceId = query.value(0).toInt();
+        target.host = query.value(1).toString();
+        targets.append(target);
+    }
+    span.setRows(targets.size());
+
+    return targets;
+}
+
+QString DeviceManager::subnetFilter(const QString &cidr)
+{
+    IpAddress first, last;
+    if (!IpAddress::parseCidr(cidr, &first, &last)) return QString();
+
+    // Literales BLOB generados a partir de bytes, nunca del texto del usuario
+    return QString("ip_key BETWEEN X'%1' AND X'%2'")
+        .arg(QString::fromLatin1(first.toSortKey().toHex()),
+             QString::fromLatin1(last.toSortKey().toHex()));
+}
+
+QByteArray DeviceManager::ipSortKey(const QString &ip)
+{
+    const IpAddress address = IpAddress::parse(ip.trimmed());
+    // Clave vacía (no NULL) para IP no válidas: quedan fuera de cualquier rango
+    return address.isValid() ? address.toSortKey() : QByteArray("");
+}
+
 // ---------------------------------------------------------
 // ACTUALIZAR (UPDATE)
 // ---------------------------------------------------------
 
 bool DeviceManager::updateDevice(Device *device)
 {
-    if (!device || device->getId() == -1) return false;
+    ConnectionPool *pool = openPool();
+    if (!device || device->getId() == -1 || !pool) return false;
+
+    Tracer::Span span("DeviceManager::updateDevice");
+    // Lectura previa y UPDATE bajo el mismo bloqueo: nadie escribe entre ambos
+    ConnectionPool::WriteLock lock(pool);
+
+    // Valores anteriores: permiten a la vista ubicar la fila antes del cambio
+    DeviceChange change;
+    change.kind = DeviceChange::Updated;
+    if (!fetchValues(device->getId(), &change.previous)) {
+        qWarning() << "Dispositivo a actualizar no encontrado:" << device->getId();
+        return false;
+    }
 
-    QSqlQuery query;
-    query.prepare("UPDATE devices SET name = :name, type = :type, "
-                  "ip_address = :ip, calibration = :cal WHERE id = :id");
+    QSqlQuery &query = pool->writeStatement("UPDATE devices SET name = :name, type = :type, "
+                                            "ip_address = :ip, ip_key = :key, calibration = :cal WHERE id = :id");
 
     query.bindValue(":name", device->getName());
     query.bindValue(":type", device->getType());
     query.bindValue(":ip", device->getIp());
+    query.bindValue(":key", ipSortKey(device->getIp()));
     query.bindValue(":cal", device->getCalibration());
     query.bindValue(":id", device->getId());
 
-    if (!query.exec()) {
+    if (!SlowQueryLog::exec(query)) {
         qCritical() << "Error actualizando dispositivo:" << query.lastError().text();
         return false;
     }
+    span.setRows(query.numRowsAffected());
 
-    emit deviceListChanged();
+    change.values = valuesOf(device);
+    // El propietario no se modifica en el UPDATE
+    change.values.userId = change.previous.userId;
+
+    emit deviceListChanged({ change });
     return true;
 }
 
@@ -100,15 +302,50 @@ bool DeviceManager::updateDevice(Device *device)
 
 bool DeviceManager::removeDevice(int deviceId)
 {
-    QSqlQuery query;
-    query.prepare("DELETE FROM devices WHERE id = :id");
+    ConnectionPool *pool = openPool();
+    if (!pool) return false;
+
+    Tracer::Span span("DeviceManager::removeDevice");
+    ConnectionPool::WriteLock lock(pool);
+
+    DeviceChange change;
+    change.kind = DeviceChange::Removed;
+    if (!fetchValues(deviceId, &change.values)) {
+        qWarning() << "Dispositivo a eliminar no encontrado:" << deviceId;
+        return false;
+    }
+
+    QSqlQuery &query = pool->writeStatement("DELETE FROM devices WHERE id = :id");
     query.bindValue(":id", deviceId);
 
-    if (!query.exec()) {
+    if (!SlowQueryLog::exec(query)) {
         qCritical() << "Error eliminando dispositivo:" << query.lastError().text();
         return false;
     }
+    span.setRows(query.numRowsAffected());
+
+    emit deviceListChanged({ change });
+    return true;
+}
+
+bool DeviceManager::fetchValues(int deviceId, DeviceRecord *values)
+{
+    // Conexión de escritura: el llamador ya tiene el WriteLock
+    QSqlQuery &query = DatabaseManager::pool()->writeStatement(
+        "SELECT user_id, name, type, ip_address, calibration FROM devices WHERE id = :id");
+    query.bindValue(":id", deviceId);
+
+    if (!SlowQueryLog::exec(query) || !query.next()) {
+        query.finish();
+        return false;
+    }
 
-    emit deviceListChanged();
+    values->id = deviceId;
+    values->userId = query.value(0).toInt();
+    values->name = query.value(1).toString();
+    values->type = query.value(2).toString();
+    values->ip = query.value(3).toString();
+    values->calibration = query.value(4).toDouble();
+    query.finish();
     return true;
 }
@@ -0,0 +1,191 @@
+#include "devicesearch.h"
+#include "tracer.h"
+#include "slowquerylog.h"
+#include <QSqlDatabase>
+#include <QSqlQuery>
+#include <QSqlError>
+#include <QRegularExpression>
+#include <QDebug>
+
+// ---------------------------------------------------------
+// CONSTRUCTOR Y DESTRUCTOR
+// ---------------------------------------------------------
+
+DeviceSearch::DeviceSearch(ConnectionPool *pool, QObject *parent)
+    : QObject(parent)
+    , m_pool(pool)
+    , m_limit(5000)
+    , m_connected(false)
+    , m_ftsAvailable(false)
+    , m_context(new QObject)
+    , m_generation(0)
+{
+    m_debounce.setSingleShot(true);
+    m_debounce.setInterval(150);
+    connect(&m_debounce, &QTimer::timeout, this, &DeviceSearch::dispatch);
+
+    m_context->moveToThread(&m_thread);
+    connect(&m_thread, &QThread::finished, m_context, &QObject::deleteLater);
+    m_thread.setObjectName("Búsqueda");
+    m_thread.start();
+}
+
+DeviceSearch::~DeviceSearch()
+{
+    cancel();
+
+    // La conexión debe cerrarse en el mismo hilo que la abrió
+    QMetaObject::invokeMethod(m_context, [this]() {
+        ConnectionPool::releaseCurrentThread();
+        m_connected = false;
+    }, Qt::BlockingQueuedConnection);
+
+    m_thread.quit();
+    m_thread.wait();
+}
+
+// ---------------------------------------------------------
+// CONFIGURACIÓN
+// ---------------------------------------------------------
+
+void DeviceSearch::setDebounceInterval(int ms) { m_debounce.setInterval(qMax(0, ms)); }
+
+void DeviceSearch::setResultLimit(int limit) { m_limit = qMax(1, limit); }
+
+// ---------------------------------------------------------
+// PROGRAMACIÓN DE BÚSQUEDAS
+// ---------------------------------------------------------
+
+void DeviceSearch::search(const QString &text)
+{
+    // Invalida inmediatamente cualquier consulta anterior aún en cola
+    ++m_generation;
+    m_pendingText = text;
+    m_debounce.start();
+}
+
+void DeviceSearch::cancel()
+{
+    ++m_generation;
+    m_debounce.stop();
+    m_pendingText.clear();
+}
+
+void DeviceSearch::dispatch()
+{
+    const quint64 generation = m_generation;
+    const QString text = m_pendingText;
+    const int limit = m_limit;
+
+    QMetaObject::invokeMethod(m_context, [this, generation, text, limit]() {
+        execute(generation, text, limit);
+    }, Qt::QueuedConnection);
+}
+
+QString DeviceSearch::buildMatchExpression(const QString &text)
+{
+    static const QRegularExpression separators("\\s+");
+
+    QStringList terms;
+    const QStringList words = text.split(separators, Qt::SkipEmptyParts);
+    for (QString word : words) {
+        word.replace('"', "\"\"");
+        terms << '"' + word + "\"*";
+    }
+    return terms.join(' ');
+}
+
+bool DeviceSearch::hasFtsIndex(QSqlDatabase db)
+{
+    QSqlQuery check(db);
+    return check.exec("SELECT 1 FROM sqlite_master WHERE name = 'devices_fts'") && check.next();
+}
+
+bool DeviceSearch::findIds(QSqlDatabase db, const QString &text, bool fts, int limit, QList<int> *ids,
+                           bool *truncated, const std::function<bool()> &cancelled)
+{
+    if (truncated) *truncated = false;
+
+    QSqlQuery query(db);
+    query.setForwardOnly(true);
+
+    if (fts) {
+        const QString match = buildMatchExpression(text);
+        if (match.isEmpty()) return true;
+
+        query.prepare("SELECT rowid FROM devices_fts WHERE devices_fts MATCH :q "
+                      "ORDER BY rowid LIMIT :lim");
+        query.bindValue(":q", match);
+    } else {
+        QString pattern = text;
+        pattern.replace('\\', "\\\\").replace('%', "\\%").replace('_', "\\_");
+        pattern = '%' + pattern + '%';
+
+        query.prepare("SELECT id FROM devices WHERE name LIKE :name ESCAPE '\\' "
+                      "OR ip_address LIKE :ip ESCAPE '\\' ORDER BY id LIMIT :lim");
+        query.bindValue(":name", pattern);
+        query.bindValue(":ip", pattern);
+    }
+    // Se pide una fila extra para saber si el resultado quedó truncado (-1: sin límite)
+    query.bindValue(":lim", limit > 0 ? limit + 1 : -1);
+
+    if (!SlowQueryLog::exec(query)) {
+        qWarning() << "Error en búsqueda de dispositivos:" << query.lastError().text();
+        return false;
+    }
+
+    if (limit > 0) ids->reserve(qMin(limit, 1024));
+    while (query.next()) {
+        // Abandonar a mitad de lectura si quien llama ya no quiere el resultado
+        if ((ids->size() & 255) == 0 && cancelled && cancelled()) return false;
+
+        if (limit > 0 && ids->size() == limit) {
+            if (truncated) *truncated = true;
+            break;
+        }
+        ids->append(query.value(0).toInt());
+    }
+    return true;
+}
+
+// ---------------------------------------------------------
+// HILO DE BÚSQUEDA
+// ---------------------------------------------------------
+
+void DeviceSearch::execute(quint64 generation, const QString &text, int limit)
+{
+    // Consulta reemplazada por otra más reciente: no se ejecuta
+    if (generation != m_generation) return;
+
+    // Conexión de solo lectura del hilo de búsqueda (se abre en la primera consulta)
+    QSqlDatabase db = m_pool->reader();
+    if (!db.isOpen()) return;
+
+    if (!m_connected) {
+        m_connected = true;
+
+        m_ftsAvailable = hasFtsIndex(db);
+        if (!m_ftsAvailable) {
+            qWarning() << "Índice FTS5 no disponible; la búsqueda usará LIKE parametrizado.";
+        }
+    }
+
+    // Sin términos que buscar en el índice no hay resultados que publicar
+    if (m_ftsAvailable && buildMatchExpression(text).isEmpty()) return;
+
+    Tracer::Span span("DeviceSearch::execute");
+    span.setDetail(text);
+
+    // Abandonar a mitad de lectura si el usuario ya escribió otra cosa
+    QList<int> ids;
+    bool truncated = false;
+    if (!findIds(db, text, m_ftsAvailable, limit, &ids, &truncated,
+                 [this, generation]() { return generation != m_generation; })) {
+        return;
+    }
+    span.setRows(ids.size());
+
+    if (generation == m_generation) {
+        emit resultsReady(text, ids, truncated);
+    }
+}
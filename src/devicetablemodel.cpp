@@ -0,0 +1,588 @@
+#include "devicetablemodel.h"
+#include "tracer.h"
+#include "slowquerylog.h"
+#include <QSqlError>
+#include <QStringList>
+#include <QDebug>
+#include <cstdlib>
+
+// ---------------------------------------------------------
+// CONSTRUCTOR
+// ---------------------------------------------------------
+
+DeviceTableModel::DeviceTableModel(const QSqlDatabase &db, QObject *parent)
+    : QAbstractTableModel(parent)
+    , m_db(db)
+    , m_sortColumn(ColId)
+    , m_sortOrder(Qt::AscendingOrder)
+    , m_rowCount(0)
+    , m_pageSize(256)
+    , m_maxPages(8)
+    , m_useCounter(0)
+    , m_lastPage(0)
+    , m_prefetchPage(-1)
+{
+}
+
+// ---------------------------------------------------------
+// INTERFAZ DE QAbstractTableModel
+// ---------------------------------------------------------
+
+int DeviceTableModel::rowCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : m_rowCount;
+}
+
+int DeviceTableModel::columnCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : ColumnCount;
+}
+
+QVariant DeviceTableModel::data(const QModelIndex &index, int role) const
+{
+    if (!index.isValid() || (role != Qt::DisplayRole && role != Qt::EditRole)) {
+        return QVariant();
+    }
+
+    const DeviceRecord *row = rowAt(index.row());
+    if (!row) return QVariant();
+
+    switch (index.column()) {
+    case ColId:          return row->id;
+    case ColUserId:      return row->userId;
+    case ColName:        return row->name;
+    case ColType:        return row->type;
+    case ColIp:          return row->ip;
+    case ColCalibration: return row->calibration;
+    case ColStatus:      return m_probes.value(row->id).statusText();
+    default:             return QVariant();
+    }
+}
+
+QVariant DeviceTableModel::headerData(int section, Qt::Orientation orientation, int role) const
+{
+    if (orientation != Qt::Horizontal || role != Qt::DisplayRole) {
+        return QAbstractTableModel::headerData(section, orientation, role);
+    }
+
+    switch (section) {
+    case ColId:          return "ID";
+    case ColUserId:      return "Usuario";
+    case ColName:        return "Nombre";
+    case ColType:        return "Tipo";
+    case ColIp:          return "Dirección IP";
+    case ColCalibration: return "Calibración";
+    case ColStatus:      return "Estado";
+    default:             return QVariant();
+    }
+}
+
+void DeviceTableModel::sort(int column, Qt::SortOrder order)
+{
+    // El estado solo existe en memoria: no hay columna indexada por la que ordenar
+    if (column < 0 || column >= ColumnCount || column == ColStatus) return;
+    if (column == m_sortColumn && order == m_sortOrder) return;
+
+    beginResetModel();
+    m_sortColumn = column;
+    m_sortOrder = order;
+    m_pages.clear();
+    m_anchors.clear();
+    m_prefetchPage = -1;
+    endResetModel();
+}
+
+// ---------------------------------------------------------
+// FILTRO Y RECARGA
+// ---------------------------------------------------------
+
+void DeviceTableModel::setFilter(const QString &where, const QVariantList &params)
+{
+    m_filter = where;
+    m_filterParams = params;
+}
+
+QString DeviceTableModel::filter() const
+{
+    return m_filter;
+}
+
+bool DeviceTableModel::select()
+{
+    beginResetModel();
+
+    m_pages.clear();
+    m_anchors.clear();
+    m_types.clear();
+    m_prefetchPage = -1;
+    m_lastPage = 0;
+    m_rowCount = 0;
+
+    Tracer::Span span("DeviceTableModel::select");
+    span.setDetail(m_filter);
+    QSqlQuery query(m_db);
+    query.prepare("SELECT COUNT(*) FROM devices" + whereSql(false));
+    bindFilter(query, nullptr);
+
+    bool ok = SlowQueryLog::exec(query) && query.next();
+    if (ok) {
+        m_rowCount = query.value(0).toInt();
+        span.setRows(m_rowCount);
+    } else {
+        qCritical() << "Error contando dispositivos:" << query.lastError().text();
+    }
+
+    endResetModel();
+    return ok;
+}
+
+int DeviceTableModel::deviceIdAt(int row) const
+{
+    const DeviceRecord *r = rowAt(row);
+    return r ? r->id : -1;
+}
+
+void DeviceTableModel::setPageSize(int rows) { m_pageSize = qMax(16, rows); }
+
+void DeviceTableModel::setMaxCachedPages(int pages) { m_maxPages = qMax(2, pages); }
+
+// ---------------------------------------------------------
+// ACTUALIZACIONES INCREMENTALES
+// ---------------------------------------------------------
+
+void DeviceTableModel::applyChanges(const QList<DeviceChange> &changes)
+{
+    for (const DeviceChange &change : changes) {
+        switch (change.kind) {
+        case DeviceChange::Inserted:
+            applyInsert(change.values.id, change.values);
+            break;
+
+        case DeviceChange::Removed:
+            applyRemove(change.values.id, change.values);
+            m_probes.remove(change.values.id);
+            break;
+
+        case DeviceChange::Updated: {
+            const bool wasVisible = matchesFilter(change.values.id, change.previous);
+            const bool isVisible = matchesFilter(change.values.id, change.values);
+            const bool sameKey = sortKeyOf(change.values.id, change.previous)
+                                 == sortKeyOf(change.values.id, change.values);
+
+            if (wasVisible && isVisible && sameKey) {
+                // Misma posición: basta con actualizar la fila en caché (si lo está)
+                int row = cachedRowOf(change.values.id);
+                if (row >= 0) {
+                    Page &page = m_pages[row / m_pageSize];
+                    DeviceRecord &cached = page.rows[row % m_pageSize];
+                    cached.name = change.values.name;
+                    cached.type = m_types.intern(change.values.type);
+                    cached.ip = change.values.ip;
+                    cached.calibration = change.values.calibration;
+                    emit dataChanged(index(row, 0), index(row, ColumnCount - 1));
+                }
+            } else {
+                if (wasVisible) applyRemove(change.values.id, change.previous);
+                if (isVisible) applyInsert(change.values.id, change.values);
+            }
+            break;
+        }
+        }
+    }
+}
+
+void DeviceTableModel::setProbeResult(const ProbeResult &result)
+{
+    m_probes.insert(result.deviceId, result);
+
+    // Solo las filas en caché pueden estar a la vista; el resto lee el estado al cargarse
+    const int row = cachedRowOf(result.deviceId);
+    if (row >= 0) {
+        const QModelIndex cell = index(row, ColStatus);
+        emit dataChanged(cell, cell, { Qt::DisplayRole });
+    }
+}
+
+void DeviceTableModel::clearProbeResults()
+{
+    if (m_probes.isEmpty()) return;
+
+    m_probes.clear();
+    if (m_rowCount > 0) {
+        emit dataChanged(index(0, ColStatus), index(m_rowCount - 1, ColStatus), { Qt::DisplayRole });
+    }
+}
+
+void DeviceTableModel::applyInsert(int id, const DeviceRecord &values)
+{
+    if (!matchesFilter(id, values)) return;
+
+    const int row = positionOf(id, sortKeyOf(id, values));
+    if (row < 0 || row > m_rowCount) {
+        select();
+        return;
+    }
+
+    beginInsertRows(QModelIndex(), row, row);
+    ++m_rowCount;
+    invalidateFrom(row);
+    endInsertRows();
+}
+
+void DeviceTableModel::applyRemove(int id, const DeviceRecord &values)
+{
+    if (!matchesFilter(id, values)) return;
+
+    int row = cachedRowOf(id);
+    if (row < 0) {
+        row = positionOf(id, sortKeyOf(id, values));
+    }
+    if (row < 0 || row >= m_rowCount) {
+        select();
+        return;
+    }
+
+    beginRemoveRows(QModelIndex(), row, row);
+    --m_rowCount;
+    invalidateFrom(row);
+    endRemoveRows();
+}
+
+bool DeviceTableModel::matchesFilter(int id, const DeviceRecord &values) const
+{
+    if (m_filter.isEmpty()) return true;
+
+    Tracer::Span span("DeviceTableModel::matchesFilter");
+
+    // El filtro se evalúa sobre una fila literal con las mismas columnas que 'devices'
+    QSqlQuery query(m_db);
+    query.prepare("SELECT 1 FROM (SELECT ? AS id, ? AS user_id, ? AS name, ? AS type, "
+                  "? AS ip_address, ? AS ip_key, ? AS calibration) AS devices "
+                  "WHERE (" + m_filter + ")");
+    query.addBindValue(id);
+    query.addBindValue(values.userId);
+    query.addBindValue(values.name);
+    query.addBindValue(values.type);
+    query.addBindValue(values.ip);
+    query.addBindValue(DeviceManager::ipSortKey(values.ip));
+    query.addBindValue(values.calibration);
+    for (const QVariant &param : m_filterParams) {
+        query.addBindValue(param);
+    }
+
+    return SlowQueryLog::exec(query) && query.next();
+}
+
+QVariant DeviceTableModel::sortKeyOf(int id, const DeviceRecord &values) const
+{
+    switch (m_sortColumn) {
+    case ColUserId:      return values.userId;
+    case ColName:        return values.name;
+    case ColType:        return values.type;
+    case ColIp:          return DeviceManager::ipSortKey(values.ip);
+    case ColCalibration: return values.calibration;
+    default:             return id;
+    }
+}
+
+int DeviceTableModel::positionOf(int id, const QVariant &key) const
+{
+    const QString op = (m_sortOrder == Qt::AscendingOrder) ? "<" : ">";
+
+    QStringList clauses;
+    if (!m_filter.isEmpty()) {
+        clauses << "(" + m_filter + ")";
+    }
+    if (m_sortColumn == ColId) {
+        clauses << "id " + op + " ?";
+    } else {
+        clauses << QString("(%1, id) %2 (?, ?)").arg(sortKeySql(), op);
+    }
+    clauses << "id <> ?";
+
+    Tracer::Span span("DeviceTableModel::positionOf");
+    QSqlQuery query(m_db);
+    query.prepare("SELECT COUNT(*) FROM devices WHERE " + clauses.join(" AND "));
+    for (const QVariant &param : m_filterParams) {
+        query.addBindValue(param);
+    }
+    if (m_sortColumn != ColId) {
+        query.addBindValue(key);
+    }
+    query.addBindValue(id);
+    query.addBindValue(id);
+
+    if (!SlowQueryLog::exec(query) || !query.next()) {
+        qWarning() << "No se pudo ubicar el dispositivo" << id << query.lastError().text();
+        return -1;
+    }
+    return query.value(0).toInt();
+}
+
+int DeviceTableModel::cachedRowOf(int id) const
+{
+    for (auto it = m_pages.constBegin(); it != m_pages.constEnd(); ++it) {
+        const QVector<DeviceRecord> &rows = it->rows;
+        for (int i = 0; i < rows.size(); ++i) {
+            if (rows.at(i).id == id) {
+                return it.key() * m_pageSize + i;
+            }
+        }
+    }
+    return -1;
+}
+
+void DeviceTableModel::invalidateFrom(int row)
+{
+    const int firstPage = row / m_pageSize;
+
+    for (auto it = m_pages.begin(); it != m_pages.end();) {
+        if (it.key() >= firstPage) {
+            it = m_pages.erase(it);
+        } else {
+            ++it;
+        }
+    }
+
+    // El ancla de una página es su primera fila: cambia si la página empieza en 'row' o después
+    for (auto it = m_anchors.begin(); it != m_anchors.end();) {
+        if (qint64(it.key()) * m_pageSize >= row) {
+            it = m_anchors.erase(it);
+        } else {
+            ++it;
+        }
+    }
+
+    m_prefetchPage = -1;
+}
+
+// ---------------------------------------------------------
+// CACHÉ DE PÁGINAS
+// ---------------------------------------------------------
+
+const DeviceRecord *DeviceTableModel::rowAt(int row) const
+{
+    if (row < 0 || row >= m_rowCount) return nullptr;
+
+    const int page = row / m_pageSize;
+
+    auto it = m_pages.find(page);
+    if (it == m_pages.end()) {
+        if (!loadPage(page)) return nullptr;
+        it = m_pages.find(page);
+    }
+    it->lastUse = ++m_useCounter;
+
+    // Precargar en la dirección del desplazamiento
+    if (page != m_lastPage) {
+        const int next = page + (page > m_lastPage ? 1 : -1);
+        m_lastPage = page;
+        if (next >= 0 && next * m_pageSize < m_rowCount && !m_pages.contains(next)) {
+            schedulePrefetch(next);
+        }
+    }
+
+    const int offset = row - page * m_pageSize;
+    if (offset >= it->rows.size()) return nullptr;
+    return &it->rows.at(offset);
+}
+
+bool DeviceTableModel::loadPage(int page) const
+{
+    if (page < 0 || page * m_pageSize >= m_rowCount) return false;
+
+    Anchor anchor;
+    const bool hasAnchor = page > 0;
+    if (hasAnchor && !findAnchor(page, &anchor)) return false;
+
+    Tracer::Span span("DeviceTableModel::loadPage");
+    QSqlQuery query(m_db);
+    query.setForwardOnly(true);
+    // Columnas de la fila y, al final, la clave de orden (para las anclas)
+    query.prepare("SELECT id, user_id, name, type, ip_address, calibration, " + sortKeySql()
+                  + " FROM devices" + whereSql(hasAnchor) + orderSql(false) + " LIMIT ?");
+    bindFilter(query, hasAnchor ? &anchor : nullptr);
+    // Una fila extra: su clave es el ancla de la página siguiente
+    query.addBindValue(m_pageSize + 1);
+
+    if (!SlowQueryLog::exec(query)) {
+        qCritical() << "Error cargando página de dispositivos:" << query.lastError().text();
+        return false;
+    }
+
+    Page loaded;
+    loaded.rows.reserve(m_pageSize);
+
+    while (query.next()) {
+        if (loaded.rows.size() == m_pageSize) {
+            m_anchors.insert(page + 1, Anchor{ query.value(6), query.value(0).toInt() });
+            break;
+        }
+
+        DeviceRecord row;
+        row.id = query.value(0).toInt();
+        row.userId = query.value(1).toInt();
+        row.name = query.value(2).toString();
+        row.type = m_types.intern(query.value(3).toString());
+        row.ip = query.value(4).toString();
+        row.calibration = query.value(5).toDouble();
+
+        if (loaded.rows.isEmpty()) {
+            m_anchors.insert(page, Anchor{ query.value(6), row.id });
+        }
+        loaded.rows.append(std::move(row));
+    }
+
+    span.setRows(loaded.rows.size());
+    if (loaded.rows.isEmpty()) return false;
+
+    loaded.lastUse = ++m_useCounter;
+    m_pages.insert(page, loaded);
+    evictPages(page);
+    return true;
+}
+
+bool DeviceTableModel::findAnchor(int page, Anchor *anchor) const
+{
+    auto known = m_anchors.constFind(page);
+    if (known != m_anchors.constEnd()) {
+        *anchor = known.value();
+        return true;
+    }
+
+    // Ancla conocida más cercana por debajo (la página 0 no necesita ancla)
+    int basePage = 0;
+    const Anchor *base = nullptr;
+    auto below = m_anchors.lowerBound(page);
+    if (below != m_anchors.begin()) {
+        --below;
+        basePage = below.key();
+        base = &below.value();
+    }
+
+    const qint64 forwardDistance = qint64(page - basePage) * m_pageSize;
+    const qint64 backwardDistance = qint64(m_rowCount) - qint64(page) * m_pageSize - 1;
+    const bool fromEnd = backwardDistance < forwardDistance;
+
+    Tracer::Span span("DeviceTableModel::findAnchor");
+    QSqlQuery query(m_db);
+    query.setForwardOnly(true);
+
+    if (fromEnd) {
+        // Recorrer el índice en orden inverso desde la última fila
+        query.prepare("SELECT " + sortKeySql() + ", id FROM devices"
+                      + whereSql(false) + orderSql(true) + " LIMIT 1 OFFSET ?");
+        bindFilter(query, nullptr);
+        query.addBindValue(backwardDistance);
+    } else {
+        query.prepare("SELECT " + sortKeySql() + ", id FROM devices"
+                      + whereSql(base != nullptr) + orderSql(false) + " LIMIT 1 OFFSET ?");
+        bindFilter(query, base);
+        query.addBindValue(forwardDistance);
+    }
+
+    if (!SlowQueryLog::exec(query) || !query.next()) {
+        qWarning() << "No se pudo ubicar la página" << page << query.lastError().text();
+        return false;
+    }
+
+    anchor->key = query.value(0);
+    anchor->id = query.value(1).toInt();
+    m_anchors.insert(page, *anchor);
+    return true;
+}
+
+void DeviceTableModel::schedulePrefetch(int page) const
+{
+    if (m_prefetchPage >= 0) return;
+    m_prefetchPage = page;
+
+    // Fuera de data(): la precarga no retrasa el pintado de la vista actual
+    DeviceTableModel *self = const_cast<DeviceTableModel *>(this);
+    QMetaObject::invokeMethod(self, [self]() {
+        const int target = self->m_prefetchPage;
+        self->m_prefetchPage = -1;
+        if (target >= 0 && !self->m_pages.contains(target)) {
+            self->loadPage(target);
+        }
+    }, Qt::QueuedConnection);
+}
+
+void DeviceTableModel::evictPages(int current) const
+{
+    while (m_pages.size() > m_maxPages) {
+        // Descartar la página más alejada; a igual distancia, la menos usada
+        auto victim = m_pages.end();
+        int victimDistance = -1;
+        for (auto it = m_pages.begin(); it != m_pages.end(); ++it) {
+            const int distance = std::abs(it.key() - current);
+            if (distance > victimDistance
+                || (distance == victimDistance && it->lastUse < victim->lastUse)) {
+                victim = it;
+                victimDistance = distance;
+            }
+        }
+        if (victim == m_pages.end() || victim.key() == current) break;
+        m_pages.erase(victim);
+    }
+}
+
+// ---------------------------------------------------------
+// CONSTRUCCIÓN DE CONSULTAS
+// ---------------------------------------------------------
+
+QString DeviceTableModel::sortKeySql() const
+{
+    switch (m_sortColumn) {
+    case ColUserId:      return "user_id";
+    case ColName:        return "name";
+    case ColType:        return "type";
+    case ColIp:          return "ip_key";   // Orden numérico, no lexicográfico
+    case ColCalibration: return "calibration";
+    default:             return "id";
+    }
+}
+
+QString DeviceTableModel::whereSql(bool withAnchor) const
+{
+    QStringList clauses;
+    if (!m_filter.isEmpty()) {
+        clauses << "(" + m_filter + ")";
+    }
+
+    if (withAnchor) {
+        const QString op = (m_sortOrder == Qt::AscendingOrder) ? ">=" : "<=";
+        if (m_sortColumn == ColId) {
+            clauses << "id " + op + " ?";
+        } else {
+            clauses << QString("(%1, id) %2 (?, ?)").arg(sortKeySql(), op);
+        }
+    }
+
+    return clauses.isEmpty() ? QString() : " WHERE " + clauses.join(" AND ");
+}
+
+QString DeviceTableModel::orderSql(bool reversed) const
+{
+    const bool ascending = (m_sortOrder == Qt::AscendingOrder) != reversed;
+    const QString dir = ascending ? " ASC" : " DESC";
+
+    if (m_sortColumn == ColId) {
+        return " ORDER BY id" + dir;
+    }
+    return " ORDER BY " + sortKeySql() + dir + ", id" + dir;
+}
+
+void DeviceTableModel::bindFilter(QSqlQuery &query, const Anchor *anchor) const
+{
+    for (const QVariant &param : m_filterParams) {
+        query.addBindValue(param);
+    }
+
+    if (anchor) {
+        if (m_sortColumn != ColId) {
+            query.addBindValue(anchor->key);
+        }
+        query.addBindValue(anchor->id);
+    }
+}
@@ -0,0 +1,516 @@
+#include "healthscheduler.h"
+#include "connectionpool.h"
+#include "ipaddress.h"
+#include "tracer.h"
+#include <QSqlQuery>
+#include <QSqlError>
+#include <QDebug>
+#include <cmath>
+
+// ---------------------------------------------------------
+// CONSTRUCTOR Y DESTRUCTOR
+// ---------------------------------------------------------
+
+HealthScheduler::HealthScheduler(ConnectionPool *pool, QObject *parent)
+    : QObject(parent)
+    , m_pool(pool)
+    , m_random(QRandomGenerator::global()->generate())
+    , m_context(new QObject)
+    , m_generation(0)
+    , m_tickOrigin(0)
+    , m_tickMs(100)
+    , m_defaultIntervalSec(300)
+    , m_jitter(0.1)
+    , m_subnetRate(10.0)
+    , m_subnetBurst(20)
+    , m_maxBackoffSec(3600)
+    , m_running(false)
+{
+    m_tick.setInterval(m_tickMs);
+    m_flush.setInterval(2000);
+
+    connect(&m_tick, &QTimer::timeout, this, &HealthScheduler::onTick);
+    connect(&m_flush, &QTimer::timeout, this, &HealthScheduler::flush);
+    connect(&m_engine, &ProbeEngine::resultReady, this, &HealthScheduler::onProbeResult);
+
+    m_context->moveToThread(&m_thread);
+    connect(&m_thread, &QThread::finished, m_context, &QObject::deleteLater);
+    m_thread.setObjectName("Estados de comprobación");
+    m_thread.start();
+}
+
+HealthScheduler::~HealthScheduler()
+{
+    stop();
+
+    // Espera al último guardado; la conexión debe cerrarse en el mismo hilo que la abrió
+    QMetaObject::invokeMethod(m_context, []() {
+        ConnectionPool::releaseCurrentThread();
+    }, Qt::BlockingQueuedConnection);
+
+    m_thread.quit();
+    m_thread.wait();
+}
+
+// ---------------------------------------------------------
+// CONFIGURACIÓN
+// ---------------------------------------------------------
+
+void HealthScheduler::setTickInterval(int ms)
+{
+    if (m_running) return;
+    m_tickMs = qMax(10, ms);
+    m_tick.setInterval(m_tickMs);
+}
+
+void HealthScheduler::setDefaultInterval(int seconds) { m_defaultIntervalSec = qMax(1, seconds); }
+
+void HealthScheduler::setJitter(double fraction) { m_jitter = qBound(0.0, fraction, 0.5); }
+
+void HealthScheduler::setSubnetRateLimit(double probesPerSecond, int burst)
+{
+    m_subnetRate = qMax(0.01, probesPerSecond);
+    m_subnetBurst = qMax(1, burst);
+}
+
+void HealthScheduler::setMaxBackoff(int seconds) { m_maxBackoffSec = qMax(1, seconds); }
+
+ProbeEngine *HealthScheduler::engine() { return &m_engine; }
+
+bool HealthScheduler::isRunning() const { return m_running; }
+
+ProbeResult HealthScheduler::lastResult(int deviceId) const
+{
+    return m_devices.value(deviceId).last;
+}
+
+HealthStats HealthScheduler::stats() const
+{
+    HealthStats stats = m_stats;
+    stats.devices = m_devices.size();
+    stats.failing = 0;
+    for (const Entry &entry : m_devices) {
+        if (entry.failures > 0) ++stats.failing;
+    }
+    return stats;
+}
+
+bool HealthScheduler::setPollInterval(int deviceId, int seconds)
+{
+    seconds = qMax(0, seconds);
+    {
+        ConnectionPool::WriteLock lock(m_pool);
+        QSqlQuery &query = m_pool->writeStatement(
+            "INSERT INTO device_health (device_id, poll_interval) VALUES (?, ?) "
+            "ON CONFLICT(device_id) DO UPDATE SET poll_interval = excluded.poll_interval");
+        query.bindValue(0, deviceId);
+        query.bindValue(1, seconds > 0 ? QVariant(seconds) : QVariant());
+        if (!query.exec()) {
+            qWarning() << "Error guardando el intervalo de comprobación:" << query.lastError().text();
+            return false;
+        }
+    }
+
+    auto it = m_devices.find(deviceId);
+    if (it != m_devices.end()) {
+        it->intervalSec = seconds;
+        if (m_running && !it->inFlight && !it->reserved) scheduleNext(deviceId, *it);
+    }
+    return true;
+}
+
+// ---------------------------------------------------------
+// CONTROL
+// ---------------------------------------------------------
+
+void HealthScheduler::start()
+{
+    if (m_running) return;
+
+    // La rueda parte vacía: los ticks se cuentan desde ahora
+    m_wheel.clear();
+    m_tickOrigin = m_wheel.now();
+    m_buckets.clear();
+    m_clock.start();
+    m_running = true;
+
+    loadFleet();
+
+    m_tick.start();
+    m_flush.start();
+    qInfo() << "Planificador de comprobaciones iniciado";
+}
+
+void HealthScheduler::stop()
+{
+    if (m_running) {
+        m_running = false;
+        ++m_generation;   // La flota que aún no ha llegado ya no se programa
+        m_tick.stop();
+        m_flush.stop();
+        m_engine.cancel();
+        m_wheel.clear();
+
+        for (Entry &entry : m_devices) {
+            entry.inFlight = false;
+            entry.reserved = false;
+        }
+    }
+    flush();
+}
+
+void HealthScheduler::reload()
+{
+    loadFleet();
+}
+
+void HealthScheduler::applyChanges(const QList<DeviceChange> &changes)
+{
+    for (const DeviceChange &change : changes) {
+        const int id = change.values.id;
+
+        if (change.kind == DeviceChange::Removed) {
+            untrack(id);
+            continue;
+        }
+
+        const bool known = m_devices.contains(id);
+        Entry &entry = track(id, change.values.ip);
+
+        // Altas y cambios de IP se comprueban enseguida (dentro del próximo segundo)
+        const bool hostChanged = change.kind == DeviceChange::Updated && change.previous.ip != change.values.ip;
+        if (m_running && !entry.inFlight && (!known || hostChanged)) {
+            entry.reserved = false;
+            m_wheel.schedule(id, ticksFor(m_random.bounded(1000)));
+        }
+    }
+}
+
+// ---------------------------------------------------------
+// PLANIFICACIÓN
+// ---------------------------------------------------------
+
+void HealthScheduler::onTick()
+{
+    QElapsedTimer cost;
+    cost.start();
+
+    // Se avanza según el reloj, no según los disparos: un retraso del bucle se recupera
+    const quint64 target = m_tickOrigin + quint64(m_clock.elapsed() / m_tickMs);
+    if (target <= m_wheel.now()) return;
+
+    const QList<int> due = m_wheel.advance(target - m_wheel.now());
+
+    QList<ProbeTarget> batch;
+    for (int id : due) {
+        auto it = m_devices.find(id);
+        if (it == m_devices.end()) continue;
+
+        // Sin ficha de su subred: se reserva la siguiente y se reprograma para entonces
+        if (!it->reserved) {
+            const qint64 waitMs = takeToken(it->subnet);
+            if (waitMs > 0) {
+                it->reserved = true;
+                ++m_stats.deferred;
+                m_wheel.schedule(id, ticksFor(waitMs));
+                continue;
+            }
+        }
+
+        it->reserved = false;
+        it->inFlight = true;
+
+        ProbeTarget probeTarget;
+        probeTarget.deviceId = id;
+        probeTarget.host = it->host;
+        batch.append(probeTarget);
+    }
+
+    if (!batch.isEmpty()) {
+        m_stats.probesStarted += batch.size();
+        m_engine.probe(batch);
+    }
+
+    m_stats.lastTickUs = cost.nsecsElapsed() / 1000;
+}
+
+void HealthScheduler::onProbeResult(const ProbeResult &result)
+{
+    auto it = m_devices.find(result.deviceId);
+    if (it == m_devices.end() || !it->inFlight) return;   // Dado de baja durante la comprobación
+
+    it->inFlight = false;
+    it->failures = result.hostResponded() ? 0 : it->failures + 1;
+    it->last = result;
+    it->checkedAt = QDateTime::currentDateTimeUtc();
+    m_dirty.insert(result.deviceId);
+
+    if (m_running) scheduleNext(result.deviceId, *it);
+
+    emit resultReady(result);
+}
+
+void HealthScheduler::scheduleNext(int deviceId, const Entry &entry)
+{
+    const qint64 baseMs = qint64(entry.intervalSec > 0 ? entry.intervalSec : m_defaultIntervalSec) * 1000;
+    qint64 ms = baseMs;
+
+    // Espera exponencial para los que no responden, con tope (nunca por debajo del intervalo)
+    if (entry.failures > 0) {
+        const qint64 capMs = qMax(baseMs, qint64(m_maxBackoffSec) * 1000);
+        ms = qMin(capMs, baseMs << qMin(entry.failures, 16));
+    }
+
+    ms = qint64(ms * (1.0 + m_jitter * (2.0 * m_random.generateDouble() - 1.0)));
+    m_wheel.schedule(deviceId, ticksFor(ms));
+}
+
+qint64 HealthScheduler::takeToken(const QByteArray &subnet)
+{
+    if (subnet.isEmpty()) return 0;   // IP no válida: el motor la resuelve sin tráfico
+
+    const qint64 now = m_clock.elapsed();
+    auto it = m_buckets.find(subnet);
+    if (it == m_buckets.end()) {
+        Bucket bucket;
+        bucket.tokens = m_subnetBurst;
+        bucket.updatedMs = now;
+        it = m_buckets.insert(subnet, bucket);
+    } else {
+        it->tokens = qMin(double(m_subnetBurst), it->tokens + (now - it->updatedMs) * m_subnetRate / 1000.0);
+        it->updatedMs = now;
+    }
+
+    it->tokens -= 1.0;
+    if (it->tokens >= 0.0) return 0;
+
+    // Fichas en negativo: cada reserva espera a la suya, así salen en orden y espaciadas
+    return qint64(std::ceil(-it->tokens * 1000.0 / m_subnetRate));
+}
+
+quint64 HealthScheduler::ticksFor(qint64 ms) const
+{
+    if (ms <= 0) return 1;
+    return qMax<quint64>(1, quint64((ms + m_tickMs - 1) / m_tickMs));
+}
+
+QByteArray HealthScheduler::subnetKey(const QString &host)
+{
+    const IpAddress address = IpAddress::parse(host.trimmed());
+    if (!address.isValid()) return QByteArray();
+
+    // Clave de 16 bytes (IPv4 mapeada): /24 = 15 primeros bytes, /64 = 8 primeros
+    return address.toSortKey().left(address.family() == IpAddress::IPv4 ? 15 : 8);
+}
+
+// ---------------------------------------------------------
+// FLOTA Y PERSISTENCIA
+// ---------------------------------------------------------
+
+void HealthScheduler::loadFleet()
+{
+    ConnectionPool *pool = m_pool;
+    const quint64 generation = m_generation;
+
+    QMetaObject::invokeMethod(m_context, [this, pool, generation]() {
+        if (generation != m_generation) return;
+
+        QList<Stored> rows;
+        if (!readFleet(pool, rows)) return;
+
+        QMetaObject::invokeMethod(this, [this, generation, rows]() {
+            if (generation == m_generation) applyFleet(rows);
+        }, Qt::QueuedConnection);
+    }, Qt::QueuedConnection);
+}
+
+bool HealthScheduler::readFleet(ConnectionPool *pool, QList<Stored> &rows)
+{
+    Tracer::Span span("HealthScheduler::readFleet");
+    QSqlQuery query(pool->reader());
+    query.setForwardOnly(true);
+    if (!query.exec("SELECT d.id, d.ip_address, h.status, h.port, h.latency_us, h.error, "
+                    "h.failures, h.checked_at, h.poll_interval "
+                    "FROM devices d LEFT JOIN device_health h ON h.device_id = d.id")) {
+        qCritical() << "Error leyendo la flota a comprobar:" << query.lastError().text();
+        return false;
+    }
+
+    while (query.next()) {
+        Stored row;
+        row.deviceId = query.value(0).toInt();
+        row.host = query.value(1).toString();
+        row.intervalSec = query.value(8).toInt();
+        row.hasState = !query.value(2).isNull();
+        if (row.hasState) {
+            row.last.deviceId = row.deviceId;
+            row.last.host = row.host;
+            row.last.status = ProbeResult::Status(query.value(2).toInt());
+            row.last.port = quint16(query.value(3).toUInt());
+            row.last.latencyUs = query.value(4).toLongLong();
+            row.last.error = query.value(5).toString();
+            row.failures = query.value(6).toInt();
+            row.checkedAt = query.value(7).toDateTime();
+        }
+        rows.append(row);
+    }
+    span.setRows(rows.size());
+    return true;
+}
+
+void HealthScheduler::applyFleet(const QList<Stored> &rows)
+{
+    const QDateTime now = QDateTime::currentDateTimeUtc();
+    QSet<int> seen;
+    seen.reserve(rows.size());
+
+    for (const Stored &row : rows) {
+        const int id = row.deviceId;
+        seen.insert(id);
+
+        const bool known = m_devices.contains(id);
+        Entry &entry = track(id, row.host);
+        entry.intervalSec = row.intervalSec;
+
+        if (!known && row.hasState) {
+            entry.last = row.last;
+            entry.failures = row.failures;
+            entry.checkedAt = row.checkedAt;
+            if (entry.last.status != ProbeResult::Unknown) emit resultReady(entry.last);
+        }
+
+        if (!m_running || entry.inFlight || entry.reserved || m_wheel.contains(id)) continue;
+
+        // Se respeta el plazo pendiente de la última comprobación guardada; los vencidos
+        // (o nunca comprobados) se reparten por todo el intervalo para evitar la avalancha
+        const qint64 intervalMs = qint64(entry.intervalSec > 0 ? entry.intervalSec : m_defaultIntervalSec) * 1000;
+        const qint64 remainingMs = entry.checkedAt.isValid() ? intervalMs - entry.checkedAt.msecsTo(now) : 0;
+        if (remainingMs > 0 && entry.failures == 0) {
+            m_wheel.schedule(id, ticksFor(remainingMs));
+        } else {
+            m_wheel.schedule(id, ticksFor(qint64(m_random.generateDouble() * intervalMs)));
+        }
+    }
+
+    // Dispositivos borrados por otras vías (otra instancia, herramientas externas)
+    QList<int> gone;
+    for (auto it = m_devices.cbegin(); it != m_devices.cend(); ++it) {
+        if (!seen.contains(it.key())) gone.append(it.key());
+    }
+    for (int id : std::as_const(gone)) untrack(id);
+}
+
+HealthScheduler::Entry &HealthScheduler::track(int deviceId, const QString &host)
+{
+    auto it = m_devices.find(deviceId);
+    if (it == m_devices.end()) {
+        it = m_devices.insert(deviceId, Entry());
+    } else if (it->host == host) {
+        return *it;
+    } else {
+        // Nueva IP: el historial de la anterior ya no aplica
+        it->failures = 0;
+        it->last = ProbeResult();
+    }
+
+    it->host = host;
+    it->subnet = subnetKey(host);
+    return *it;
+}
+
+void HealthScheduler::untrack(int deviceId)
+{
+    // La fila de 'device_health' la elimina el disparador de borrado de 'devices'
+    m_wheel.cancel(deviceId);
+    m_devices.remove(deviceId);
+    m_dirty.remove(deviceId);
+}
+
+void HealthScheduler::flush()
+{
+    // Los cubos llenos equivalen a no tener cubo: se liberan
+    const qint64 now = m_clock.isValid() ? m_clock.elapsed() : 0;
+    for (auto it = m_buckets.begin(); it != m_buckets.end();) {
+        if (it->tokens + (now - it->updatedMs) * m_subnetRate / 1000.0 >= m_subnetBurst) {
+            it = m_buckets.erase(it);
+        } else {
+            ++it;
+        }
+    }
+
+    if (m_dirty.isEmpty()) return;
+
+    // Copia de los estados: la transacción (y el bloqueo de escritura) va al hilo propio
+    QList<Stored> rows;
+    rows.reserve(m_dirty.size());
+    for (int id : std::as_const(m_dirty)) {
+        auto it = m_devices.constFind(id);
+        if (it == m_devices.cend()) continue;
+
+        Stored row;
+        row.deviceId = id;
+        row.last = it->last;
+        row.failures = it->failures;
+        row.checkedAt = it->checkedAt;
+        rows.append(row);
+    }
+    m_dirty.clear();
+
+    ConnectionPool *pool = m_pool;
+    QMetaObject::invokeMethod(m_context, [this, pool, rows]() {
+        const bool written = writeStates(pool, rows);
+
+        QMetaObject::invokeMethod(this, [this, rows, written]() {
+            if (written) {
+                m_stats.persisted += rows.size();
+                return;
+            }
+            // Se reintentan en el próximo guardado (salvo los dados de baja entretanto)
+            for (const Stored &row : rows) {
+                if (m_devices.contains(row.deviceId)) m_dirty.insert(row.deviceId);
+            }
+        }, Qt::QueuedConnection);
+    }, Qt::QueuedConnection);
+}
+
+bool HealthScheduler::writeStates(ConnectionPool *pool, const QList<Stored> &rows)
+{
+    Tracer::Span span("HealthScheduler::writeStates");
+    span.setRows(rows.size());
+
+    ConnectionPool::WriteLock lock(pool);
+    QSqlDatabase db = pool->writer();
+    if (!db.transaction()) {
+        qWarning() << "No se pudo iniciar la transacción de estados:" << db.lastError().text();
+        return false;
+    }
+
+    QSqlQuery &upsert = pool->writeStatement(
+        "INSERT INTO device_health (device_id, status, port, latency_us, error, failures, checked_at) "
+        "VALUES (?, ?, ?, ?, ?, ?, ?) "
+        "ON CONFLICT(device_id) DO UPDATE SET status = excluded.status, port = excluded.port, "
+        "latency_us = excluded.latency_us, error = excluded.error, failures = excluded.failures, "
+        "checked_at = excluded.checked_at");
+
+    for (const Stored &row : rows) {
+        upsert.bindValue(0, row.deviceId);
+        upsert.bindValue(1, int(row.last.status));
+        upsert.bindValue(2, row.last.port);
+        upsert.bindValue(3, row.last.latencyUs);
+        upsert.bindValue(4, row.last.error);
+        upsert.bindValue(5, row.failures);
+        upsert.bindValue(6, row.checkedAt);
+        if (!upsert.exec()) {
+            qWarning() << "Error guardando el estado del dispositivo" << row.deviceId << ":" << upsert.lastError().text();
+            db.rollback();
+            return false;
+        }
+    }
+
+    if (!db.commit()) {
+        qWarning() << "Error confirmando los estados:" << db.lastError().text();
+        db.rollback();
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,274 @@
+#include "ipaddress.h"
+#include <cstring>
+
+namespace {
+
+// Prefijo de las IPv4 mapeadas en IPv6 (::ffff:0:0/96)
+constexpr quint8 kMappedPrefix[12] = { 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0xff, 0xff };
+
+template <typename Ch>
+inline int hexValue(Ch c)
+{
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+template <typename Ch>
+bool parseV4(const Ch *s, qsizetype n, quint32 *out)
+{
+    quint32 address = 0;
+    unsigned octet = 0;
+    int digits = 0;
+    int dots = 0;
+
+    for (qsizetype i = 0; i < n; ++i) {
+        const Ch c = s[i];
+        if (c >= '0' && c <= '9') {
+            if (++digits > 3) return false;
+            octet = octet * 10 + unsigned(c - '0');
+        } else if (c == '.') {
+            if (digits == 0 || octet > 255 || ++dots > 3) return false;
+            address = (address << 8) | octet;
+            octet = 0;
+            digits = 0;
+        } else {
+            return false;
+        }
+    }
+
+    if (dots != 3 || digits == 0 || octet > 255) return false;
+
+    *out = (address << 8) | octet;
+    return true;
+}
+
+template <typename Ch>
+bool parseV6(const Ch *s, qsizetype n, quint8 out[16])
+{
+    quint16 groups[8];
+    int count = 0;
+    int gap = -1;       // Posición de "::" (grupos anteriores a la compresión)
+    qsizetype i = 0;
+
+    if (n >= 2 && s[0] == ':' && s[1] == ':') {
+        gap = 0;
+        i = 2;
+    } else if (n >= 1 && s[0] == ':') {
+        return false;
+    }
+
+    while (i < n) {
+        const qsizetype start = i;
+        unsigned value = 0;
+        int digits = 0;
+
+        while (i < n) {
+            const int h = hexValue(s[i]);
+            if (h < 0) break;
+            value = (value << 4) | unsigned(h);
+            ++digits;
+            ++i;
+            if (digits > 4) break;
+        }
+
+        // IPv4 incrustada al final (ej. ::ffff:192.168.0.1)
+        if (i < n && s[i] == '.') {
+            quint32 v4;
+            if (count > 6 || !parseV4(s + start, n - start, &v4)) return false;
+            groups[count++] = quint16(v4 >> 16);
+            groups[count++] = quint16(v4 & 0xffff);
+            i = n;
+            break;
+        }
+
+        if (digits == 0 || digits > 4 || count == 8) return false;
+        groups[count++] = quint16(value);
+
+        if (i == n) break;
+        if (s[i] != ':') return false;
+        ++i;
+
+        if (i < n && s[i] == ':') {
+            if (gap >= 0) return false;   // Solo se permite un "::"
+            gap = count;
+            ++i;
+        } else if (i == n) {
+            return false;                 // ':' final suelto
+        }
+    }
+
+    if (gap < 0 && count != 8) return false;
+    if (gap >= 0 && count > 7) return false;
+
+    quint16 full[8] = { 0, 0, 0, 0, 0, 0, 0, 0 };
+    if (gap < 0) {
+        for (int g = 0; g < 8; ++g) full[g] = groups[g];
+    } else {
+        const int tail = count - gap;
+        for (int g = 0; g < gap; ++g) full[g] = groups[g];
+        for (int g = 0; g < tail; ++g) full[8 - tail + g] = groups[gap + g];
+    }
+
+    for (int g = 0; g < 8; ++g) {
+        out[2 * g] = quint8(full[g] >> 8);
+        out[2 * g + 1] = quint8(full[g] & 0xff);
+    }
+    return true;
+}
+
+template <typename Ch>
+IpAddress parseAny(const Ch *s, qsizetype n)
+{
+    if (n <= 0 || n > 45) return IpAddress();
+
+    // Un ':' identifica IPv6; en otro caso se intenta IPv4
+    bool hasColon = false;
+    for (qsizetype i = 0; i < n && !hasColon; ++i) hasColon = (s[i] == ':');
+
+    if (!hasColon) {
+        quint32 v4;
+        return parseV4(s, n, &v4) ? IpAddress::fromIPv4(v4) : IpAddress();
+    }
+
+    quint8 bytes[16];
+    if (!parseV6(s, n, bytes)) return IpAddress();
+
+    // fromRawData no copia: el análisis no reserva memoria dinámica
+    return IpAddress::fromSortKey(QByteArray::fromRawData(reinterpret_cast<const char *>(bytes), 16));
+}
+
+} // namespace
+
+// ---------------------------------------------------------
+// CONSTRUCCIÓN
+// ---------------------------------------------------------
+
+IpAddress::IpAddress()
+    : m_family(Invalid)
+{
+    m_bytes.fill(0);
+}
+
+IpAddress IpAddress::fromIPv4(quint32 address)
+{
+    IpAddress ip;
+    std::memcpy(ip.m_bytes.data(), kMappedPrefix, sizeof(kMappedPrefix));
+    ip.m_bytes[12] = quint8(address >> 24);
+    ip.m_bytes[13] = quint8(address >> 16);
+    ip.m_bytes[14] = quint8(address >> 8);
+    ip.m_bytes[15] = quint8(address);
+    ip.m_family = IPv4;
+    return ip;
+}
+
+IpAddress IpAddress::fromSortKey(const QByteArray &key)
+{
+    IpAddress ip;
+    if (key.size() != 16) return ip;
+
+    std::memcpy(ip.m_bytes.data(), key.constData(), 16);
+    ip.m_family = std::memcmp(ip.m_bytes.data(), kMappedPrefix, sizeof(kMappedPrefix)) == 0
+                      ? IPv4 : IPv6;
+    return ip;
+}
+
+// ---------------------------------------------------------
+// ANÁLISIS DE TEXTO
+// ---------------------------------------------------------
+
+IpAddress IpAddress::parse(QStringView text)
+{
+    return parseAny(text.utf16(), text.size());
+}
+
+IpAddress IpAddress::parse(const char *data, qsizetype size)
+{
+    return parseAny(data, size);
+}
+
+bool IpAddress::parseCidr(QStringView text, IpAddress *first, IpAddress *last)
+{
+    text = text.trimmed();
+    const qsizetype slash = text.indexOf(u'/');
+
+    const IpAddress base = parse(slash < 0 ? text : text.left(slash));
+    if (!base.isValid()) return false;
+
+    int prefix = base.m_family == IPv4 ? 32 : 128;
+    if (slash >= 0) {
+        bool ok = false;
+        const int value = text.mid(slash + 1).toInt(&ok);
+        if (!ok || value < 0 || value > prefix) return false;
+        prefix = value;
+    }
+
+    // Las IPv4 ocupan los últimos 32 bits de la dirección mapeada
+    const int bits = base.m_family == IPv4 ? 96 + prefix : prefix;
+
+    IpAddress lo = base;
+    IpAddress hi = base;
+    for (int byte = 0; byte < 16; ++byte) {
+        const int fixedBits = qBound(0, bits - byte * 8, 8);
+        const quint8 mask = quint8(0xff00 >> fixedBits);
+        lo.m_bytes[byte] &= mask;
+        hi.m_bytes[byte] |= quint8(~mask);
+    }
+
+    if (first) *first = lo;
+    if (last) *last = hi;
+    return true;
+}
+
+// ---------------------------------------------------------
+// CONVERSIONES
+// ---------------------------------------------------------
+
+quint32 IpAddress::toIPv4() const
+{
+    if (m_family != IPv4) return 0;
+    return (quint32(m_bytes[12]) << 24) | (quint32(m_bytes[13]) << 16)
+           | (quint32(m_bytes[14]) << 8) | quint32(m_bytes[15]);
+}
+
+QByteArray IpAddress::toSortKey() const
+{
+    if (!isValid()) return QByteArray();
+    return QByteArray(reinterpret_cast<const char *>(m_bytes.data()), 16);
+}
+
+QString IpAddress::toString() const
+{
+    if (m_family == IPv4) {
+        return QString("%1.%2.%3.%4").arg(int(m_bytes[12])).arg(int(m_bytes[13]))
+                                     .arg(int(m_bytes[14])).arg(int(m_bytes[15]));
+    }
+    if (m_family != IPv6) return QString();
+
+    quint16 groups[8];
+    for (int g = 0; g < 8; ++g) groups[g] = quint16((m_bytes[2 * g] << 8) | m_bytes[2 * g + 1]);
+
+    // RFC 5952: comprimir la racha más larga (mínimo 2) de grupos a cero
+    int bestStart = -1, bestLen = 0;
+    for (int g = 0; g < 8;) {
+        if (groups[g] != 0) { ++g; continue; }
+        int end = g;
+        while (end < 8 && groups[end] == 0) ++end;
+        if (end - g > bestLen) { bestStart = g; bestLen = end - g; }
+        g = end;
+    }
+    if (bestLen < 2) bestStart = -1;
+
+    QString text;
+    for (int g = 0; g < 8; ++g) {
+        if (g == bestStart) {
+            text += "::";
+            g += bestLen - 1;
+            continue;
+        }
+        if (!text.isEmpty() && !text.endsWith(':')) text += ':';
+        text += QString::number(groups[g], 16);
+    }
+    return text;
+}
@@ -0,0 +1,391 @@
+#include "logstore.h"
+#include "slowquerylog.h"
+#include "tracer.h"
+#include <QSqlDatabase>
+#include <QSqlQuery>
+#include <QSqlError>
+#include <QSaveFile>
+#include <QFile>
+#include <QDir>
+#include <QThread>
+#include <QMap>
+#include <QDebug>
+#include <algorithm>
+
+namespace {
+
+const char *const kPartitionPrefix = "logs-";
+const char *const kPartitionSuffix = ".sqlite";
+const char *const kArchiveSuffix = ".sqlite.qz";
+
+QAtomicInt nextStoreId;
+
+/**
+ * @brief Primer día del mes de una clave "AAAA-MM".
+ */
+QDate monthOf(const QString &key)
+{
+    return QDate::fromString(key + "-01", "yyyy-MM-dd");
+}
+
+} // namespace
+
+// ---------------------------------------------------------
+// CONSTRUCTOR Y DESTRUCTOR
+// ---------------------------------------------------------
+
+LogStore::LogStore(const QString &directory)
+    : m_directory(QDir(directory).absolutePath())
+    , m_prefix(QString("logstore%1").arg(nextStoreId.fetchAndAddRelaxed(1)))
+    , m_retentionMonths(3)
+    , m_archiveRetentionMonths(24)
+    , m_retentionOnRollover(true)
+    , m_querySerial(0)
+    , m_statementCounters(std::make_shared<StatementCache::Counters>())
+{
+    QDir().mkpath(m_directory);
+}
+
+LogStore::~LogStore()
+{
+    closeWriter();
+}
+
+// ---------------------------------------------------------
+// CONFIGURACIÓN
+// ---------------------------------------------------------
+
+QString LogStore::directory() const { return m_directory; }
+
+void LogStore::setRetentionMonths(int months) { m_retentionMonths = qMax(1, months); }
+
+void LogStore::setArchiveRetentionMonths(int months) { m_archiveRetentionMonths = qMax(0, months); }
+
+void LogStore::setRetentionOnRollover(bool enabled) { m_retentionOnRollover = enabled; }
+
+QString LogStore::partitionKey(const QDate &date)
+{
+    return date.toString("yyyy-MM");
+}
+
+QString LogStore::partitionPath(const QString &key) const
+{
+    return m_directory + '/' + kPartitionPrefix + key + kPartitionSuffix;
+}
+
+QStringList LogStore::partitions() const { return keysWithSuffix(kPartitionSuffix); }
+
+QStringList LogStore::archives() const { return keysWithSuffix(kArchiveSuffix); }
+
+QStringList LogStore::keysWithSuffix(const QString &suffix) const
+{
+    const QString prefix = kPartitionPrefix;
+    QStringList keys;
+    const QStringList files = QDir(m_directory).entryList({ prefix + "*" + suffix }, QDir::Files);
+    for (const QString &file : files) {
+        // Los archivos repetidos de un mes llevan un número: logs-AAAA-MM.N.sqlite.qz
+        const QString name = file.mid(prefix.size(), file.size() - prefix.size() - suffix.size());
+        const QString key = name.left(7);
+        if (monthOf(key).isValid() && (name.size() == 7 || name.at(7) == '.')) keys << key;
+    }
+    keys.sort();   // "AAAA-MM" ordena cronológicamente
+    keys.removeDuplicates();
+    return keys;
+}
+
+QStringList LogStore::archivePaths(const QString &key) const
+{
+    QStringList paths;
+    const QString base = QString(kPartitionPrefix) + key;
+    const QStringList files = QDir(m_directory).entryList({ base + "*" + kArchiveSuffix }, QDir::Files, QDir::Name);
+    for (const QString &file : files) {
+        const QString rest = file.mid(base.size(), file.size() - base.size() - int(qstrlen(kArchiveSuffix)));
+        if (rest.isEmpty() || rest.at(0) == '.') paths << m_directory + '/' + file;
+    }
+    return paths;
+}
+
+// ---------------------------------------------------------
+// ESCRITURA
+// ---------------------------------------------------------
+
+QString LogStore::writerConnection(const QString &key)
+{
+    auto it = m_writers.constFind(key);
+    if (it != m_writers.constEnd()) return it.value();
+
+    const QString name = QString("%1_w_%2_%3").arg(m_prefix, key)
+                             .arg(reinterpret_cast<quintptr>(QThread::currentThread()));
+    {
+        QSqlDatabase db = QSqlDatabase::addDatabase("QSQLITE", name);
+        db.setDatabaseName(partitionPath(key));
+        db.setConnectOptions("QSQLITE_BUSY_TIMEOUT=5000");
+
+        if (!db.open()) {
+            qCritical() << "Error abriendo partición de logs" << key << ":" << db.lastError().text();
+            db = QSqlDatabase();
+            QSqlDatabase::removeDatabase(name);
+            return QString();
+        }
+
+        // Un único escritor por partición: WAL para no bloquear las consultas
+        QSqlQuery query(db);
+        const QStringList schema = {
+            "PRAGMA journal_mode=WAL",
+            "PRAGMA synchronous=NORMAL",
+            "CREATE TABLE IF NOT EXISTS logs ("
+            "id INTEGER PRIMARY KEY AUTOINCREMENT, "
+            "timestamp DATETIME, "
+            "category TEXT, "
+            "message TEXT)",
+            "CREATE INDEX IF NOT EXISTS idx_logs_timestamp ON logs(timestamp)"
+        };
+        for (const QString &statement : schema) {
+            if (!query.exec(statement)) {
+                qCritical() << "Error preparando partición de logs" << key << ":" << query.lastError().text();
+            }
+        }
+    }
+
+    m_writers.insert(key, name);
+    return name;
+}
+
+bool LogStore::append(const QList<LogEntry> &entries)
+{
+    Tracer::Span span("LogStore::append");
+    span.setRows(entries.size());
+
+    // Agrupar por partición conservando el orden de llegada dentro de cada una
+    QMap<QString, QList<const LogEntry *>> byPartition;
+    for (const LogEntry &entry : entries) {
+        const QDate date = entry.timestamp.isValid() ? entry.timestamp.date() : QDate::currentDate();
+        byPartition[partitionKey(date)].append(&entry);
+    }
+
+    bool ok = true;
+    for (auto it = byPartition.cbegin(); it != byPartition.cend(); ++it) {
+        // Cambio de mes: cerrar particiones antiguas y aplicar la retención
+        if (it.key() > m_currentKey) {
+            const bool rolled = !m_currentKey.isEmpty();
+            m_currentKey = it.key();
+            if (rolled) {
+                closeWriter();
+                if (m_retentionOnRollover) applyRetention();
+            }
+        }
+
+        const QString name = writerConnection(it.key());
+        if (name.isEmpty()) {
+            ok = false;
+            continue;
+        }
+
+        QSqlDatabase db = QSqlDatabase::database(name, false);
+        if (!db.transaction()) {
+            qWarning() << "Error iniciando transacción de logs:" << db.lastError().text();
+            ok = false;
+            continue;
+        }
+
+        // Sentencia preparada una sola vez por conexión de escritura
+        std::shared_ptr<StatementCache> &statements = m_statements[name];
+        if (!statements) {
+            statements = std::make_shared<StatementCache>(name, 4, m_statementCounters);
+        }
+        QSqlQuery &insert = statements->acquire("INSERT INTO logs (timestamp, category, message) VALUES (?, ?, ?)");
+
+        // Filas de la tabla antigua: conservan su id con signo negativo, fuera del rango
+        // de AUTOINCREMENT, y un reintento de la migración las ignora
+        QSqlQuery *legacy = nullptr;
+
+        bool partitionOk = true;
+        for (const LogEntry *entry : it.value()) {
+            QSqlQuery *statement = &insert;
+            int column = 0;
+            if (entry->legacyId > 0) {
+                if (!legacy) {
+                    legacy = &statements->acquire("INSERT OR IGNORE INTO logs (id, timestamp, category, message) "
+                                                  "VALUES (?, ?, ?, ?)");
+                }
+                statement = legacy;
+                statement->bindValue(column++, -entry->legacyId);
+            }
+            statement->bindValue(column++, entry->timestamp);
+            statement->bindValue(column++, entry->category);
+            statement->bindValue(column, entry->message);
+            if (!SlowQueryLog::exec(*statement)) {
+                qWarning() << "Error insertando log:" << statement->lastError().text();
+                partitionOk = false;
+                break;
+            }
+        }
+        insert.finish();
+        if (legacy) legacy->finish();
+
+        if (!partitionOk || !SlowQueryLog::commit(db)) {
+            db.rollback();
+            ok = false;
+        }
+    }
+
+    return ok;
+}
+
+void LogStore::closeWriter()
+{
+    m_statements.clear();
+    for (const QString &name : std::as_const(m_writers)) {
+        {
+            QSqlDatabase db = QSqlDatabase::database(name, false);
+            if (db.isOpen()) db.close();
+        }
+        QSqlDatabase::removeDatabase(name);
+    }
+    m_writers.clear();
+}
+
+// ---------------------------------------------------------
+// CONSULTA
+// ---------------------------------------------------------
+
+QList<LogRecord> LogStore::query(const QDateTime &from, const QDateTime &to,
+                                 const QString &category, int limit) const
+{
+    Tracer::Span span("LogStore::query");
+    span.setDetail(category);
+    QList<LogRecord> records;
+    const QString firstKey = partitionKey(from.date());
+    const QString lastKey = partitionKey(to.date());
+
+    QStringList keys = partitions();
+    std::reverse(keys.begin(), keys.end());
+
+    for (const QString &key : std::as_const(keys)) {
+        if (records.size() >= limit) break;
+        if (key > lastKey || key < firstKey) continue;
+
+        const QString name = QString("%1_q_%2").arg(m_prefix).arg(m_querySerial.fetchAndAddRelaxed(1));
+        {
+            QSqlDatabase db = QSqlDatabase::addDatabase("QSQLITE", name);
+            db.setDatabaseName(partitionPath(key));
+            db.setConnectOptions("QSQLITE_OPEN_READONLY;QSQLITE_BUSY_TIMEOUT=2000");
+
+            if (db.open()) {
+                QSqlQuery query(db);
+                query.setForwardOnly(true);
+                query.prepare(QString("SELECT id, timestamp, category, message FROM logs "
+                                      "WHERE timestamp BETWEEN ? AND ?%1 "
+                                      "ORDER BY timestamp DESC LIMIT ?")
+                                  .arg(category.isEmpty() ? QString() : QStringLiteral(" AND category = ?")));
+                query.addBindValue(from);
+                query.addBindValue(to);
+                if (!category.isEmpty()) query.addBindValue(category);
+                query.addBindValue(limit - records.size());
+
+                if (SlowQueryLog::exec(query)) {
+                    while (query.next()) {
+                        LogRecord record;
+                        record.id = query.value(0).toLongLong();
+                        record.timestamp = query.value(1).toDateTime();
+                        record.category = query.value(2).toString();
+                        record.message = query.value(3).toString();
+                        records.append(record);
+                    }
+                } else {
+                    qWarning() << "Error consultando logs" << key << ":" << query.lastError().text();
+                }
+                query.finish();
+                db.close();
+            } else {
+                qWarning() << "Error abriendo partición de logs" << key << ":" << db.lastError().text();
+            }
+        }
+        QSqlDatabase::removeDatabase(name);
+    }
+
+    span.setRows(records.size());
+    return records;
+}
+
+// ---------------------------------------------------------
+// RETENCIÓN Y ARCHIVO
+// ---------------------------------------------------------
+
+int LogStore::applyRetention(const QDate &today)
+{
+    Tracer::Span span("LogStore::applyRetention");
+    const QDate thisMonth(today.year(), today.month(), 1);
+    const QString oldestLive = partitionKey(thisMonth.addMonths(-(m_retentionMonths - 1)));
+
+    int archived = 0;
+    const QStringList live = partitions();
+    for (const QString &key : live) {
+        if (key < oldestLive && archivePartition(key)) {
+            ++archived;
+        }
+    }
+
+    if (m_archiveRetentionMonths > 0) {
+        const QString oldestArchive = partitionKey(thisMonth.addMonths(-m_archiveRetentionMonths));
+        const QStringList stored = archives();
+        for (const QString &key : stored) {
+            if (key < oldestArchive) {
+                for (const QString &path : archivePaths(key)) QFile::remove(path);
+            }
+        }
+    }
+
+    span.setRows(archived);
+    return archived;
+}
+
+bool LogStore::archivePartition(const QString &key)
+{
+    Tracer::Span span("LogStore::archivePartition");
+    span.setDetail(key);
+    const QString path = partitionPath(key);
+
+    // Volcar el WAL y volver al diario clásico: la partición queda en un único archivo
+    const QString name = QString("%1_a_%2").arg(m_prefix, key);
+    {
+        QSqlDatabase db = QSqlDatabase::addDatabase("QSQLITE", name);
+        db.setDatabaseName(path);
+        if (db.open()) {
+            QSqlQuery query(db);
+            query.exec("PRAGMA wal_checkpoint(TRUNCATE)");
+            query.exec("PRAGMA journal_mode=DELETE");
+            query.finish();
+            db.close();
+        }
+    }
+    QSqlDatabase::removeDatabase(name);
+
+    QFile source(path);
+    if (!source.open(QIODevice::ReadOnly)) {
+        qWarning() << "No se pudo leer la partición a archivar:" << path;
+        return false;
+    }
+
+    // Un mes ya archivado (p. ej. logs con fecha atrasada) recibe otro archivo: nunca
+    // se reescribe uno existente
+    QString archivePath = m_directory + '/' + kPartitionPrefix + key + kArchiveSuffix;
+    for (int copy = 2; QFile::exists(archivePath); ++copy) {
+        archivePath = m_directory + '/' + kPartitionPrefix + key + '.' + QString::number(copy) + kArchiveSuffix;
+    }
+
+    QSaveFile archive(archivePath);
+    if (!archive.open(QIODevice::WriteOnly)
+        || archive.write(qCompress(source.readAll(), 9)) < 0
+        || !archive.commit()) {
+        qWarning() << "No se pudo escribir el archivo de logs" << key << ":" << archive.errorString();
+        return false;
+    }
+    source.close();
+
+    // Eliminar la partición completa en lugar de borrar filas
+    QFile::remove(path);
+    QFile::remove(path + "-wal");
+    QFile::remove(path + "-shm");
+    return true;
+}
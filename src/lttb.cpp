@@ -0,0 +1,62 @@
+#include "lttb.h"
+#include <cmath>
+
+void Lttb::downsample(const QPointF *points, qsizetype count, int threshold, QList<QPointF> *out)
+{
+    out->resize(0);
+    if (count <= 0) return;
+
+    if (threshold < 3 || threshold >= count) {
+        out->reserve(count);
+        for (qsizetype i = 0; i < count; ++i) out->append(points[i]);
+        return;
+    }
+
+    out->reserve(threshold);
+    out->append(points[0]);
+
+    // Cubos entre el primer y el último punto, que se conservan aparte
+    const double every = double(count - 2) / (threshold - 2);
+    qsizetype selected = 0;
+
+    for (int bucket = 0; bucket < threshold - 2; ++bucket) {
+        // Media del cubo siguiente (el último punto hace de cubo final)
+        const qsizetype nextStart = qsizetype(std::floor((bucket + 1) * every)) + 1;
+        const qsizetype nextEnd = qMin(qsizetype(std::floor((bucket + 2) * every)) + 1, count);
+        double avgX = 0.0;
+        double avgY = 0.0;
+        for (qsizetype i = nextStart; i < nextEnd; ++i) {
+            avgX += points[i].x();
+            avgY += points[i].y();
+        }
+        const qsizetype nextCount = nextEnd - nextStart;
+        if (nextCount > 0) {
+            avgX /= nextCount;
+            avgY /= nextCount;
+        } else {
+            avgX = points[count - 1].x();
+            avgY = points[count - 1].y();
+        }
+
+        // Punto del cubo actual con el triángulo más grande
+        const qsizetype start = qsizetype(std::floor(bucket * every)) + 1;
+        const qsizetype end = qsizetype(std::floor((bucket + 1) * every)) + 1;
+        const double ax = points[selected].x();
+        const double ay = points[selected].y();
+
+        double maxArea = -1.0;
+        qsizetype best = start;
+        for (qsizetype i = start; i < end; ++i) {
+            const double area = std::abs((ax - avgX) * (points[i].y() - ay) - (ax - points[i].x()) * (avgY - ay));
+            if (area > maxArea) {
+                maxArea = area;
+                best = i;
+            }
+        }
+
+        out->append(points[best]);
+        selected = best;
+    }
+
+    out->append(points[count - 1]);
+}
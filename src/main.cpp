@@ -1,11 +1,21 @@
 #include "mainwindow.h"
+#include "databasemanager.h"
+#include "storageprofile.h"
+#include "startuptimeline.h"
+#include "tracer.h"
+#include "slowquerylog.h"
 #include <QApplication>
 #include <QTranslator>
 #include <QLibraryInfo>
+#include <QCommandLineParser>
+#include <QSettings>
+#include <QDebug>
 
 int main(int argc, char *argv[])
 {
+    StartupTimeline::start();
     QApplication a(argc, argv);
+    StartupTimeline::mark("QApplication creada");
 
     // ---------------------------------------------------------
     // CONFIGURACIÓN DE IDIOMA (Internacionalización)
@@ -20,11 +30,59 @@ int main(int argc, char *argv[])
         }
     }
 
+    // ---------------------------------------------------------
+    // PERFIL DE ALMACENAMIENTO (línea de comandos > configuración)
+    // ---------------------------------------------------------
+    QCommandLineParser parser;
+    parser.addHelpOption();
+    QCommandLineOption profileOption("storage-profile",
+                                     "Perfil de almacenamiento SQLite: " + StorageProfile::names().join(", ") + ".",
+                                     "perfil");
+    parser.addOption(profileOption);
+    QCommandLineOption traceOption("trace",
+                                   "Guarda una traza de consultas y acciones (formato Chrome trace-event) al salir.",
+                                   "archivo");
+    parser.addOption(traceOption);
+    QCommandLineOption slowQueryOption("slow-query-ms",
+                                       "Umbral del registro de consultas lentas en ms (negativo para desactivarlo).",
+                                       "ms");
+    parser.addOption(slowQueryOption);
+    parser.process(a);
+
+    // Traza desde el arranque: opción --trace o variable de entorno PROYECTO_TRACE
+    const QString traceFile = parser.isSet(traceOption) ? parser.value(traceOption)
+                                                        : qEnvironmentVariable("PROYECTO_TRACE");
+    if (!traceFile.isEmpty()) {
+        Tracer::start(traceFile);
+    }
+
+    QSettings settings(QSettings::IniFormat, QSettings::UserScope, "ProyectoFinal", "AppProyectoFinal");
+    const QString profileName = parser.isSet(profileOption)
+                                    ? parser.value(profileOption)
+                                    : settings.value("storage/profile", "balanced").toString();
+
+    StorageProfile profile;
+    if (StorageProfile::fromName(profileName, &profile)) {
+        DatabaseManager::setDefaultStorageProfile(profile);
+    } else {
+        qWarning() << "Perfil de almacenamiento desconocido:" << profileName << "- se usa 'balanced'.";
+    }
+
+    // Umbral de consultas lentas (línea de comandos > configuración)
+    SlowQueryLog::setThresholdMs(parser.isSet(slowQueryOption)
+                                     ? parser.value(slowQueryOption).toInt()
+                                     : settings.value("diagnostics/slow_query_ms", 100).toInt());
+
     // ---------------------------------------------------------
     // INICIO DE LA APLICACIÓN
     // ---------------------------------------------------------
+    // La ventana se muestra de inmediato: la BD se prepara en segundo plano (ver
+    // MainWindow::onDatabasePrepared()) y la cronología del arranque se escribe en el log
     MainWindow w;
     w.show();
+    StartupTimeline::mark("Ventana mostrada");
 
-    return a.exec();
+    const int result = a.exec();
+    Tracer::stop();   // Sin efecto si la traza no está activa
+    return result;
 }
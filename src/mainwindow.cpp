@@ -4,44 +4,173 @@
 #include "devicemanager.h"
 #include "databasemanager.h"
 #include "registerdialog.h"
+#include "startuptimeline.h"
+#include "tracer.h"
 #include <QMessageBox>
-#include <QSqlTableModel>
 #include <QFile>
 #include <QTextStream>
 #include <QFileDialog>
 #include <QDir>
 #include <QDebug>
+#include <QProgressDialog>
+#include <QDateTime>
+#include <QThread>
+#include <QShortcut>
+#include <QFileInfo>
+#include <algorithm>
 
 MainWindow::MainWindow(QWidget *parent)
     : QMainWindow(parent)
     , ui(new Ui::MainWindow)
     , m_model(nullptr)
+    , m_importer(nullptr)
+    , m_importProgress(nullptr)
+    , m_exporter(nullptr)
+    , m_exportProgress(nullptr)
+    , m_search(nullptr)
+    , m_probe(nullptr)
+    , m_deviceCheck(nullptr)
+    , m_scheduler(nullptr)
+    , m_commands(nullptr)
+    , m_telemetry(nullptr)
+    , m_startup(nullptr)
+    , m_firstFrame(false)
 {
-    ui->setupUi(this);
-
-    // Configuración visual inicial
-    applyStyles();
-
-    // Inicialización de la base de datos y modelo
-    if (m_dbManager.openDatabase()) {
-        setupDevicesTable();
-    } else {
-        ui->lblStatus->setText("Error: No hay conexión a BD");
-        ui->lblStatus->setStyleSheet("color: red;");
+    // Estilos antes de crear los widgets: cada uno se pule una sola vez al mostrarse
+    {
+        StartupTimeline::Scope phase("Hoja de estilos");
+        applyStyles();
     }
+    {
+        StartupTimeline::Scope phase("Interfaz");
+        ui->setupUi(this);
+    }
+    ui->stackedWidget->installEventFilter(this);
+
+    // Ctrl+Mayús+T activa o detiene la traza de consultas y acciones (ver Tracer)
+    QShortcut *traceShortcut = new QShortcut(QKeySequence("Ctrl+Shift+T"), this);
+    connect(traceShortcut, &QShortcut::activated, this, &MainWindow::toggleTracing);
 
-    // Iniciar siempre en la vista de Login
+    // Iniciar siempre en la vista de Login (se habilita cuando la base de datos está lista)
     ui->stackedWidget->setCurrentIndex(0);
+    ui->btnLogin->setEnabled(false);
+    ui->lblStatus->setText("Preparando la base de datos...");
+
+    // Las migraciones y la apertura de los almacenes, lo más lento de un arranque en frío,
+    // se hacen en segundo plano: la ventana aparece sin esperar al disco y el resto sigue
+    // en onDatabasePrepared()
+    m_dbManager.setDeferMaintenance(true);
+    m_startup = QThread::create([this] { m_dbManager.prepareDatabase(); });
+    m_startup->setObjectName("Preparación de la BD");
+    connect(m_startup, &QThread::finished, this, &MainWindow::onDatabasePrepared);
+    m_startup->start();
 }
 
 MainWindow::~MainWindow()
 {
+    // La preparación de la BD y su mantenimiento usan m_dbManager: esperar a que terminen
+    if (m_startup) {
+        m_startup->wait();
+        delete m_startup;
+    }
+
+    // Detener los hilos de trabajo antes de cerrar el pool de conexiones (m_dbManager)
+    delete m_importer;
+    delete m_exporter;
+    delete m_search;
+    delete m_scheduler;   // Guarda los últimos estados antes de cerrar el pool
+    delete m_telemetry;   // Detiene el hilo receptor antes de cerrar el almacén de series
+    ui->trendView->setRollups(nullptr);   // La gráfica se destruye después que m_dbManager
     delete ui;
     if (m_model) {
         delete m_model;
     }
 }
 
+// ---------------------------------------------------------
+// ARRANQUE DIFERIDO
+// ---------------------------------------------------------
+
+void MainWindow::onDatabasePrepared()
+{
+    Tracer::Span span("MainWindow::onDatabasePrepared", "ui");
+
+    m_startup->wait();
+    delete m_startup;
+    m_startup = nullptr;
+
+    if (!m_dbManager.openDatabase()) {
+        ui->lblStatus->setText("Error: No hay conexión a BD");
+        ui->lblStatus->setStyleSheet("color: red;");
+        return;
+    }
+
+    {
+        StartupTimeline::Scope phase("Servicios de la sesión");
+
+        setupDevicesTable();
+
+        m_search = new DeviceSearch(DatabaseManager::pool(), this);
+        connect(m_search, &DeviceSearch::resultsReady, this, &MainWindow::onSearchResults);
+
+        m_probe = new ProbeEngine(this);
+        connect(m_probe, &ProbeEngine::resultReady, m_model, &DeviceTableModel::setProbeResult);
+        connect(m_probe, &ProbeEngine::finished, this, &MainWindow::onProbeFinished);
+
+        m_deviceCheck = new ProbeEngine(this);
+        connect(m_deviceCheck, &ProbeEngine::resultReady, m_model, &DeviceTableModel::setProbeResult);
+
+        m_scheduler = new HealthScheduler(DatabaseManager::pool(), this);
+        connect(m_scheduler, &HealthScheduler::resultReady, m_model, &DeviceTableModel::setProbeResult);
+        connect(&m_deviceManager, &DeviceManager::deviceListChanged,
+                m_scheduler, &HealthScheduler::applyChanges);
+
+        m_commands = new CommandPipeline(this);
+        connect(m_commands, &CommandPipeline::commandFinished, this, &MainWindow::onCommandFinished);
+
+        m_telemetry = new TelemetryReceiver(m_dbManager.timeSeries(), this);
+        connect(&m_deviceManager, &DeviceManager::deviceListChanged,
+                m_telemetry, &TelemetryReceiver::applyChanges);
+
+        ui->trendView->setRollups(m_dbManager.rollups());
+    }
+
+    ui->btnLogin->setEnabled(true);
+    ui->lblStatus->clear();
+    StartupTimeline::mark("Sesión disponible");
+
+    // Relleno y retención de los agregados en segundo plano; se conectan al terminar
+    m_startup = QThread::create([this] { m_dbManager.prepareMaintenance(); });
+    m_startup->setObjectName("Mantenimiento de la BD");
+    connect(m_startup, &QThread::finished, this, &MainWindow::onMaintenancePrepared);
+    m_startup->start();
+}
+
+void MainWindow::onMaintenancePrepared()
+{
+    Tracer::Span span("MainWindow::onMaintenancePrepared", "ui");
+
+    m_startup->wait();
+    delete m_startup;
+    m_startup = nullptr;
+
+    m_dbManager.runMaintenance();
+    StartupTimeline::mark("Arranque completo");
+    qInfo().noquote() << StartupTimeline::report();
+    m_dbManager.insertLog("Arranque", StartupTimeline::summary());
+}
+
+bool MainWindow::eventFilter(QObject *watched, QEvent *event)
+{
+    // Primer pintado del contenido de la ventana
+    if (!m_firstFrame && watched == ui->stackedWidget && event->type() == QEvent::Paint) {
+        m_firstFrame = true;
+        StartupTimeline::mark("Primer fotograma");
+        ui->stackedWidget->removeEventFilter(this);
+    }
+    return QMainWindow::eventFilter(watched, event);
+}
+
 // ---------------------------------------------------------
 // CONFIGURACIÓN DE LA TABLA
 // ---------------------------------------------------------
@@ -49,38 +178,71 @@ MainWindow::~MainWindow()
 void MainWindow::setupDevicesTable()
 {
     if (m_model == nullptr) {
-        m_model = new QSqlTableModel(this, m_dbManager.getDatabase());
-    }
+        m_model = new DeviceTableModel(m_dbManager.getDatabase(), this);
 
-    // Configuración del modelo
-    m_model->setTable("devices");
-    m_model->select();
-
-    // Mapeo dinámico de columnas por nombre (independiente del orden en BD)
-    int idxName = m_model->fieldIndex("name");
-    int idxType = m_model->fieldIndex("type");
-    int idxIp   = m_model->fieldIndex("ip_address");
-    int idxCal  = m_model->fieldIndex("calibration");
+        // Actualizaciones fila a fila en lugar de recargar la tabla tras cada operación
+        connect(&m_deviceManager, &DeviceManager::deviceListChanged,
+                m_model, &DeviceTableModel::applyChanges);
+    }
 
-    // Asignación de encabezados
-    if(idxName != -1) m_model->setHeaderData(idxName, Qt::Horizontal, "Nombre");
-    if(idxType != -1) m_model->setHeaderData(idxType, Qt::Horizontal, "Tipo");
-    if(idxIp != -1)   m_model->setHeaderData(idxIp,   Qt::Horizontal, "Dirección IP");
-    if(idxCal != -1)  m_model->setHeaderData(idxCal,  Qt::Horizontal, "Calibración");
+    // El modelo cuenta sus filas al iniciar sesión (las páginas se cargan al pintar):
+    // el arranque no recorre la tabla 'devices'
 
     // Asignación a la vista
     ui->tableDevices->setModel(m_model);
 
     // Ocultar columnas internas (IDs)
-    ui->tableDevices->setColumnHidden(m_model->fieldIndex("id"), true);
-    ui->tableDevices->setColumnHidden(m_model->fieldIndex("user_id"), true);
+    ui->tableDevices->setColumnHidden(DeviceTableModel::ColId, true);
+    ui->tableDevices->setColumnHidden(DeviceTableModel::ColUserId, true);
 
     // Configuración visual de la tabla
     ui->tableDevices->setEditTriggers(QAbstractItemView::NoEditTriggers);
     ui->tableDevices->setAlternatingRowColors(true);
 
+    // Ordenar desde la cabecera: el modelo reordena por keyset sobre columnas indexadas
+    ui->tableDevices->setSortingEnabled(true);
+    ui->tableDevices->sortByColumn(DeviceTableModel::ColId, Qt::AscendingOrder);
+
     QHeaderView *header = ui->tableDevices->horizontalHeader();
     header->setSectionResizeMode(QHeaderView::Stretch);
+
+    // La gráfica de tendencia muestra los dispositivos seleccionados
+    connect(ui->tableDevices->selectionModel(), &QItemSelectionModel::selectionChanged,
+            this, &MainWindow::onDeviceSelectionChanged, Qt::UniqueConnection);
+}
+
+void MainWindow::onDeviceSelectionChanged()
+{
+    Tracer::Span span("MainWindow::onDeviceSelectionChanged", "ui");
+
+    QModelIndexList rows = ui->tableDevices->selectionModel()->selectedRows();
+    std::sort(rows.begin(), rows.end());
+
+    QList<int> ids;
+    QStringList names;
+    for (const QModelIndex &index : std::as_const(rows)) {
+        ids.append(m_model->deviceIdAt(index.row()));
+        names.append(m_model->data(m_model->index(index.row(), DeviceTableModel::ColName)).toString());
+    }
+    ui->trendView->setDevices(ids, names);
+}
+
+void MainWindow::toggleTracing()
+{
+    if (Tracer::isEnabled()) {
+        if (Tracer::stop()) {
+            ui->statusbar->showMessage("Traza guardada en " + Tracer::fileName(), 10000);
+        } else {
+            ui->statusbar->showMessage("No se pudo guardar la traza en " + Tracer::fileName(), 10000);
+        }
+        return;
+    }
+
+    // Junto a la base de datos, con la fecha en el nombre para no sobrescribir otras
+    const QString fileName = QFileInfo(m_dbManager.getDatabasePath()).absolutePath() + "/traza-"
+                             + QDateTime::currentDateTime().toString("yyyyMMdd-HHmmss") + ".json";
+    Tracer::start(fileName);
+    ui->statusbar->showMessage("Traza activada (Ctrl+Mayús+T para guardarla)");
 }
 
 // ---------------------------------------------------------
@@ -89,6 +251,10 @@ void MainWindow::setupDevicesTable()
 
 void MainWindow::on_btnLogin_clicked()
 {
+    Tracer::Span span("MainWindow::on_btnLogin_clicked", "ui");
+
+    if (!ui->btnLogin->isEnabled()) return;   // Base de datos aún sin preparar
+
     QString user = ui->inputUser->text();
     QString pass = ui->inputPassword->text();
 
@@ -102,6 +268,16 @@ void MainWindow::on_btnLogin_clicked()
             m_model->select();
         }
 
+        // Comprobaciones periódicas; al arrancar publica el último estado guardado
+        if (m_scheduler) m_scheduler->start();
+
+        // Telemetría de los dispositivos hacia el almacén de series
+        // El índice de direcciones se lee en segundo plano y se publica al llegar
+        if (m_telemetry) {
+            m_telemetry->loadDevices(DatabaseManager::pool());
+            m_telemetry->start();
+        }
+
         // Cambio de vista y actualización de UI
         ui->stackedWidget->setCurrentIndex(1);
         ui->lblWelcome->setText("Bienvenido, " + m_user.getUsername() +
@@ -131,6 +307,8 @@ void MainWindow::on_btnLogin_clicked()
 
 void MainWindow::on_btnLogout_clicked()
 {
+    Tracer::Span span("MainWindow::on_btnLogout_clicked", "ui");
+
     m_user.logout();
 
     // Retorno al login y limpieza
@@ -141,9 +319,21 @@ void MainWindow::on_btnLogout_clicked()
     ui->lblStatus->setStyleSheet("color: green;");
     ui->btnCreateUser->setVisible(false);
 
+    // Descartar búsquedas pendientes de la sesión anterior
+    if (m_search) m_search->cancel();
+    ui->txtSearch->clear();
+
+    if (m_probe) m_probe->cancel();
+    if (m_deviceCheck) m_deviceCheck->cancel();
+    if (m_scheduler) m_scheduler->stop();
+    if (m_telemetry) m_telemetry->stop();
+    if (m_model) m_model->clearProbeResults();
+    ui->trendView->clear();
+
     // Ocultar datos sensibles del modelo
     if(m_model) {
         m_model->setFilter("1=0");
+        m_model->select();
     }
 }
 
@@ -156,24 +346,32 @@ void MainWindow::on_btnAddDevice_clicked()
     DeviceDialog dialog(this);
 
     if (dialog.exec() == QDialog::Accepted) {
-        Device *newDevice = dialog.getDeviceInfo();
-
-        // Asignar dispositivo al usuario actual
-        int currentUserId = m_user.getId();
-        if (currentUserId <= 0) currentUserId = 1;
-
-        newDevice->setUserId(currentUserId);
+        // El tramo mide el guardado, no el tiempo con el diálogo o los mensajes abiertos
+        bool saved = false;
+        {
+            Tracer::Span span("MainWindow::on_btnAddDevice_clicked", "ui");
+            Device *newDevice = dialog.getDeviceInfo();
+
+            // Asignar dispositivo al usuario actual
+            int currentUserId = m_user.getId();
+            if (currentUserId <= 0) currentUserId = 1;
+
+            newDevice->setUserId(currentUserId);
+
+            // La tabla se actualiza con el cambio emitido por deviceListChanged
+            saved = m_deviceManager.addDevice(newDevice);
+            if (saved) {
+                checkDeviceConnection(newDevice);
+            } else {
+                delete newDevice;
+            }
+        }
 
-        DeviceManager devManager;
-        if (devManager.addDevice(newDevice)) {
+        if (saved) {
             QMessageBox::information(this, "Éxito", "Dispositivo guardado.");
-            if (m_model) {
-                m_model->select();
-            }
         } else {
             QMessageBox::critical(this, "Error", "No se pudo guardar en la BD.");
         }
-        delete newDevice;
     }
 }
 
@@ -193,12 +391,15 @@ void MainWindow::on_btnDeleteDevice_clicked()
 
     if (reply == QMessageBox::No) return;
 
-    int row = selectedRows.at(0).row();
-    int deviceId = m_model->data(m_model->index(row, 0)).toInt();
+    bool removed = false;
+    {
+        Tracer::Span span("MainWindow::on_btnDeleteDevice_clicked", "ui");
+        int row = selectedRows.at(0).row();
+        int deviceId = m_model->deviceIdAt(row);
+        removed = m_deviceManager.removeDevice(deviceId);
+    }
 
-    DeviceManager devManager;
-    if (devManager.removeDevice(deviceId)) {
-        m_model->select();
+    if (removed) {
         QMessageBox::information(this, "Éxito", "Dispositivo eliminado.");
     } else {
         QMessageBox::critical(this, "Error", "No se pudo eliminar de la BD.");
@@ -215,24 +416,13 @@ void MainWindow::on_btnEditDevice_clicked()
 
     int row = selectedRows.at(0).row();
 
-    // Recuperación de datos del modelo usando índices seguros
-    int idxId = m_model->fieldIndex("id");
-    int idxUser = m_model->fieldIndex("user_id");
-    int idxName = m_model->fieldIndex("name");
-    int idxType = m_model->fieldIndex("type");
-    int idxIp = m_model->fieldIndex("ip_address");
-    int idxCal = m_model->fieldIndex("calibration");
-
-    int id = m_model->data(m_model->index(row, idxId)).toInt();
-    int userId = m_model->data(m_model->index(row, idxUser)).toInt();
-    QString name = m_model->data(m_model->index(row, idxName)).toString();
-    QString type = m_model->data(m_model->index(row, idxType)).toString();
-    QString ip = m_model->data(m_model->index(row, idxIp)).toString();
-
-    double calib = 0.0;
-    if(idxCal != -1) {
-        calib = m_model->data(m_model->index(row, idxCal)).toDouble();
-    }
+    // Recuperación de datos de la fila desde la página en caché del modelo
+    int id = m_model->data(m_model->index(row, DeviceTableModel::ColId)).toInt();
+    int userId = m_model->data(m_model->index(row, DeviceTableModel::ColUserId)).toInt();
+    QString name = m_model->data(m_model->index(row, DeviceTableModel::ColName)).toString();
+    QString type = m_model->data(m_model->index(row, DeviceTableModel::ColType)).toString();
+    QString ip = m_model->data(m_model->index(row, DeviceTableModel::ColIp)).toString();
+    double calib = m_model->data(m_model->index(row, DeviceTableModel::ColCalibration)).toDouble();
 
     // Configuración del objeto temporal
     Device tempDev;
@@ -247,48 +437,150 @@ void MainWindow::on_btnEditDevice_clicked()
     dialog.setDeviceData(&tempDev);
 
     if (dialog.exec() == QDialog::Accepted) {
-        Device *modifiedDev = dialog.getDeviceInfo();
-
-        // Preservar integridad referencial
-        modifiedDev->setId(id);
-        modifiedDev->setUserId(userId);
+        // El tramo mide el guardado, no el tiempo con el diálogo o los mensajes abiertos
+        bool updated = false;
+        {
+            Tracer::Span span("MainWindow::on_btnEditDevice_clicked", "ui");
+            Device *modifiedDev = dialog.getDeviceInfo();
+
+            // Preservar integridad referencial
+            modifiedDev->setId(id);
+            modifiedDev->setUserId(userId);
+
+            updated = m_deviceManager.updateDevice(modifiedDev);
+            if (updated) {
+                // La nueva calibración se envía al equipo; las escrituras seguidas se fusionan en cola.
+                // El resultado lo recibe onCommandFinished(): modifiedDev no sobrevive a este bloque
+                if (m_commands && !qFuzzyCompare(modifiedDev->getCalibration() + 1.0, calib + 1.0)) {
+                    modifiedDev->setCommandSender([this](int deviceId, const QString &host, const QString &command) {
+                        return m_commands->submit(deviceId, host, command);
+                    });
+                    modifiedDev->sendData("calibration=" + QString::number(modifiedDev->getCalibration(), 'g', 17));
+                }
+                // Dirección nueva: se comprueba si el equipo responde en ella
+                if (modifiedDev->getIp() != ip) {
+                    checkDeviceConnection(modifiedDev);
+                    modifiedDev = nullptr;
+                }
+            }
+            delete modifiedDev;
+        }
 
-        DeviceManager devManager;
-        if (devManager.updateDevice(modifiedDev)) {
-            m_model->select();
+        if (updated) {
             QMessageBox::information(this, "Éxito", "Dispositivo actualizado.");
         } else {
             QMessageBox::critical(this, "Error", "No se pudo actualizar.");
         }
-        delete modifiedDev;
     }
 }
 
+void MainWindow::checkDeviceConnection(Device *device)
+{
+    if (!m_deviceCheck) {
+        delete device;
+        return;
+    }
+
+    // El dispositivo vive hasta que llega su propio resultado; una cancelación (cierre de
+    // sesión) termina la ronda sin él y también lo libera
+    device->setParent(this);
+    device->setProbeRequester([this](int deviceId, const QString &host) {
+        m_deviceCheck->probe({ ProbeTarget{ deviceId, host, 0 } });
+        return true;
+    });
+    const int id = device->getId();
+    connect(m_deviceCheck, &ProbeEngine::resultReady, device, [device, id](const ProbeResult &result) {
+        if (result.deviceId != id) return;
+        device->applyProbeResult(result);
+        device->deleteLater();
+    });
+    connect(m_deviceCheck, &ProbeEngine::finished, device, [device](const ProbeStats &stats) {
+        if (stats.cancelled) device->deleteLater();
+    });
+
+    const QString name = device->getName();
+    connect(device, &Device::deviceConnected, this, [this, name] {
+        ui->statusbar->showMessage(name + ": en línea");
+    });
+    connect(device, &Device::errorOccurred, this, [this, name](const QString &msg) {
+        ui->statusbar->showMessage(name + ": " + msg);
+        m_dbManager.insertLog("Conectividad", name + ": " + msg);
+    });
+
+    if (!device->connectToDevice()) device->deleteLater();
+}
+
 // ---------------------------------------------------------
 // FUNCIONALIDADES ADICIONALES (BUSCAR, EXPORTAR, ADMIN)
 // ---------------------------------------------------------
 
 void MainWindow::on_txtSearch_textChanged(const QString &arg1)
 {
+    Tracer::Span span("MainWindow::on_txtSearch_textChanged", "ui");
+
     if (!m_model) return;
 
-    if (arg1.isEmpty()) {
+    if (arg1.trimmed().isEmpty()) {
+        if (m_search) m_search->cancel();
         m_model->setFilter("");
+        m_model->select();
+        ui->statusbar->clearMessage();
+        return;
+    }
+
+    // Subred en notación CIDR (ej. 10.20.0.0/16): rango sobre la columna indexada ip_key
+    if (arg1.contains('/')) {
+        const QString filter = DeviceManager::subnetFilter(arg1);
+        if (!filter.isEmpty()) {
+            if (m_search) m_search->cancel();
+            m_model->setFilter(filter);
+            m_model->select();
+            ui->statusbar->showMessage("Filtrando por subred " + arg1.trimmed());
+            return;
+        }
+    }
+
+    // La consulta se lanza en segundo plano tras el debounce (ver onSearchResults)
+    if (m_search) m_search->search(arg1);
+}
+
+void MainWindow::onSearchResults(const QString &text, const QList<int> &ids, bool truncated)
+{
+    Tracer::Span span("MainWindow::onSearchResults", "ui");
+
+    // Resultado de un texto que ya no está en la barra de búsqueda
+    if (!m_model || text != ui->txtSearch->text()) return;
+
+    if (ids.isEmpty()) {
+        m_model->setFilter("1=0");
     } else {
-        // Filtro SQL para búsqueda parcial en nombre o IP
-        QString filter = QString("name LIKE '%%1%' OR ip_address LIKE '%%1%'").arg(arg1);
-        m_model->setFilter(filter);
+        // Solo enteros devueltos por la consulta parametrizada: no hay texto del usuario en el SQL
+        QStringList idList;
+        idList.reserve(ids.size());
+        for (int id : ids) idList << QString::number(id);
+        m_model->setFilter("id IN (" + idList.join(',') + ")");
     }
     m_model->select();
+
+    if (truncated) {
+        ui->statusbar->showMessage(QString("Mostrando los primeros %1 resultados").arg(ids.size()));
+    } else {
+        ui->statusbar->showMessage(QString("%1 resultados").arg(ids.size()));
+    }
 }
 
 void MainWindow::on_btnExport_clicked()
 {
-    if (!m_model || m_model->rowCount() == 0) {
+    if (!m_model) {
         QMessageBox::warning(this, "Exportar", "No hay datos para exportar.");
         return;
     }
 
+    if (m_exporter && m_exporter->isRunning()) {
+        QMessageBox::warning(this, "Exportar", "Ya hay una exportación en curso.");
+        return;
+    }
+
     QString fileName = QFileDialog::getSaveFileName(this,
                                                     "Guardar reporte",
                                                     QDir::homePath() + "/dispositivos.csv",
@@ -296,37 +588,217 @@ void MainWindow::on_btnExport_clicked()
 
     if (fileName.isEmpty()) return;
 
-    QFile file(fileName);
-    if (!file.open(QIODevice::WriteOnly | QIODevice::Text)) {
-        QMessageBox::critical(this, "Error", "No se pudo crear el archivo.");
+    // El tramo empieza con el archivo ya elegido: mide la puesta en marcha, no el diálogo
+    Tracer::Span span("MainWindow::on_btnExport_clicked", "ui");
+
+    if (!m_exporter) {
+        m_exporter = new DeviceExporter(DatabaseManager::pool());
+        connect(m_exporter, &DeviceExporter::progress, this, &MainWindow::onExportProgress);
+        connect(m_exporter, &DeviceExporter::finished, this, &MainWindow::onExportFinished);
+    }
+
+    // Exportar las mismas filas que muestra la tabla (filtro de búsqueda activo)
+    m_exporter->setFilter(m_model->filter());
+
+    m_exportProgress = new QProgressDialog("Exportando dispositivos...", "Cancelar", 0, 1000, this);
+    m_exportProgress->setWindowModality(Qt::WindowModal);
+    m_exportProgress->setMinimumDuration(500);
+    m_exportProgress->setAutoClose(false);
+    m_exportProgress->setAutoReset(false);
+    connect(m_exportProgress, &QProgressDialog::canceled, m_exporter, &DeviceExporter::cancel);
+
+    m_exporter->start(fileName);
+}
+
+void MainWindow::onExportProgress(qint64 rowsExported, qint64 rowsTotal)
+{
+    Tracer::Span span("MainWindow::onExportProgress", "ui");
+
+    if (!m_exportProgress) return;
+
+    if (rowsTotal > 0) {
+        m_exportProgress->setValue(static_cast<int>(qMin<qint64>(rowsExported * 1000 / rowsTotal, 1000)));
+    }
+    m_exportProgress->setLabelText(QString("Exportando dispositivos... %1 de %2 filas")
+                                       .arg(rowsExported).arg(rowsTotal));
+}
+
+void MainWindow::onExportFinished(const ExportStats &stats)
+{
+    {
+        Tracer::Span span("MainWindow::onExportFinished", "ui");
+
+        if (m_exportProgress) {
+            m_exportProgress->deleteLater();
+            m_exportProgress = nullptr;
+        }
+    }
+
+    if (!stats.error.isEmpty()) {
+        QMessageBox::critical(this, "Error", stats.error);
+    } else if (stats.cancelled) {
+        QMessageBox::warning(this, "Exportar", "Exportación cancelada.");
+    } else if (stats.rowsExported == 0) {
+        QMessageBox::warning(this, "Exportar", "No hay datos para exportar.");
+    } else {
+        QMessageBox::information(this, "Éxito", QString("%1 dispositivos exportados correctamente a:\n%2")
+                                                    .arg(stats.rowsExported).arg(stats.fileName));
+    }
+}
+
+void MainWindow::on_btnImport_clicked()
+{
+    if (m_importer && m_importer->isRunning()) {
+        QMessageBox::warning(this, "Importar", "Ya hay una importación en curso.");
         return;
     }
 
-    QTextStream out(&file);
+    QString fileName = QFileDialog::getOpenFileName(this,
+                                                    "Importar dispositivos",
+                                                    QDir::homePath(),
+                                                    "Archivos CSV (*.csv);;Todos los archivos (*)");
+
+    if (fileName.isEmpty()) return;
+
+    // El tramo empieza con el archivo ya elegido: mide la puesta en marcha, no el diálogo
+    Tracer::Span span("MainWindow::on_btnImport_clicked", "ui");
+
+    if (!m_importer) {
+        m_importer = new DeviceImporter(DatabaseManager::pool());
+        connect(m_importer, &DeviceImporter::progress, this, &MainWindow::onImportProgress);
+        connect(m_importer, &DeviceImporter::finished, this, &MainWindow::onImportFinished);
+    }
+
+    // Asignar las filas sin propietario al usuario actual
+    int currentUserId = m_user.getId();
+    if (currentUserId <= 0) currentUserId = 1;
+    m_importer->setDefaultUserId(currentUserId);
 
-    // Escribir encabezados
-    QStringList headers;
-    headers << "ID" << "Usuario_ID" << "Nombre" << "Tipo" << "IP" << "Calibracion";
-    out << headers.join(";") << "\n";
+    m_importProgress = new QProgressDialog("Importando dispositivos...", "Cancelar", 0, 1000, this);
+    m_importProgress->setWindowModality(Qt::WindowModal);
+    m_importProgress->setMinimumDuration(0);
+    m_importProgress->setAutoClose(false);
+    m_importProgress->setAutoReset(false);
+    connect(m_importProgress, &QProgressDialog::canceled, m_importer, &DeviceImporter::cancel);
+    m_importProgress->show();
 
-    // Escribir filas
-    for (int row = 0; row < m_model->rowCount(); ++row) {
-        QStringList rowData;
-        for (int col = 0; col < m_model->columnCount(); ++col) {
-            QString data = m_model->data(m_model->index(row, col)).toString();
-            // Sanitización básica para formato CSV
-            data.replace(";", ",");
-            rowData << data;
+    m_importer->start(fileName);
+}
+
+void MainWindow::onImportProgress(qint64 bytesProcessed, qint64 bytesTotal, qint64 rowsImported)
+{
+    Tracer::Span span("MainWindow::onImportProgress", "ui");
+
+    if (!m_importProgress) return;
+
+    if (bytesTotal > 0) {
+        m_importProgress->setValue(static_cast<int>(bytesProcessed * 1000 / bytesTotal));
+    }
+    m_importProgress->setLabelText(QString("Importando dispositivos... %1 filas").arg(rowsImported));
+}
+
+void MainWindow::onImportFinished(const ImportStats &stats)
+{
+    QString summary = QString("%1 filas importadas, %2 rechazadas en %3 ms (%4 filas/s)")
+                          .arg(stats.rowsImported)
+                          .arg(stats.rowsRejected)
+                          .arg(stats.elapsedMs)
+                          .arg(stats.rowsPerSecond(), 0, 'f', 0);
+
+    // El tramo termina antes del mensaje modal
+    {
+        Tracer::Span span("MainWindow::onImportFinished", "ui");
+
+        if (m_importProgress) {
+            m_importProgress->deleteLater();
+            m_importProgress = nullptr;
+        }
+
+        // Registro de auditoría con el rendimiento para poder seguirlo en el tiempo
+        m_dbManager.insertLog("Importación", summary);
+
+        if (m_model) {
+            m_model->select();
         }
-        out << rowData.join(";") << "\n";
+
+        // La importación no emite cambios fila a fila: el planificador relee la flota
+        if (m_scheduler && m_scheduler->isRunning()) m_scheduler->reload();
+        if (m_telemetry && m_telemetry->isRunning()) m_telemetry->loadDevices(DatabaseManager::pool());
+    }
+
+    if (!stats.error.isEmpty()) {
+        QMessageBox::critical(this, "Error", stats.error + "\n" + summary);
+    } else if (stats.cancelled) {
+        QMessageBox::warning(this, "Importar", "Importación cancelada.\n" + summary);
+    } else {
+        QMessageBox::information(this, "Éxito", "Importación completada.\n" + summary);
+    }
+}
+
+void MainWindow::on_btnProbe_clicked()
+{
+    if (!m_model || !m_probe) return;
+
+    // Un segundo clic detiene la ronda en curso
+    if (m_probe->isRunning()) {
+        Tracer::Span span("MainWindow::on_btnProbe_clicked", "ui");
+        m_probe->cancel();
+        return;
+    }
+
+    QList<ProbeTarget> targets;
+    {
+        Tracer::Span span("MainWindow::on_btnProbe_clicked", "ui");
+        targets = m_deviceManager.getProbeTargets(m_model->filter());
+        if (!targets.isEmpty()) {
+            m_model->clearProbeResults();
+            ui->btnProbe->setText("Detener comprobación");
+            ui->statusbar->showMessage(QString("Comprobando %1 dispositivos...").arg(targets.size()));
+            m_probe->probe(targets);
+        }
+    }
+
+    if (targets.isEmpty()) {
+        QMessageBox::warning(this, "Comprobar", "No hay dispositivos para comprobar.");
     }
+}
+
+void MainWindow::onProbeFinished(const ProbeStats &stats)
+{
+    Tracer::Span span("MainWindow::onProbeFinished", "ui");
+
+    ui->btnProbe->setText("Comprobar conexión");
+
+    QString summary = QString("%1 dispositivos: %2 en línea, %3 puerto cerrado, %4 sin respuesta, "
+                              "%5 inaccesibles en %6 ms (%7 comprobaciones/s)")
+                          .arg(stats.total)
+                          .arg(stats.reachable)
+                          .arg(stats.refused)
+                          .arg(stats.timedOut)
+                          .arg(stats.unreachable)
+                          .arg(stats.elapsedMs)
+                          .arg(stats.probesPerSecond(), 0, 'f', 0);
+    if (stats.cancelled) summary.prepend("Cancelada. ");
+
+    m_dbManager.insertLog("Conectividad", summary);
+    ui->statusbar->showMessage(summary);
+}
+
+void MainWindow::onCommandFinished(const CommandResult &result)
+{
+    Tracer::Span span("MainWindow::onCommandFinished", "ui");
+
+    // Un "OK calibration=2.5" confirma una escritura: no es una lectura del dispositivo
+    if (result.status != CommandResult::Rejected && result.status != CommandResult::Failed) return;
 
-    file.close();
-    QMessageBox::information(this, "Éxito", "Datos exportados correctamente a:\n" + fileName);
+    const QString message = QString("Dispositivo %1: comando no aplicado (%2)").arg(result.deviceId).arg(result.reply);
+    m_dbManager.insertLog("Comandos", message);
+    ui->statusbar->showMessage(message);
 }
 
 void MainWindow::on_btnCreateUser_clicked()
 {
+    // Sin tramo propio: exec() es modal y el alta ya la mide RegisterDialog
     RegisterDialog dialog(this);
     dialog.exec();
 }
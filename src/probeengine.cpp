@@ -0,0 +1,216 @@
+#include "probeengine.h"
+#include <QTcpSocket>
+#include <QHostAddress>
+#include <QDebug>
+
+// ---------------------------------------------------------
+// CONSTRUCTOR Y DESTRUCTOR
+// ---------------------------------------------------------
+
+ProbeEngine::ProbeEngine(QObject *parent)
+    : QObject(parent)
+    , m_maxConcurrent(256)
+    , m_timeoutMs(1500)
+    , m_defaultPort(80)
+    , m_running(false)
+    , m_launchScheduled(false)
+{
+    qRegisterMetaType<ProbeResult>();
+    qRegisterMetaType<ProbeStats>();
+
+    m_sweep.setInterval(qBound(10, m_timeoutMs / 10, 100));
+    connect(&m_sweep, &QTimer::timeout, this, &ProbeEngine::sweepTimeouts);
+}
+
+ProbeEngine::~ProbeEngine()
+{
+    m_queue.clear();
+    for (auto it = m_inFlight.begin(); it != m_inFlight.end(); ++it) {
+        it.key()->disconnect(this);
+        it.key()->abort();
+    }
+    m_inFlight.clear();
+}
+
+// ---------------------------------------------------------
+// CONFIGURACIÓN
+// ---------------------------------------------------------
+
+void ProbeEngine::setMaxConcurrent(int sockets) { m_maxConcurrent = qMax(1, sockets); }
+
+void ProbeEngine::setTimeout(int ms)
+{
+    m_timeoutMs = qMax(10, ms);
+    // Resolución de los plazos: una décima parte del plazo, entre 10 y 100 ms
+    m_sweep.setInterval(qBound(10, m_timeoutMs / 10, 100));
+}
+
+void ProbeEngine::setDefaultPort(quint16 port) { m_defaultPort = port; }
+
+bool ProbeEngine::isRunning() const { return m_running; }
+
+int ProbeEngine::pending() const { return m_queue.size() + m_inFlight.size(); }
+
+// ---------------------------------------------------------
+// CONTROL DE LA RONDA
+// ---------------------------------------------------------
+
+void ProbeEngine::probe(const QList<ProbeTarget> &targets)
+{
+    if (!m_running) {
+        m_stats = ProbeStats();
+        m_clock.start();
+        m_running = true;
+        m_sweep.start();
+    }
+
+    m_queue.append(targets);
+    launchPending();
+    finishIfIdle();
+}
+
+void ProbeEngine::cancel()
+{
+    m_queue.clear();
+    for (auto it = m_inFlight.begin(); it != m_inFlight.end(); ++it) {
+        QTcpSocket *socket = it.key();
+        socket->disconnect(this);
+        socket->abort();
+        socket->deleteLater();
+    }
+    m_inFlight.clear();
+
+    if (!m_running) return;
+
+    m_running = false;
+    m_sweep.stop();
+    m_stats.cancelled = true;
+    m_stats.elapsedMs = m_clock.elapsed();
+    emit finished(m_stats);
+}
+
+// ---------------------------------------------------------
+// SOCKETS
+// ---------------------------------------------------------
+
+void ProbeEngine::launchPending()
+{
+    while (m_inFlight.size() < m_maxConcurrent && !m_queue.isEmpty()) {
+        ProbeTarget target = m_queue.dequeue();
+        if (target.port == 0) target.port = m_defaultPort;
+
+        const QString host = target.host.trimmed();
+        if (host.isEmpty()) {
+            ProbeResult result;
+            result.deviceId = target.deviceId;
+            result.port = target.port;
+            result.status = ProbeResult::Unreachable;
+            result.error = "IP inválida";
+            ++m_stats.total;
+            ++m_stats.unreachable;
+            emit resultReady(result);
+            continue;
+        }
+
+        QTcpSocket *socket = new QTcpSocket(this);
+        // Búfer de lectura mínimo: la comprobación nunca lee datos del dispositivo
+        socket->setReadBufferSize(1);
+
+        connect(socket, &QTcpSocket::connected, this, [this, socket]() {
+            complete(socket, ProbeResult::Reachable);
+        });
+        connect(socket, &QTcpSocket::errorOccurred, this, [this, socket](QAbstractSocket::SocketError error) {
+            switch (error) {
+            case QAbstractSocket::ConnectionRefusedError:
+                complete(socket, ProbeResult::Refused, socket->errorString());
+                break;
+            case QAbstractSocket::SocketTimeoutError:
+                complete(socket, ProbeResult::Timeout, socket->errorString());
+                break;
+            default:
+                complete(socket, ProbeResult::Unreachable, socket->errorString());
+                break;
+            }
+        });
+
+        // Registrar antes de conectar: un error inmediato ya encuentra su entrada
+        m_inFlight.insert(socket, InFlight{ target, m_clock.nsecsElapsed() });
+
+        // Las IP literales evitan la resolución de nombres
+        const QHostAddress address(host);
+        if (address.isNull()) {
+            socket->connectToHost(host, target.port);
+        } else {
+            socket->connectToHost(address, target.port);
+        }
+    }
+}
+
+void ProbeEngine::complete(QTcpSocket *socket, ProbeResult::Status status, const QString &error)
+{
+    auto it = m_inFlight.find(socket);
+    if (it == m_inFlight.end()) return;   // Ya resuelto (ej. error tras el plazo)
+
+    ProbeResult result;
+    result.deviceId = it->target.deviceId;
+    result.host = it->target.host;
+    result.port = it->target.port;
+    result.status = status;
+    result.error = error;
+    if (status == ProbeResult::Reachable || status == ProbeResult::Refused) {
+        result.latencyUs = (m_clock.nsecsElapsed() - it->startedNs) / 1000;
+    }
+    m_inFlight.erase(it);
+
+    socket->disconnect(this);
+    socket->abort();
+    socket->deleteLater();
+
+    ++m_stats.total;
+    switch (status) {
+    case ProbeResult::Reachable:   ++m_stats.reachable; break;
+    case ProbeResult::Refused:     ++m_stats.refused; break;
+    case ProbeResult::Timeout:     ++m_stats.timedOut; break;
+    default:                       ++m_stats.unreachable; break;
+    }
+
+    emit resultReady(result);
+    scheduleLaunch();
+}
+
+void ProbeEngine::scheduleLaunch()
+{
+    if (m_launchScheduled) return;
+    m_launchScheduled = true;
+
+    QMetaObject::invokeMethod(this, [this]() {
+        m_launchScheduled = false;
+        launchPending();
+        finishIfIdle();
+    }, Qt::QueuedConnection);
+}
+
+void ProbeEngine::sweepTimeouts()
+{
+    const qint64 now = m_clock.nsecsElapsed();
+    const qint64 limit = qint64(m_timeoutMs) * 1000000;
+
+    QList<QTcpSocket *> expired;
+    for (auto it = m_inFlight.cbegin(); it != m_inFlight.cend(); ++it) {
+        if (now - it->startedNs >= limit) expired.append(it.key());
+    }
+
+    for (QTcpSocket *socket : std::as_const(expired)) {
+        complete(socket, ProbeResult::Timeout, "Sin respuesta");
+    }
+}
+
+void ProbeEngine::finishIfIdle()
+{
+    if (!m_running || !m_queue.isEmpty() || !m_inFlight.isEmpty()) return;
+
+    m_running = false;
+    m_sweep.stop();
+    m_stats.elapsedMs = m_clock.elapsed();
+    emit finished(m_stats);
+}
@@ -4,6 +4,7 @@
 #include <QSqlQuery>
 #include <QSqlError>
 #include "databasemanager.h"
+#include "tracer.h"
 
 // ---------------------------------------------------------
 // CONSTRUCTOR Y DESTRUCTOR
@@ -37,17 +38,37 @@ void RegisterDialog::on_btnSave_clicked()
         return;
     }
 
-    QSqlQuery query;
-    query.prepare("INSERT INTO users (username, password, role) VALUES (:u, :p, :r)");
-    query.bindValue(":u", user);
-    query.bindValue(":p", pass);
-    query.bindValue(":r", role);
+    ConnectionPool *pool = DatabaseManager::pool();
+    if (!pool) {
+        QMessageBox::critical(this, "Error", "No hay conexión a la base de datos.");
+        return;
+    }
+
+    // El bloqueo de escritura (y el tramo de la traza) terminan antes de los mensajes
+    bool created = false;
+    QString error;
+    {
+        Tracer::Span span("RegisterDialog::insertUser");
+        ConnectionPool::WriteLock lock(pool);
+        // Marcadores con nombre de credencial: SlowQueryLog no registra la forma de :pass
+        QSqlQuery &query = pool->writeStatement("INSERT INTO users (username, password, role) VALUES (:user, :pass, :role)");
+        query.bindValue(":user", user);
+        query.bindValue(":pass", pass);
+        query.bindValue(":role", role);
+
+        created = query.exec();
+        if (created) {
+            span.setRows(query.numRowsAffected());
+        } else {
+            error = query.lastError().text();
+        }
+    }
 
-    if (query.exec()) {
+    if (created) {
         QMessageBox::information(this, "Éxito", "Usuario creado correctamente.");
         accept();
     } else {
-        QMessageBox::critical(this, "Error", "No se pudo crear el usuario.\n" + query.lastError().text());
+        QMessageBox::critical(this, "Error", "No se pudo crear el usuario.\n" + error);
     }
 }
 
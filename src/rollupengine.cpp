@@ -0,0 +1,465 @@
+#include "rollupengine.h"
+#include "connectionpool.h"
+#include "tracer.h"
+#include <QSqlQuery>
+#include <QSqlError>
+#include <QMap>
+#include <QElapsedTimer>
+#include <QDebug>
+#include <climits>
+
+namespace {
+
+const qint64 DayMs = 24LL * 3600 * 1000;
+
+// Inicio del intervalo que contiene una marca (también para marcas negativas)
+qint64 bucketOf(qint64 timestampMs, qint64 step)
+{
+    const qint64 rest = timestampMs % step;
+    return timestampMs - (rest < 0 ? rest + step : rest);
+}
+
+} // namespace
+
+// ---------------------------------------------------------
+// CONSTRUCTOR Y DESTRUCTOR
+// ---------------------------------------------------------
+
+RollupEngine::RollupEngine(ConnectionPool *pool, TimeSeriesStore *store, QObject *parent)
+    : QObject(parent)
+    , m_pool(pool)
+    , m_store(store)
+    , m_retentionDays{ 30, 90, 730, 0 }
+    , m_backfilled(false)
+    , m_readings(0)
+    , m_rejected(0)
+    , m_written(0)
+    , m_lastFlushUs(0)
+{
+    m_flush.setInterval(5000);
+    connect(&m_flush, &QTimer::timeout, this, &RollupEngine::flush);
+}
+
+RollupEngine::~RollupEngine()
+{
+    stop();
+}
+
+// ---------------------------------------------------------
+// CONFIGURACIÓN
+// ---------------------------------------------------------
+
+qint64 RollupEngine::stepMs(Resolution resolution)
+{
+    switch (resolution) {
+    case Minute: return 60LL * 1000;
+    case Hour: return 3600LL * 1000;
+    case Day: return DayMs;
+    default: return 0;
+    }
+}
+
+void RollupEngine::setFlushInterval(int ms) { m_flush.setInterval(qMax(100, ms)); }
+
+void RollupEngine::setRetentionDays(Resolution resolution, int days) { m_retentionDays[resolution] = qMax(0, days); }
+
+int RollupEngine::retentionDays(Resolution resolution) const { return m_retentionDays[resolution]; }
+
+void RollupEngine::start()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_resume.clear();
+        m_backfilled = false;
+    }
+    m_flush.start();
+}
+
+void RollupEngine::stop()
+{
+    m_flush.stop();
+    flush();
+}
+
+// ---------------------------------------------------------
+// AGREGACIÓN
+// ---------------------------------------------------------
+
+void RollupEngine::add(int deviceId, qint64 timestampMs, double value)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    addLocked(deviceId, m_open[deviceId], timestampMs, value);
+}
+
+void RollupEngine::add(int deviceId, const QList<SeriesPoint> &points)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    Open &open = m_open[deviceId];
+    for (const SeriesPoint &point : points) addLocked(deviceId, open, point.timestampMs, point.value);
+}
+
+void RollupEngine::add(const SeriesBatch &batch)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    int currentId = 0;
+    Open *open = nullptr;
+    for (qsizetype i = 0; i < batch.size(); ++i) {
+        const int deviceId = batch.deviceIds.at(i);
+        if (!open || deviceId != currentId) {
+            open = &m_open[deviceId];
+            currentId = deviceId;
+        }
+        addLocked(deviceId, *open, batch.timestampsMs.at(i), batch.values.at(i));
+    }
+}
+
+void RollupEngine::addLocked(int deviceId, Open &open, qint64 timestampMs, double value)
+{
+    if (open.hasData && timestampMs < open.lastMs) {
+        ++m_rejected;
+        return;
+    }
+    open.lastMs = timestampMs;
+    open.hasData = true;
+    ++m_readings;
+
+    for (int level = 0; level < Levels; ++level) {
+        RollupPoint &current = open.levels[level];
+        const qint64 bucket = bucketOf(timestampMs, stepMs(Resolution(level + 1)));
+
+        // La lectura abre un intervalo nuevo: el anterior queda pendiente de guardar
+        if (current.bucketMs != bucket) {
+            if (current.count > 0) m_pending.append(Row{ deviceId, level + 1, current });
+            current = RollupPoint();
+            current.bucketMs = bucket;
+        }
+        current.add(value);
+    }
+}
+
+qint64 RollupEngine::backfill()
+{
+    if (!m_store) return 0;
+
+    Tracer::Span span("RollupEngine::backfill");
+    QSqlQuery &last = m_pool->readStatement(
+        "SELECT MAX(bucket_ms) FROM device_rollups WHERE device_id = ? AND resolution = ?");
+
+    qint64 total = 0;
+    const QList<int> devices = m_store->devices();
+    for (int deviceId : devices) {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (m_open.value(deviceId).hasData) continue;   // Ya se está agregando en vivo
+        }
+
+        last.bindValue(0, deviceId);
+        last.bindValue(1, int(Minute));
+        if (!last.exec()) {
+            qWarning() << "Error leyendo los agregados del dispositivo" << deviceId << ":" << last.lastError().text();
+            continue;
+        }
+        // El último minuto guardado ya contó sus lecturas: se sigue desde el siguiente
+        const qint64 fromMs = last.next() && !last.value(0).isNull()
+                                  ? last.value(0).toLongLong() + stepMs(Minute)
+                                  : LLONG_MIN;
+        last.finish();
+
+        // Se anota la última lectura agregada (y cuántas comparten su marca) para que
+        // TimeSeriesStore::setRollups() siga desde ahí sin repetir ni perder ninguna
+        Resume resume;
+        resume.fromMs = fromMs;
+        QList<SeriesPoint> points;
+        points.reserve(4096);
+        m_store->scan(deviceId, fromMs, LLONG_MAX, [&](const SeriesPoint &point) {
+            if (point.timestampMs == resume.fromMs) {
+                ++resume.skip;
+            } else {
+                resume.fromMs = point.timestampMs;
+                resume.skip = 1;
+            }
+            points.append(point);
+            if (points.size() == 4096) {
+                add(deviceId, points);
+                total += points.size();
+                points.resize(0);
+            }
+            return true;
+        });
+        add(deviceId, points);
+        total += points.size();
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_resume.insert(deviceId, resume);
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_backfilled = true;
+    }
+
+    span.setRows(total);
+    if (total > 0) {
+        qInfo() << "Agregados reconstruidos a partir de" << total << "lecturas";
+        flush();
+    }
+    return total;
+}
+
+bool RollupEngine::resumePoint(int deviceId, qint64 *fromMs, qint64 *skip) const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (!m_backfilled) return false;
+
+    auto it = m_resume.constFind(deviceId);
+    if (it != m_resume.cend()) {
+        *fromMs = it->fromMs;
+        *skip = it->skip;
+        return true;
+    }
+
+    // Sin lecturas cuando backfill() pidió la lista de dispositivos: todas son posteriores
+    if (m_open.value(deviceId).hasData) return false;
+    *fromMs = LLONG_MIN;
+    *skip = 0;
+    return true;
+}
+
+// ---------------------------------------------------------
+// VOLCADO
+// ---------------------------------------------------------
+
+bool RollupEngine::flush()
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    // Entre tomar las filas y confirmarlas no están ni en memoria ni en la tabla:
+    // query() espera a que termine el volcado
+    std::lock_guard<std::mutex> serial(m_flushMutex);
+
+    // Se toman los pendientes y una copia de los abiertos; estos siguen acumulando desde cero
+    QList<Row> rows;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        rows.swap(m_pending);
+        for (auto it = m_open.begin(); it != m_open.end(); ++it) {
+            for (int level = 0; level < Levels; ++level) {
+                RollupPoint &current = it->levels[level];
+                if (current.count == 0) continue;
+                rows.append(Row{ it.key(), level + 1, current });
+                const qint64 bucket = current.bucketMs;
+                current = RollupPoint();
+                current.bucketMs = bucket;
+            }
+        }
+    }
+    if (rows.isEmpty()) return true;
+
+    Tracer::Span span("RollupEngine::flush");
+    span.setRows(rows.size());
+    bool ok = false;
+    {
+        ConnectionPool::WriteLock lock(m_pool);
+        QSqlDatabase db = m_pool->writer();
+        if (!db.transaction()) {
+            qWarning() << "No se pudo iniciar la transacción de agregados:" << db.lastError().text();
+        } else {
+            QSqlQuery &upsert = m_pool->writeStatement(
+                "INSERT INTO device_rollups (device_id, resolution, bucket_ms, min_value, max_value, sum_value, samples) "
+                "VALUES (?, ?, ?, ?, ?, ?, ?) "
+                "ON CONFLICT(device_id, resolution, bucket_ms) DO UPDATE SET "
+                "min_value = MIN(min_value, excluded.min_value), "
+                "max_value = MAX(max_value, excluded.max_value), "
+                "sum_value = sum_value + excluded.sum_value, "
+                "samples = samples + excluded.samples");
+
+            ok = true;
+            for (const Row &row : std::as_const(rows)) {
+                upsert.bindValue(0, row.deviceId);
+                upsert.bindValue(1, row.resolution);
+                upsert.bindValue(2, row.point.bucketMs);
+                upsert.bindValue(3, row.point.min);
+                upsert.bindValue(4, row.point.max);
+                upsert.bindValue(5, row.point.sum);
+                upsert.bindValue(6, row.point.count);
+                if (!upsert.exec()) {
+                    qWarning() << "Error guardando agregados:" << upsert.lastError().text();
+                    ok = false;
+                    break;
+                }
+            }
+
+            if (ok && !db.commit()) {
+                qWarning() << "Error confirmando los agregados:" << db.lastError().text();
+                ok = false;
+            }
+            if (!ok) db.rollback();
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (!ok) {
+        // Se reintentan en el próximo volcado (las filas se fusionan, no se duplican)
+        rows.append(m_pending);
+        m_pending.swap(rows);
+        return false;
+    }
+    m_written += rows.size();
+    m_lastFlushUs = timer.nsecsElapsed() / 1000;
+    return true;
+}
+
+// ---------------------------------------------------------
+// CONSULTAS
+// ---------------------------------------------------------
+
+RollupEngine::Resolution RollupEngine::chooseResolution(int deviceId, qint64 fromMs, qint64 toMs, int maxPoints) const
+{
+    const qint64 nowMs = QDateTime::currentMSecsSinceEpoch();
+    const qint64 spanMs = qMax<qint64>(0, toMs - fromMs);
+
+    for (int level = Raw; level <= Day; ++level) {
+        const Resolution resolution = Resolution(level);
+
+        // Solo sirve si conserva todo el rango pedido
+        const int days = m_retentionDays[level];
+        if (days > 0 && fromMs < nowMs - days * DayMs) continue;
+
+        qint64 expected = 0;
+        if (resolution == Raw) {
+            // Las lecturas no tienen paso fijo: se cuentan con los agregados por hora
+            for (const RollupPoint &point : query(deviceId, Hour, fromMs, toMs)) expected += point.count;
+        } else {
+            expected = spanMs / stepMs(resolution) + 1;
+        }
+        if (expected <= maxPoints) return resolution;
+    }
+    return Day;
+}
+
+QList<RollupPoint> RollupEngine::query(int deviceId, qint64 fromMs, qint64 toMs, int maxPoints, Resolution *used) const
+{
+    const Resolution resolution = chooseResolution(deviceId, fromMs, toMs, maxPoints);
+    if (used) *used = resolution;
+    return query(deviceId, resolution, fromMs, toMs);
+}
+
+QList<RollupPoint> RollupEngine::query(int deviceId, Resolution resolution, qint64 fromMs, qint64 toMs) const
+{
+    Tracer::Span span("RollupEngine::query");
+    QList<RollupPoint> points;
+
+    if (resolution == Raw) {
+        if (!m_store) return points;
+        m_store->scan(deviceId, fromMs, toMs, [&points](const SeriesPoint &reading) {
+            RollupPoint point;
+            point.bucketMs = reading.timestampMs;
+            point.add(reading.value);
+            points.append(point);
+            return true;
+        });
+        span.setRows(points.size());
+        return points;
+    }
+
+    const qint64 firstBucket = bucketOf(fromMs, stepMs(resolution));
+    QMap<qint64, RollupPoint> buckets;
+
+    // La tabla y la memoria se leen sin un volcado de por medio (ver flush())
+    std::lock_guard<std::mutex> serial(m_flushMutex);
+
+    QSqlQuery &select = m_pool->readStatement(
+        "SELECT bucket_ms, min_value, max_value, sum_value, samples FROM device_rollups "
+        "WHERE device_id = ? AND resolution = ? AND bucket_ms BETWEEN ? AND ? ORDER BY bucket_ms");
+    select.bindValue(0, deviceId);
+    select.bindValue(1, int(resolution));
+    select.bindValue(2, firstBucket);
+    select.bindValue(3, toMs);
+    if (select.exec()) {
+        while (select.next()) {
+            RollupPoint point;
+            point.bucketMs = select.value(0).toLongLong();
+            point.min = select.value(1).toDouble();
+            point.max = select.value(2).toDouble();
+            point.sum = select.value(3).toDouble();
+            point.count = select.value(4).toLongLong();
+            buckets.insert(point.bucketMs, point);
+        }
+    } else {
+        qWarning() << "Error consultando agregados:" << select.lastError().text();
+    }
+    select.finish();
+
+    // Se suman los intervalos que aún no se han guardado
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto include = [&](const RollupPoint &point) {
+            if (point.count == 0 || point.bucketMs < firstBucket || point.bucketMs > toMs) return;
+            RollupPoint &target = buckets[point.bucketMs];
+            target.bucketMs = point.bucketMs;
+            target.merge(point);
+        };
+        for (const Row &row : m_pending) {
+            if (row.deviceId == deviceId && row.resolution == resolution) include(row.point);
+        }
+        auto open = m_open.constFind(deviceId);
+        if (open != m_open.cend()) include(open->levels[resolution - 1]);
+    }
+
+    points.reserve(buckets.size());
+    for (const RollupPoint &point : std::as_const(buckets)) points.append(point);
+    span.setRows(points.size());
+    return points;
+}
+
+// ---------------------------------------------------------
+// RETENCIÓN
+// ---------------------------------------------------------
+
+int RollupEngine::applyRetention(const QDateTime &now)
+{
+    Tracer::Span span("RollupEngine::applyRetention");
+
+    // Lo que se borre tiene que estar ya resumido en la resolución siguiente
+    flush();
+
+    const qint64 nowMs = now.toMSecsSinceEpoch();
+    if (m_store && m_retentionDays[Raw] > 0) {
+        const int segments = m_store->removeBefore(nowMs - m_retentionDays[Raw] * DayMs);
+        if (segments > 0) qInfo() << "Segmentos de lecturas caducados:" << segments;
+    }
+
+    int removed = 0;
+    ConnectionPool::WriteLock lock(m_pool);
+    QSqlQuery &remove = m_pool->writeStatement("DELETE FROM device_rollups WHERE resolution = ? AND bucket_ms < ?");
+    for (int level = Minute; level <= Day; ++level) {
+        const int days = m_retentionDays[level];
+        if (days == 0) continue;
+
+        remove.bindValue(0, level);
+        remove.bindValue(1, nowMs - days * DayMs);
+        if (!remove.exec()) {
+            qWarning() << "Error aplicando la retención de agregados:" << remove.lastError().text();
+            continue;
+        }
+        removed += remove.numRowsAffected();
+    }
+    span.setRows(removed);
+    return removed;
+}
+
+RollupStats RollupEngine::stats() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    RollupStats stats;
+    stats.devices = m_open.size();
+    stats.pendingBuckets = m_pending.size();
+    stats.readings = m_readings;
+    stats.rejected = m_rejected;
+    stats.written = m_written;
+    stats.lastFlushUs = m_lastFlushUs;
+    return stats;
+}
@@ -0,0 +1,98 @@
+#include "schemamigrator.h"
+#include <QSqlQuery>
+#include <QSqlError>
+#include <QElapsedTimer>
+#include <QDebug>
+#include <algorithm>
+
+// ---------------------------------------------------------
+// REGISTRO DE MIGRACIONES
+// ---------------------------------------------------------
+
+void SchemaMigrator::addMigration(int version, const QString &description, const Apply &apply)
+{
+    m_migrations.append({ version, description, apply });
+    std::stable_sort(m_migrations.begin(), m_migrations.end(),
+                     [](const Migration &a, const Migration &b) { return a.version < b.version; });
+}
+
+int SchemaMigrator::targetVersion() const
+{
+    return m_migrations.isEmpty() ? 0 : m_migrations.last().version;
+}
+
+int SchemaMigrator::currentVersion(QSqlDatabase &db)
+{
+    QSqlQuery query(db);
+    if (!query.exec("PRAGMA user_version") || !query.next()) {
+        qCritical() << "Error leyendo la versión del esquema:" << query.lastError().text();
+        return -1;
+    }
+    return query.value(0).toInt();
+}
+
+QList<MigrationStep> SchemaMigrator::report() const
+{
+    return m_report;
+}
+
+// ---------------------------------------------------------
+// EJECUCIÓN
+// ---------------------------------------------------------
+
+bool SchemaMigrator::migrate(QSqlDatabase &db)
+{
+    m_report.clear();
+
+    const int from = currentVersion(db);
+    if (from < 0) return false;
+
+    if (from > targetVersion()) {
+        qWarning() << "El esquema (versión" << from << ") es más reciente que esta aplicación ("
+                   << targetVersion() << ")";
+        return true;
+    }
+
+    for (const Migration &migration : std::as_const(m_migrations)) {
+        if (migration.version <= from) continue;
+
+        MigrationStep step;
+        step.version = migration.version;
+        step.description = migration.description;
+
+        QElapsedTimer timer;
+        timer.start();
+
+        if (!db.transaction()) {
+            qCritical() << "Error iniciando la migración" << migration.version << ":" << db.lastError().text();
+            m_report.append(step);
+            return false;
+        }
+
+        // La versión se guarda en la cabecera del archivo dentro de la misma transacción
+        QSqlQuery version(db);
+        step.ok = migration.apply(db)
+                  && version.exec(QString("PRAGMA user_version = %1").arg(migration.version));
+        version.finish();
+
+        if (step.ok && !db.commit()) {
+            qCritical() << "Error confirmando la migración" << migration.version << ":" << db.lastError().text();
+            step.ok = false;
+        }
+        if (!step.ok) {
+            db.rollback();
+        }
+
+        step.elapsedUs = timer.nsecsElapsed() / 1000;
+        m_report.append(step);
+
+        qInfo().noquote() << QString("Migración %1 (%2): %3 en %4 ms")
+                                 .arg(step.version)
+                                 .arg(step.description, step.ok ? "aplicada" : "FALLIDA")
+                                 .arg(step.elapsedUs / 1000.0, 0, 'f', 1);
+
+        if (!step.ok) return false;
+    }
+
+    return true;
+}
@@ -0,0 +1,236 @@
+#include "seriescodec.h"
+#include <QtEndian>
+#include <cstring>
+
+namespace {
+
+quint64 doubleBits(double value)
+{
+    quint64 bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+
+double bitsDouble(quint64 bits)
+{
+    double value;
+    std::memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+int leadingZeros(quint64 x) { return qCountLeadingZeroBits(x); }
+int trailingZeros(quint64 x) { return qCountTrailingZeroBits(x); }
+
+quint64 lowMask(int bits) { return bits >= 64 ? ~quint64(0) : (quint64(1) << bits) - 1; }
+
+} // namespace
+
+// ---------------------------------------------------------
+// CODIFICADOR
+// ---------------------------------------------------------
+
+SeriesEncoder::SeriesEncoder()
+{
+    clear();
+}
+
+void SeriesEncoder::clear()
+{
+    m_bytes.clear();
+    m_acc = 0;
+    m_used = 0;
+    m_count = 0;
+    m_firstTimestamp = 0;
+    m_prevTimestamp = 0;
+    m_prevDelta = 0;
+    m_prevValue = 0;
+    m_prevLeading = -1;
+    m_prevTrailing = 0;
+}
+
+void SeriesEncoder::append(qint64 timestampMs, double value)
+{
+    const quint64 bits = doubleBits(value);
+
+    if (m_count == 0) {
+        writeBits(quint64(timestampMs), 64);
+        writeBits(bits, 64);
+        m_firstTimestamp = timestampMs;
+        m_prevTimestamp = timestampMs;
+        m_prevValue = bits;
+        ++m_count;
+        return;
+    }
+
+    // Marca de tiempo: delta de delta con prefijos de longitud variable
+    const qint64 delta = timestampMs - m_prevTimestamp;
+    const qint64 dod = delta - m_prevDelta;
+    if (dod == 0) {
+        writeBits(0, 1);
+    } else if (dod >= -63 && dod <= 64) {
+        writeBits(0b10, 2);
+        writeBits(quint64(dod + 63), 7);
+    } else if (dod >= -255 && dod <= 256) {
+        writeBits(0b110, 3);
+        writeBits(quint64(dod + 255), 9);
+    } else if (dod >= -2047 && dod <= 2048) {
+        writeBits(0b1110, 4);
+        writeBits(quint64(dod + 2047), 12);
+    } else {
+        writeBits(0b1111, 4);
+        writeBits(quint64(dod), 64);
+    }
+    m_prevDelta = delta;
+    m_prevTimestamp = timestampMs;
+
+    // Valor: XOR con el anterior; solo se guardan los bits significativos
+    const quint64 x = bits ^ m_prevValue;
+    m_prevValue = bits;
+    ++m_count;
+
+    if (x == 0) {
+        writeBits(0, 1);
+        return;
+    }
+
+    const int leading = qMin(leadingZeros(x), 31);   // Se guarda en 5 bits
+    const int trailing = trailingZeros(x);
+
+    if (m_prevLeading >= 0 && leading >= m_prevLeading && trailing >= m_prevTrailing) {
+        // Cabe en la ventana anterior: no hace falta repetir su tamaño
+        const int meaningful = 64 - m_prevLeading - m_prevTrailing;
+        writeBits(0b10, 2);
+        writeBits(x >> m_prevTrailing, meaningful);
+        return;
+    }
+
+    const int meaningful = 64 - leading - trailing;
+    writeBits(0b11, 2);
+    writeBits(quint64(leading), 5);
+    writeBits(quint64(meaningful & 63), 6);   // 64 se guarda como 0
+    writeBits(x >> trailing, meaningful);
+    m_prevLeading = leading;
+    m_prevTrailing = trailing;
+}
+
+void SeriesEncoder::writeBits(quint64 value, int bits)
+{
+    while (bits > 0) {
+        const int take = qMin(64 - m_used, bits);
+        const quint64 chunk = (value >> (bits - take)) & lowMask(take);
+        m_acc = take == 64 ? chunk : (m_acc << take) | chunk;
+        m_used += take;
+        bits -= take;
+
+        if (m_used == 64) {
+            uchar word[8];
+            qToBigEndian(m_acc, word);
+            m_bytes.append(reinterpret_cast<const char *>(word), 8);
+            m_acc = 0;
+            m_used = 0;
+        }
+    }
+}
+
+QByteArray SeriesEncoder::bytes() const
+{
+    QByteArray out = m_bytes;
+    if (m_used > 0) {
+        uchar word[8];
+        qToBigEndian(m_acc << (64 - m_used), word);
+        out.append(reinterpret_cast<const char *>(word), (m_used + 7) / 8);
+    }
+    return out;
+}
+
+// ---------------------------------------------------------
+// DECODIFICADOR
+// ---------------------------------------------------------
+
+SeriesDecoder::SeriesDecoder(const uchar *data, qint64 size, quint32 count)
+    : m_data(data)
+    , m_size(size)
+    , m_pos(0)
+    , m_acc(0)
+    , m_avail(0)
+    , m_remaining(count)
+    , m_read(0)
+    , m_truncated(false)
+    , m_prevTimestamp(0)
+    , m_prevDelta(0)
+    , m_prevValue(0)
+    , m_leading(0)
+    , m_trailing(0)
+{
+}
+
+bool SeriesDecoder::next(qint64 *timestampMs, double *value)
+{
+    if (m_remaining == 0 || m_truncated) return false;
+
+    if (m_read == 0) {
+        m_prevTimestamp = qint64(readBits(64));
+        m_prevValue = readBits(64);
+    } else {
+        qint64 dod = 0;
+        if (readBit()) {
+            if (!readBit()) {
+                dod = qint64(readBits(7)) - 63;
+            } else if (!readBit()) {
+                dod = qint64(readBits(9)) - 255;
+            } else if (!readBit()) {
+                dod = qint64(readBits(12)) - 2047;
+            } else {
+                dod = qint64(readBits(64));
+            }
+        }
+        m_prevDelta += dod;
+        m_prevTimestamp += m_prevDelta;
+
+        if (readBit()) {
+            if (readBit()) {
+                m_leading = int(readBits(5));
+                int meaningful = int(readBits(6));
+                if (meaningful == 0) meaningful = 64;
+                m_trailing = 64 - m_leading - meaningful;
+            }
+            const int meaningful = 64 - m_leading - m_trailing;
+            m_prevValue ^= readBits(meaningful) << m_trailing;
+        }
+    }
+
+    if (m_truncated) return false;
+
+    *timestampMs = m_prevTimestamp;
+    *value = bitsDouble(m_prevValue);
+    --m_remaining;
+    ++m_read;
+    return true;
+}
+
+quint64 SeriesDecoder::readBits(int bits)
+{
+    quint64 result = 0;
+
+    while (bits > 0) {
+        if (m_avail == 0) {
+            // Carga hasta 8 bytes de una vez (alineados a la izquierda)
+            while (m_avail <= 56 && m_pos < m_size) {
+                m_acc |= quint64(m_data[m_pos++]) << (56 - m_avail);
+                m_avail += 8;
+            }
+            if (m_avail == 0) {
+                m_truncated = true;
+                return 0;
+            }
+        }
+
+        const int take = qMin(bits, m_avail);
+        result = take == 64 ? m_acc : (result << take) | (m_acc >> (64 - take));
+        m_acc = take == 64 ? 0 : m_acc << take;
+        m_avail -= take;
+        bits -= take;
+    }
+
+    return result;
+}
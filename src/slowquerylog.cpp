@@ -0,0 +1,550 @@
+#include "slowquerylog.h"
+#include <QElapsedTimer>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QHash>
+#include <QFile>
+#include <QSaveFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QRegularExpression>
+#include <QSqlError>
+#include <QSqlDriver>
+#include <QSqlResult>
+#include <QDebug>
+#include <algorithm>
+#include <atomic>
+
+namespace {
+
+std::atomic<qint64> g_thresholdUs{100 * 1000};
+
+/**
+ * @brief Sentencias de la sesión, por SQL normalizado.
+ */
+struct SlowQueryState
+{
+    QMutex mutex;
+    QHash<QString, SlowQueryEntry> entries;
+};
+
+SlowQueryState &state()
+{
+    static SlowQueryState instance;
+    return instance;
+}
+
+bool isIdentifierChar(QChar c)
+{
+    return c.isLetterOrNumber() || c == '_' || c == '$';
+}
+
+/**
+ * @brief El marcador nombra una credencial: su forma no se registra.
+ */
+bool isCredential(const QString &name)
+{
+    static const QRegularExpression credential("pass|pwd|secret|token|credential",
+                                               QRegularExpression::CaseInsensitiveOption);
+    return !name.isEmpty() && credential.match(name).hasMatch();
+}
+
+bool hasCredential(const QStringList &names)
+{
+    return std::any_of(names.cbegin(), names.cend(), isCredential);
+}
+
+/**
+ * @brief Solo las sentencias DML tienen plan (PRAGMA, DDL y COMMIT no).
+ */
+bool hasPlan(const QString &sql)
+{
+    static const QRegularExpression dml("^\\s*(SELECT|INSERT|UPDATE|DELETE|REPLACE|WITH)\\b",
+                                        QRegularExpression::CaseInsensitiveOption);
+    return dml.match(sql).hasMatch();
+}
+
+/**
+ * @brief EXPLAIN QUERY PLAN de la sentencia, con los mismos parámetros y en la misma conexión.
+ */
+QStringList explain(const QString &sql, const QVariantList &params, const QSqlDriver *driver)
+{
+    QStringList plan;
+    if (!driver || !driver->isOpen() || !hasPlan(sql)) return plan;
+
+    // Resultado creado por el propio driver: misma conexión y mismo hilo que la sentencia
+    QSqlQuery query(driver->createResult());
+    query.setForwardOnly(true);
+    if (!query.prepare("EXPLAIN QUERY PLAN " + sql)) {
+        plan << "(sin plan: " + query.lastError().text() + ")";
+        return plan;
+    }
+    for (int i = 0; i < params.size(); ++i) {
+        query.bindValue(i, params.at(i));
+    }
+    if (!query.exec()) {
+        plan << "(sin plan: " + query.lastError().text() + ")";
+        return plan;
+    }
+
+    // Columnas: id, parent, notused, detail; la sangría refleja el árbol del plan
+    QHash<int, int> depth;
+    while (query.next()) {
+        const int id = query.value(0).toInt();
+        const int parent = query.value(1).toInt();
+        const int level = parent == 0 ? 0 : depth.value(parent) + 1;
+        depth.insert(id, level);
+        plan << QString(level * 2, ' ') + query.value(3).toString();
+    }
+    return plan;
+}
+
+/**
+ * @brief El plan recorre una tabla o un índice entero.
+ * Las tablas virtuales (FTS5) y las filas constantes no cuentan como recorrido completo.
+ */
+bool isFullScan(const QStringList &plan)
+{
+    for (const QString &line : plan) {
+        const QString step = line.trimmed();
+        if (step.startsWith("SCAN ") && !step.contains("VIRTUAL TABLE") && !step.contains("CONSTANT ROW")) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void addShape(SlowQueryEntry &entry, const QString &shape)
+{
+    if (!entry.parameterShapes.contains(shape) && entry.parameterShapes.size() < SlowQueryLog::MaxParameterShapes) {
+        entry.parameterShapes.append(shape);
+    }
+}
+
+QJsonObject toJson(const SlowQueryEntry &entry)
+{
+    QJsonObject json;
+    json["sql"] = entry.sql;
+    json["sample_sql"] = entry.sampleSql;
+    json["parameter_shapes"] = QJsonArray::fromStringList(entry.parameterShapes);
+    json["plan"] = QJsonArray::fromStringList(entry.plan);
+    json["full_scan"] = entry.fullScan;
+    json["count"] = entry.count;
+    json["total_us"] = entry.totalUs;
+    json["max_us"] = entry.maxUs;
+    json["last_seen"] = entry.lastSeen.toString(Qt::ISODate);
+    return json;
+}
+
+SlowQueryEntry fromJson(const QJsonObject &json)
+{
+    SlowQueryEntry entry;
+    entry.sql = json["sql"].toString();
+    entry.sampleSql = json["sample_sql"].toString();
+    // Archivos anteriores pudieron guardar la longitud de una credencial: se descartan
+    if (!hasCredential(SlowQueryLog::placeholderNames(entry.sampleSql))) {
+        for (const QJsonValue &shape : json["parameter_shapes"].toArray()) entry.parameterShapes << shape.toString();
+    }
+    for (const QJsonValue &step : json["plan"].toArray()) entry.plan << step.toString();
+    entry.fullScan = json["full_scan"].toBool();
+    entry.count = json["count"].toInteger();
+    entry.totalUs = json["total_us"].toInteger();
+    entry.maxUs = json["max_us"].toInteger();
+    entry.lastSeen = QDateTime::fromString(json["last_seen"].toString(), Qt::ISODate);
+    return entry;
+}
+
+void sortByTotal(QList<SlowQueryEntry> &list)
+{
+    std::sort(list.begin(), list.end(), [](const SlowQueryEntry &a, const SlowQueryEntry &b) {
+        return a.totalUs > b.totalUs;
+    });
+}
+
+} // namespace
+
+// ---------------------------------------------------------
+// CONFIGURACIÓN
+// ---------------------------------------------------------
+
+void SlowQueryLog::setThresholdMs(int ms)
+{
+    g_thresholdUs.store(ms < 0 ? -1 : qint64(ms) * 1000, std::memory_order_relaxed);
+}
+
+int SlowQueryLog::thresholdMs()
+{
+    const qint64 us = g_thresholdUs.load(std::memory_order_relaxed);
+    return us < 0 ? -1 : int(us / 1000);
+}
+
+bool SlowQueryLog::isEnabled()
+{
+    return g_thresholdUs.load(std::memory_order_relaxed) >= 0;
+}
+
+// ---------------------------------------------------------
+// MEDICIÓN
+// ---------------------------------------------------------
+
+bool SlowQueryLog::exec(QSqlQuery &query)
+{
+    const qint64 thresholdUs = g_thresholdUs.load(std::memory_order_relaxed);
+    if (thresholdUs < 0) return query.exec();
+
+    QElapsedTimer timer;
+    timer.start();
+    const bool ok = query.exec();
+    const qint64 elapsedUs = timer.nsecsElapsed() / 1000;
+
+    if (elapsedUs >= thresholdUs) {
+        record(query.lastQuery(), query.boundValues(), elapsedUs, query.driver());
+    }
+    return ok;
+}
+
+bool SlowQueryLog::exec(QSqlQuery &query, const QString &sql)
+{
+    const qint64 thresholdUs = g_thresholdUs.load(std::memory_order_relaxed);
+    if (thresholdUs < 0) return query.exec(sql);
+
+    QElapsedTimer timer;
+    timer.start();
+    const bool ok = query.exec(sql);
+    const qint64 elapsedUs = timer.nsecsElapsed() / 1000;
+
+    if (elapsedUs >= thresholdUs) {
+        record(sql, QVariantList(), elapsedUs, query.driver());
+    }
+    return ok;
+}
+
+bool SlowQueryLog::commit(QSqlDatabase &db)
+{
+    const qint64 thresholdUs = g_thresholdUs.load(std::memory_order_relaxed);
+    if (thresholdUs < 0) return db.commit();
+
+    QElapsedTimer timer;
+    timer.start();
+    const bool ok = db.commit();
+    const qint64 elapsedUs = timer.nsecsElapsed() / 1000;
+
+    if (elapsedUs >= thresholdUs) {
+        record("COMMIT", QVariantList(), elapsedUs, nullptr);
+    }
+    return ok;
+}
+
+void SlowQueryLog::record(const QString &sql, const QVariantList &params, qint64 elapsedUs, const QSqlDriver *driver)
+{
+    const QString normalized = normalize(sql);
+    const QString shape = parameterShape(params, placeholderNames(sql));
+    SlowQueryState &slow = state();
+
+    bool known;
+    {
+        QMutexLocker locker(&slow.mutex);
+        known = slow.entries.contains(normalized);
+    }
+
+    // El plan se obtiene una vez por sentencia, fuera del mutex (ejecuta SQL)
+    QStringList plan;
+    if (!known) plan = explain(sql, params, driver);
+
+    bool created = false;
+    {
+        QMutexLocker locker(&slow.mutex);
+        auto it = slow.entries.find(normalized);
+        if (it == slow.entries.end()) {
+            SlowQueryEntry entry;
+            entry.sql = normalized;
+            entry.plan = plan;
+            entry.fullScan = isFullScan(plan);
+            it = slow.entries.insert(normalized, entry);
+            created = true;
+        }
+
+        SlowQueryEntry &entry = it.value();
+        entry.sampleSql = sql;
+        addShape(entry, shape);
+        ++entry.count;
+        entry.totalUs += elapsedUs;
+        entry.maxUs = qMax(entry.maxUs, elapsedUs);
+        entry.lastSeen = QDateTime::currentDateTime();
+    }
+
+    if (created) {
+        qWarning().noquote() << QString("Consulta lenta (%1 ms%2): %3")
+                                    .arg(QString::number(elapsedUs / 1000.0, 'f', 1),
+                                         isFullScan(plan) ? QString(", recorrido completo") : QString(), normalized)
+                             << (plan.isEmpty() ? QString() : "\n    " + plan.join("\n    "));
+    }
+}
+
+// ---------------------------------------------------------
+// NORMALIZACIÓN
+// ---------------------------------------------------------
+
+QString SlowQueryLog::normalize(const QString &sql)
+{
+    QString out;
+    out.reserve(sql.size());
+    bool pendingSpace = false;
+
+    auto append = [&](const QString &token) {
+        if (pendingSpace && !out.isEmpty()) out += ' ';
+        pendingSpace = false;
+        out += token;
+    };
+
+    const int n = sql.size();
+    int i = 0;
+    while (i < n) {
+        const QChar c = sql.at(i);
+        const bool afterIdentifier = i > 0 && isIdentifierChar(sql.at(i - 1));
+
+        if (c.isSpace()) {
+            pendingSpace = true;
+            ++i;
+        } else if (c == '\'' || ((c == 'x' || c == 'X') && i + 1 < n && sql.at(i + 1) == '\'' && !afterIdentifier)) {
+            // Texto o blob literal ('' escapa una comilla)
+            i += (c == '\'') ? 1 : 2;
+            while (i < n) {
+                if (sql.at(i) == '\'') {
+                    if (i + 1 < n && sql.at(i + 1) == '\'') {
+                        i += 2;
+                        continue;
+                    }
+                    ++i;
+                    break;
+                }
+                ++i;
+            }
+            append("?");
+        } else if (c == '"') {
+            // Identificador entrecomillado: se conserva
+            const int start = i++;
+            while (i < n && sql.at(i) != '"') ++i;
+            i = qMin(n, i + 1);
+            append(sql.mid(start, i - start));
+        } else if ((c == ':' || c == '@' || c == '$') && i + 1 < n && isIdentifierChar(sql.at(i + 1))) {
+            // Marcador con nombre
+            ++i;
+            while (i < n && isIdentifierChar(sql.at(i))) ++i;
+            append("?");
+        } else if ((c.isDigit() || (c == '.' && i + 1 < n && sql.at(i + 1).isDigit())) && !afterIdentifier) {
+            // Número (entero, decimal o con exponente)
+            while (i < n && (sql.at(i).isLetterOrNumber() || sql.at(i) == '.'
+                             || ((sql.at(i) == '+' || sql.at(i) == '-') && (sql.at(i - 1) == 'e' || sql.at(i - 1) == 'E')))) {
+                ++i;
+            }
+            append("?");
+        } else if (isIdentifierChar(c)) {
+            const int start = i;
+            while (i < n && isIdentifierChar(sql.at(i))) ++i;
+            append(sql.mid(start, i - start));
+        } else {
+            // Puntuación: sin espacio antes de ',' y ')' ni después de '('
+            if (c == ',' || c == ')' || c == '.') pendingSpace = false;
+            if (pendingSpace && !out.isEmpty() && !out.endsWith('(') && !out.endsWith('.')) out += ' ';
+            pendingSpace = false;
+            out += c;
+            ++i;
+            if (c == '(' || c == '.') {
+                while (i < n && sql.at(i).isSpace()) ++i;
+            }
+        }
+    }
+
+    // Listas de longitud variable (IN de la búsqueda, inserciones múltiples): una sola forma
+    static const QRegularExpression list("\\(\\?(?:, ?\\?)+\\)");
+    out.replace(list, "(?...)");
+    return out;
+}
+
+QString SlowQueryLog::parameterShape(const QVariantList &params, const QStringList &names)
+{
+    // Sin correspondencia fiable entre marcadores y parámetros, se oculta todo texto o blob
+    const bool aligned = names.size() == params.size();
+    const bool redactAll = !aligned && hasCredential(names);
+
+    QStringList types;
+    types.reserve(params.size());
+    for (int i = 0; i < params.size(); ++i) {
+        const QVariant &value = params.at(i);
+        if (aligned && isCredential(names.at(i))) {
+            types << "redacted";
+            continue;
+        }
+        if (value.isNull()) {
+            types << "null";
+            continue;
+        }
+        if (redactAll && (value.metaType().id() == QMetaType::QString || value.metaType().id() == QMetaType::QByteArray)) {
+            types << "redacted";
+            continue;
+        }
+        switch (value.metaType().id()) {
+        case QMetaType::Bool:
+        case QMetaType::Int:
+        case QMetaType::UInt:
+        case QMetaType::LongLong:
+        case QMetaType::ULongLong:
+            types << "int";
+            break;
+        case QMetaType::Double:
+        case QMetaType::Float:
+            types << "real";
+            break;
+        case QMetaType::QByteArray:
+            types << QString("blob(%1)").arg(value.toByteArray().size());
+            break;
+        case QMetaType::QString:
+            types << QString("text(%1)").arg(value.toString().size());
+            break;
+        case QMetaType::QDateTime:
+        case QMetaType::QDate:
+            types << "datetime";
+            break;
+        default:
+            types << QString::fromLatin1(value.typeName());
+            break;
+        }
+    }
+    return "(" + types.join(", ") + ")";
+}
+
+QStringList SlowQueryLog::placeholderNames(const QString &sql)
+{
+    QStringList names;
+    const int n = sql.size();
+    int i = 0;
+    while (i < n) {
+        const QChar c = sql.at(i);
+        if (c == '\'' || c == '"') {
+            // Literal o identificador entre comillas (la comilla doble escapa)
+            ++i;
+            while (i < n) {
+                if (sql.at(i) == c) {
+                    if (i + 1 < n && sql.at(i + 1) == c) {
+                        i += 2;
+                        continue;
+                    }
+                    break;
+                }
+                ++i;
+            }
+            ++i;
+        } else if (c == '?') {
+            names << QString();
+            ++i;
+            while (i < n && sql.at(i).isDigit()) ++i;
+        } else if ((c == ':' || c == '@' || c == '$') && i + 1 < n && isIdentifierChar(sql.at(i + 1))
+                   && (i == 0 || !isIdentifierChar(sql.at(i - 1)))) {
+            const int start = ++i;
+            while (i < n && isIdentifierChar(sql.at(i))) ++i;
+            names << sql.mid(start, i - start);
+        } else {
+            ++i;
+        }
+    }
+    return names;
+}
+
+// ---------------------------------------------------------
+// RESULTADOS
+// ---------------------------------------------------------
+
+QList<SlowQueryEntry> SlowQueryLog::entries()
+{
+    SlowQueryState &slow = state();
+    QList<SlowQueryEntry> list;
+    {
+        QMutexLocker locker(&slow.mutex);
+        list = slow.entries.values();
+    }
+    sortByTotal(list);
+    return list;
+}
+
+void SlowQueryLog::clear()
+{
+    SlowQueryState &slow = state();
+    QMutexLocker locker(&slow.mutex);
+    slow.entries.clear();
+}
+
+QString SlowQueryLog::report(int maxEntries)
+{
+    const QList<SlowQueryEntry> list = entries();
+    if (list.isEmpty()) return QString();
+
+    QStringList lines;
+    lines << QString("Consultas lentas (umbral %1 ms): %2 sentencias distintas").arg(thresholdMs()).arg(list.size());
+    for (int i = 0; i < qMin(maxEntries, int(list.size())); ++i) {
+        const SlowQueryEntry &entry = list.at(i);
+        lines << QString("  %1 x, %2 ms en total, %3 ms como máximo%4: %5")
+                     .arg(entry.count)
+                     .arg(QString::number(entry.totalUs / 1000.0, 'f', 1),
+                          QString::number(entry.maxUs / 1000.0, 'f', 1),
+                          entry.fullScan ? QString(" [SCAN]") : QString(), entry.sql);
+        for (const QString &step : entry.plan) lines << "      " + step;
+    }
+    return lines.join('\n');
+}
+
+bool SlowQueryLog::save(const QString &fileName)
+{
+    QList<SlowQueryEntry> session = entries();
+    if (session.isEmpty()) return true;
+
+    // Acumular con las sesiones anteriores del mismo archivo
+    QHash<QString, SlowQueryEntry> merged;
+    QFile previous(fileName);
+    if (previous.open(QIODevice::ReadOnly)) {
+        const QJsonArray saved = QJsonDocument::fromJson(previous.readAll()).object()["entries"].toArray();
+        for (const QJsonValue &value : saved) {
+            const SlowQueryEntry entry = fromJson(value.toObject());
+            if (!entry.sql.isEmpty()) merged.insert(entry.sql, entry);
+        }
+        previous.close();
+    }
+
+    for (const SlowQueryEntry &entry : std::as_const(session)) {
+        auto it = merged.find(entry.sql);
+        if (it == merged.end()) {
+            merged.insert(entry.sql, entry);
+            continue;
+        }
+        SlowQueryEntry &total = it.value();
+        total.sampleSql = entry.sampleSql;
+        if (!entry.plan.isEmpty()) {
+            // El plan más reciente refleja los índices actuales
+            total.plan = entry.plan;
+            total.fullScan = entry.fullScan;
+        }
+        for (const QString &shape : entry.parameterShapes) addShape(total, shape);
+        total.count += entry.count;
+        total.totalUs += entry.totalUs;
+        total.maxUs = qMax(total.maxUs, entry.maxUs);
+        total.lastSeen = qMax(total.lastSeen, entry.lastSeen);
+    }
+
+    QList<SlowQueryEntry> list = merged.values();
+    sortByTotal(list);
+
+    QJsonArray array;
+    for (const SlowQueryEntry &entry : std::as_const(list)) array.append(toJson(entry));
+    QJsonObject root;
+    root["threshold_ms"] = thresholdMs();
+    root["entries"] = array;
+
+    QSaveFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly)) {
+        qWarning() << "No se pudo escribir el registro de consultas lentas:" << file.errorString();
+        return false;
+    }
+    file.write(QJsonDocument(root).toJson(QJsonDocument::Indented));
+    return file.commit();
+}
@@ -0,0 +1,123 @@
+#include "startuptimeline.h"
+#include <QElapsedTimer>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QStringList>
+#include <algorithm>
+
+namespace {
+
+/**
+ * @brief Estado compartido: origen de tiempos y fases registradas.
+ */
+struct Timeline
+{
+    QMutex mutex;
+    QElapsedTimer clock;
+    QList<StartupPhase> phases;
+
+    Timeline() { clock.start(); }
+};
+
+Timeline &timeline()
+{
+    static Timeline instance;
+    return instance;
+}
+
+void record(const QString &name, qint64 startUs, qint64 durationUs)
+{
+    Timeline &state = timeline();
+    QMutexLocker locker(&state.mutex);
+
+    StartupPhase phase;
+    phase.name = name;
+    phase.startUs = startUs;
+    phase.durationUs = durationUs;
+
+    // Las fases se registran al terminar: se insertan por su inicio
+    auto position = std::upper_bound(state.phases.begin(), state.phases.end(), startUs,
+                                     [](qint64 us, const StartupPhase &other) { return us < other.startUs; });
+    state.phases.insert(position, phase);
+}
+
+QString milliseconds(qint64 us)
+{
+    return QString::number(us / 1000.0, 'f', 1);
+}
+
+} // namespace
+
+StartupTimeline::Scope::Scope(const QString &name)
+    : m_name(name)
+    , m_startUs(StartupTimeline::elapsedUs())
+{
+}
+
+StartupTimeline::Scope::~Scope()
+{
+    record(m_name, m_startUs, StartupTimeline::elapsedUs() - m_startUs);
+}
+
+void StartupTimeline::start()
+{
+    Timeline &state = timeline();
+    QMutexLocker locker(&state.mutex);
+    state.clock.restart();
+    state.phases.clear();
+}
+
+void StartupTimeline::mark(const QString &name)
+{
+    record(name, elapsedUs(), 0);
+}
+
+qint64 StartupTimeline::elapsedUs()
+{
+    return timeline().clock.nsecsElapsed() / 1000;
+}
+
+QList<StartupPhase> StartupTimeline::phases()
+{
+    Timeline &state = timeline();
+    QMutexLocker locker(&state.mutex);
+    return state.phases;
+}
+
+QString StartupTimeline::report()
+{
+    QStringList lines;
+    lines << "Cronología del arranque (inicio, duración en ms):";
+    for (const StartupPhase &phase : phases()) {
+        lines << QString("  %1  %2  %3")
+                     .arg(milliseconds(phase.startUs), 8)
+                     .arg(phase.durationUs > 0 ? milliseconds(phase.durationUs) : QString("-"), 8)
+                     .arg(phase.name);
+    }
+    return lines.join('\n');
+}
+
+QString StartupTimeline::summary(int maxPhases)
+{
+    QList<StartupPhase> sorted = phases();
+    qint64 totalUs = 0;
+    for (const StartupPhase &phase : std::as_const(sorted)) {
+        totalUs = qMax(totalUs, phase.startUs + phase.durationUs);
+    }
+    std::stable_sort(sorted.begin(), sorted.end(), [](const StartupPhase &a, const StartupPhase &b) {
+        return a.durationUs > b.durationUs;
+    });
+
+    QStringList parts;
+    for (const StartupPhase &phase : std::as_const(sorted)) {
+        if (parts.size() == maxPhases || phase.durationUs == 0) break;
+        parts << QString("%1 %2 ms").arg(phase.name, milliseconds(phase.durationUs));
+    }
+
+    // Hitos: momento en que ocurrieron
+    for (const StartupPhase &phase : phases()) {
+        if (phase.durationUs == 0) parts << QString("%1 a los %2 ms").arg(phase.name, milliseconds(phase.startUs));
+    }
+
+    return QString("Arranque en %1 ms: %2").arg(milliseconds(totalUs), parts.join(", "));
+}
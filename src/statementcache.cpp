@@ -0,0 +1,75 @@
+#include "statementcache.h"
+#include <QSqlDatabase>
+#include <QSqlError>
+#include <QDebug>
+
+// ---------------------------------------------------------
+// CONSTRUCTOR
+// ---------------------------------------------------------
+
+StatementCache::StatementCache(const QString &connectionName, int capacity,
+                               std::shared_ptr<Counters> counters)
+    : m_connectionName(connectionName)
+    , m_capacity(qMax(4, capacity))
+    , m_counters(std::move(counters))
+{
+}
+
+// ---------------------------------------------------------
+// SENTENCIAS
+// ---------------------------------------------------------
+
+QSqlQuery &StatementCache::acquire(const QString &sql)
+{
+    auto found = m_entries.find(sql);
+    if (found != m_entries.end()) {
+        // Acierto: mover al frente de la lista LRU y descartar el resultado anterior
+        m_lru.splice(m_lru.begin(), m_lru, found->second.position);
+        m_counters->hits.fetch_add(1, std::memory_order_relaxed);
+
+        QSqlQuery &query = *found->second.query;
+        query.finish();
+        return query;
+    }
+
+    m_counters->misses.fetch_add(1, std::memory_order_relaxed);
+
+    auto query = std::make_unique<QSqlQuery>(QSqlDatabase::database(m_connectionName, false));
+    query->setForwardOnly(true);
+    if (!query->prepare(sql)) {
+        // No se cachea: el llamador verá el error al ejecutar
+        qWarning() << "Error preparando sentencia:" << query->lastError().text();
+        m_failed = std::move(query);
+        return *m_failed;
+    }
+
+    // Desalojar la menos usada antes de insertar (la que se entrega nunca es la desalojada)
+    if (static_cast<int>(m_entries.size()) >= m_capacity) {
+        m_entries.erase(m_lru.back());
+        m_lru.pop_back();
+        m_counters->evictions.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    m_lru.push_front(sql);
+    Node &node = m_entries[sql];
+    node.query = std::move(query);
+    node.position = m_lru.begin();
+    return *node.query;
+}
+
+void StatementCache::clear()
+{
+    m_entries.clear();
+    m_lru.clear();
+    m_failed.reset();
+}
+
+int StatementCache::size() const
+{
+    return static_cast<int>(m_entries.size());
+}
+
+QString StatementCache::connectionName() const
+{
+    return m_connectionName;
+}
@@ -0,0 +1,80 @@
+#include "storageprofile.h"
+
+// ---------------------------------------------------------
+// PERFILES PREDEFINIDOS
+// ---------------------------------------------------------
+
+StorageProfile StorageProfile::durable()
+{
+    StorageProfile profile;
+    profile.name = "durable";
+    profile.synchronous = "FULL";
+    profile.mmapSize = 0;
+    profile.cacheSizeKiB = 4 * 1024;
+    profile.tempStore = "DEFAULT";
+    return profile;
+}
+
+StorageProfile StorageProfile::balanced()
+{
+    StorageProfile profile;
+    profile.name = "balanced";
+    profile.synchronous = "NORMAL";
+    profile.mmapSize = qint64(256) << 20;
+    profile.cacheSizeKiB = 16 * 1024;
+    profile.tempStore = "MEMORY";
+    return profile;
+}
+
+StorageProfile StorageProfile::bulkLoad()
+{
+    StorageProfile profile;
+    profile.name = "bulk-load";
+    profile.synchronous = "OFF";
+    profile.mmapSize = qint64(1) << 30;
+    profile.cacheSizeKiB = 64 * 1024;
+    profile.tempStore = "MEMORY";
+    profile.walAutoCheckpoint = 10000;
+    profile.busyTimeoutMs = 30000;
+    return profile;
+}
+
+bool StorageProfile::fromName(const QString &name, StorageProfile *profile)
+{
+    const QString key = name.trimmed().toLower();
+
+    if (key == "durable") {
+        *profile = durable();
+    } else if (key == "balanced") {
+        *profile = balanced();
+    } else if (key == "bulk-load" || key == "bulkload" || key == "bulk") {
+        *profile = bulkLoad();
+    } else {
+        return false;
+    }
+    return true;
+}
+
+QStringList StorageProfile::names()
+{
+    return { "durable", "balanced", "bulk-load" };
+}
+
+// ---------------------------------------------------------
+// SENTENCIAS PRAGMA
+// ---------------------------------------------------------
+
+QStringList StorageProfile::connectionPragmas(bool readOnly) const
+{
+    QStringList pragmas;
+    pragmas << QString("PRAGMA cache_size=%1").arg(-qMax(1, cacheSizeKiB))
+            << QString("PRAGMA mmap_size=%1").arg(qMax<qint64>(0, mmapSize))
+            << QString("PRAGMA temp_store=%1").arg(tempStore);
+
+    // Parámetros que solo afectan a las escrituras
+    if (!readOnly) {
+        pragmas << QString("PRAGMA synchronous=%1").arg(synchronous)
+                << QString("PRAGMA wal_autocheckpoint=%1").arg(qMax(0, walAutoCheckpoint));
+    }
+    return pragmas;
+}
@@ -0,0 +1,102 @@
+#include "telemetryframe.h"
+#include <QtEndian>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define TELEMETRY_SSE2
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#include <arm_neon.h>
+#define TELEMETRY_NEON
+#endif
+
+// ---------------------------------------------------------
+// CODIFICACIÓN
+// ---------------------------------------------------------
+
+QByteArray TelemetryFrame::encode(quint16 sequence, const QList<Sample> &samples)
+{
+    if (samples.isEmpty() || samples.size() > MaxSamples) return QByteArray();
+
+    const qint64 baseMs = samples.first().timestampMs;
+    QByteArray frame(HeaderBytes + samples.size() * SampleBytes, Qt::Uninitialized);
+    uchar *out = reinterpret_cast<uchar *>(frame.data());
+
+    qToLittleEndian<quint32>(Magic, out);
+    qToLittleEndian<quint16>(quint16(samples.size()), out + 4);
+    qToLittleEndian<quint16>(sequence, out + 6);
+    qToLittleEndian<qint64>(baseMs, out + 8);
+
+    out += HeaderBytes;
+    for (const Sample &sample : samples) {
+        const qint64 offset = sample.timestampMs - baseMs;
+        if (offset < 0 || offset > 0xFFFFFFFFLL) return QByteArray();
+
+        quint32 bits;
+        std::memcpy(&bits, &sample.value, sizeof(bits));
+        qToLittleEndian<quint32>(quint32(offset), out);
+        qToLittleEndian<quint32>(bits, out + 4);
+        out += SampleBytes;
+    }
+    return frame;
+}
+
+// ---------------------------------------------------------
+// DECODIFICACIÓN
+// ---------------------------------------------------------
+
+bool TelemetryFrame::parseHeader(const uchar *data, qsizetype size, Header *header)
+{
+    if (size < HeaderBytes + SampleBytes) return false;
+    if (qFromLittleEndian<quint32>(data) != Magic) return false;
+
+    const int count = qFromLittleEndian<quint16>(data + 4);
+    if (count == 0 || count > MaxSamples || size != HeaderBytes + qsizetype(count) * SampleBytes) return false;
+
+    header->count = count;
+    header->sequence = qFromLittleEndian<quint16>(data + 6);
+    header->baseMs = qFromLittleEndian<qint64>(data + 8);
+    return true;
+}
+
+void TelemetryFrame::unpack(const uchar *data, const Header &header, qint64 *timestampsMs, float *raw)
+{
+    const uchar *in = data + HeaderBytes;
+    for (int i = 0; i < header.count; ++i, in += SampleBytes) {
+        timestampsMs[i] = header.baseMs + qFromLittleEndian<quint32>(in);
+        const quint32 bits = qFromLittleEndian<quint32>(in + 4);
+        std::memcpy(&raw[i], &bits, sizeof(bits));
+    }
+}
+
+// ---------------------------------------------------------
+// CALIBRACIÓN
+// ---------------------------------------------------------
+
+void TelemetryFrame::calibrate(const float *raw, const double *offsets, double *out, qsizetype count)
+{
+    qsizetype i = 0;
+
+#if defined(TELEMETRY_SSE2)
+    // Cuatro lecturas por iteración: float -> double y suma del desplazamiento
+    for (; i + 4 <= count; i += 4) {
+        const __m128 values = _mm_loadu_ps(raw + i);
+        const __m128d low = _mm_add_pd(_mm_cvtps_pd(values), _mm_loadu_pd(offsets + i));
+        const __m128d high = _mm_add_pd(_mm_cvtps_pd(_mm_movehl_ps(values, values)), _mm_loadu_pd(offsets + i + 2));
+        _mm_storeu_pd(out + i, low);
+        _mm_storeu_pd(out + i + 2, high);
+    }
+#elif defined(TELEMETRY_NEON)
+    for (; i + 4 <= count; i += 4) {
+        const float32x4_t values = vld1q_f32(raw + i);
+        const float64x2_t low = vaddq_f64(vcvt_f64_f32(vget_low_f32(values)), vld1q_f64(offsets + i));
+        const float64x2_t high = vaddq_f64(vcvt_high_f64_f32(values), vld1q_f64(offsets + i + 2));
+        vst1q_f64(out + i, low);
+        vst1q_f64(out + i + 2, high);
+    }
+#endif
+
+    for (; i < count; ++i) {
+        out[i] = double(raw[i]) + offsets[i];
+    }
+}
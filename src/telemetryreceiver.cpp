@@ -0,0 +1,477 @@
+#include "telemetryreceiver.h"
+#include "telemetryframe.h"
+#include "connectionpool.h"
+#include <QSqlQuery>
+#include <QSqlError>
+#include <QMutexLocker>
+#include <QUdpSocket>
+#include <QDebug>
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+#ifdef Q_OS_LINUX
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+#endif
+
+namespace {
+
+// Mayor que cualquier trama válida: un datagrama más largo se detecta y se descarta
+const int DatagramCapacity = 2048;
+
+} // namespace
+
+// ---------------------------------------------------------
+// CONSTRUCTOR Y DESTRUCTOR
+// ---------------------------------------------------------
+
+TelemetryReceiver::TelemetryReceiver(TimeSeriesStore *store, QObject *parent)
+    : QObject(parent)
+    , m_store(store)
+    , m_batchSize(64)
+    , m_receiveBufferSize(4 * 1024 * 1024)
+    , m_index(std::make_shared<const SourceIndex>())
+    , m_loaderContext(new QObject)
+    , m_generation(0)
+    , m_loading(false)
+    , m_thread(nullptr)
+    , m_stopping(false)
+    , m_socket(-1)
+    , m_udp(nullptr)
+    , m_port(0)
+    , m_elapsedMs(0)
+    , m_datagrams(0)
+    , m_batches(0)
+    , m_samples(0)
+    , m_stored(0)
+    , m_malformed(0)
+    , m_unknownSource(0)
+    , m_lost(0)
+    , m_kernelDrops(0)
+    , m_rejected(0)
+{
+    m_loaderContext->moveToThread(&m_loader);
+    connect(&m_loader, &QThread::finished, m_loaderContext, &QObject::deleteLater);
+    m_loader.setObjectName("Carga de telemetría");
+    m_loader.start();
+}
+
+TelemetryReceiver::~TelemetryReceiver()
+{
+    stop();
+
+    // La conexión del lector debe cerrarse en el mismo hilo que la abrió
+    QMetaObject::invokeMethod(m_loaderContext, []() {
+        ConnectionPool::releaseCurrentThread();
+    }, Qt::BlockingQueuedConnection);
+
+    m_loader.quit();
+    m_loader.wait();
+}
+
+// ---------------------------------------------------------
+// CONFIGURACIÓN
+// ---------------------------------------------------------
+
+void TelemetryReceiver::setBatchSize(int datagrams) { m_batchSize = qBound(1, datagrams, 1024); }
+
+void TelemetryReceiver::setReceiveBufferSize(int bytes) { m_receiveBufferSize = qMax(64 * 1024, bytes); }
+
+// ---------------------------------------------------------
+// ÍNDICE DE DIRECCIONES
+// ---------------------------------------------------------
+
+void TelemetryReceiver::loadDevices(ConnectionPool *pool)
+{
+    const quint64 generation = ++m_generation;
+    m_loading = true;
+    m_changesWhileLoading.clear();
+
+    QMetaObject::invokeMethod(m_loaderContext, [this, pool, generation]() {
+        if (generation != m_generation) return;
+
+        QSqlQuery query(pool->reader());
+        query.setForwardOnly(true);
+        if (!query.exec("SELECT id, ip_address, calibration FROM devices")) {
+            qCritical() << "Error leyendo los dispositivos de telemetría:" << query.lastError().text();
+            return;
+        }
+
+        SourceIndex index;
+        while (query.next()) {
+            quint32 key;
+            if (!addressKey(query.value(1).toString(), &key)) continue;
+            index.insert(key, Source{ query.value(0).toInt(), query.value(2).toDouble() });
+        }
+
+        QMetaObject::invokeMethod(this, [this, generation, index]() {
+            applyLoadedIndex(generation, index);
+        }, Qt::QueuedConnection);
+    }, Qt::QueuedConnection);
+}
+
+void TelemetryReceiver::applyLoadedIndex(quint64 generation, SourceIndex index)
+{
+    if (generation != m_generation) return;
+
+    m_loading = false;
+    publishIndex(std::move(index));
+
+    // Un cambio confirmado después de la consulta no está en el índice leído; volver a
+    // aplicar uno que sí lo está deja el mismo resultado
+    const QList<DeviceChange> changes = std::exchange(m_changesWhileLoading, {});
+    if (!changes.isEmpty()) applyChanges(changes);
+}
+
+void TelemetryReceiver::setDevices(const QList<DeviceRecord> &devices)
+{
+    // Sustituye a cualquier carga pendiente
+    ++m_generation;
+    m_loading = false;
+    m_changesWhileLoading.clear();
+
+    SourceIndex index;
+    index.reserve(devices.size());
+    for (const DeviceRecord &device : devices) {
+        quint32 key;
+        if (addressKey(device.ip, &key)) index.insert(key, Source{ device.id, device.calibration });
+    }
+    publishIndex(std::move(index));
+}
+
+void TelemetryReceiver::applyChanges(const QList<DeviceChange> &changes)
+{
+    if (m_loading) m_changesWhileLoading += changes;
+
+    SourceIndex index = *currentIndex();
+
+    // Solo se quita la dirección si sigue apuntando a este dispositivo (IPs duplicadas)
+    auto release = [&index](const QString &ip, int id) {
+        quint32 key;
+        if (addressKey(ip, &key) && index.value(key).deviceId == id) index.remove(key);
+    };
+
+    for (const DeviceChange &change : changes) {
+        const DeviceRecord &values = change.values;
+        switch (change.kind) {
+        case DeviceChange::Removed:
+            release(values.ip, values.id);
+            break;
+        case DeviceChange::Updated:
+            release(change.previous.ip, values.id);
+            Q_FALLTHROUGH();
+        case DeviceChange::Inserted: {
+            quint32 key;
+            if (addressKey(values.ip, &key)) index.insert(key, Source{ values.id, values.calibration });
+            break;
+        }
+        }
+    }
+    publishIndex(std::move(index));
+}
+
+std::shared_ptr<const TelemetryReceiver::SourceIndex> TelemetryReceiver::currentIndex() const
+{
+    QMutexLocker locker(&m_indexMutex);
+    return m_index;
+}
+
+void TelemetryReceiver::publishIndex(SourceIndex index)
+{
+    auto next = std::make_shared<const SourceIndex>(std::move(index));
+    QMutexLocker locker(&m_indexMutex);
+    m_index = std::move(next);
+}
+
+bool TelemetryReceiver::addressKey(const QString &ip, quint32 *key)
+{
+    bool ok = false;
+    *key = QHostAddress(ip.trimmed()).toIPv4Address(&ok);
+    return ok;
+}
+
+// ---------------------------------------------------------
+// CONTROL DEL HILO RECEPTOR
+// ---------------------------------------------------------
+
+bool TelemetryReceiver::start(const QHostAddress &address, quint16 port)
+{
+    if (m_thread) return false;
+
+    bool ipv4 = false;
+    const quint32 local = address.toIPv4Address(&ipv4);
+    if (!ipv4) {
+        qCritical() << "La telemetría solo admite direcciones IPv4:" << address.toString();
+        return false;
+    }
+
+#ifdef Q_OS_LINUX
+    m_socket = ::socket(AF_INET, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+    if (m_socket < 0) {
+        qCritical() << "No se pudo crear el socket de telemetría:" << std::strerror(errno);
+        return false;
+    }
+
+    const int one = 1;
+    ::setsockopt(m_socket, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    ::setsockopt(m_socket, SOL_SOCKET, SO_RCVBUF, &m_receiveBufferSize, sizeof(m_receiveBufferSize));
+    // El núcleo adjunta a cada datagrama el total de descartes por búfer lleno
+    ::setsockopt(m_socket, SOL_SOCKET, SO_RXQ_OVFL, &one, sizeof(one));
+    // Espera acotada para que el hilo compruebe m_stopping con regularidad
+    const timeval timeout{ 0, 100 * 1000 };
+    ::setsockopt(m_socket, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl(local);
+    socklen_t length = sizeof(addr);
+    if (::bind(m_socket, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) != 0
+        || ::getsockname(m_socket, reinterpret_cast<sockaddr *>(&addr), &length) != 0) {
+        qCritical() << "No se pudo abrir el puerto de telemetría" << port << ":" << std::strerror(errno);
+        ::close(m_socket);
+        m_socket = -1;
+        return false;
+    }
+    m_port = ntohs(addr.sin_port);
+#else
+    Q_UNUSED(local);
+    m_udp = new QUdpSocket();
+    if (!m_udp->bind(address, port)) {
+        qCritical() << "No se pudo abrir el puerto de telemetría" << port << ":" << m_udp->errorString();
+        delete m_udp;
+        m_udp = nullptr;
+        return false;
+    }
+    m_udp->setSocketOption(QAbstractSocket::ReceiveBufferSizeSocketOption, m_receiveBufferSize);
+    m_port = m_udp->localPort();
+#endif
+
+    m_datagrams = 0;
+    m_batches = 0;
+    m_samples = 0;
+    m_stored = 0;
+    m_malformed = 0;
+    m_unknownSource = 0;
+    m_lost = 0;
+    m_kernelDrops = 0;
+    m_rejected = 0;
+    m_lastSequence.clear();
+    m_stopping = false;
+
+    m_thread = QThread::create([this]() { run(); });
+    if (m_udp) m_udp->moveToThread(m_thread);
+    m_clock.start();
+    m_thread->setObjectName("Telemetría");
+    m_thread->start();
+
+    qInfo() << "Telemetría escuchando en el puerto UDP" << m_port;
+    return true;
+}
+
+void TelemetryReceiver::stop()
+{
+    if (!m_thread) return;
+
+    m_stopping = true;
+    m_thread->wait();
+    delete m_thread;
+    m_thread = nullptr;
+    m_elapsedMs = m_clock.elapsed();
+
+#ifdef Q_OS_LINUX
+    ::close(m_socket);
+    m_socket = -1;
+#endif
+    delete m_udp;
+    m_udp = nullptr;
+    m_port = 0;
+}
+
+bool TelemetryReceiver::isRunning() const
+{
+    return m_thread != nullptr;
+}
+
+quint16 TelemetryReceiver::port() const
+{
+    return m_port;
+}
+
+TelemetryStats TelemetryReceiver::stats() const
+{
+    TelemetryStats stats;
+    stats.datagrams = m_datagrams.load();
+    stats.batches = m_batches.load();
+    stats.samples = m_samples.load();
+    stats.stored = m_stored.load();
+    stats.malformed = m_malformed.load();
+    stats.unknownSource = m_unknownSource.load();
+    stats.lost = m_lost.load();
+    stats.kernelDrops = m_kernelDrops.load();
+    stats.rejected = m_rejected.load();
+    stats.elapsedMs = m_thread ? m_clock.elapsed() : m_elapsedMs;
+    return stats;
+}
+
+// ---------------------------------------------------------
+// HILO RECEPTOR
+// ---------------------------------------------------------
+
+void TelemetryReceiver::run()
+{
+    const int capacity = m_batchSize;
+
+    // Todos los búferes se reservan una vez: el bucle no vuelve a pedir memoria
+    QByteArray storage(capacity * DatagramCapacity, Qt::Uninitialized);
+    uchar *buffers = reinterpret_cast<uchar *>(storage.data());
+    std::vector<const uchar *> datagrams(capacity);
+    std::vector<qsizetype> sizes(capacity);
+    std::vector<quint32> sources(capacity);
+    for (int i = 0; i < capacity; ++i) datagrams[i] = buffers + i * DatagramCapacity;
+
+    const qsizetype maxSamples = qsizetype(capacity) * TelemetryFrame::MaxSamples;
+    m_batch.deviceIds.reserve(maxSamples);
+    m_batch.timestampsMs.reserve(maxSamples);
+    m_batch.values.reserve(maxSamples);
+    m_raw.reserve(maxSamples);
+
+#ifdef Q_OS_LINUX
+    std::vector<mmsghdr> messages(capacity);
+    std::vector<iovec> vectors(capacity);
+    std::vector<sockaddr_in> senders(capacity);
+    const std::size_t controlSize = CMSG_SPACE(sizeof(quint32));
+    std::vector<char> control(capacity * controlSize);
+    quint32 lastOverflow = 0;
+
+    while (!m_stopping) {
+        // recvmmsg() modifica las longitudes: se restauran antes de cada llamada
+        for (int i = 0; i < capacity; ++i) {
+            vectors[i].iov_base = buffers + i * DatagramCapacity;
+            vectors[i].iov_len = DatagramCapacity;
+            msghdr &header = messages[i].msg_hdr;
+            header.msg_name = &senders[i];
+            header.msg_namelen = sizeof(sockaddr_in);
+            header.msg_iov = &vectors[i];
+            header.msg_iovlen = 1;
+            header.msg_control = control.data() + i * controlSize;
+            header.msg_controllen = controlSize;
+            header.msg_flags = 0;
+        }
+
+        // Espera el primer datagrama y recoge sin bloquear los que ya estén en cola
+        const int received = ::recvmmsg(m_socket, messages.data(), capacity, MSG_WAITFORONE, nullptr);
+        if (received < 0) {
+            if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) continue;
+            qCritical() << "Error recibiendo telemetría:" << std::strerror(errno);
+            break;
+        }
+
+        for (int i = 0; i < received; ++i) {
+            msghdr &header = messages[i].msg_hdr;
+            sizes[i] = (header.msg_flags & MSG_TRUNC) ? 0 : qsizetype(messages[i].msg_len);
+            sources[i] = ntohl(senders[i].sin_addr.s_addr);
+
+            for (cmsghdr *cmsg = CMSG_FIRSTHDR(&header); cmsg; cmsg = CMSG_NXTHDR(&header, cmsg)) {
+                if (cmsg->cmsg_level != SOL_SOCKET || cmsg->cmsg_type != SO_RXQ_OVFL) continue;
+                quint32 overflow;
+                std::memcpy(&overflow, CMSG_DATA(cmsg), sizeof(overflow));
+                m_kernelDrops.fetch_add(quint32(overflow - lastOverflow), std::memory_order_relaxed);
+                lastOverflow = overflow;
+            }
+        }
+
+        processBatch(datagrams.data(), sizes.data(), sources.data(), received);
+    }
+#else
+    while (!m_stopping) {
+        if (!m_udp->waitForReadyRead(100)) continue;
+
+        int received = 0;
+        while (received < capacity && m_udp->hasPendingDatagrams()) {
+            QHostAddress sender;
+            const qint64 size = m_udp->readDatagram(reinterpret_cast<char *>(buffers + received * DatagramCapacity),
+                                                    DatagramCapacity, &sender);
+            if (size < 0) break;
+            sizes[received] = size;
+            sources[received] = sender.toIPv4Address();
+            ++received;
+        }
+        if (received > 0) processBatch(datagrams.data(), sizes.data(), sources.data(), received);
+    }
+#endif
+}
+
+void TelemetryReceiver::processBatch(const uchar *const *datagrams, const qsizetype *sizes,
+                                     const quint32 *sources, int count)
+{
+    const std::shared_ptr<const SourceIndex> index = currentIndex();
+    m_batch.clear();
+    m_raw.resize(0);
+
+    qint64 malformed = 0;
+    qint64 unknown = 0;
+    qint64 lost = 0;
+
+    for (int i = 0; i < count; ++i) {
+        TelemetryFrame::Header header;
+        if (!TelemetryFrame::parseHeader(datagrams[i], sizes[i], &header)) {
+            ++malformed;
+            continue;
+        }
+
+        const auto source = index->constFind(sources[i]);
+        if (source == index->cend()) {
+            ++unknown;
+            continue;
+        }
+        const int deviceId = source->deviceId;
+
+        // Saltos de secuencia = tramas perdidas; las repetidas o atrasadas no cuentan
+        auto last = m_lastSequence.find(deviceId);
+        if (last == m_lastSequence.end()) {
+            m_lastSequence.insert(deviceId, header.sequence);
+        } else {
+            const quint16 gap = quint16(header.sequence - *last - 1);
+            if (gap < 0x8000) {
+                lost += gap;
+                *last = header.sequence;
+            }
+        }
+
+        // Columnas del lote: la calibración se copia como valor inicial y calibrate()
+        // le suma después la lectura sin calibrar
+        const qsizetype at = m_batch.size();
+        const qsizetype end = at + header.count;
+        m_batch.deviceIds.resize(end);
+        m_batch.timestampsMs.resize(end);
+        m_batch.values.resize(end);
+        m_raw.resize(end);
+
+        std::fill(m_batch.deviceIds.begin() + at, m_batch.deviceIds.end(), deviceId);
+        std::fill(m_batch.values.begin() + at, m_batch.values.end(), source->calibration);
+        TelemetryFrame::unpack(datagrams[i], header, m_batch.timestampsMs.data() + at, m_raw.data() + at);
+    }
+
+    const qsizetype samples = m_batch.size();
+    if (samples > 0) {
+        TelemetryFrame::calibrate(m_raw.constData(), m_batch.values.constData(), m_batch.values.data(), samples);
+
+        const int stored = m_store ? m_store->append(m_batch) : 0;
+        m_stored.fetch_add(stored, std::memory_order_relaxed);
+        m_rejected.fetch_add(samples - stored, std::memory_order_relaxed);
+    }
+
+    m_datagrams.fetch_add(count, std::memory_order_relaxed);
+    m_batches.fetch_add(1, std::memory_order_relaxed);
+    m_samples.fetch_add(samples, std::memory_order_relaxed);
+    m_malformed.fetch_add(malformed, std::memory_order_relaxed);
+    m_unknownSource.fetch_add(unknown, std::memory_order_relaxed);
+    m_lost.fetch_add(lost, std::memory_order_relaxed);
+}
@@ -0,0 +1,608 @@
+#include "timeseriesstore.h"
+#include "rollupengine.h"
+#include "tracer.h"
+#include <QDir>
+#include <QFileInfo>
+#include <QtEndian>
+#include <QDebug>
+#include <QSet>
+#include <algorithm>
+#include <climits>
+
+namespace {
+
+const char *const kSegmentPrefix = "series-";
+const char *const kSegmentSuffix = ".tsd";
+
+// Cabecera de bloque (little-endian):
+//   magic u32 | deviceId i32 | count u32 | bytes u32 | firstMs i64 | lastMs i64
+constexpr quint32 ChunkMagic = 0x31435354;   // "TSC1"
+constexpr int HeaderSize = 32;
+
+struct ChunkHeader
+{
+    quint32 magic = 0;
+    qint32 deviceId = 0;
+    quint32 count = 0;
+    quint32 bytes = 0;
+    qint64 firstMs = 0;
+    qint64 lastMs = 0;
+};
+
+void writeHeader(const ChunkHeader &header, uchar *out)
+{
+    qToLittleEndian(header.magic, out);
+    qToLittleEndian(header.deviceId, out + 4);
+    qToLittleEndian(header.count, out + 8);
+    qToLittleEndian(header.bytes, out + 12);
+    qToLittleEndian(header.firstMs, out + 16);
+    qToLittleEndian(header.lastMs, out + 24);
+}
+
+ChunkHeader readHeader(const uchar *in)
+{
+    ChunkHeader header;
+    header.magic = qFromLittleEndian<quint32>(in);
+    header.deviceId = qFromLittleEndian<qint32>(in + 4);
+    header.count = qFromLittleEndian<quint32>(in + 8);
+    header.bytes = qFromLittleEndian<quint32>(in + 12);
+    header.firstMs = qFromLittleEndian<qint64>(in + 16);
+    header.lastMs = qFromLittleEndian<qint64>(in + 24);
+    return header;
+}
+
+} // namespace
+
+TimeSeriesStore::Mapping::~Mapping()
+{
+    if (data) file.unmap(data);
+}
+
+// ---------------------------------------------------------
+// CONSTRUCTOR Y DESTRUCTOR
+// ---------------------------------------------------------
+
+TimeSeriesStore::TimeSeriesStore(const QString &directory)
+    : m_directory(QDir(directory).absolutePath())
+    , m_chunkPoints(1024)
+    , m_segmentBytes(64LL * 1024 * 1024)
+    , m_maxOpenAgeMs(10000)
+    , m_active(0)
+    , m_chunkCount(0)
+    , m_storedPoints(0)
+    , m_rejected(0)
+    , m_rollups(nullptr)
+{
+    QDir().mkpath(m_directory);
+    m_clock.start();
+}
+
+TimeSeriesStore::~TimeSeriesStore()
+{
+    close();
+}
+
+// ---------------------------------------------------------
+// CONFIGURACIÓN
+// ---------------------------------------------------------
+
+QString TimeSeriesStore::directory() const { return m_directory; }
+
+void TimeSeriesStore::setChunkPoints(int points) { m_chunkPoints = qMax(16, points); }
+
+void TimeSeriesStore::setSegmentBytes(qint64 bytes) { m_segmentBytes = qMax<qint64>(1024 * 1024, bytes); }
+
+void TimeSeriesStore::setMaxOpenAge(int ms)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_maxOpenAgeMs = qMax(100, ms);
+}
+
+void TimeSeriesStore::setRollups(RollupEngine *rollups)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    // Lecturas guardadas entre el recorrido de backfill() y este momento: sin el bloqueo
+    // de append() de por medio, ninguna se queda sin agregar ni se agrega dos veces
+    qint64 caughtUp = 0;
+    for (auto it = m_series.cbegin(); rollups && it != m_series.cend(); ++it) {
+        qint64 fromMs = 0;
+        qint64 skip = 0;
+        if (!rollups->resumePoint(it.key(), &fromMs, &skip)) continue;
+
+        Selection selection;
+        if (!selectLocked(*it, fromMs, LLONG_MAX, &selection)) continue;
+
+        QList<SeriesPoint> points;
+        visit(it.key(), selection, fromMs, LLONG_MAX, [&points, &skip, fromMs](const SeriesPoint &point) {
+            if (skip > 0 && point.timestampMs == fromMs) {
+                --skip;
+            } else {
+                points.append(point);
+            }
+            return true;
+        });
+        if (points.isEmpty()) continue;
+
+        rollups->add(it.key(), points);
+        caughtUp += points.size();
+    }
+    if (caughtUp > 0) qInfo() << "Agregadas" << caughtUp << "lecturas recibidas durante el mantenimiento";
+
+    m_rollups = rollups;
+}
+
+QString TimeSeriesStore::segmentPath(int number) const
+{
+    return m_directory + '/' + kSegmentPrefix + QString("%1").arg(number, 6, 10, QChar('0')) + kSegmentSuffix;
+}
+
+// ---------------------------------------------------------
+// APERTURA Y CIERRE
+// ---------------------------------------------------------
+
+bool TimeSeriesStore::open()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_active > 0) return true;
+
+    Tracer::Span span("TimeSeriesStore::open", "io");
+    span.setDetail(m_directory);
+
+    if (!QDir().mkpath(m_directory)) {
+        qCritical() << "No se pudo crear la carpeta de series:" << m_directory;
+        return false;
+    }
+
+    QList<int> numbers;
+    const QStringList files = QDir(m_directory).entryList({ QString(kSegmentPrefix) + "*" + kSegmentSuffix }, QDir::Files);
+    for (const QString &file : files) {
+        bool ok = false;
+        const int number = file.mid(int(qstrlen(kSegmentPrefix)), 6).toInt(&ok);
+        if (ok && number > 0) numbers.append(number);
+    }
+    std::sort(numbers.begin(), numbers.end());
+
+    for (int i = 0; i < numbers.size(); ++i) {
+        const int number = numbers.at(i);
+        Segment segment;
+        segment.path = segmentPath(number);
+        segment.size = indexSegment(number, segment.path, i == numbers.size() - 1);
+        m_segments.insert(number, segment);
+    }
+    span.setRows(m_chunkCount);
+
+    // Se sigue escribiendo en el último segmento mientras no esté lleno
+    if (!numbers.isEmpty() && m_segments.value(numbers.last()).size < m_segmentBytes) {
+        m_active = numbers.last();
+        m_writer.setFileName(segmentPath(m_active));
+        if (!m_writer.open(QIODevice::WriteOnly | QIODevice::Append)) {
+            qCritical() << "No se pudo abrir el segmento de series:" << m_writer.errorString();
+            m_active = 0;
+            return false;
+        }
+        return true;
+    }
+
+    return startSegment();
+}
+
+void TimeSeriesStore::close()
+{
+    flush();
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_writer.isOpen()) m_writer.close();
+    m_active = 0;
+    m_segments.clear();   // Los mapeos en uso por consultas siguen vivos hasta que terminen
+    m_series.clear();
+    m_chunkCount = 0;
+    m_storedPoints = 0;
+}
+
+qint64 TimeSeriesStore::indexSegment(int number, const QString &path, bool last)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        qWarning() << "No se pudo leer el segmento de series" << path << ":" << file.errorString();
+        return 0;
+    }
+
+    const qint64 size = file.size();
+    uchar *data = size > 0 ? file.map(0, size) : nullptr;
+    if (size > 0 && !data) {
+        qWarning() << "No se pudo mapear el segmento de series" << path << ":" << file.errorString();
+        return 0;
+    }
+
+    // Solo se leen las cabeceras: los datos comprimidos se saltan
+    qint64 offset = 0;
+    while (offset + HeaderSize <= size) {
+        const ChunkHeader header = readHeader(data + offset);
+        if (header.magic != ChunkMagic || offset + HeaderSize + header.bytes > size) break;
+
+        ChunkRef ref;
+        ref.segment = number;
+        ref.offset = offset + HeaderSize;
+        ref.bytes = header.bytes;
+        ref.count = header.count;
+        ref.firstMs = header.firstMs;
+        ref.lastMs = header.lastMs;
+
+        Series &series = m_series[header.deviceId];
+        series.chunks.append(ref);
+        series.lastMs = series.hasData ? qMax(series.lastMs, ref.lastMs) : ref.lastMs;
+        series.hasData = true;
+
+        ++m_chunkCount;
+        m_storedPoints += header.count;
+        offset = ref.offset + header.bytes;
+    }
+
+    if (data) file.unmap(data);
+    file.close();
+
+    if (offset < size) {
+        if (last) {
+            // Cola de un bloque a medio escribir (cierre inesperado): se descarta
+            qWarning() << "Segmento de series con cola incompleta, se recorta:" << path << (size - offset) << "bytes";
+            QFile::resize(path, offset);
+        } else {
+            qWarning() << "Segmento de series dañado a partir del byte" << offset << ":" << path;
+        }
+    }
+
+    return offset;
+}
+
+bool TimeSeriesStore::startSegment()
+{
+    if (m_writer.isOpen()) m_writer.close();
+
+    int number = 1;
+    for (auto it = m_segments.cbegin(); it != m_segments.cend(); ++it) number = qMax(number, it.key() + 1);
+
+    Segment segment;
+    segment.path = segmentPath(number);
+    m_writer.setFileName(segment.path);
+    if (!m_writer.open(QIODevice::WriteOnly | QIODevice::Append)) {
+        qCritical() << "No se pudo crear el segmento de series:" << m_writer.errorString();
+        m_active = 0;
+        return false;
+    }
+
+    segment.size = m_writer.size();
+    m_segments.insert(number, segment);
+    m_active = number;
+    return true;
+}
+
+// ---------------------------------------------------------
+// ESCRITURA
+// ---------------------------------------------------------
+
+bool TimeSeriesStore::append(int deviceId, qint64 timestampMs, double value)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_active == 0) return false;
+
+    if (!appendLocked(deviceId, m_series[deviceId], timestampMs, value)) return false;
+    if (m_rollups) m_rollups->add(deviceId, timestampMs, value);
+    return true;
+}
+
+int TimeSeriesStore::append(int deviceId, const QList<SeriesPoint> &points)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_active == 0) return 0;
+
+    Series &series = m_series[deviceId];
+    int accepted = 0;
+    for (const SeriesPoint &point : points) {
+        if (appendLocked(deviceId, series, point.timestampMs, point.value)) ++accepted;
+    }
+    if (m_rollups && accepted > 0) m_rollups->add(deviceId, points);
+    return accepted;
+}
+
+int TimeSeriesStore::append(const SeriesBatch &batch)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_active == 0) return 0;
+
+    // Las lecturas de un mismo dispositivo suelen ir seguidas: se evita buscarlo cada vez
+    int accepted = 0;
+    int currentId = 0;
+    Series *series = nullptr;
+    for (qsizetype i = 0; i < batch.size(); ++i) {
+        const int deviceId = batch.deviceIds.at(i);
+        if (!series || deviceId != currentId) {
+            series = &m_series[deviceId];
+            currentId = deviceId;
+        }
+        if (appendLocked(deviceId, *series, batch.timestampsMs.at(i), batch.values.at(i))) ++accepted;
+    }
+    if (m_rollups && accepted > 0) m_rollups->add(batch);
+    return accepted;
+}
+
+bool TimeSeriesStore::appendLocked(int deviceId, Series &series, qint64 timestampMs, double value)
+{
+    if (series.hasData && timestampMs < series.lastMs) {
+        ++m_rejected;
+        return false;
+    }
+
+    if (series.open.count() == 0) series.openedMs = m_clock.elapsed();
+    series.open.append(timestampMs, value);
+    series.lastMs = timestampMs;
+    series.hasData = true;
+
+    if (int(series.open.count()) >= m_chunkPoints) seal(deviceId, series);
+    return true;
+}
+
+bool TimeSeriesStore::seal(int deviceId, Series &series)
+{
+    if (series.open.count() == 0) return true;
+
+    Tracer::Span span("TimeSeriesStore::seal", "io");
+    span.setRows(series.open.count());
+    const QByteArray payload = series.open.bytes();
+    const qint64 chunkSize = HeaderSize + payload.size();
+
+    if (m_segments.value(m_active).size > 0 && m_segments.value(m_active).size + chunkSize > m_segmentBytes) {
+        if (!startSegment()) return false;
+    }
+
+    Segment &segment = m_segments[m_active];
+
+    ChunkHeader header;
+    header.magic = ChunkMagic;
+    header.deviceId = deviceId;
+    header.count = series.open.count();
+    header.bytes = quint32(payload.size());
+    header.firstMs = series.open.firstTimestamp();
+    header.lastMs = series.open.lastTimestamp();
+
+    uchar raw[HeaderSize];
+    writeHeader(header, raw);
+
+    if (m_writer.write(reinterpret_cast<const char *>(raw), HeaderSize) != HeaderSize
+        || m_writer.write(payload) != payload.size()) {
+        // El bloque sigue abierto en memoria; se recorta lo escrito a medias
+        qWarning() << "Error escribiendo el segmento de series:" << m_writer.errorString();
+        m_writer.flush();
+        m_writer.resize(segment.size);
+        return false;
+    }
+
+    ChunkRef ref;
+    ref.segment = m_active;
+    ref.offset = segment.size + HeaderSize;
+    ref.bytes = header.bytes;
+    ref.count = header.count;
+    ref.firstMs = header.firstMs;
+    ref.lastMs = header.lastMs;
+    series.chunks.append(ref);
+
+    segment.size += chunkSize;
+    ++m_chunkCount;
+    m_storedPoints += header.count;
+    series.open.clear();
+    return true;
+}
+
+bool TimeSeriesStore::flush()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_active == 0) return true;
+
+    Tracer::Span span("TimeSeriesStore::flush", "io");
+    bool ok = true;
+    for (auto it = m_series.begin(); it != m_series.end(); ++it) {
+        if (!seal(it.key(), it.value())) ok = false;
+    }
+
+    if (!m_writer.flush()) {
+        qWarning() << "Error volcando el segmento de series:" << m_writer.errorString();
+        ok = false;
+    }
+    return ok;
+}
+
+bool TimeSeriesStore::flushExpired()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_active == 0) return true;
+
+    Tracer::Span span("TimeSeriesStore::flushExpired", "io");
+    // Los bloques recientes siguen abiertos para no fragmentar los dispositivos lentos
+    const qint64 nowMs = m_clock.elapsed();
+    bool ok = true;
+    for (auto it = m_series.begin(); it != m_series.end(); ++it) {
+        Series &series = it.value();
+        if (series.open.count() == 0 || nowMs - series.openedMs < m_maxOpenAgeMs) continue;
+        if (!seal(it.key(), series)) ok = false;
+    }
+
+    // Los bloques sellados por tamaño también pueden seguir en el búfer de QFile
+    if (!m_writer.flush()) {
+        qWarning() << "Error volcando el segmento de series:" << m_writer.errorString();
+        ok = false;
+    }
+    return ok;
+}
+
+int TimeSeriesStore::removeBefore(qint64 cutoffMs)
+{
+    Tracer::Span span("TimeSeriesStore::removeBefore", "io");
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    // Lectura más reciente de cada segmento (los segmentos sin bloques también caducan)
+    QHash<int, qint64> newest;
+    for (auto it = m_segments.cbegin(); it != m_segments.cend(); ++it) newest.insert(it.key(), LLONG_MIN);
+    for (const Series &series : std::as_const(m_series)) {
+        for (const ChunkRef &ref : series.chunks) {
+            qint64 &last = newest[ref.segment];
+            last = qMax(last, ref.lastMs);
+        }
+    }
+
+    QSet<int> expired;
+    for (auto it = newest.cbegin(); it != newest.cend(); ++it) {
+        if (it.key() != m_active && it.value() < cutoffMs) expired.insert(it.key());
+    }
+    if (expired.isEmpty()) return 0;
+
+    for (Series &series : m_series) {
+        series.chunks.removeIf([&](const ChunkRef &ref) {
+            if (!expired.contains(ref.segment)) return false;
+            --m_chunkCount;
+            m_storedPoints -= ref.count;
+            return true;
+        });
+    }
+
+    // Las consultas en curso conservan su mapeo; el archivo se libera al terminar
+    for (int number : std::as_const(expired)) {
+        const QString path = m_segments.value(number).path;
+        m_segments.remove(number);
+        if (!QFile::remove(path)) qWarning() << "No se pudo borrar el segmento de series" << path;
+    }
+    span.setRows(expired.size());
+    return expired.size();
+}
+
+// ---------------------------------------------------------
+// CONSULTAS
+// ---------------------------------------------------------
+
+std::shared_ptr<TimeSeriesStore::Mapping> TimeSeriesStore::mapping(int number, qint64 end) const
+{
+    auto it = m_segments.constFind(number);
+    if (it == m_segments.cend()) return nullptr;
+
+    if (it->map && it->map->size >= end) return it->map;
+
+    // El segmento activo ha crecido desde el último mapeo (o nunca se mapeó)
+    if (number == m_active) m_writer.flush();
+
+    auto map = std::make_shared<Mapping>();
+    map->file.setFileName(it->path);
+    if (!map->file.open(QIODevice::ReadOnly)) {
+        qWarning() << "No se pudo abrir el segmento de series" << it->path << ":" << map->file.errorString();
+        return nullptr;
+    }
+    map->size = map->file.size();
+    map->data = map->size > 0 ? map->file.map(0, map->size) : nullptr;
+    if (!map->data || map->size < end) {
+        qWarning() << "No se pudo mapear el segmento de series" << it->path << ":" << map->file.errorString();
+        return nullptr;
+    }
+
+    it->map = map;
+    return map;
+}
+
+qint64 TimeSeriesStore::scan(int deviceId, qint64 fromMs, qint64 toMs,
+                             const std::function<bool(const SeriesPoint &)> &visitor) const
+{
+    Tracer::Span span("TimeSeriesStore::scan", "io");
+
+    // Bajo el mutex solo se eligen los bloques; la decodificación se hace después
+    Selection selection;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto it = m_series.constFind(deviceId);
+        if (it == m_series.cend()) return 0;
+        if (!selectLocked(*it, fromMs, toMs, &selection)) return -1;
+    }
+    const qint64 visited = visit(deviceId, selection, fromMs, toMs, visitor);
+    span.setRows(visited);
+    return visited;
+}
+
+bool TimeSeriesStore::selectLocked(const Series &series, qint64 fromMs, qint64 toMs, Selection *selection) const
+{
+    const QList<ChunkRef> &refs = series.chunks;
+    auto first = std::lower_bound(refs.cbegin(), refs.cend(), fromMs,
+                                  [](const ChunkRef &ref, qint64 ms) { return ref.lastMs < ms; });
+    for (auto ref = first; ref != refs.cend() && ref->firstMs <= toMs; ++ref) {
+        std::shared_ptr<Mapping> map = mapping(ref->segment, ref->offset + ref->bytes);
+        if (!map) return false;
+        selection->maps.append(map);
+        selection->chunks.append(*ref);
+    }
+
+    const SeriesEncoder &open = series.open;
+    if (open.count() > 0 && open.lastTimestamp() >= fromMs && open.firstTimestamp() <= toMs) {
+        selection->openBytes = open.bytes();
+        selection->openCount = open.count();
+    }
+    return true;
+}
+
+qint64 TimeSeriesStore::visit(int deviceId, const Selection &selection, qint64 fromMs, qint64 toMs,
+                              const std::function<bool(const SeriesPoint &)> &visitor)
+{
+    qint64 visited = 0;
+    auto decode = [&](const uchar *data, qint64 size, quint32 count) -> int {
+        SeriesDecoder decoder(data, size, count);
+        SeriesPoint point;
+        while (decoder.next(&point.timestampMs, &point.value)) {
+            if (point.timestampMs < fromMs) continue;
+            if (point.timestampMs > toMs) return 1;
+            ++visited;
+            if (!visitor(point)) return 1;
+        }
+        return decoder.truncated() ? -1 : 0;
+    };
+
+    for (qsizetype i = 0; i < selection.chunks.size(); ++i) {
+        const ChunkRef &ref = selection.chunks.at(i);
+        const int state = decode(selection.maps.at(i)->data + ref.offset, ref.bytes, ref.count);
+        if (state < 0) {
+            qWarning() << "Bloque de series dañado del dispositivo" << deviceId;
+            return -1;
+        }
+        if (state > 0) return visited;
+    }
+
+    if (selection.openCount > 0) {
+        decode(reinterpret_cast<const uchar *>(selection.openBytes.constData()),
+               selection.openBytes.size(), selection.openCount);
+    }
+    return visited;
+}
+
+QList<SeriesPoint> TimeSeriesStore::query(int deviceId, qint64 fromMs, qint64 toMs, int limit) const
+{
+    QList<SeriesPoint> points;
+    scan(deviceId, fromMs, toMs, [&points, limit](const SeriesPoint &point) {
+        points.append(point);
+        return limit < 0 || points.size() < limit;
+    });
+    return points;
+}
+
+QList<int> TimeSeriesStore::devices() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_series.keys();
+}
+
+TimeSeriesStats TimeSeriesStore::stats() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    TimeSeriesStats stats;
+    stats.devices = m_series.size();
+    stats.segments = m_segments.size();
+    stats.chunks = m_chunkCount;
+    stats.storedPoints = m_storedPoints;
+    stats.rejected = m_rejected;
+    for (const Series &series : m_series) stats.openPoints += series.open.count();
+    for (const Segment &segment : m_segments) stats.diskBytes += segment.size;
+    return stats;
+}
@@ -0,0 +1,134 @@
+#include "timingwheel.h"
+
+namespace {
+
+// Distancia máxima representable: 256^Levels - 1 ticks
+constexpr quint64 MaxDelay = (quint64(1) << (TimingWheel::SlotBits * TimingWheel::Levels)) - 1;
+
+} // namespace
+
+TimingWheel::TimingWheel()
+    : m_now(0)
+    , m_slots(Levels * Slots)
+{
+}
+
+// ---------------------------------------------------------
+// PROGRAMACIÓN
+// ---------------------------------------------------------
+
+void TimingWheel::schedule(int key, quint64 delayTicks)
+{
+    const quint64 expires = m_now + qBound<quint64>(1, delayTicks, MaxDelay);
+    const int slot = slotFor(expires);
+
+    auto it = m_nodes.find(key);
+    if (it != m_nodes.end()) {
+        // Reprogramar: se mueve el nodo de lista sin liberar ni reservar memoria
+        Node &node = it->second;
+        m_slots[slot].splice(m_slots[slot].end(), m_slots[node.slot], node.pos);
+        node.expires = expires;
+        node.slot = slot;
+        return;
+    }
+
+    Node node;
+    node.expires = expires;
+    node.slot = slot;
+    node.pos = m_slots[slot].insert(m_slots[slot].end(), key);
+    m_nodes.emplace(key, node);
+}
+
+bool TimingWheel::cancel(int key)
+{
+    auto it = m_nodes.find(key);
+    if (it == m_nodes.end()) return false;
+
+    m_slots[it->second.slot].erase(it->second.pos);
+    m_nodes.erase(it);
+    return true;
+}
+
+bool TimingWheel::contains(int key) const
+{
+    return m_nodes.find(key) != m_nodes.end();
+}
+
+quint64 TimingWheel::expiry(int key) const
+{
+    auto it = m_nodes.find(key);
+    return it != m_nodes.end() ? it->second.expires : 0;
+}
+
+void TimingWheel::clear()
+{
+    for (std::list<int> &slot : m_slots) slot.clear();
+    m_nodes.clear();
+}
+
+// ---------------------------------------------------------
+// AVANCE DEL TIEMPO
+// ---------------------------------------------------------
+
+QList<int> TimingWheel::advance(quint64 ticks)
+{
+    QList<int> expired;
+
+    for (quint64 i = 0; i < ticks; ++i) {
+        // Sin claves no hay casillas que revisar: se salta el resto de golpe
+        if (m_nodes.empty()) {
+            m_now += ticks - i;
+            break;
+        }
+
+        ++m_now;
+        const int index = int(m_now & (Slots - 1));
+
+        // Al completar una vuelta del nivel 0 se baja la casilla siguiente del nivel 1,
+        // y así hacia arriba mientras los niveles superiores también completen vuelta
+        if (index == 0) {
+            for (int level = 1; level < Levels; ++level) {
+                const int upper = int((m_now >> (SlotBits * level)) & (Slots - 1));
+                cascade(level, upper);
+                if (upper != 0) break;
+            }
+        }
+
+        std::list<int> &due = m_slots[index];
+        for (int key : due) {
+            expired.append(key);
+            m_nodes.erase(key);
+        }
+        due.clear();
+    }
+
+    return expired;
+}
+
+int TimingWheel::slotFor(quint64 expires) const
+{
+    const quint64 delta = expires - m_now;
+
+    for (int level = 0; level < Levels - 1; ++level) {
+        if (delta < (quint64(1) << (SlotBits * (level + 1)))) {
+            return level * Slots + int((expires >> (SlotBits * level)) & (Slots - 1));
+        }
+    }
+    const int top = Levels - 1;
+    return top * Slots + int((expires >> (SlotBits * top)) & (Slots - 1));
+}
+
+void TimingWheel::cascade(int level, int index)
+{
+    // swap conserva los iteradores: los nodos pasan a 'pending' y de ahí a su nueva casilla
+    std::list<int> pending;
+    pending.swap(m_slots[level * Slots + index]);
+
+    while (!pending.empty()) {
+        auto pos = pending.begin();
+        Node &node = m_nodes[*pos];
+        const int slot = slotFor(node.expires);
+        m_slots[slot].splice(m_slots[slot].end(), pending, pos);
+        node.slot = slot;
+    }
+}
@@ -0,0 +1,209 @@
+#include "tracer.h"
+#include <QCoreApplication>
+#include <QThread>
+#include <QElapsedTimer>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QList>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QDebug>
+#include <memory>
+#include <vector>
+
+std::atomic<bool> Tracer::s_enabled{false};
+
+namespace {
+
+/**
+ * @brief Tramo ya terminado.
+ */
+struct TraceEvent
+{
+    const char *name;
+    const char *category;
+    qint64 startNs;
+    qint64 durationNs;
+    qint64 rows;
+    QString detail;
+};
+
+/**
+ * @brief Tramos de un hilo. Sobrevive al hilo hasta que stop() lo vacía.
+ */
+struct ThreadBuffer
+{
+    QMutex mutex;
+    QList<TraceEvent> events;
+    qint64 dropped = 0;
+    int tid = 0;
+    QString threadName;
+};
+
+/**
+ * @brief Estado compartido: reloj, sesión y búferes de todos los hilos.
+ */
+struct TraceState
+{
+    QMutex mutex;
+    QElapsedTimer clock;
+    QString fileName;
+    qint64 sessionStartNs = 0;
+    int nextTid = 1;
+    std::vector<std::shared_ptr<ThreadBuffer>> buffers;
+
+    TraceState() { clock.start(); }
+};
+
+TraceState &state()
+{
+    static TraceState instance;
+    return instance;
+}
+
+ThreadBuffer *currentBuffer()
+{
+    thread_local std::shared_ptr<ThreadBuffer> buffer;
+    if (!buffer) {
+        buffer = std::make_shared<ThreadBuffer>();
+
+        TraceState &trace = state();
+        QMutexLocker locker(&trace.mutex);
+        buffer->tid = trace.nextTid++;
+
+        QThread *thread = QThread::currentThread();
+        const QCoreApplication *app = QCoreApplication::instance();
+        if (app && thread == app->thread()) {
+            buffer->threadName = "Hilo principal";
+        } else if (thread && !thread->objectName().isEmpty()) {
+            buffer->threadName = thread->objectName();
+        } else {
+            buffer->threadName = QString("Hilo %1").arg(buffer->tid);
+        }
+        trace.buffers.push_back(buffer);
+    }
+    return buffer.get();
+}
+
+QJsonObject metadata(const char *name, qint64 pid, int tid, const QString &value)
+{
+    QJsonObject event;
+    event["name"] = name;
+    event["ph"] = "M";
+    event["pid"] = pid;
+    event["tid"] = tid;
+    event["args"] = QJsonObject{ { "name", value } };
+    return event;
+}
+
+} // namespace
+
+void Tracer::Span::finish()
+{
+    const qint64 endNs = Tracer::nowNs();
+    if (!Tracer::isEnabled()) return;   // La sesión terminó mientras se medía
+
+    ThreadBuffer *buffer = currentBuffer();
+    QMutexLocker locker(&buffer->mutex);
+    if (buffer->events.size() >= MaxEventsPerThread) {
+        ++buffer->dropped;
+        return;
+    }
+    buffer->events.append({ m_name, m_category, m_startNs, endNs - m_startNs, m_rows, m_detail });
+}
+
+bool Tracer::start(const QString &fileName)
+{
+    TraceState &trace = state();
+    QMutexLocker locker(&trace.mutex);
+    if (s_enabled.load()) return false;
+
+    for (const auto &buffer : trace.buffers) {
+        QMutexLocker bufferLocker(&buffer->mutex);
+        buffer->events.clear();
+        buffer->dropped = 0;
+    }
+    trace.fileName = fileName;
+    trace.sessionStartNs = trace.clock.nsecsElapsed();
+    s_enabled.store(true);
+
+    qInfo() << "Traza activada:" << fileName;
+    return true;
+}
+
+bool Tracer::stop()
+{
+    TraceState &trace = state();
+    QMutexLocker locker(&trace.mutex);
+    if (!s_enabled.exchange(false)) return false;
+
+    const qint64 pid = QCoreApplication::applicationPid();
+    QJsonArray events;
+    events.append(metadata("process_name", pid, 0,
+                           QCoreApplication::applicationName().isEmpty() ? QString("ProyectoFinal")
+                                                                         : QCoreApplication::applicationName()));
+
+    qint64 spans = 0;
+    qint64 dropped = 0;
+    for (const auto &buffer : trace.buffers) {
+        QList<TraceEvent> recorded;
+        {
+            QMutexLocker bufferLocker(&buffer->mutex);
+            recorded.swap(buffer->events);
+            dropped += buffer->dropped;
+            buffer->dropped = 0;
+        }
+        if (recorded.isEmpty()) continue;
+
+        events.append(metadata("thread_name", pid, buffer->tid, buffer->threadName));
+        for (const TraceEvent &recordedEvent : std::as_const(recorded)) {
+            // Tramos empezados antes de esta sesión: fuera de la traza
+            if (recordedEvent.startNs < trace.sessionStartNs) continue;
+
+            QJsonObject event;
+            event["name"] = recordedEvent.name;
+            event["cat"] = recordedEvent.category;
+            event["ph"] = "X";
+            event["ts"] = recordedEvent.startNs / 1000.0;        // Microsegundos
+            event["dur"] = recordedEvent.durationNs / 1000.0;
+            event["pid"] = pid;
+            event["tid"] = buffer->tid;
+
+            QJsonObject args;
+            if (recordedEvent.rows >= 0) args["rows"] = recordedEvent.rows;
+            if (!recordedEvent.detail.isEmpty()) args["detail"] = recordedEvent.detail;
+            if (!args.isEmpty()) event["args"] = args;
+
+            events.append(event);
+            ++spans;
+        }
+    }
+
+    QJsonObject root;
+    root["traceEvents"] = events;
+    root["displayTimeUnit"] = "ms";
+
+    QFile file(trace.fileName);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        qCritical() << "No se pudo escribir la traza en" << trace.fileName << ":" << file.errorString();
+        return false;
+    }
+    file.write(QJsonDocument(root).toJson(QJsonDocument::Compact));
+
+    qInfo() << "Traza escrita en" << trace.fileName << ":" << spans << "tramos," << dropped << "descartados";
+    return true;
+}
+
+QString Tracer::fileName()
+{
+    TraceState &trace = state();
+    QMutexLocker locker(&trace.mutex);
+    return trace.fileName;
+}
+
+qint64 Tracer::nowNs()
+{
+    return state().clock.nsecsElapsed();
+}
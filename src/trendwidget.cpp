@@ -0,0 +1,488 @@
+#include "trendwidget.h"
+#include "lttb.h"
+#include "connectionpool.h"
+#include <QPainter>
+#include <QPolygonF>
+#include <QMouseEvent>
+#include <QWheelEvent>
+#include <QDateTime>
+#include <QtMath>
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+const qint64 DefaultSpanMs = 3600LL * 1000;               // Vista inicial: la última hora
+const qint64 MinSpanMs = 10LL * 1000;
+const qint64 MaxSpanMs = 5LL * 365 * 24 * 3600 * 1000;
+const int PointsPerPixel = 4;                             // Densidad de la caché antes de LTTB
+const int ValueTicks = 5;
+const int TimeLabelWidth = 120;
+
+const QColor Background("#3b3b3b");
+const QColor Grid("#555555");
+const QColor Text("#cccccc");
+
+const QColor Palette[TrendWidget::MaxSeries] = {
+    QColor("#0d6efd"), QColor("#198754"), QColor("#ffc107"), QColor("#dc3545"),
+    QColor("#20c997"), QColor("#6f42c1"), QColor("#fd7e14"), QColor("#adb5bd")
+};
+
+QString resolutionName(RollupEngine::Resolution resolution)
+{
+    switch (resolution) {
+    case RollupEngine::Raw: return QStringLiteral("lecturas");
+    case RollupEngine::Minute: return QStringLiteral("minuto");
+    case RollupEngine::Hour: return QStringLiteral("hora");
+    default: return QStringLiteral("día");
+    }
+}
+
+QString timeFormat(qint64 spanMs)
+{
+    if (spanMs <= 2LL * 60 * 1000) return QStringLiteral("hh:mm:ss");
+    if (spanMs <= 2LL * 24 * 3600 * 1000) return QStringLiteral("hh:mm");
+    if (spanMs <= 180LL * 24 * 3600 * 1000) return QStringLiteral("dd/MM hh:mm");
+    return QStringLiteral("dd/MM/yyyy");
+}
+
+} // namespace
+
+TrendWidget::TrendWidget(QWidget *parent)
+    : QWidget(parent)
+    , m_rollups(nullptr)
+    , m_followLive(true)
+    , m_dragging(false)
+    , m_dragX(0)
+    , m_dragFrom(0)
+    , m_dragTo(0)
+    , m_context(new QObject)
+    , m_generation(0)
+{
+    m_to = QDateTime::currentMSecsSinceEpoch();
+    m_from = m_to - DefaultSpanMs;
+
+    setMinimumHeight(180);
+    setCursor(Qt::OpenHandCursor);
+
+    m_refresh.setInterval(1000);
+    connect(&m_refresh, &QTimer::timeout, this, &TrendWidget::refresh);
+
+    // Las consultas van a su propio hilo: pintar solo lee la caché
+    m_context->moveToThread(&m_thread);
+    connect(&m_thread, &QThread::finished, m_context, &QObject::deleteLater);
+    m_thread.setObjectName("Tendencias");
+    m_thread.start();
+}
+
+TrendWidget::~TrendWidget()
+{
+    dropQueries();
+    m_thread.quit();
+    m_thread.wait();
+}
+
+void TrendWidget::setRollups(RollupEngine *rollups)
+{
+    dropQueries();
+
+    m_rollups = rollups;
+    for (Series &series : m_series) {
+        series.points.clear();
+        series.cacheTo = series.cacheFrom - 1;
+        series.fetching = false;
+        series.refreshing = false;
+        ++series.version;
+        series.dirty = true;
+    }
+
+    if (m_rollups && !m_series.isEmpty()) m_refresh.start();
+    else m_refresh.stop();
+    update();
+}
+
+void TrendWidget::setDevices(const QList<int> &deviceIds, const QStringList &names)
+{
+    QList<Series> series;
+    for (int i = 0; i < deviceIds.size() && i < MaxSeries; ++i) {
+        Series item;
+        for (const Series &existing : std::as_const(m_series)) {
+            if (existing.deviceId == deviceIds.at(i)) {
+                item = existing;
+                break;
+            }
+        }
+        item.deviceId = deviceIds.at(i);
+        item.name = i < names.size() ? names.at(i) : QString("Dispositivo %1").arg(deviceIds.at(i));
+        item.color = Palette[i];
+        series.append(item);
+    }
+    m_series = series;
+
+    if (m_rollups && !m_series.isEmpty()) m_refresh.start();
+    else m_refresh.stop();
+    update();
+}
+
+void TrendWidget::setRange(qint64 fromMs, qint64 toMs)
+{
+    if (toMs <= fromMs) return;
+    m_followLive = false;
+    moveView(fromMs, toMs);
+}
+
+void TrendWidget::setFollowLive(bool follow)
+{
+    m_followLive = follow;
+    if (follow) {
+        const qint64 now = QDateTime::currentMSecsSinceEpoch();
+        moveView(now - (m_to - m_from), now);
+    } else {
+        update();
+    }
+}
+
+void TrendWidget::setRefreshInterval(int ms)
+{
+    m_refresh.setInterval(qMax(50, ms));
+}
+
+void TrendWidget::clear()
+{
+    m_series.clear();
+    m_refresh.stop();
+    update();
+}
+
+QSize TrendWidget::sizeHint() const
+{
+    return QSize(600, 220);
+}
+
+// ---------------------------------------------------------
+// DATOS: CACHÉ, REDUCCIÓN Y LECTURAS NUEVAS
+// ---------------------------------------------------------
+
+void TrendWidget::refresh()
+{
+    if (!m_rollups || m_series.isEmpty() || !isVisible()) return;
+
+    const qint64 now = QDateTime::currentMSecsSinceEpoch();
+
+    for (Series &series : m_series) {
+        // Sin caché, o caché lejos del presente: se rellenará al pintar si hace falta
+        if (series.fetching || series.refreshing) continue;
+        if (series.cacheTo < series.cacheFrom || series.cacheTo < now - series.cacheSpan) continue;
+
+        // El último intervalo pudo seguir abierto: se sustituye junto con lo posterior
+        Fetch fetch;
+        fetch.deviceId = series.deviceId;
+        fetch.tail = true;
+        fetch.fromMs = series.points.isEmpty() ? series.cacheFrom : qint64(series.points.last().x());
+        fetch.toMs = now;
+        fetch.resolution = series.resolution;
+        fetch.version = series.version;
+        series.refreshing = true;
+        submit(fetch);
+    }
+
+    if (m_followLive) {
+        moveView(now - (m_to - m_from), now);
+    }
+}
+
+void TrendWidget::ensureCache(Series &series)
+{
+    if (!m_rollups || series.fetching) return;
+
+    const qint64 span = m_to - m_from;
+    const bool covered = series.cacheTo >= series.cacheFrom
+        && m_from >= series.cacheFrom && m_to <= series.cacheTo
+        && span * 2 >= series.cacheSpan && span <= series.cacheSpan * 2;
+    if (covered) return;
+
+    // La vista y un ancho a cada lado: desplazarse no vuelve a consultar en cada fotograma
+    Fetch fetch;
+    fetch.deviceId = series.deviceId;
+    fetch.fromMs = m_from - span;
+    fetch.toMs = m_to + span;
+    fetch.span = span;
+    fetch.budget = qMax(1, plotRect().width()) * PointsPerPixel * 3;
+    series.fetching = true;
+    submit(fetch);
+}
+
+void TrendWidget::submit(const Fetch &fetch)
+{
+    RollupEngine *rollups = m_rollups;
+    const quint64 generation = m_generation;
+
+    QMetaObject::invokeMethod(m_context, [this, rollups, generation, fetch]() mutable {
+        // Consulta de un motor ya sustituido: no se ejecuta
+        if (generation != m_generation) return;
+
+        const QList<RollupPoint> rows = fetch.tail
+            ? rollups->query(fetch.deviceId, fetch.resolution, fetch.fromMs, fetch.toMs)
+            : rollups->query(fetch.deviceId, fetch.fromMs, fetch.toMs, fetch.budget, &fetch.resolution);
+
+        fetch.points.reserve(rows.size());
+        for (const RollupPoint &row : rows) {
+            fetch.points.append(QPointF(double(row.bucketMs), row.average()));
+        }
+
+        QMetaObject::invokeMethod(this, [this, generation, fetch]() {
+            receive(generation, fetch);
+        }, Qt::QueuedConnection);
+    }, Qt::QueuedConnection);
+}
+
+void TrendWidget::receive(quint64 generation, const Fetch &fetch)
+{
+    if (generation != m_generation) return;
+
+    auto it = std::find_if(m_series.begin(), m_series.end(),
+                           [&fetch](const Series &series) { return series.deviceId == fetch.deviceId; });
+    if (it == m_series.end()) return;
+    Series &series = *it;
+
+    if (!fetch.tail) {
+        if (!series.fetching) return;
+        series.fetching = false;
+        series.points = fetch.points;
+        series.resolution = fetch.resolution;
+        series.cacheFrom = fetch.fromMs;
+        series.cacheTo = fetch.toMs;
+        series.cacheSpan = fetch.span;
+        ++series.version;
+        series.dirty = true;
+        update();   // Si la vista ya se ha movido fuera de la caché, se pide otra al pintar
+        return;
+    }
+
+    if (!series.refreshing) return;
+    series.refreshing = false;
+    if (fetch.version != series.version) return;   // La caché se sustituyó mientras tanto
+
+    qsizetype keep = series.points.size();
+    while (keep > 0 && series.points.at(keep - 1).x() >= fetch.fromMs) --keep;
+
+    series.cacheTo = qMax(series.cacheTo, fetch.toMs);
+    if (series.points.mid(keep) == fetch.points) return;
+
+    series.points.resize(keep);
+    series.points.append(fetch.points);
+    series.dirty = true;
+    update();
+}
+
+void TrendWidget::dropQueries()
+{
+    // Las consultas en cola se descartan; al volver ya no queda ninguna en curso
+    ++m_generation;
+    QMetaObject::invokeMethod(m_context, []() {
+        ConnectionPool::releaseCurrentThread();
+    }, Qt::BlockingQueuedConnection);
+}
+
+void TrendWidget::decimate(Series &series)
+{
+    const auto begin = series.points.cbegin();
+    const auto end = series.points.cend();
+    auto first = std::lower_bound(begin, end, double(m_from),
+                                  [](const QPointF &point, double ms) { return point.x() < ms; });
+    auto last = std::upper_bound(first, end, double(m_to),
+                                 [](double ms, const QPointF &point) { return ms < point.x(); });
+
+    // Un punto más a cada lado para que la línea llegue a los bordes
+    if (first != begin) --first;
+    if (last != end) ++last;
+
+    Lttb::downsample(series.points.constData() + (first - begin), last - first,
+                     qMax(3, plotRect().width()), &series.visible);
+    series.dirty = false;
+}
+
+void TrendWidget::moveView(qint64 fromMs, qint64 toMs)
+{
+    m_from = fromMs;
+    m_to = toMs;
+    for (Series &series : m_series) {
+        series.dirty = true;
+    }
+    update();
+}
+
+QRect TrendWidget::plotRect() const
+{
+    return rect().adjusted(64, 24, -12, -24);
+}
+
+// ---------------------------------------------------------
+// PINTADO
+// ---------------------------------------------------------
+
+void TrendWidget::paintEvent(QPaintEvent *)
+{
+    QPainter painter(this);
+    painter.fillRect(rect(), Background);
+
+    const QRect plot = plotRect();
+    if (m_series.isEmpty() || !m_rollups || plot.width() <= 0 || plot.height() <= 0) {
+        painter.setPen(Text);
+        painter.drawText(rect(), Qt::AlignCenter, QStringLiteral("Seleccione dispositivos para ver su tendencia"));
+        return;
+    }
+
+    // Rango de valores del tramo visible
+    double minY = 0.0;
+    double maxY = 0.0;
+    bool any = false;
+    bool loading = false;
+    for (Series &series : m_series) {
+        ensureCache(series);
+        loading = loading || series.fetching;
+        if (series.dirty) decimate(series);
+        for (const QPointF &point : std::as_const(series.visible)) {
+            minY = any ? qMin(minY, point.y()) : point.y();
+            maxY = any ? qMax(maxY, point.y()) : point.y();
+            any = true;
+        }
+    }
+    if (maxY - minY < 1e-9) {
+        minY -= 1.0;
+        maxY += 1.0;
+    }
+    const double padding = (maxY - minY) * 0.05;
+    minY -= padding;
+    maxY += padding;
+
+    const double span = double(m_to - m_from);
+    const double xScale = plot.width() / span;
+    const double yScale = plot.height() / (maxY - minY);
+
+    // Rejilla y etiquetas de los ejes
+    painter.setPen(Grid);
+    painter.drawRect(plot);
+    const int decimals = qBound(0, 2 - int(std::floor(std::log10(maxY - minY))), 6);
+    for (int i = 0; i <= ValueTicks; ++i) {
+        const int y = plot.bottom() - i * plot.height() / ValueTicks;
+        painter.setPen(Grid);
+        painter.drawLine(plot.left(), y, plot.right(), y);
+        painter.setPen(Text);
+        painter.drawText(QRect(0, y - 10, plot.left() - 6, 20), Qt::AlignRight | Qt::AlignVCenter,
+                         QString::number(minY + i * (maxY - minY) / ValueTicks, 'f', decimals));
+    }
+
+    const QString format = timeFormat(m_to - m_from);
+    const int timeTicks = qMax(1, plot.width() / TimeLabelWidth);
+    for (int i = 0; i <= timeTicks; ++i) {
+        const int x = plot.left() + i * plot.width() / timeTicks;
+        const qint64 ms = m_from + qint64(span * i / timeTicks);
+        painter.setPen(Grid);
+        painter.drawLine(x, plot.top(), x, plot.bottom());
+        painter.setPen(Text);
+        painter.drawText(QRect(x - TimeLabelWidth / 2, plot.bottom() + 4, TimeLabelWidth, 18), Qt::AlignCenter,
+                         QDateTime::fromMSecsSinceEpoch(ms).toString(format));
+    }
+
+    // Series
+    painter.setRenderHint(QPainter::Antialiasing);
+    painter.setClipRect(plot);
+    for (const Series &series : std::as_const(m_series)) {
+        QPolygonF line;
+        line.reserve(series.visible.size());
+        for (const QPointF &point : series.visible) {
+            line.append(QPointF(plot.left() + (point.x() - m_from) * xScale,
+                                plot.bottom() - (point.y() - minY) * yScale));
+        }
+        painter.setPen(QPen(series.color, 1.5));
+        if (line.size() == 1) painter.drawEllipse(line.first(), 2.0, 2.0);
+        else painter.drawPolyline(line);
+    }
+    painter.setClipping(false);
+    painter.setRenderHint(QPainter::Antialiasing, false);
+
+    // Leyenda y estado de la vista
+    int legendX = plot.left();
+    const QFontMetrics metrics = painter.fontMetrics();
+    for (const Series &series : std::as_const(m_series)) {
+        painter.fillRect(legendX, 8, 10, 10, series.color);
+        painter.setPen(Text);
+        painter.drawText(legendX + 14, 4, metrics.horizontalAdvance(series.name) + 1, 18,
+                         Qt::AlignLeft | Qt::AlignVCenter, series.name);
+        legendX += 14 + metrics.horizontalAdvance(series.name) + 16;
+    }
+
+    QString status = "Resolución: " + resolutionName(m_series.first().resolution);
+    if (m_followLive) status += " · en vivo";
+    if (!any) status = (loading ? "Cargando lecturas · " : "Sin lecturas en este intervalo · ") + status;
+    painter.drawText(QRect(plot.left(), 4, plot.width(), 18), Qt::AlignRight | Qt::AlignVCenter, status);
+}
+
+void TrendWidget::resizeEvent(QResizeEvent *event)
+{
+    // La reducción depende del ancho en píxeles
+    for (Series &series : m_series) {
+        series.dirty = true;
+    }
+    QWidget::resizeEvent(event);
+}
+
+// ---------------------------------------------------------
+// INTERACCIÓN
+// ---------------------------------------------------------
+
+void TrendWidget::mousePressEvent(QMouseEvent *event)
+{
+    if (event->button() != Qt::LeftButton) return QWidget::mousePressEvent(event);
+
+    m_dragging = true;
+    m_dragX = qRound(event->position().x());
+    m_dragFrom = m_from;
+    m_dragTo = m_to;
+    setCursor(Qt::ClosedHandCursor);
+}
+
+void TrendWidget::mouseMoveEvent(QMouseEvent *event)
+{
+    const int width = plotRect().width();
+    if (!m_dragging || width <= 0) return QWidget::mouseMoveEvent(event);
+
+    const qint64 shift = qint64(double(qRound(event->position().x()) - m_dragX) * (m_dragTo - m_dragFrom) / width);
+    m_followLive = false;
+    moveView(m_dragFrom - shift, m_dragTo - shift);
+}
+
+void TrendWidget::mouseReleaseEvent(QMouseEvent *event)
+{
+    if (event->button() != Qt::LeftButton) return QWidget::mouseReleaseEvent(event);
+
+    m_dragging = false;
+    setCursor(Qt::OpenHandCursor);
+}
+
+void TrendWidget::mouseDoubleClickEvent(QMouseEvent *)
+{
+    setFollowLive(true);
+}
+
+void TrendWidget::wheelEvent(QWheelEvent *event)
+{
+    const QRect plot = plotRect();
+    if (plot.width() <= 0) return;
+
+    // Acercar o alejar manteniendo fijo el instante bajo el cursor
+    const double steps = event->angleDelta().y() / 120.0;
+    const qint64 span = m_to - m_from;
+    const qint64 newSpan = qBound(MinSpanMs, qint64(span * qPow(0.8, steps)), MaxSpanMs);
+
+    if (m_followLive) {
+        moveView(m_to - newSpan, m_to);
+    } else {
+        const double fraction = qBound(0.0, (event->position().x() - plot.left()) / plot.width(), 1.0);
+        const qint64 anchor = m_from + qint64(span * fraction);
+        const qint64 from = anchor - qint64(newSpan * fraction);
+        moveView(from, from + newSpan);
+    }
+    event->accept();
+}
@@ -3,6 +3,9 @@
 #include <QSqlQuery>
 #include <QSqlError>
 #include <QVariant>
+#include "databasemanager.h"
+#include "tracer.h"
+#include "slowquerylog.h"
 
 // ---------------------------------------------------------
 // CONSTRUCTOR Y DESTRUCTOR
@@ -39,17 +42,25 @@ bool User::login(const QString &username, const QString &password)
     // Asegurar estado limpio antes de intentar login
     clear();
 
-    QSqlQuery query;
-    query.prepare("SELECT id, username, role FROM users WHERE username = :user AND password = :pass");
+    ConnectionPool *pool = DatabaseManager::pool();
+    if (!pool) {
+        qCritical() << "Error en consulta de Login: no hay una base de datos abierta.";
+        return false;
+    }
+
+    Tracer::Span span("User::login");
+    QSqlQuery &query = pool->readStatement("SELECT id, username, role FROM users WHERE username = :user AND password = :pass");
     query.bindValue(":user", username);
     query.bindValue(":pass", password);
 
-    if (query.exec()) {
+    if (SlowQueryLog::exec(query)) {
         if (query.next()) {
             m_id = query.value("id").toInt();
             m_username = query.value("username").toString();
             m_role = query.value("role").toString();
             m_isLoggedIn = true;
+            query.finish();
+            span.setRows(1);
 
             emit userLoggedIn(m_username, m_role);
             return true;
@@ -57,6 +68,7 @@ bool User::login(const QString &username, const QString &password)
     } else {
         qCritical() << "Error en consulta de Login:" << query.lastError().text();
     }
+    query.finish();
 
     return false;
 }